@@ -0,0 +1,79 @@
+//
+//  Benchmark.h
+//  Camellia
+//
+//
+
+#ifndef __Camellia__Benchmark__
+#define __Camellia__Benchmark__
+
+#include "Teuchos_RCP.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+//! A timed unit of work, identified by a stable name.
+/*!
+ Names encode the swept parameters (e.g. "IP::computeInnerProductMatrix/quad/k=2"), so that results
+ can be matched against a stored baseline.  initialize() runs once, before the first repetition, and finalize() once
+ after the last; setUp() runs before every repetition.  Only run() is timed.  Benchmarks run on every rank, and must
+ run the same sequence of collective operations on each.
+ */
+class Benchmark {
+  std::string _name;
+  std::map<std::string, std::string> _parameters;
+protected:
+  void setName(const std::string &name);
+  void setParameter(const std::string &parameterName, const std::string &value);
+  void setParameter(const std::string &parameterName, int value);
+public:
+  virtual ~Benchmark() {}
+
+  const std::string &name() const;
+  const std::map<std::string, std::string> &parameters() const;
+
+  virtual void initialize() {}
+  virtual void setUp() {}
+  virtual void run() = 0;
+  virtual void finalize() {} // should release what initialize() allocated
+};
+typedef Teuchos::RCP<Benchmark> BenchmarkPtr;
+
+struct BenchmarkResult {
+  std::string name;
+  std::map<std::string, std::string> parameters;
+  int repetitions;
+  double minTime;    // seconds; for each repetition, the time is the max across ranks
+  double medianTime;
+  double meanTime;
+};
+
+class BenchmarkRunner {
+  int _minRepetitions;
+  double _minTotalTime;
+  std::string _filter;
+public:
+  BenchmarkRunner(int minRepetitions, double minTotalTime, const std::string &filter);
+
+  //! Runs each benchmark whose name contains the filter at least minRepetitions times, and until minTotalTime has
+  //! elapsed (up to 100 repetitions), after one untimed warm-up run.  Results are sorted by name.  Collective.
+  std::vector<BenchmarkResult> run(std::vector<BenchmarkPtr> &benchmarks, bool printProgress);
+
+  //! One result per line, with fixed formatting, so that result files diff cleanly.
+  static void writeJSON(const std::string &filePath, const std::vector<BenchmarkResult> &results);
+
+  //! Reads the median times from a file written by writeJSON().
+  static std::map<std::string, double> readBaselineMedians(const std::string &filePath);
+
+  //! Prints each benchmark's median time relative to the baseline; returns the number of benchmarks slower than
+  //! (1 + tolerance) times the baseline.
+  static int compareToBaseline(const std::vector<BenchmarkResult> &results, const std::map<std::string, double> &baseline,
+                               double tolerance);
+};
+
+// defined in MicroBenchmarks.cpp and MacroBenchmarks.cpp
+void addMicroBenchmarks(std::vector<BenchmarkPtr> &benchmarks);
+void addMacroBenchmarks(std::vector<BenchmarkPtr> &benchmarks);
+
+#endif /* defined(__Camellia__Benchmark__) */
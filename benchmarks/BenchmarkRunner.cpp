@@ -0,0 +1,198 @@
+//
+//  BenchmarkRunner.cpp
+//  Camellia
+//
+//
+
+#include "Benchmark.h"
+
+#include "PhaseTimers.h"
+
+#include "Teuchos_GlobalMPISession.hpp"
+#include "Teuchos_TestForException.hpp"
+#include "Teuchos_Time.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+  bool resultNameLessThan(const BenchmarkResult &a, const BenchmarkResult &b) {
+    return a.name < b.name;
+  }
+
+  // our names and parameters are code literals; this handles quotes and backslashes in case that changes
+  string jsonEscaped(const string &value) {
+    string escaped;
+    for (int i=0; i<value.size(); i++) {
+      if ((value[i] == '"') || (value[i] == '\\')) escaped += '\\';
+      escaped += value[i];
+    }
+    return escaped;
+  }
+
+  string jsonUnescaped(const string &value) {
+    string unescaped;
+    for (int i=0; i<value.size(); i++) {
+      if ((value[i] == '\\') && (i+1 < value.size())) i++;
+      unescaped += value[i];
+    }
+    return unescaped;
+  }
+
+  string formattedTime(double seconds) {
+    char buffer[32];
+    sprintf(buffer, "%.6e", seconds);
+    return buffer;
+  }
+}
+
+void Benchmark::setName(const string &name) {
+  _name = name;
+}
+
+void Benchmark::setParameter(const string &parameterName, const string &value) {
+  _parameters[parameterName] = value;
+}
+
+void Benchmark::setParameter(const string &parameterName, int value) {
+  ostringstream valueStream;
+  valueStream << value;
+  _parameters[parameterName] = valueStream.str();
+}
+
+const string & Benchmark::name() const {
+  return _name;
+}
+
+const map<string, string> & Benchmark::parameters() const {
+  return _parameters;
+}
+
+BenchmarkRunner::BenchmarkRunner(int minRepetitions, double minTotalTime, const string &filter) {
+  _minRepetitions = minRepetitions;
+  _minTotalTime = minTotalTime;
+  _filter = filter;
+}
+
+vector<BenchmarkResult> BenchmarkRunner::run(vector<BenchmarkPtr> &benchmarks, bool printProgress) {
+  static const int MAX_REPETITIONS = 100;
+  int rank = Teuchos::GlobalMPISession::getRank();
+
+  vector<BenchmarkResult> results;
+  for (int benchmarkOrdinal=0; benchmarkOrdinal<benchmarks.size(); benchmarkOrdinal++) {
+    BenchmarkPtr benchmark = benchmarks[benchmarkOrdinal];
+    if (benchmark->name().find(_filter) == string::npos) continue;
+
+    if (printProgress && (rank==0)) cout << benchmark->name() << "... " << flush;
+
+    benchmark->initialize();
+    benchmark->setUp();
+    benchmark->run(); // warm-up: fills caches, and pages in the code
+
+    vector<double> times;
+    double totalTime = 0.0;
+    while ((times.size() < _minRepetitions) || ((totalTime < _minTotalTime) && (times.size() < MAX_REPETITIONS))) {
+      benchmark->setUp();
+      double startTime = Teuchos::Time::wallTime();
+      benchmark->run();
+      double localTime = Teuchos::Time::wallTime() - startTime;
+      // the slowest rank determines the time; this also keeps the ranks in step
+      double time = PhaseTimers::timeStatistics(localTime).max;
+      times.push_back(time);
+      totalTime += time;
+    }
+    benchmark->finalize();
+
+    BenchmarkResult result;
+    result.name = benchmark->name();
+    result.parameters = benchmark->parameters();
+    result.repetitions = times.size();
+    std::sort(times.begin(), times.end());
+    result.minTime = times[0];
+    result.medianTime = (times.size() % 2 == 1) ? times[times.size() / 2]
+                                                : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+    result.meanTime = totalTime / times.size();
+    results.push_back(result);
+
+    if (printProgress && (rank==0)) cout << formattedTime(result.medianTime) << " s (median of " << result.repetitions << ")\n";
+  }
+  std::sort(results.begin(), results.end(), resultNameLessThan);
+  return results;
+}
+
+void BenchmarkRunner::writeJSON(const string &filePath, const vector<BenchmarkResult> &results) {
+  ofstream fout(filePath.c_str());
+  TEUCHOS_TEST_FOR_EXCEPTION(!fout.good(), std::invalid_argument, "could not open benchmark output file");
+  fout << "{\n";
+  fout << "  \"format\": \"camellia-benchmarks-1\",\n";
+  fout << "  \"ranks\": " << Teuchos::GlobalMPISession::getNProc() << ",\n";
+  fout << "  \"benchmarks\": [\n";
+  for (int i=0; i<results.size(); i++) {
+    const BenchmarkResult* result = &results[i];
+    fout << "    {\"name\": \"" << jsonEscaped(result->name) << "\", \"parameters\": {";
+    for (map<string,string>::const_iterator paramIt = result->parameters.begin(); paramIt != result->parameters.end(); paramIt++) {
+      if (paramIt != result->parameters.begin()) fout << ", ";
+      fout << "\"" << jsonEscaped(paramIt->first) << "\": \"" << jsonEscaped(paramIt->second) << "\"";
+    }
+    fout << "}, \"repetitions\": " << result->repetitions;
+    fout << ", \"min\": " << formattedTime(result->minTime);
+    fout << ", \"median\": " << formattedTime(result->medianTime);
+    fout << ", \"mean\": " << formattedTime(result->meanTime) << "}";
+    if (i + 1 < results.size()) fout << ",";
+    fout << "\n";
+  }
+  fout << "  ]\n";
+  fout << "}\n";
+}
+
+map<string, double> BenchmarkRunner::readBaselineMedians(const string &filePath) {
+  // not a general JSON parser: relies on writeJSON()'s one-result-per-line layout
+  ifstream fin(filePath.c_str());
+  TEUCHOS_TEST_FOR_EXCEPTION(!fin.good(), std::invalid_argument, "could not open benchmark baseline file");
+
+  map<string, double> medians;
+  string nameKey = "{\"name\": \"", medianKey = "\"median\": ";
+  string line;
+  while (getline(fin, line)) {
+    size_t nameStart = line.find(nameKey);
+    size_t medianStart = line.find(medianKey);
+    if ((nameStart == string::npos) || (medianStart == string::npos)) continue;
+    nameStart += nameKey.size();
+    size_t nameEnd = nameStart;
+    while ((nameEnd < line.size()) && (line[nameEnd] != '"')) {
+      if (line[nameEnd] == '\\') nameEnd++;
+      nameEnd++;
+    }
+    string name = jsonUnescaped(line.substr(nameStart, nameEnd - nameStart));
+    medians[name] = atof(line.c_str() + medianStart + medianKey.size());
+  }
+  return medians;
+}
+
+int BenchmarkRunner::compareToBaseline(const vector<BenchmarkResult> &results, const map<string, double> &baseline,
+                                       double tolerance) {
+  int rank = Teuchos::GlobalMPISession::getRank();
+  int regressionCount = 0;
+  for (int i=0; i<results.size(); i++) {
+    map<string, double>::const_iterator baselineIt = baseline.find(results[i].name);
+    if (baselineIt == baseline.end()) {
+      if (rank==0) cout << "(new)       " << results[i].name << endl;
+      continue;
+    }
+    double ratio = (baselineIt->second > 0.0) ? results[i].medianTime / baselineIt->second : 1.0;
+    bool isRegression = (ratio > 1.0 + tolerance);
+    if (isRegression) regressionCount++;
+    if (rank==0) {
+      char ratioString[32];
+      sprintf(ratioString, "%6.3f", ratio);
+      cout << (isRegression ? "REGRESSION " : "           ") << ratioString << "x  " << results[i].name << endl;
+    }
+  }
+  return regressionCount;
+}
@@ -0,0 +1,150 @@
+//
+//  MacroBenchmarks.cpp
+//  Camellia
+//
+//  Whole-solve benchmarks, on problems small enough to run in a few seconds on a single rank.
+//
+
+#include "Benchmark.h"
+
+#include "MeshFactory.h"
+#include "NavierStokesVGPFormulation.h"
+#include "PoissonFormulation.h"
+#include "Solution.h"
+#include "StokesVGPFormulation.h"
+
+#include <sstream>
+
+using namespace Camellia;
+using namespace std;
+
+namespace {
+  class PoissonSolveBenchmark : public Benchmark {
+    int _spaceDim;
+    int _elementsPerSide;
+    int _k;
+    SolutionPtr _solution;
+  public:
+    PoissonSolveBenchmark(int spaceDim, int elementsPerSide, int k) {
+      _spaceDim = spaceDim;
+      _elementsPerSide = elementsPerSide;
+      _k = k;
+      ostringstream name;
+      name << "Solve/Poisson/" << ((spaceDim == 2) ? "quad" : "hexahedron") << "/k=" << k;
+      setName(name.str());
+      setParameter("spaceDim", spaceDim);
+      setParameter("elementsPerSide", elementsPerSide);
+      setParameter("k", k);
+    }
+    void initialize() {
+      bool useConformingTraces = true;
+      PoissonFormulation form(_spaceDim, useConformingTraces);
+      BFPtr bf = form.bf();
+
+      int H1Order = _k + 1, delta_k = _spaceDim;
+      vector<double> dimensions(_spaceDim,1.0);
+      vector<int> elementCounts(_spaceDim,_elementsPerSide);
+      MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+
+      RHSPtr rhs = RHS::rhs();
+      rhs->addTerm(1.0 * form.q());
+      BCPtr bc = BC::bc();
+      bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), Function::zero());
+      _solution = Solution::solution(mesh, bc, rhs, bf->graphNorm());
+    }
+    void run() {
+      _solution->solve();
+    }
+    void finalize() {
+      _solution = Teuchos::null;
+    }
+  };
+
+  // lid-driven cavity: unit square, u = (1,0) on the lid
+  class StokesCavityBenchmark : public Benchmark {
+    int _elementsPerSide;
+    int _k;
+    Teuchos::RCP<StokesVGPFormulation> _form;
+  public:
+    StokesCavityBenchmark(int elementsPerSide, int k) {
+      _elementsPerSide = elementsPerSide;
+      _k = k;
+      ostringstream name;
+      name << "Solve/StokesCavity/quad/k=" << k;
+      setName(name.str());
+      setParameter("spaceDim", 2);
+      setParameter("elementsPerSide", elementsPerSide);
+      setParameter("k", k);
+    }
+    void initialize() {
+      int spaceDim = 2;
+      bool useConformingTraces = false;
+      double mu = 1.0;
+      _form = Teuchos::rcp( new StokesVGPFormulation(spaceDim, useConformingTraces, mu) );
+
+      MeshTopologyPtr meshTopo = MeshFactory::quadMeshTopology(1.0, 1.0, _elementsPerSide, _elementsPerSide);
+      int delta_k = spaceDim;
+      _form->initializeSolution(meshTopo, _k, delta_k);
+
+      SpatialFilterPtr lid = SpatialFilter::matchingY(1.0);
+      _form->addZeroMeanPressureCondition();
+      _form->addWallCondition(SpatialFilter::negatedFilter(lid));
+      _form->addInflowCondition(lid, Function::vectorize(Function::constant(1.0), Function::zero()));
+    }
+    void run() {
+      _form->solve();
+    }
+    void finalize() {
+      _form = Teuchos::null;
+    }
+  };
+
+  // the same cavity, a fixed number of Newton steps from a zero initial guess
+  class NavierStokesCavityBenchmark : public Benchmark {
+    int _elementsPerSide;
+    int _k;
+    int _newtonSteps;
+    double _Re;
+    Teuchos::RCP<NavierStokesVGPFormulation> _form;
+  public:
+    NavierStokesCavityBenchmark(int elementsPerSide, int k, int newtonSteps, double Re) {
+      _elementsPerSide = elementsPerSide;
+      _k = k;
+      _newtonSteps = newtonSteps;
+      _Re = Re;
+      ostringstream name;
+      name << "Solve/NavierStokesCavity/quad/k=" << k;
+      setName(name.str());
+      setParameter("spaceDim", 2);
+      setParameter("elementsPerSide", elementsPerSide);
+      setParameter("k", k);
+      setParameter("newtonSteps", newtonSteps);
+      setParameter("Re", (int) Re);
+    }
+    void setUp() {
+      // Newton steps accumulate into the background flow, so each repetition starts afresh
+      MeshTopologyPtr meshTopo = MeshFactory::quadMeshTopology(1.0, 1.0, _elementsPerSide, _elementsPerSide);
+      _form = Teuchos::rcp( new NavierStokesVGPFormulation(meshTopo, _Re, _k) );
+
+      SpatialFilterPtr lid = SpatialFilter::matchingY(1.0);
+      _form->addZeroMeanPressureCondition();
+      _form->addWallCondition(SpatialFilter::negatedFilter(lid));
+      _form->addInflowCondition(lid, Function::vectorize(Function::constant(1.0), Function::zero()));
+    }
+    void run() {
+      for (int stepNumber=0; stepNumber<_newtonSteps; stepNumber++) {
+        _form->solveAndAccumulate();
+      }
+    }
+    void finalize() {
+      _form = Teuchos::null;
+    }
+  };
+}
+
+void addMacroBenchmarks(vector<BenchmarkPtr> &benchmarks) {
+  benchmarks.push_back(Teuchos::rcp( new PoissonSolveBenchmark(2, 8, 2) ));
+  benchmarks.push_back(Teuchos::rcp( new PoissonSolveBenchmark(3, 4, 2) ));
+  benchmarks.push_back(Teuchos::rcp( new StokesCavityBenchmark(4, 2) ));
+  benchmarks.push_back(Teuchos::rcp( new NavierStokesCavityBenchmark(2, 3, 3, 1000.0) ));
+}
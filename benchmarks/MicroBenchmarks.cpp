@@ -0,0 +1,374 @@
+//
+//  MicroBenchmarks.cpp
+//  Camellia
+//
+//  Kernel-level benchmarks, each swept over topology (and so spatial dimension) and field polynomial order k.
+//
+
+#include "Benchmark.h"
+
+#include "BasisCache.h"
+#include "BasisEvaluation.h"
+#include "BasisFactory.h"
+#include "CellTopology.h"
+#include "CubatureFactory.h"
+#include "GDAMinimumRule.h"
+#include "MeshFactory.h"
+#include "MeshTopology.h"
+#include "PoissonFormulation.h"
+#include "RefinementPattern.h"
+
+#include "Teuchos_GlobalMPISession.hpp"
+
+#include <sstream>
+
+using namespace Intrepid;
+using namespace Camellia;
+using namespace std;
+
+namespace {
+  // the topologies we sweep over; triangles are produced by dividing quads
+  const char* TOPOLOGY_NAMES[] = {"line", "quad", "triangle", "hexahedron"};
+  const int NUM_TOPOLOGIES = 4;
+
+  int spaceDimForTopology(const string &topology) {
+    if (topology == "line") return 1;
+    if (topology == "hexahedron") return 3;
+    return 2;
+  }
+
+  int maxKForTopology(const string &topology) {
+    return (spaceDimForTopology(topology) == 3) ? 3 : 4;
+  }
+
+  CellTopoPtr cellTopology(const string &topology) {
+    if (topology == "line") return CellTopology::line();
+    if (topology == "quad") return CellTopology::quad();
+    if (topology == "triangle") return CellTopology::triangle();
+    if (topology == "hexahedron") return CellTopology::hexahedron();
+    TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "unknown topology");
+    return Teuchos::null;
+  }
+
+  // 16 cells in 1D, 16 quads or 32 triangles in 2D, 8 hexahedra in 3D
+  MeshTopologyPtr benchmarkMeshTopology(const string &topology) {
+    if (topology == "line") return MeshFactory::intervalMeshTopology(0.0, 1.0, 16);
+    if (topology == "triangle") return MeshFactory::quadMeshTopology(1.0, 1.0, 4, 4, true);
+    int spaceDim = spaceDimForTopology(topology);
+    vector<double> dimensions(spaceDim, 1.0);
+    vector<int> elementCounts(spaceDim, (spaceDim == 3) ? 2 : 4);
+    return MeshFactory::rectilinearMeshTopology(dimensions, elementCounts);
+  }
+
+  string benchmarkName(const string &kernel, const string &topology, int k) {
+    ostringstream name;
+    name << kernel << "/" << topology;
+    if (k > 0) name << "/k=" << k;
+    return name.str();
+  }
+
+  // Poisson, in its ultraweak formulation with the graph norm, on the rank-local cells of the first element type
+  struct PoissonFixture {
+    Teuchos::RCP<PoissonFormulation> form;
+    BFPtr bf;
+    IPPtr ip;
+    MeshPtr mesh;
+    ElementTypePtr elemType;
+    vector<GlobalIndexType> cellIDs;
+    FieldContainer<double> physicalCellNodes;
+    FieldContainer<double> cellSideParities;
+
+    void initialize(const string &topology, int k) {
+      int spaceDim = spaceDimForTopology(topology);
+      bool useConformingTraces = true;
+      form = Teuchos::rcp( new PoissonFormulation(spaceDim, useConformingTraces) );
+      bf = form->bf();
+      ip = bf->graphNorm();
+      int H1Order = k + 1, delta_k = spaceDim;
+      mesh = Teuchos::rcp( new Mesh(benchmarkMeshTopology(topology), bf, H1Order, delta_k) );
+
+      int rank = Teuchos::GlobalMPISession::getRank();
+      vector<ElementTypePtr> elementTypes = mesh->elementTypes(rank);
+      if (elementTypes.size() == 0) return; // no cells on this rank
+      elemType = elementTypes[0];
+      cellIDs = mesh->cellIDsOfType(rank, elemType);
+      physicalCellNodes = mesh->physicalCellNodes(elemType);
+      cellSideParities = mesh->cellSideParities(elemType);
+    }
+
+    bool hasCells() {
+      return cellIDs.size() > 0;
+    }
+
+    BasisCachePtr basisCache(bool testVsTest) {
+      BasisCachePtr basisCache = Teuchos::rcp( new BasisCache(elemType, mesh, testVsTest) );
+      bool createSideCache = true;
+      basisCache->setPhysicalCellNodes(physicalCellNodes, cellIDs, createSideCache);
+      basisCache->setCellSideParities(cellSideParities);
+      return basisCache;
+    }
+
+    void clear() {
+      form = Teuchos::null;
+      bf = Teuchos::null;
+      ip = Teuchos::null;
+      mesh = Teuchos::null;
+      elemType = Teuchos::null;
+      cellIDs.clear();
+      physicalCellNodes.resize(0);
+      cellSideParities.resize(0);
+    }
+  };
+
+  class BasisCacheSetupBenchmark : public Benchmark {
+    string _topology;
+    int _k;
+    PoissonFixture _fixture;
+  public:
+    BasisCacheSetupBenchmark(const string &topology, int k) {
+      _topology = topology;
+      _k = k;
+      setName(benchmarkName("BasisCache::setPhysicalCellNodes", topology, k));
+      setParameter("topology", topology);
+      setParameter("spaceDim", spaceDimForTopology(topology));
+      setParameter("k", k);
+    }
+    void initialize() {
+      _fixture.initialize(_topology, _k);
+    }
+    void run() {
+      if (!_fixture.hasCells()) return;
+      bool testVsTest = false;
+      _fixture.basisCache(testVsTest);
+    }
+    void finalize() {
+      _fixture.clear();
+    }
+  };
+
+  class BasisEvaluationBenchmark : public Benchmark {
+    string _topology;
+    int _k;
+    BasisPtr _basis;
+    FieldContainer<double> _points;
+  public:
+    BasisEvaluationBenchmark(const string &topology, int k) {
+      _topology = topology;
+      _k = k;
+      setName(benchmarkName("BasisEvaluation::getValues", topology, k));
+      setParameter("topology", topology);
+      setParameter("spaceDim", spaceDimForTopology(topology));
+      setParameter("k", k);
+    }
+    void initialize() {
+      CellTopoPtr cellTopo = cellTopology(_topology);
+      int H1Order = _k + 1;
+      _basis = BasisFactory::basisFactory()->getBasis(H1Order, cellTopo, Camellia::FUNCTION_SPACE_HGRAD);
+
+      CubatureFactory cubFactory;
+      Teuchos::RCP<Cubature<double> > cubature = cubFactory.create(cellTopo, 2 * H1Order);
+      FieldContainer<double> weights(cubature->getNumPoints());
+      _points.resize(cubature->getNumPoints(), cubature->getDimension());
+      cubature->getCubature(_points, weights);
+    }
+    void run() {
+      BasisEvaluation::getValues(_basis, Camellia::OP_VALUE, _points);
+      BasisEvaluation::getValues(_basis, Camellia::OP_GRAD, _points);
+    }
+    void finalize() {
+      _basis = Teuchos::null;
+      _points.resize(0);
+    }
+  };
+
+  class InnerProductMatrixBenchmark : public Benchmark {
+    string _topology;
+    int _k;
+    PoissonFixture _fixture;
+    BasisCachePtr _ipBasisCache;
+    FieldContainer<double> _ipMatrix;
+  public:
+    InnerProductMatrixBenchmark(const string &topology, int k) {
+      _topology = topology;
+      _k = k;
+      setName(benchmarkName("IP::computeInnerProductMatrix", topology, k));
+      setParameter("topology", topology);
+      setParameter("spaceDim", spaceDimForTopology(topology));
+      setParameter("k", k);
+    }
+    void initialize() {
+      _fixture.initialize(_topology, _k);
+      if (!_fixture.hasCells()) return;
+      bool testVsTest = true;
+      _ipBasisCache = _fixture.basisCache(testVsTest);
+      int numTestDofs = _fixture.elemType->testOrderPtr->totalDofs();
+      _ipMatrix.resize(_fixture.cellIDs.size(), numTestDofs, numTestDofs);
+    }
+    void run() {
+      if (!_fixture.hasCells()) return;
+      _fixture.ip->computeInnerProductMatrix(_ipMatrix, _fixture.elemType->testOrderPtr, _ipBasisCache);
+    }
+    void finalize() {
+      _ipBasisCache = Teuchos::null;
+      _ipMatrix.resize(0);
+      _fixture.clear();
+    }
+  };
+
+  class OptimalTestWeightsBenchmark : public Benchmark {
+    string _topology;
+    int _k;
+    PoissonFixture _fixture;
+    BasisCachePtr _basisCache;
+    FieldContainer<double> _ipMatrix, _ipMatrixCopy; // the solve may overwrite its copy
+    FieldContainer<double> _optimalTestWeights;
+  public:
+    OptimalTestWeightsBenchmark(const string &topology, int k) {
+      _topology = topology;
+      _k = k;
+      setName(benchmarkName("BF::optimalTestWeights", topology, k));
+      setParameter("topology", topology);
+      setParameter("spaceDim", spaceDimForTopology(topology));
+      setParameter("k", k);
+    }
+    void initialize() {
+      _fixture.initialize(_topology, _k);
+      if (!_fixture.hasCells()) return;
+      _basisCache = _fixture.basisCache(false);
+      BasisCachePtr ipBasisCache = _fixture.basisCache(true);
+      int numCells = _fixture.cellIDs.size();
+      int numTestDofs = _fixture.elemType->testOrderPtr->totalDofs();
+      int numTrialDofs = _fixture.elemType->trialOrderPtr->totalDofs();
+      _ipMatrix.resize(numCells, numTestDofs, numTestDofs);
+      _fixture.ip->computeInnerProductMatrix(_ipMatrix, _fixture.elemType->testOrderPtr, ipBasisCache);
+      _optimalTestWeights.resize(numCells, numTrialDofs, numTestDofs);
+    }
+    void setUp() {
+      _ipMatrixCopy = _ipMatrix;
+    }
+    void run() {
+      if (!_fixture.hasCells()) return;
+      _fixture.bf->optimalTestWeights(_optimalTestWeights, _ipMatrixCopy, _fixture.elemType, _fixture.cellSideParities, _basisCache);
+    }
+    void finalize() {
+      _basisCache = Teuchos::null;
+      _ipMatrix.resize(0);
+      _ipMatrixCopy.resize(0);
+      _optimalTestWeights.resize(0);
+      _fixture.clear();
+    }
+  };
+
+  class LocalDofMapperBenchmark : public Benchmark {
+    string _topology;
+    int _k;
+    PoissonFixture _fixture;
+    vector<LocalDofMapperPtr> _dofMappers;
+    FieldContainer<double> _localData;
+  public:
+    LocalDofMapperBenchmark(const string &topology, int k) {
+      _topology = topology;
+      _k = k;
+      setName(benchmarkName("LocalDofMapper::mapLocalData", topology, k));
+      setParameter("topology", topology);
+      setParameter("spaceDim", spaceDimForTopology(topology));
+      setParameter("k", k);
+    }
+    void initialize() {
+      _fixture.initialize(_topology, _k);
+      if (!_fixture.hasCells()) return;
+      GDAMinimumRule* gda = dynamic_cast<GDAMinimumRule*>(_fixture.mesh->globalDofAssignment().get());
+      for (int cellOrdinal=0; cellOrdinal<_fixture.cellIDs.size(); cellOrdinal++) {
+        CellConstraints constraints = gda->getCellConstraints(_fixture.cellIDs[cellOrdinal]);
+        _dofMappers.push_back(gda->getDofMapper(_fixture.cellIDs[cellOrdinal], constraints));
+      }
+      _localData.resize(_fixture.elemType->trialOrderPtr->totalDofs());
+      _localData.initialize(1.0);
+    }
+    void run() {
+      bool fittableGlobalDofsOnly = false;
+      for (int cellOrdinal=0; cellOrdinal<_dofMappers.size(); cellOrdinal++) {
+        _dofMappers[cellOrdinal]->mapLocalData(_localData, fittableGlobalDofsOnly);
+      }
+    }
+    void finalize() {
+      _dofMappers.clear();
+      _localData.resize(0);
+      _fixture.clear();
+    }
+  };
+
+  class RefineCellBenchmark : public Benchmark {
+    string _topology;
+    MeshTopologyPtr _meshTopology;
+  public:
+    RefineCellBenchmark(const string &topology) {
+      _topology = topology;
+      setName(benchmarkName("MeshTopology::refineCell", topology, 0));
+      setParameter("topology", topology);
+      setParameter("spaceDim", spaceDimForTopology(topology));
+    }
+    void setUp() {
+      _meshTopology = benchmarkMeshTopology(_topology); // refinement changes the topology, so each repetition starts afresh
+    }
+    void run() {
+      // two levels of uniform refinement
+      for (int refinementNumber=0; refinementNumber<2; refinementNumber++) {
+        set<IndexType> activeCellIndices = _meshTopology->getActiveCellIndices(); // copy: refineCell() changes the active cells
+        for (set<IndexType>::iterator cellIt = activeCellIndices.begin(); cellIt != activeCellIndices.end(); cellIt++) {
+          CellTopoPtr cellTopo = _meshTopology->getCell(*cellIt)->topology();
+          _meshTopology->refineCell(*cellIt, RefinementPattern::regularRefinementPattern(cellTopo));
+        }
+      }
+    }
+    void finalize() {
+      _meshTopology = Teuchos::null;
+    }
+  };
+
+  class RebuildLookupsBenchmark : public Benchmark {
+    string _topology;
+    int _k;
+    PoissonFixture _fixture;
+  public:
+    RebuildLookupsBenchmark(const string &topology, int k) {
+      _topology = topology;
+      _k = k;
+      setName(benchmarkName("GDAMinimumRule::rebuildLookups", topology, k));
+      setParameter("topology", topology);
+      setParameter("spaceDim", spaceDimForTopology(topology));
+      setParameter("k", k);
+    }
+    void initialize() {
+      _fixture.initialize(_topology, _k);
+      // refine once, so that the lookups include constraints from hanging nodes
+      set<GlobalIndexType> cellIDs;
+      if (_fixture.mesh->getActiveCellIDs().size() > 0) cellIDs.insert(*_fixture.mesh->getActiveCellIDs().begin());
+      _fixture.mesh->hRefine(cellIDs);
+    }
+    void run() {
+      GDAMinimumRule* gda = dynamic_cast<GDAMinimumRule*>(_fixture.mesh->globalDofAssignment().get());
+      // with nothing changed since the last rebuild, an incremental rebuild would reuse every cached lookup
+      gda->requireFullRebuild();
+      gda->rebuildLookups(); // collective
+    }
+    void finalize() {
+      _fixture.clear();
+    }
+  };
+}
+
+void addMicroBenchmarks(vector<BenchmarkPtr> &benchmarks) {
+  for (int topologyOrdinal=0; topologyOrdinal<NUM_TOPOLOGIES; topologyOrdinal++) {
+    string topology = TOPOLOGY_NAMES[topologyOrdinal];
+    for (int k=1; k<=maxKForTopology(topology); k++) {
+      benchmarks.push_back(Teuchos::rcp( new BasisCacheSetupBenchmark(topology, k) ));
+      benchmarks.push_back(Teuchos::rcp( new BasisEvaluationBenchmark(topology, k) ));
+      benchmarks.push_back(Teuchos::rcp( new InnerProductMatrixBenchmark(topology, k) ));
+      benchmarks.push_back(Teuchos::rcp( new OptimalTestWeightsBenchmark(topology, k) ));
+      benchmarks.push_back(Teuchos::rcp( new LocalDofMapperBenchmark(topology, k) ));
+      benchmarks.push_back(Teuchos::rcp( new RebuildLookupsBenchmark(topology, k) ));
+    }
+    benchmarks.push_back(Teuchos::rcp( new RefineCellBenchmark(topology) ));
+  }
+}
@@ -0,0 +1,69 @@
+//
+//  runBenchmarks.cpp
+//  Camellia
+//
+//  Runs the micro- and macro-benchmarks, writes their timings to a JSON file, and optionally compares against
+//  a baseline written by an earlier run.  Returns nonzero if any benchmark regressed beyond the tolerance.
+//
+
+#include "Benchmark.h"
+
+#include "Teuchos_CommandLineProcessor.hpp"
+#include "Teuchos_GlobalMPISession.hpp"
+
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+  Teuchos::GlobalMPISession mpiSession(&argc, &argv, NULL); // NULL: don't print startup info
+  int rank = Teuchos::GlobalMPISession::getRank();
+
+  string filter = "";
+  string outputFile = "benchmark_results.json";
+  string baselineFile = "";
+  double tolerance = 0.10;
+  int minRepetitions = 5;
+  double minTime = 1.0;
+  bool runMicro = true, runMacro = true;
+
+  Teuchos::CommandLineProcessor cmdp(false,true); // false: don't throw exceptions; true: do return errors for unrecognized options
+
+  cmdp.setOption("filter", &filter, "run only benchmarks whose name contains this string");
+  cmdp.setOption("output", &outputFile, "file to write the JSON results to");
+  cmdp.setOption("baseline", &baselineFile, "JSON results from an earlier run to compare against");
+  cmdp.setOption("tolerance", &tolerance, "relative slowdown in median time that counts as a regression");
+  cmdp.setOption("minRepetitions", &minRepetitions, "minimum number of timed repetitions per benchmark");
+  cmdp.setOption("minTime", &minTime, "minimum total timed seconds per benchmark (up to 100 repetitions)");
+  cmdp.setOption("micro", "noMicro", &runMicro, "run the kernel benchmarks");
+  cmdp.setOption("macro", "noMacro", &runMacro, "run the whole-solve benchmarks");
+
+  if (cmdp.parse(argc,argv) != Teuchos::CommandLineProcessor::PARSE_SUCCESSFUL) {
+#ifdef HAVE_MPI
+    MPI_Finalize();
+#endif
+    return -1;
+  }
+
+  vector<BenchmarkPtr> benchmarks;
+  if (runMicro) addMicroBenchmarks(benchmarks);
+  if (runMacro) addMacroBenchmarks(benchmarks);
+
+  BenchmarkRunner runner(minRepetitions, minTime, filter);
+  bool printProgress = true;
+  vector<BenchmarkResult> results = runner.run(benchmarks, printProgress);
+
+  if (rank==0) {
+    BenchmarkRunner::writeJSON(outputFile, results);
+    cout << "Wrote " << results.size() << " benchmark results to " << outputFile << endl;
+  }
+
+  int regressionCount = 0;
+  if (baselineFile != "") {
+    map<string, double> baseline = BenchmarkRunner::readBaselineMedians(baselineFile);
+    regressionCount = BenchmarkRunner::compareToBaseline(results, baseline, tolerance);
+    if (rank==0) cout << regressionCount << " regression(s) relative to " << baselineFile << endl;
+  }
+
+  return (regressionCount > 0) ? 1 : 0;
+}
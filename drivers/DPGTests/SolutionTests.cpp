@@ -364,20 +364,20 @@ void SolutionTests::runTests(int &numTestsRun, int &numTestsPassed) {
 }
 
 bool SolutionTests::storageSizesAgree(Teuchos::RCP< Solution > soln1, Teuchos::RCP< Solution > soln2) {
-  const map< GlobalIndexType, FieldContainer<double> >* solnMap1 = &(soln1->solutionForCellIDGlobal());
-  const map< GlobalIndexType, FieldContainer<double> >* solnMap2 = &(soln2->solutionForCellIDGlobal());
-  if (solnMap1->size() != solnMap2->size() ) {
+  const CellCoefficientStore* solnStore1 = &(soln1->solutionForCellIDGlobal());
+  const CellCoefficientStore* solnStore2 = &(soln2->solutionForCellIDGlobal());
+  vector<GlobalIndexType> cellIDs1 = solnStore1->cellIDs();
+  vector<GlobalIndexType> cellIDs2 = solnStore2->cellIDs();
+  if (cellIDs1.size() != cellIDs2.size() ) {
     cout << "SOLUTION 1 entries: ";
-    for(map< GlobalIndexType, FieldContainer<double> >::const_iterator soln1It = (*solnMap1).begin();
-        soln1It != (*solnMap1).end(); soln1It++) {
-      int cellID = soln1It->first;
+    for(vector<GlobalIndexType>::iterator cellIDIt = cellIDs1.begin(); cellIDIt != cellIDs1.end(); cellIDIt++) {
+      int cellID = *cellIDIt;
       cout << cellID << " ";
     }
     cout << endl;
     cout << "SOLUTION 2 entries: ";
-    for(map< GlobalIndexType, FieldContainer<double> >::const_iterator soln2It = (*solnMap2).begin();
-        soln2It != (*solnMap2).end(); soln2It++) {
-      int cellID = soln2It->first;
+    for(vector<GlobalIndexType>::iterator cellIDIt = cellIDs2.begin(); cellIDIt != cellIDs2.end(); cellIDIt++) {
+      int cellID = *cellIDIt;
       cout << cellID << " ";
     }
     cout << endl;
@@ -391,15 +391,13 @@ bool SolutionTests::storageSizesAgree(Teuchos::RCP< Solution > soln1, Teuchos::R
     
     return false;
   }
-  for(map< GlobalIndexType, FieldContainer<double> >::const_iterator soln1It = (*solnMap1).begin();
-      soln1It != (*solnMap1).end(); soln1It++) {
-    GlobalIndexType cellID = soln1It->first;
-    int size = soln1It->second.size();
-    map< GlobalIndexType, FieldContainer<double> >::const_iterator soln2It = (*solnMap2).find(cellID);
-    if (soln2It == (*solnMap2).end()) {
+  for(vector<GlobalIndexType>::iterator cellIDIt = cellIDs1.begin(); cellIDIt != cellIDs1.end(); cellIDIt++) {
+    GlobalIndexType cellID = *cellIDIt;
+    int size = solnStore1->coefficients(cellID).size();
+    if (! solnStore2->hasCoefficients(cellID)) {
       return false;
     }
-    if ((soln2It->second).size() != size) {
+    if (solnStore2->coefficients(cellID).size() != size) {
       return false;
     }
   }
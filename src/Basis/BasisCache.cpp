@@ -48,6 +48,7 @@
 #include "SerialDenseWrapper.h"
 
 #include "CubatureFactory.h"
+#include "ReferenceValueCache.h"
 
 #include "Teuchos_GlobalMPISession.hpp"
 
@@ -117,22 +118,10 @@ void BasisCache::init(bool createSideCacheToo, bool tensorProductTopologyMeansSp
     _spaceDim = _spaceDim - 1;
   }
   _isSideCache = false; // VOLUME constructor
+  _cellsAreAffine = false;
   
   if (_cellTopo->getDimension() > 0) {
-    CubatureFactory cubFactory;
-    Teuchos::RCP<Cubature<double> > cellTopoCub;
-    if (_cubDegree >= 0)
-      cellTopoCub = cubFactory.create(_cellTopo, _cubDegree);
-    else
-      cellTopoCub = cubFactory.create(_cellTopo, _cubDegrees);
-    
-    int cubDim       = cellTopoCub->getDimension();
-    int numCubPoints = cellTopoCub->getNumPoints();
-    
-    _cubPoints = FieldContainer<double>(numCubPoints, cubDim);
-    _cubWeights.resize(numCubPoints);
-    
-    cellTopoCub->getCubature(_cubPoints, _cubWeights);
+    ReferenceValueCache::referenceValueCache()->getCubature(_cellTopo, _cubDegree, _cubDegrees, _cubPoints, _cubWeights);
   } else {
     _cubDegree = 1;
     int numCubPointsSide = 1;
@@ -148,6 +137,8 @@ void BasisCache::init(bool createSideCacheToo, bool tensorProductTopologyMeansSp
   _cubaturePhaseCount = 1;
   _phasePointOrdinalOffsets.push_back(0);
   
+  _referencePointsAreStandard = true;
+  
   // now, create side caches
   if ( createSideCacheToo ) {
     createSideCaches();
@@ -287,11 +278,13 @@ BasisCache::BasisCache(int fakeSideOrdinal, BasisCachePtr volumeCache, const Fie
                        const FieldContainer<double> &sideNormals, const FieldContainer<double> &cellSideParities) {
   _cellTopo = volumeCache->cellTopology(); // VOLUME cell topo.
   _isSideCache = true;
+  _cellsAreAffine = false;
   _sideIndex = fakeSideOrdinal;
   _basisCacheVolume = volumeCache;
   _spaceDim = _cellTopo->getDimension();
   
   _cubPoints.resize(0); // force an exception if true side reference points are ever accessed in fake side BasisCache
+  _referencePointsAreStandard = false;
 
   int numCells = volumeCache->getPhysicalCubaturePoints().dimension(0);
   int numPoints = volumeRefPoints.dimension(0);
@@ -319,6 +312,7 @@ BasisCache::BasisCache(int fakeSideOrdinal, BasisCachePtr volumeCache, const Fie
 BasisCache::BasisCache(int sideIndex, BasisCachePtr volumeCache, int trialDegree, int testDegree, BasisPtr multiBasisIfAny) {
   _cellTopo = volumeCache->cellTopology(); // VOLUME cell topo.
   _isSideCache = true;
+  _cellsAreAffine = false;
   _sideIndex = sideIndex;
   _basisCacheVolume = volumeCache;
   _maxTestDegree = testDegree;
@@ -336,25 +330,31 @@ BasisCache::BasisCache(int sideIndex, BasisCachePtr volumeCache, int trialDegree
   initCubatureDegree(trialDegree, testDegree);
   
   if (sideDim > 0) {
-    CubatureFactory cubFactory;
-    Teuchos::RCP<Cubature<double> > sideCub;
-    if (_cubDegree >= 0)
-      sideCub = cubFactory.create(side, _cubDegree);
-    else
-      sideCub = cubFactory.create(side, _cubDegrees);
-    
-    int numCubPointsSide = sideCub->getNumPoints();
-    _cubPoints.resize(numCubPointsSide, sideDim); // cubature points from the pov of the side (i.e. a (d-1)-dimensional set)
-    _cubWeights.resize(numCubPointsSide);
+    int numCubPointsSide;
     if ( multiBasisIfAny.get() == NULL ) {
-      sideCub->getCubature(_cubPoints, _cubWeights);
+      // cubature points from the pov of the side (i.e. a (d-1)-dimensional set)
+      ReferenceValueCache::referenceValueCache()->getCubature(side, _cubDegree, _cubDegrees, _cubPoints, _cubWeights);
+      numCubPointsSide = _cubPoints.dimension(0);
+      _referencePointsAreStandard = true;
     } else {
+      CubatureFactory cubFactory;
+      Teuchos::RCP<Cubature<double> > sideCub;
+      if (_cubDegree >= 0)
+        sideCub = cubFactory.create(side, _cubDegree);
+      else
+        sideCub = cubFactory.create(side, _cubDegrees);
+      
+      numCubPointsSide = sideCub->getNumPoints();
+      _cubPoints.resize(numCubPointsSide, sideDim); // cubature points from the pov of the side (i.e. a (d-1)-dimensional set)
+      _cubWeights.resize(numCubPointsSide);
+      
       MultiBasis<>* multiBasis = (MultiBasis<>*) multiBasisIfAny.get();
       
       int cubatureEnrichment = (multiBasis->getDegree() < _maxTrialDegree) ? _maxTrialDegree - multiBasis->getDegree() : 0;
       multiBasis->getCubature(_cubPoints, _cubWeights, _maxTestDegree + cubatureEnrichment);
       
       numCubPointsSide = _cubPoints.dimension(0);
+      _referencePointsAreStandard = false; // the points depend on the MultiBasis
     }
     
     _cubPointsSideRefCell.resize(numCubPointsSide, sideDim + 1); // cubPointsSide from the pov of the ref cell
@@ -370,6 +370,7 @@ BasisCache::BasisCache(int sideIndex, BasisCachePtr volumeCache, int trialDegree
     
     _cubPointsSideRefCell.resize(numCubPointsSide, sideDim + 1); // cubPointsSide from the pov of the ref cell
     CamelliaCellTools::mapToReferenceSubcell(_cubPointsSideRefCell, _cubPoints, sideDim, _sideIndex, _cellTopo);
+    _referencePointsAreStandard = true;
   }
   
   _maxPointsPerCubaturePhase = -1; // default: -1 (infinite)
@@ -412,11 +413,16 @@ int BasisCache::cubatureDegree() {
   return _cubDegree;
 }
 
+const vector<int> & BasisCache::cubatureDegrees() {
+  return _cubDegrees;
+}
+
 int BasisCache::getCubaturePhaseCount() {
   return _cubaturePhaseCount;
 }
 
 void BasisCache::setMaxPointsPerCubaturePhase(int maxPoints) {
+  _referencePointsAreStandard = false;
   if (_maxPointsPerCubaturePhase == -1) {
     _allCubPoints = _cubPoints;
     _allCubWeights = _cubWeights;
@@ -519,6 +525,9 @@ void BasisCache::discardPhysicalNodeInfo() {
   _cellJacobian.resize(0);
   _cellJacobInv.resize(0);
   _cellJacobDet.resize(0);
+  _pointwiseJacobian.resize(0);
+  _pointwiseJacobInv.resize(0);
+  _pointwiseJacobDet.resize(0);
   _weightedMeasure.resize(0);
   _physCubPoints.resize(0);
 }
@@ -551,24 +560,71 @@ const Intrepid::FieldContainer<double> & BasisCache::getCubatureWeights() {
   return _cubWeights;
 }
 
+bool BasisCache::cellsAreAffine() {
+  return _cellsAreAffine;
+}
+
 const FieldContainer<double> & BasisCache::getJacobian() {
+  if (_cellsAreAffine) {
+    broadcastAffineJacobian();
+    return _pointwiseJacobian;
+  }
   return _cellJacobian;
 }
 const FieldContainer<double> & BasisCache::getJacobianDet() {
+  if (_cellsAreAffine) {
+    broadcastAffineJacobian();
+    return _pointwiseJacobDet;
+  }
   return _cellJacobDet;
 }
 const FieldContainer<double> & BasisCache::getJacobianInv() {
+  if (_cellsAreAffine) {
+    broadcastAffineJacobian();
+    return _pointwiseJacobInv;
+  }
   return _cellJacobInv;
 }
 
+const FieldContainer<double> & BasisCache::getCellJacobian() {
+  return _cellJacobian;
+}
+
+void BasisCache::broadcastAffineJacobian() {
+  if (_pointwiseJacobDet.size() > 0) return; // already broadcast
+  int numPoints = isSideCache() ? _cubPointsSideRefCell.dimension(0) : _cubPoints.dimension(0);
+  int cellDim = _cellJacobian.dimension(2);
+  int matrixSize = cellDim * cellDim;
+  _pointwiseJacobian.resize(_numCells, numPoints, cellDim, cellDim);
+  _pointwiseJacobInv.resize(_numCells, numPoints, cellDim, cellDim);
+  _pointwiseJacobDet.resize(_numCells, numPoints);
+  for (int cellOrdinal=0; cellOrdinal<_numCells; cellOrdinal++) {
+    const double* jacobian = &_cellJacobian(cellOrdinal,0,0,0);
+    const double* jacobInv = &_cellJacobInv(cellOrdinal,0,0,0);
+    for (int ptOrdinal=0; ptOrdinal<numPoints; ptOrdinal++) {
+      std::copy(jacobian, jacobian + matrixSize, &_pointwiseJacobian(cellOrdinal,ptOrdinal,0,0));
+      std::copy(jacobInv, jacobInv + matrixSize, &_pointwiseJacobInv(cellOrdinal,ptOrdinal,0,0));
+      _pointwiseJacobDet(cellOrdinal,ptOrdinal) = _cellJacobDet(cellOrdinal,0);
+    }
+  }
+}
+
+constFCPtr BasisCache::computeReferenceValues(BasisPtr basis, Camellia::EOperator op, bool useCubPointsSideRefCell) {
+  const FieldContainer<double>* cubPoints = useCubPointsSideRefCell ? &_cubPointsSideRefCell : &_cubPoints;
+  if (!_referencePointsAreStandard) {
+    return BasisEvaluation::getValues(basis, op, *cubPoints);
+  }
+  ReferenceValueCache::PointSetKey pointSetKey;
+  pointSetKey.cellTopoKey = _cellTopo->getKey();
+  pointSetKey.cubatureDegree = _cubDegree;
+  if (_cubDegree < 0) pointSetKey.cubatureDegrees = _cubDegrees;
+  pointSetKey.sideOrdinal = _isSideCache ? _sideIndex : -1;
+  pointSetKey.sidePointsInVolumeCoordinates = _isSideCache && useCubPointsSideRefCell;
+  return ReferenceValueCache::referenceValueCache()->getValues(basis, op, pointSetKey, *cubPoints);
+}
+
 constFCPtr BasisCache::getValues(BasisPtr basis, Camellia::EOperator op,
                                  bool useCubPointsSideRefCell) {
-  FieldContainer<double> cubPoints;
-  if (useCubPointsSideRefCell) {
-    cubPoints = _cubPointsSideRefCell; // unnecessary copy
-  } else {
-    cubPoints = _cubPoints;
-  }
   // first, let's check whether the exact request is already known
   pair< Camellia::Basis<>*, Camellia::EOperator> key = make_pair(basis.get(), op);
   
@@ -585,7 +641,7 @@ constFCPtr BasisCache::getValues(BasisPtr basis, Camellia::EOperator op,
     relatedKey = make_pair(basis.get(), (Camellia::EOperator) relatedOp);
     if (_knownValues.find(relatedKey) == _knownValues.end() ) {
       // we can assume relatedResults has dimensions (numPoints,basisCardinality,spaceDim)
-      FCPtr relatedResults = BasisEvaluation::getValues(basis,(Camellia::EOperator)relatedOp,cubPoints);
+      constFCPtr relatedResults = computeReferenceValues(basis,(Camellia::EOperator)relatedOp,useCubPointsSideRefCell);
       _knownValues[relatedKey] = relatedResults;
     }
     
@@ -605,7 +661,7 @@ constFCPtr BasisCache::getValues(BasisPtr basis, Camellia::EOperator op,
   if ( (op >= Camellia::OP_X) || (op <  Camellia::OP_VALUE) ) {
     TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,"Unknown operator.");
   }
-  FCPtr result = BasisEvaluation::getValues(basis,op,cubPoints);
+  constFCPtr result = computeReferenceValues(basis,op,useCubPointsSideRefCell);
   _knownValues[key] = result;
   return result;
 }
@@ -792,6 +848,7 @@ void BasisCache::setRefCellPoints(const FieldContainer<double> &pointsRefCell) {
 
 void BasisCache::setRefCellPoints(const FieldContainer<double> &pointsRefCell, const FieldContainer<double> &cubWeights) {
   _cubPoints = pointsRefCell;
+  _referencePointsAreStandard = false;
   int numPoints = pointsRefCell.dimension(0);
   
   if ( isSideCache() ) { // then we need to map pointsRefCell (on side) into volume coordinates, and store in _cubPointsSideRefCell
@@ -908,13 +965,36 @@ void BasisCache::determineJacobian() {
   // Compute cell Jacobians, their inverses and their determinants
   int numCubPoints = isSideCache() ? _cubPointsSideRefCell.dimension(0) : _cubPoints.dimension(0);
   
+  // any earlier broadcast is for other points or cells
+  _pointwiseJacobian.resize(0);
+  _pointwiseJacobInv.resize(0);
+  _pointwiseJacobDet.resize(0);
+  
+  typedef CellTools<double>  CellTools;
+  
+  const FieldContainer<double>* refPoints = isSideCache() ? &_cubPointsSideRefCell : &_cubPoints;
+  
+  _cellsAreAffine = Function::isNull(_transformationFxn) && (numCubPoints > 0)
+                    && CamelliaCellTools::cellsAreAffine(_physicalCellNodes, _cellTopo);
+  if (_cellsAreAffine) {
+    // constant Jacobian on each cell: compute and invert it at a single point, and keep just that
+    FieldContainer<double> firstPoint(1, refPoints->dimension(1));
+    for (int d=0; d<refPoints->dimension(1); d++) {
+      firstPoint(0,d) = (*refPoints)(0,d);
+    }
+    _cellJacobian.resize(_numCells, 1, cellDim, cellDim);
+    _cellJacobInv.resize(_numCells, 1, cellDim, cellDim);
+    _cellJacobDet.resize(_numCells, 1);
+    CamelliaCellTools::setJacobian(_cellJacobian, firstPoint, _physicalCellNodes, _cellTopo);
+    SerialDenseWrapper::determinantAndInverse(_cellJacobDet, _cellJacobInv, _cellJacobian);
+    return;
+  }
+  
   // Containers for Jacobian
   _cellJacobian.resize(_numCells, numCubPoints, cellDim, cellDim);
   _cellJacobInv.resize(_numCells, numCubPoints, cellDim, cellDim);
   _cellJacobDet.resize(_numCells, numCubPoints);
   
-  typedef CellTools<double>  CellTools;
-  
   if ( Function::isNull(_transformationFxn) || _composeTransformationFxnWithMeshTransformation) {
     if (!isSideCache())
       CamelliaCellTools::setJacobian(_cellJacobian, _cubPoints, _physicalCellNodes, _cellTopo);
@@ -1148,13 +1228,23 @@ void BasisCache::recomputeMeasures() {
     // TODO: rename _cubPoints and related methods...
     _weightedMeasure.resize(_numCells, numCubPoints);
     if (! isSideCache()) {
-      fst::computeCellMeasure<double>(_weightedMeasure, _cellJacobDet, _cubWeights);
+      if (_cellsAreAffine) {
+        // as computeCellMeasure() does, but with one determinant per cell
+        for (int cellOrdinal=0; cellOrdinal<_numCells; cellOrdinal++) {
+          double cellMeasure = std::abs(_cellJacobDet(cellOrdinal,0));
+          for (int ptOrdinal=0; ptOrdinal<numCubPoints; ptOrdinal++) {
+            _weightedMeasure(cellOrdinal,ptOrdinal) = cellMeasure * _cubWeights(ptOrdinal);
+          }
+        }
+      } else {
+        fst::computeCellMeasure<double>(_weightedMeasure, _cellJacobDet, _cubWeights);
+      }
     } else {
       if (_cellTopo->getDimension()==1) {
         // TODO: determine whether this is the right thing:
         _weightedMeasure.initialize(1.0); // not sure this is the right thing.
       } else {
-        CamelliaCellTools::computeSideMeasure(_weightedMeasure, _cellJacobian, _cubWeights, _sideIndex, _cellTopo);
+        CamelliaCellTools::computeSideMeasure(_weightedMeasure, getJacobian(), _cubWeights, _sideIndex, _cellTopo);
       } /*else if (_cellTopo->getDimension()==2) {
         if (_cellTopo->getTensorialDegree() == 0) {
           // compute weighted edge measure
@@ -1189,13 +1279,13 @@ void BasisCache::recomputeMeasures() {
       if (_cellTopo->getTensorialDegree() == 0) {
         // recompute sideNormals
         _sideNormals.resize(_numCells, numPoints, _spaceDim);
-        CellTools<double>::getPhysicalSideNormals(_sideNormals, _cellJacobian, _sideIndex, _cellTopo->getShardsTopology());
+        CellTools<double>::getPhysicalSideNormals(_sideNormals, getJacobian(), _sideIndex, _cellTopo->getShardsTopology());
         // make unit length
         RealSpaceTools<double>::vectorNorm(normalLengths, _sideNormals, NORM_TWO);
         FunctionSpaceTools::scalarMultiplyDataData<double>(_sideNormals, normalLengths, _sideNormals, true);
       } else {
         _sideNormalsSpaceTime.resize(_numCells, numPoints, _cellTopo->getDimension());
-        CamelliaCellTools::getUnitSideNormals(_sideNormalsSpaceTime, _sideIndex, _cellJacobian, _cellTopo);
+        CamelliaCellTools::getUnitSideNormals(_sideNormalsSpaceTime, _sideIndex, getJacobian(), _cellTopo);
         
         // next, extract the pure-spatial part of the normal (this might not be unit length)
         _sideNormals.resize(_numCells, numPoints, _spaceDim);
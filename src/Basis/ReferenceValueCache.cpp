@@ -0,0 +1,173 @@
+//
+//  ReferenceValueCache.cpp
+//  Camellia
+//
+//
+
+#include "ReferenceValueCache.h"
+
+#include "BasisEvaluation.h"
+#include "CubatureFactory.h"
+
+using namespace Intrepid;
+using namespace Camellia;
+
+static const long long DEFAULT_MAX_MEMORY_IN_BYTES = 256 * 1024 * 1024; // 256 MB
+
+bool ReferenceValueCache::PointSetKey::operator<(const PointSetKey &other) const {
+  if (cellTopoKey != other.cellTopoKey) return cellTopoKey < other.cellTopoKey;
+  if (cubatureDegree != other.cubatureDegree) return cubatureDegree < other.cubatureDegree;
+  if (cubatureDegrees != other.cubatureDegrees) return cubatureDegrees < other.cubatureDegrees;
+  if (sideOrdinal != other.sideOrdinal) return sideOrdinal < other.sideOrdinal;
+  return sidePointsInVolumeCoordinates < other.sidePointsInVolumeCoordinates;
+}
+
+ReferenceValueCache::ReferenceValueCache() {
+  _memoryInBytes = 0;
+  _maxMemoryInBytes = DEFAULT_MAX_MEMORY_IN_BYTES;
+  _hitCount = 0;
+  _missCount = 0;
+}
+
+ReferenceValueCache* ReferenceValueCache::referenceValueCache() { // shared/static instance
+  static ReferenceValueCache cache;
+  return &cache;
+}
+
+Teuchos::RCP< const FieldContainer<double> > ReferenceValueCache::getValues(BasisPtr basis, Camellia::EOperator op,
+                                                                             const PointSetKey &pointSetKey,
+                                                                             const FieldContainer<double> &points) {
+  ValuesKey key = make_pair(make_pair(basis.get(), op), pointSetKey);
+
+  // the RCPs we hand out share ownership with the cache, so that they outlive clear()
+  Teuchos::RCP< const FieldContainer<double> > knownValues;
+#ifdef _OPENMP
+#pragma omp critical (ReferenceValueCache)
+#endif
+  {
+    map< ValuesKey, ValuesEntry >::iterator entryIt = _values.find(key);
+    if (entryIt != _values.end()) {
+      knownValues = entryIt->second.values;
+      _hitCount++;
+    } else {
+      _missCount++;
+    }
+  }
+  if (knownValues != Teuchos::null) return knownValues;
+
+  // evaluate outside the critical section, so that threads don't wait on each other's evaluations
+  Teuchos::RCP< const FieldContainer<double> > values = BasisEvaluation::getValues(basis, op, points);
+  long long valuesSize = values->size() * sizeof(double);
+
+#ifdef _OPENMP
+#pragma omp critical (ReferenceValueCache)
+#endif
+  {
+    map< ValuesKey, ValuesEntry >::iterator entryIt = _values.find(key);
+    if (entryIt != _values.end()) {
+      // another thread got here first; use its values
+      knownValues = entryIt->second.values;
+    } else if (_memoryInBytes + valuesSize <= _maxMemoryInBytes) {
+      ValuesEntry* entry = &_values[key];
+      entry->basis = basis;
+      entry->values = values;
+      _memoryInBytes += valuesSize;
+    }
+  }
+  if (knownValues != Teuchos::null) return knownValues;
+  return values; // stored, or (if the cache is full) owned by the caller alone
+}
+
+void ReferenceValueCache::getCubature(CellTopoPtr cellTopo, int cubatureDegree, const std::vector<int> &cubatureDegrees,
+                                      FieldContainer<double> &points, FieldContainer<double> &weights) {
+  PointSetKey key;
+  key.cellTopoKey = cellTopo->getKey();
+  key.cubatureDegree = cubatureDegree;
+  if (cubatureDegree < 0) key.cubatureDegrees = cubatureDegrees;
+  key.sideOrdinal = -1;
+  key.sidePointsInVolumeCoordinates = false;
+
+  bool found = false;
+#ifdef _OPENMP
+#pragma omp critical (ReferenceValueCache)
+#endif
+  {
+    map< PointSetKey, CubatureEntry >::iterator entryIt = _cubatureRules.find(key);
+    if (entryIt != _cubatureRules.end()) {
+      points = entryIt->second.points;
+      weights = entryIt->second.weights;
+      found = true;
+    }
+  }
+  if (found) return;
+
+  CubatureFactory cubFactory;
+  Teuchos::RCP<Cubature<double> > cellTopoCub;
+  if (cubatureDegree >= 0)
+    cellTopoCub = cubFactory.create(cellTopo, cubatureDegree);
+  else
+    cellTopoCub = cubFactory.create(cellTopo, cubatureDegrees);
+
+  int cubDim       = cellTopoCub->getDimension();
+  int numCubPoints = cellTopoCub->getNumPoints();
+
+  points.resize(numCubPoints, cubDim);
+  weights.resize(numCubPoints);
+
+  cellTopoCub->getCubature(points, weights);
+
+  // cubature rules are small; we don't count them against the memory bound
+#ifdef _OPENMP
+#pragma omp critical (ReferenceValueCache)
+#endif
+  {
+    if (_cubatureRules.find(key) == _cubatureRules.end()) {
+      CubatureEntry* entry = &_cubatureRules[key];
+      entry->points = points;
+      entry->weights = weights;
+    }
+  }
+}
+
+void ReferenceValueCache::clear() {
+#ifdef _OPENMP
+#pragma omp critical (ReferenceValueCache)
+#endif
+  {
+    _values.clear();
+    _cubatureRules.clear();
+    _memoryInBytes = 0;
+    _hitCount = 0;
+    _missCount = 0;
+  }
+}
+
+long long ReferenceValueCache::hitCount() const {
+  return _hitCount;
+}
+
+long long ReferenceValueCache::missCount() const {
+  return _missCount;
+}
+
+long long ReferenceValueCache::memoryInBytes() const {
+  return _memoryInBytes;
+}
+
+long long ReferenceValueCache::maxMemoryInBytes() const {
+  return _maxMemoryInBytes;
+}
+
+void ReferenceValueCache::setMaxMemoryInBytes(long long maxMemory) {
+#ifdef _OPENMP
+#pragma omp critical (ReferenceValueCache)
+#endif
+  {
+    _maxMemoryInBytes = maxMemory;
+    if (_memoryInBytes > _maxMemoryInBytes) {
+      // over the new bound: drop the stored values (views already handed out keep theirs)
+      _values.clear();
+      _memoryInBytes = 0;
+    }
+  }
+}
@@ -650,6 +650,52 @@ void CamelliaCellTools::permutedReferenceCellPoints(CellTopoPtr cellTopo, unsign
   CamelliaCellTools::mapToPhysicalFrame(permutedPoints,refPoints,permutedNodes,cellTopo, whichCell);
 }
 
+bool CamelliaCellTools::cellsAreAffine(const FieldContainer<double> &cellWorkset, CellTopoPtr cellTopo) {
+  if (cellTopo->getTensorialDegree() > 0) return false; // we don't attempt to detect affine space-time cells
+  
+  unsigned cellTopoKey = cellTopo->getShardsTopology().getKey();
+  if ((cellTopoKey == shards::Line<2>::key) || (cellTopoKey == shards::Triangle<3>::key)
+      || (cellTopoKey == shards::Tetrahedron<4>::key)) {
+    return true; // linear simplices
+  }
+  
+  // for the quadrilateral and hexahedron, the map is affine iff each listed node n satisfies x_n = x_a + x_b - x_0
+  // (parallelograms and parallelepipeds); entries are {n, a, b}
+  vector< vector<int> > nodeSums;
+  if (cellTopoKey == shards::Quadrilateral<4>::key) {
+    int sums[1][3] = {{2, 1, 3}};
+    nodeSums.push_back(vector<int>(sums[0], sums[0]+3));
+  } else if (cellTopoKey == shards::Hexahedron<8>::key) {
+    int sums[4][3] = {{2, 1, 3}, {5, 1, 4}, {7, 3, 4}, {6, 2, 4}};
+    for (int i=0; i<4; i++) {
+      nodeSums.push_back(vector<int>(sums[i], sums[i]+3));
+    }
+  } else {
+    return false;
+  }
+  
+  int numCells = cellWorkset.dimension(0);
+  int numNodes = cellWorkset.dimension(1);
+  int spaceDim = cellWorkset.dimension(2);
+  double relativeTol = 1e-12;
+  for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+    double scale = 0; // the cell's extent, so that the tolerance is relative
+    for (int nodeOrdinal=1; nodeOrdinal<numNodes; nodeOrdinal++) {
+      for (int d=0; d<spaceDim; d++) {
+        scale = max(scale, abs(cellWorkset(cellOrdinal,nodeOrdinal,d) - cellWorkset(cellOrdinal,0,d)));
+      }
+    }
+    for (int i=0; i<nodeSums.size(); i++) {
+      int node = nodeSums[i][0], nodeA = nodeSums[i][1], nodeB = nodeSums[i][2];
+      for (int d=0; d<spaceDim; d++) {
+        double expected = cellWorkset(cellOrdinal,nodeA,d) + cellWorkset(cellOrdinal,nodeB,d) - cellWorkset(cellOrdinal,0,d);
+        if (abs(cellWorkset(cellOrdinal,node,d) - expected) > relativeTol * scale) return false;
+      }
+    }
+  }
+  return true;
+}
+
 void CamelliaCellTools::setJacobian(FieldContainer<double> &jacobian, const FieldContainer<double> &points, const FieldContainer<double> &cellWorkset, CellTopoPtr cellTopo, const int &whichCell) {
   int spaceDim  = (int)cellTopo->getDimension();
   int numCells  = cellWorkset.dimension(0);
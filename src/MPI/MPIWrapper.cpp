@@ -35,6 +35,9 @@ void MPIWrapper::allGather(FieldContainer<int> &allValues, FieldContainer<int> &
   Epetra_MpiComm Comm(MPI_COMM_WORLD);
   Comm.GatherAll(&myValues[0], &allValues[0], allValues.size()/numProcs);
 #else
+  for (int i=0; i<myValues.size(); i++) {
+    allValues[i] = myValues[i];
+  }
 #endif
 }
 
@@ -0,0 +1,91 @@
+//
+//  CellCostModel.cpp
+//  Camellia
+//
+//
+
+#include "CellCostModel.h"
+
+#include "Mesh.h"
+#include "MPIWrapper.h"
+#include "Solution.h"
+
+using namespace std;
+
+double CellCostModel::localSolveCost(int numTrialDofs, int numTestDofs) {
+  double n = numTestDofs, m = numTrialDofs;
+  return n * n * n / 3.0 // Cholesky factorization of the Gram matrix
+       + 2.0 * n * n * m // forward and back substitution for each trial basis function
+       + 2.0 * n * m * m; // stiffness = (optimal test weights)^T * B
+}
+
+namespace {
+  map<GlobalIndexType, double> dofCountCellCosts(Mesh *mesh) {
+    // every rank knows every active cell's element type, so no communication is required
+    map<GlobalIndexType, double> cellCosts;
+    map<ElementType*, double> costForElementType;
+    const set<IndexType>* activeCellIndices = &mesh->getTopology()->getActiveCellIndices();
+    for (set<IndexType>::const_iterator cellIt = activeCellIndices->begin(); cellIt != activeCellIndices->end(); cellIt++) {
+      ElementTypePtr elemType = mesh->getElementType(*cellIt);
+      map<ElementType*, double>::iterator costIt = costForElementType.find(elemType.get());
+      if (costIt == costForElementType.end()) {
+        double cost = CellCostModel::localSolveCost(elemType->trialOrderPtr->totalDofs(), elemType->testOrderPtr->totalDofs());
+        costIt = costForElementType.insert(make_pair(elemType.get(), cost)).first;
+      }
+      cellCosts[*cellIt] = costIt->second;
+    }
+    return cellCosts;
+  }
+
+  class DofCountCostModel : public CellCostModel {
+  public:
+    map<GlobalIndexType, double> cellCosts(Mesh *mesh) {
+      return dofCountCellCosts(mesh);
+    }
+  };
+
+  class MeasuredCostModel : public CellCostModel {
+    Teuchos::RCP<Solution> _solution; // weak: the solution's mesh holds the partition policy, which holds this
+  public:
+    MeasuredCostModel(Teuchos::RCP<Solution> solution) {
+      _solution = solution.create_weak();
+    }
+    map<GlobalIndexType, double> cellCosts(Mesh *mesh) {
+      map<GlobalIndexType, double> cellCosts = dofCountCellCosts(mesh);
+      if (!_solution.is_valid_ptr()) return cellCosts; // the solution is gone: the model alone
+
+      // each cell was measured on (at most) one rank; the sum shares the measurements
+      FieldContainer<double> measuredTimes(mesh->getTopology()->cellCount());
+      const map<GlobalIndexType, double>* myMeasuredTimes = &_solution->localStiffnessTimes();
+      for (map<GlobalIndexType, double>::const_iterator timeIt = myMeasuredTimes->begin(); timeIt != myMeasuredTimes->end(); timeIt++) {
+        if (timeIt->first < measuredTimes.size()) measuredTimes(timeIt->first) = timeIt->second;
+      }
+      MPIWrapper::entryWiseSum(measuredTimes);
+
+      // seconds per unit of modeled cost, over the cells that were measured
+      double measuredTotal = 0.0, modeledTotal = 0.0;
+      for (map<GlobalIndexType, double>::iterator costIt = cellCosts.begin(); costIt != cellCosts.end(); costIt++) {
+        if (measuredTimes(costIt->first) > 0.0) {
+          measuredTotal += measuredTimes(costIt->first);
+          modeledTotal += costIt->second;
+        }
+      }
+      if (measuredTotal == 0.0) return cellCosts; // nothing measured (yet): the model alone
+
+      double scale = measuredTotal / modeledTotal;
+      for (map<GlobalIndexType, double>::iterator costIt = cellCosts.begin(); costIt != cellCosts.end(); costIt++) {
+        double measuredTime = measuredTimes(costIt->first);
+        costIt->second = (measuredTime > 0.0) ? measuredTime : scale * costIt->second;
+      }
+      return cellCosts;
+    }
+  };
+}
+
+CellCostModelPtr CellCostModel::dofCountCostModel() {
+  return Teuchos::rcp( new DofCountCostModel() );
+}
+
+CellCostModelPtr CellCostModel::measuredCostModel(Teuchos::RCP<Solution> solution) {
+  return Teuchos::rcp( new MeasuredCostModel(solution) );
+}
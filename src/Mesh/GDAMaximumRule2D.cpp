@@ -1137,6 +1137,7 @@ FieldContainer<double> & GDAMaximumRule2D::physicalCellNodesGlobal( ElementTypeP
 
 void GDAMaximumRule2D::rebuildLookups() {
 //  cout << "GDAMaximumRule2D::rebuildLookups().\n";
+  _dofAssignmentVersion++;
   _cellSideUpgrades.clear();
   buildTypeLookups(); // build data structures for efficient lookup by element type
   buildLocalToGlobalMap();
@@ -26,7 +26,9 @@ GDAMinimumRule::GDAMinimumRule(MeshPtr mesh, VarFactory varFactory, DofOrderingF
                                unsigned initialH1OrderTrial, unsigned testOrderEnhancement)
 : GlobalDofAssignment(mesh,varFactory,dofOrderingFactory,partitionPolicy, initialH1OrderTrial, testOrderEnhancement, false)
 {
-
+  _fullRebuildRequired = true;
+  _meshTopologyAtRebuild = NULL;
+  _expectedCellCount = 0;
 }
 
 vector<unsigned> GDAMinimumRule::allBasisDofOrdinalsVector(int basisCardinality) {
@@ -37,6 +39,61 @@ vector<unsigned> GDAMinimumRule::allBasisDofOrdinalsVector(int basisCardinality)
   return ordinals;
 }
 
+set<GlobalIndexType> GDAMinimumRule::cellsNearChangedCells() {
+  // Constraints for a cell are determined by the entity hierarchy around its subcells, and by the H1 orders of the cells containing
+  // the constraining entities.  A change to a cell can therefore affect the active cells that contain one of its subcell entities,
+  // a (like-dimensional) descendant of one, or the entity constraining one; and, through ownership, any cell whose cached
+  // constraints point to one of those.
+  set<GlobalIndexType> nearbyCellIDs = _cellsChangedSinceRebuild;
+  int spaceDim = _meshTopology->getSpaceDim();
+  
+  set< pair<unsigned, IndexType> > entitiesToVisit, visitedEntities; // (d, entityIndex)
+  for (set<GlobalIndexType>::iterator cellIDIt = _cellsChangedSinceRebuild.begin(); cellIDIt != _cellsChangedSinceRebuild.end(); cellIDIt++) {
+    CellPtr cell = _meshTopology->getCell(*cellIDIt);
+    for (int d=0; d<spaceDim; d++) {
+      vector<IndexType> entityIndices = cell->getEntityIndices(d);
+      for (int i=0; i<entityIndices.size(); i++) {
+        entitiesToVisit.insert(make_pair(d, entityIndices[i]));
+        pair<IndexType, unsigned> constrainingEntity = _meshTopology->getConstrainingEntity(d, entityIndices[i]);
+        entitiesToVisit.insert(make_pair(constrainingEntity.second, constrainingEntity.first));
+      }
+    }
+  }
+  while (entitiesToVisit.size() > 0) {
+    pair<unsigned, IndexType> entity = *entitiesToVisit.begin();
+    entitiesToVisit.erase(entitiesToVisit.begin());
+    if (visitedEntities.find(entity) != visitedEntities.end()) continue;
+    visitedEntities.insert(entity);
+    
+    if (_meshTopology->getActiveCellCount(entity.first, entity.second) > 0) {
+      const vector< pair<IndexType,IndexType> >* activeCells = &_meshTopology->getActiveCellIndices(entity.first, entity.second);
+      for (int i=0; i<activeCells->size(); i++) {
+        nearbyCellIDs.insert((*activeCells)[i].first);
+      }
+    }
+    set<IndexType> childEntities = _meshTopology->getChildEntitiesSet(entity.first, entity.second);
+    for (set<IndexType>::iterator childIt = childEntities.begin(); childIt != childEntities.end(); childIt++) {
+      entitiesToVisit.insert(make_pair(entity.first, *childIt));
+    }
+  }
+  
+  set<GlobalIndexType> referencingCellIDs = cellsReferencingCells(nearbyCellIDs);
+  nearbyCellIDs.insert(referencingCellIDs.begin(), referencingCellIDs.end());
+  
+  return nearbyCellIDs;
+}
+
+set<GlobalIndexType> GDAMinimumRule::cellsReferencingCells(const set<GlobalIndexType> &cellIDs) {
+  set<GlobalIndexType> referencingCellIDs;
+  for (set<GlobalIndexType>::const_iterator cellIDIt = cellIDs.begin(); cellIDIt != cellIDs.end(); cellIDIt++) {
+    map< GlobalIndexType, set<GlobalIndexType> >::iterator referencingIt = _cellsReferencingCell.find(*cellIDIt);
+    if (referencingIt != _cellsReferencingCell.end()) {
+      referencingCellIDs.insert(referencingIt->second.begin(), referencingIt->second.end());
+    }
+  }
+  return referencingCellIDs;
+}
+
 GlobalDofAssignmentPtr GDAMinimumRule::deepCopy() {
   return Teuchos::rcp(new GDAMinimumRule(*this) );
 }
@@ -53,6 +110,9 @@ void GDAMinimumRule::didHRefine(const set<GlobalIndexType> &parentCellIDs) {
     CellPtr parentCell = _meshTopology->getCell(parentCellID);
     vector<IndexType> childIDs = parentCell->getChildIndices();
     int parentH1Order = _cellH1Orders[parentCellID];
+    _cellsChangedSinceRebuild.insert(parentCellID);
+    _cellsChangedSinceRebuild.insert(childIDs.begin(), childIDs.end());
+    _expectedCellCount += childIDs.size();
     for (vector<IndexType>::iterator childIDIt = childIDs.begin(); childIDIt != childIDs.end(); childIDIt++) {
       GlobalIndexType childCellID = *childIDIt;
       _cellH1Orders[childCellID] = parentH1Order;
@@ -96,7 +156,9 @@ void GDAMinimumRule::didPRefine(const set<GlobalIndexType> &cellIDs, int deltaP)
   for (set<GlobalIndexType>::const_iterator cellIDIt = cellIDs.begin(); cellIDIt != cellIDs.end(); cellIDIt++) {
     CellPtr cell = _meshTopology->getCell(*cellIDIt);
     CellPtr parent = cell->getParent();
+    _cellsChangedSinceRebuild.insert(*cellIDIt);
     while (parent.get() != NULL) {
+      _cellsChangedSinceRebuild.insert(parent->cellIndex()); // inactive, but its H1 order enters constraint determination
       vector<IndexType> childIndices = parent->getChildIndices();
       unsigned minH1Order = _cellH1Orders[*cellIDIt];
       for (int childOrdinal=0; childOrdinal<childIndices.size(); childOrdinal++) {
@@ -126,6 +188,7 @@ void GDAMinimumRule::didPRefine(const set<GlobalIndexType> &cellIDs, int deltaP)
 
 void GDAMinimumRule::didHUnrefine(const set<GlobalIndexType> &parentCellIDs) {
   this->GlobalDofAssignment::didHUnrefine(parentCellIDs);
+  _fullRebuildRequired = true;
   // TODO: implement this
   cout << "WARNING: GDAMinimumRule::didHUnrefine() unimplemented.\n";
   // will need to treat cell side parities here--probably suffices to redo those in parentCellIDs plus all their neighbors.
@@ -385,6 +448,16 @@ void GDAMinimumRule::interpretGlobalCoefficients(GlobalIndexType cellID, FieldCo
 //  cout << " to localData:\n " << localDofs;
 }
 
+bool GDAMinimumRule::prepareForConcurrentInterpretation(const set<GlobalIndexType> &cellIDs) {
+  // once the constraints and mappers are cached, interpretLocalData() only reads our containers, and each cell's mapper is its own
+  for (set<GlobalIndexType>::const_iterator cellIt = cellIDs.begin(); cellIt != cellIDs.end(); cellIt++) {
+    CellConstraints constraints = getCellConstraints(*cellIt);
+    LocalDofMapperPtr dofMapper = getDofMapper(*cellIt, constraints);
+    dofMapper->prepareMatrixMapping(false);
+  }
+  return true;
+}
+
 void GDAMinimumRule::interpretLocalData(GlobalIndexType cellID, const FieldContainer<double> &localData,
                                         FieldContainer<double> &globalData, FieldContainer<GlobalIndexType> &globalDofIndices) {
   CellConstraints constraints = getCellConstraints(cellID);
@@ -473,6 +546,35 @@ void GDAMinimumRule::interpretLocalBasisCoefficients(GlobalIndexType cellID, int
   }
 }
 
+void GDAMinimumRule::invalidateCachesForCells(const set<GlobalIndexType> &cellIDs) {
+  for (set<GlobalIndexType>::const_iterator cellIDIt = cellIDs.begin(); cellIDIt != cellIDs.end(); cellIDIt++) {
+    GlobalIndexType cellID = *cellIDIt;
+    map< GlobalIndexType, CellConstraints >::iterator constraintsIt = _constraintsCache.find(cellID);
+    if (constraintsIt != _constraintsCache.end()) {
+      set<GlobalIndexType> referencedCells = referencedCellIDs(constraintsIt->second);
+      for (set<GlobalIndexType>::iterator referencedIt = referencedCells.begin(); referencedIt != referencedCells.end(); referencedIt++) {
+        _cellsReferencingCell[*referencedIt].erase(cellID);
+      }
+      _constraintsCache.erase(constraintsIt);
+    }
+    _cellDofLayoutCache.erase(cellID);
+    _ownedGlobalDofIndicesCache.erase(cellID);
+    _dofMapperCache.erase(cellID);
+    _dofMapperForVariableOnSideCache.erase(cellID);
+  }
+}
+
+set<GlobalIndexType> GDAMinimumRule::referencedCellIDs(const CellConstraints &constraints) {
+  set<GlobalIndexType> cellIDs;
+  for (int d=0; d<constraints.subcellConstraints.size(); d++) {
+    for (int scord=0; scord<constraints.subcellConstraints[d].size(); scord++) {
+      cellIDs.insert(constraints.subcellConstraints[d][scord].cellID);
+      cellIDs.insert(constraints.owningCellIDForSubcell[d][scord].cellID);
+    }
+  }
+  return cellIDs;
+}
+
 IndexType GDAMinimumRule::localDofCount() {
   // TODO: implement this
   cout << "WARNING: localDofCount() unimplemented.\n";
@@ -1606,6 +1708,10 @@ CellConstraints GDAMinimumRule::getCellConstraints(GlobalIndexType cellID) {
     cellConstraints.owningCellIDForSubcell[spaceDim][0].dimension = spaceDim;
     
     _constraintsCache[cellID] = cellConstraints;
+    set<GlobalIndexType> referencedCells = referencedCellIDs(cellConstraints);
+    for (set<GlobalIndexType>::iterator referencedIt = referencedCells.begin(); referencedIt != referencedCells.end(); referencedIt++) {
+      _cellsReferencingCell[*referencedIt].insert(cellID);
+    }
     
 //    if (cellID==4) { // DEBUGGING
 //      printConstraintInfo(cellID);
@@ -1615,6 +1721,96 @@ CellConstraints GDAMinimumRule::getCellConstraints(GlobalIndexType cellID) {
   return _constraintsCache[cellID];
 }
 
+const GDAMinimumRule::CellDofLayout & GDAMinimumRule::getCellDofLayout(GlobalIndexType cellID) {
+  map< GlobalIndexType, CellDofLayout >::iterator layoutIt = _cellDofLayoutCache.find(cellID);
+  if (layoutIt != _cellDofLayoutCache.end()) {
+    return layoutIt->second;
+  }
+  
+  CellDofLayout layout;
+  layout.ownedDofCount = 0;
+  
+  map<int, VarPtr> trialVars = _varFactory.trialVars();
+  
+  int spaceDim = _meshTopology->getSpaceDim();
+  int sideDim = spaceDim - 1;
+  
+  // pieces of this remain fairly ugly--the brute force searches are limited to entities on a cell (i.e. < O(12) items to search in a hexahedron),
+  // and I've done a reasonable job only doing them when we need the result, but they still are brute force searches.  By tweaking
+  // the design of MeshTopology and Cell to take better advantage of regularities (or just to store better lookups), we should be able to do better.
+  // But in the interest of avoiding wasting development time on premature optimization, I'm leaving it as is for now...
+  
+  CellPtr cell = _meshTopology->getCell(cellID);
+  CellTopoPtr topo = cell->topology();
+  CellConstraints constraints = getCellConstraints(cellID);
+  
+  set< pair<unsigned,IndexType> > entitiesClaimedForCell;
+  
+  for (int d=0; d<=spaceDim; d++) {
+    int scCount = topo->getSubcellCount(d);
+    for (int scord=0; scord<scCount; scord++) {
+      OwnershipInfo ownershipInfo = constraints.owningCellIDForSubcell[d][scord];
+      if (ownershipInfo.cellID == cellID) { // owned by this cell: count all the constraining dofs as entries for this cell
+        pair<unsigned, IndexType> owningSubcellEntity = make_pair(ownershipInfo.dimension, ownershipInfo.owningSubcellEntityIndex);
+        if (entitiesClaimedForCell.find(owningSubcellEntity) != entitiesClaimedForCell.end()) {
+          continue; // already processed this guy on this cell
+        } else {
+          entitiesClaimedForCell.insert(owningSubcellEntity);
+        }
+        GlobalIndexType constrainingCellID = constraints.subcellConstraints[d][scord].cellID;
+        unsigned constrainingSubcellDimension = constraints.subcellConstraints[d][scord].dimension;
+        DofOrderingPtr trialOrdering = _elementTypeForCell[constrainingCellID]->trialOrderPtr;
+        for (map<int, VarPtr>::iterator varIt = trialVars.begin(); varIt != trialVars.end(); varIt++) {
+          VarPtr var = varIt->second;
+          unsigned scordForBasis;
+          bool varHasSupportOnVolume = (var->varType() == FIELD) || (var->varType() == TEST);
+          BasisPtr basis; // the constraining basis for the subcell
+          if (varHasSupportOnVolume) {
+             // volume basis => the basis sees the cell as a whole: in constraining cell, map from side scord to the volume
+            if (constrainingSubcellDimension==spaceDim) {
+              // then there is only one subcell ordinal (and there will be -1's in sideOrdinal and subcellOrdinalInSide....
+              scordForBasis = 0;
+            } else {
+              scordForBasis = CamelliaCellTools::subcellOrdinalMap(_meshTopology->getCell(constrainingCellID)->topology(), sideDim,
+                                                                   constraints.subcellConstraints[d][scord].sideOrdinal,
+                                                                   constrainingSubcellDimension, constraints.subcellConstraints[d][scord].subcellOrdinal);
+            }
+            basis = trialOrdering->getBasis(var->ID());
+            // field
+            int ordinalCount = basis->dofOrdinalsForSubcell(constrainingSubcellDimension, scordForBasis).size();
+            for (int ordinal=0; ordinal<ordinalCount; ordinal++) {
+              layout.dofOffsetsForVarID[var->ID()].push_back(ordinal+layout.ownedDofCount);
+            }
+          } else {
+            if (constrainingSubcellDimension==spaceDim) continue; // side bases don't have any support on the interior of the cell...
+            if (!trialOrdering->hasBasisEntry(var->ID(), constraints.subcellConstraints[d][scord].sideOrdinal)) continue;
+            
+            scordForBasis = constraints.subcellConstraints[d][scord].subcellOrdinal; // the basis sees the side, so that's the view to use for subcell ordinal
+            basis = trialOrdering->getBasis(var->ID(), constraints.subcellConstraints[d][scord].sideOrdinal);
+
+            int ordinalCount = basis->dofOrdinalsForSubcell(constrainingSubcellDimension, scordForBasis).size();
+            if (var->varType()==FLUX) {
+              for (int ordinal=0; ordinal<ordinalCount; ordinal++) {
+                layout.fluxDofOffsets.push_back(ordinal+layout.ownedDofCount);
+                layout.dofOffsetsForVarID[var->ID()].push_back(ordinal+layout.ownedDofCount);
+              }
+            } else if (var->varType() == TRACE) {
+              for (int ordinal=0; ordinal<ordinalCount; ordinal++) {
+                layout.traceDofOffsets.push_back(ordinal+layout.ownedDofCount);
+                layout.dofOffsetsForVarID[var->ID()].push_back(ordinal+layout.ownedDofCount);
+              }
+            }
+          }
+          layout.ownedDofCount += basis->dofOrdinalsForSubcell(constrainingSubcellDimension, scordForBasis).size();
+        }
+      }
+    }
+  }
+  
+  _cellDofLayoutCache[cellID] = layout;
+  return _cellDofLayoutCache[cellID];
+}
+
 typedef map<int, vector<GlobalIndexType> > VarIDToDofIndices; // key: varID
 typedef map<unsigned, VarIDToDofIndices> SubCellOrdinalToMap; // key: subcell ordinal
 typedef vector< SubCellOrdinalToMap > SubCellDofIndexInfo; // index to vector: subcell dimension
@@ -2006,11 +2202,30 @@ void GDAMinimumRule::printGlobalDofInfo() {
   }
 }
 
+void GDAMinimumRule::requireFullRebuild() {
+  _fullRebuildRequired = true;
+}
+
 void GDAMinimumRule::rebuildLookups() {
-  _constraintsCache.clear(); // to free up memory, could clear this again after the lookups are rebuilt.  Having the cache is most important during the construction below.
-  _dofMapperCache.clear();
-  _dofMapperForVariableOnSideCache.clear();
-  _ownedGlobalDofIndicesCache.clear();
+  _dofAssignmentVersion++;
+  
+  bool topologyChangedElsewhere = (_meshTopologyAtRebuild != _meshTopology.get()) || (_meshTopology->cellCount() != _expectedCellCount);
+  if (_fullRebuildRequired || topologyChangedElsewhere) {
+    _constraintsCache.clear();
+    _cellsReferencingCell.clear();
+    _cellDofLayoutCache.clear();
+    _dofMapperCache.clear();
+    _dofMapperForVariableOnSideCache.clear();
+    _ownedGlobalDofIndicesCache.clear();
+  } else {
+    // constraints and dof layouts only change near the refined cells; the rest of the caches survive
+    set<GlobalIndexType> nearbyCellIDs = cellsNearChangedCells();
+    invalidateCachesForCells(nearbyCellIDs);
+  }
+  _cellsChangedSinceRebuild.clear();
+  _fullRebuildRequired = false;
+  _meshTopologyAtRebuild = _meshTopology.get();
+  _expectedCellCount = _meshTopology->cellCount();
   
   _partitionFluxIndexOffsets.clear();
   _partitionTraceIndexOffsets.clear();
@@ -2020,88 +2235,27 @@ void GDAMinimumRule::rebuildLookups() {
 //  cout << "GDAMinimumRule: Rebuilding lookups on rank " << rank << endl;
   set<GlobalIndexType> myCellIDs = _partitions[rank];
   
-  map<int, VarPtr> trialVars = _varFactory.trialVars();
-  
   _cellDofOffsets.clear(); // within the partition, offsets for the owned dofs in cell
   
-  int spaceDim = _meshTopology->getSpaceDim();
-  int sideDim = spaceDim - 1;
-  
-  // pieces of this remain fairly ugly--the brute force searches are limited to entities on a cell (i.e. < O(12) items to search in a hexahedron),
-  // and I've done a reasonable job only doing them when we need the result, but they still are brute force searches.  By tweaking
-  // the design of MeshTopology and Cell to take better advantage of regularities (or just to store better lookups), we should be able to do better.
-  // But in the interest of avoiding wasting development time on premature optimization, I'm leaving it as is for now...
-  
+  // offsets are a prefix sum over the cached per-cell layouts; only cells without a cached layout do any real work here
   _partitionDofCount = 0; // how many dofs we own locally
   for (set<GlobalIndexType>::iterator cellIDIt = myCellIDs.begin(); cellIDIt != myCellIDs.end(); cellIDIt++) {
     GlobalIndexType cellID = *cellIDIt;
     _cellDofOffsets[cellID] = _partitionDofCount;
-    CellPtr cell = _meshTopology->getCell(cellID);
-    CellTopoPtr topo = cell->topology();
-    CellConstraints constraints = getCellConstraints(cellID);
-    
-    set< pair<unsigned,IndexType> > entitiesClaimedForCell;
-    
-    for (int d=0; d<=spaceDim; d++) {
-      int scCount = topo->getSubcellCount(d);
-      for (int scord=0; scord<scCount; scord++) {
-        OwnershipInfo ownershipInfo = constraints.owningCellIDForSubcell[d][scord];
-        if (ownershipInfo.cellID == cellID) { // owned by this cell: count all the constraining dofs as entries for this cell
-          pair<unsigned, IndexType> owningSubcellEntity = make_pair(ownershipInfo.dimension, ownershipInfo.owningSubcellEntityIndex);
-          if (entitiesClaimedForCell.find(owningSubcellEntity) != entitiesClaimedForCell.end()) {
-            continue; // already processed this guy on this cell
-          } else {
-            entitiesClaimedForCell.insert(owningSubcellEntity);
-          }
-          GlobalIndexType constrainingCellID = constraints.subcellConstraints[d][scord].cellID;
-          unsigned constrainingSubcellDimension = constraints.subcellConstraints[d][scord].dimension;
-          DofOrderingPtr trialOrdering = _elementTypeForCell[constrainingCellID]->trialOrderPtr;
-          for (map<int, VarPtr>::iterator varIt = trialVars.begin(); varIt != trialVars.end(); varIt++) {
-            VarPtr var = varIt->second;
-            unsigned scordForBasis;
-            bool varHasSupportOnVolume = (var->varType() == FIELD) || (var->varType() == TEST);
-            BasisPtr basis; // the constraining basis for the subcell
-            if (varHasSupportOnVolume) {
-               // volume basis => the basis sees the cell as a whole: in constraining cell, map from side scord to the volume
-              if (constrainingSubcellDimension==spaceDim) {
-                // then there is only one subcell ordinal (and there will be -1's in sideOrdinal and subcellOrdinalInSide....
-                scordForBasis = 0;
-              } else {
-                scordForBasis = CamelliaCellTools::subcellOrdinalMap(_meshTopology->getCell(constrainingCellID)->topology(), sideDim,
-                                                                     constraints.subcellConstraints[d][scord].sideOrdinal,
-                                                                     constrainingSubcellDimension, constraints.subcellConstraints[d][scord].subcellOrdinal);
-              }
-              basis = trialOrdering->getBasis(var->ID());
-              // field
-              int ordinalCount = basis->dofOrdinalsForSubcell(constrainingSubcellDimension, scordForBasis).size();
-              for (int ordinal=0; ordinal<ordinalCount; ordinal++) {
-                _partitionIndexOffsetsForVarID[var->ID()].insert(ordinal+_partitionDofCount);
-              }
-            } else {
-              if (constrainingSubcellDimension==spaceDim) continue; // side bases don't have any support on the interior of the cell...
-              if (!trialOrdering->hasBasisEntry(var->ID(), constraints.subcellConstraints[d][scord].sideOrdinal)) continue;
-              
-              scordForBasis = constraints.subcellConstraints[d][scord].subcellOrdinal; // the basis sees the side, so that's the view to use for subcell ordinal
-              basis = trialOrdering->getBasis(var->ID(), constraints.subcellConstraints[d][scord].sideOrdinal);
-
-              int ordinalCount = basis->dofOrdinalsForSubcell(constrainingSubcellDimension, scordForBasis).size();
-              if (var->varType()==FLUX) {
-                for (int ordinal=0; ordinal<ordinalCount; ordinal++) {
-                  _partitionFluxIndexOffsets.insert(ordinal+_partitionDofCount);
-                  _partitionIndexOffsetsForVarID[var->ID()].insert(ordinal+_partitionDofCount);
-                }
-              } else if (var->varType() == TRACE) {
-                for (int ordinal=0; ordinal<ordinalCount; ordinal++) {
-                  _partitionTraceIndexOffsets.insert(ordinal+_partitionDofCount);
-                  _partitionIndexOffsetsForVarID[var->ID()].insert(ordinal+_partitionDofCount);
-                }
-              }
-            }
-            _partitionDofCount += basis->dofOrdinalsForSubcell(constrainingSubcellDimension, scordForBasis).size();
-          }
-        }
+    const CellDofLayout* layout = &getCellDofLayout(cellID);
+    for (map<int, vector<IndexType> >::const_iterator varIt = layout->dofOffsetsForVarID.begin(); varIt != layout->dofOffsetsForVarID.end(); varIt++) {
+      set<IndexType>* varOffsets = &_partitionIndexOffsetsForVarID[varIt->first];
+      for (int i=0; i<varIt->second.size(); i++) {
+        varOffsets->insert(varIt->second[i] + _partitionDofCount);
       }
     }
+    for (int i=0; i<layout->fluxDofOffsets.size(); i++) {
+      _partitionFluxIndexOffsets.insert(layout->fluxDofOffsets[i] + _partitionDofCount);
+    }
+    for (int i=0; i<layout->traceDofOffsets.size(); i++) {
+      _partitionTraceIndexOffsets.insert(layout->traceDofOffsets[i] + _partitionDofCount);
+    }
+    _partitionDofCount += layout->ownedDofCount;
   }
   int numRanks = Teuchos::GlobalMPISession::getNProc();
   _partitionDofCounts.resize(numRanks);
@@ -2135,7 +2289,8 @@ void GDAMinimumRule::rebuildLookups() {
   // global copy:
   MPIWrapper::entryWiseSum(globalCellIDDofOffsets);
   // fill in the lookup table:
-  _globalCellDofOffsets.clear();
+  map<GlobalIndexType, GlobalIndexType> previousGlobalCellDofOffsets;
+  previousGlobalCellDofOffsets.swap(_globalCellDofOffsets);
   int globalCellIndex = 0;
   for (int i=0; i<numRanks; i++) {
     set<GlobalIndexType> rankCellIDs = _partitions[i];
@@ -2147,6 +2302,26 @@ void GDAMinimumRule::rebuildLookups() {
     }
   }
   
+  // cached global dof indices are stale for cells whose offset moved, and dof mappers for cells that see dofs owned by those.
+  // Offsets are a prefix sum, so a change in one cell's owned dof count moves the offsets of every later cell (in this
+  // partition and in those of later ranks); refinement near the start of the ordering therefore rebuilds most mappers.
+  set<GlobalIndexType> shiftedCellIDs;
+  for (map<GlobalIndexType, GlobalIndexType>::iterator offsetIt = previousGlobalCellDofOffsets.begin(); offsetIt != previousGlobalCellDofOffsets.end(); offsetIt++) {
+    map<GlobalIndexType, GlobalIndexType>::iterator newOffsetIt = _globalCellDofOffsets.find(offsetIt->first);
+    if ((newOffsetIt == _globalCellDofOffsets.end()) || (newOffsetIt->second != offsetIt->second)) {
+      shiftedCellIDs.insert(offsetIt->first);
+    }
+  }
+  for (set<GlobalIndexType>::iterator cellIDIt = shiftedCellIDs.begin(); cellIDIt != shiftedCellIDs.end(); cellIDIt++) {
+    _ownedGlobalDofIndicesCache.erase(*cellIDIt);
+  }
+  // (cells whose own caches were invalidated above lost their mappers then, along with every cell referencing them)
+  set<GlobalIndexType> cellIDsWithStaleMappers = cellsReferencingCells(shiftedCellIDs);
+  for (set<GlobalIndexType>::iterator cellIDIt = cellIDsWithStaleMappers.begin(); cellIDIt != cellIDsWithStaleMappers.end(); cellIDIt++) {
+    _dofMapperCache.erase(*cellIDIt);
+    _dofMapperForVariableOnSideCache.erase(*cellIDIt);
+  }
+  
   _cellIDsForElementType = vector< map< ElementType*, vector<GlobalIndexType> > >(numRanks);
   for (int i=0; i<numRanks; i++) {
     set<GlobalIndexType> cellIDs = _partitions[i];
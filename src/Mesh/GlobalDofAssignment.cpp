@@ -35,6 +35,7 @@ GlobalDofAssignment::GlobalDofAssignment(MeshPtr mesh, VarFactory varFactory,
   _initialH1OrderTrial = initialH1OrderTrial;
   _testOrderEnhancement = testOrderEnhancement;
   _enforceConformityLocally = enforceConformityLocally;
+  _dofAssignmentVersion = 0;
   
 //  unsigned testOrder = initialH1OrderTrial + testOrderEnhancement;
   // assign some initial element types:
@@ -90,6 +91,7 @@ GlobalDofAssignment::GlobalDofAssignment( GlobalDofAssignment &otherGDA ) : DofI
   _activeCellMap = Teuchos::rcp( new Epetra_Map(*otherGDA._activeCellMap) );
   
   _numPartitions = otherGDA._numPartitions;
+  _dofAssignmentVersion = otherGDA._dofAssignmentVersion;
   
   // we leave _registeredSolutions empty
   ///_registeredSolutions;
@@ -239,6 +241,10 @@ void GlobalDofAssignment::constructActiveCellMap() {
     _activeCellMap = Teuchos::rcp( new Epetra_Map(-1, myCellIDsFC.size(), &myCellIDsFC[0], indexBase, Comm) );
 }
 
+int GlobalDofAssignment::dofAssignmentVersion() {
+  return _dofAssignmentVersion;
+}
+
 void GlobalDofAssignment::repartitionAndMigrate() {
   _partitionPolicy->partitionMesh(_mesh.get(),_numPartitions);
   for (vector< Solution* >::iterator solutionIt = _registeredSolutions.begin();
@@ -178,36 +178,71 @@ vector<GlobalIndexType> LocalDofMapper::fittableGlobalIndices() {
   return _fittableGlobalIndices;
 }
 
+const LocalDofMapper::LocalToGlobalOperator & LocalDofMapper::localToGlobalOperator(bool fittableGlobalDofsOnly) {
+  LocalToGlobalOperator* op = &_localToGlobalOperator[fittableGlobalDofsOnly ? 1 : 0];
+  if (op->columnOffsets.size() == 0) {
+    // the map is linear, so we can determine its columns by mapping each unit vector once
+    unsigned dofCount;
+    if (_varIDToMap == -1) {
+      dofCount = _dofOrdering->totalDofs();
+    } else {
+      dofCount = _dofOrdering->getBasisCardinality(_varIDToMap, _sideOrdinalToMap);
+    }
+    op->columnOffsets.resize(dofCount+1);
+    FieldContainer<double> unitVector(dofCount);
+    for (int j=0; j<dofCount; j++) {
+      op->columnOffsets[j] = op->globalOrdinals.size();
+      unitVector(j) = 1.0;
+      FieldContainer<double> mappedColumn = mapLocalData(unitVector, fittableGlobalDofsOnly);
+      unitVector(j) = 0.0;
+      for (int i=0; i<mappedColumn.size(); i++) {
+        if (mappedColumn(i) != 0.0) {
+          op->globalOrdinals.push_back(i);
+          op->weights.push_back(mappedColumn(i));
+        }
+      }
+    }
+    op->columnOffsets[dofCount] = op->globalOrdinals.size();
+  }
+  return *op;
+}
+
 FieldContainer<double> LocalDofMapper::mapLocalDataMatrix(const FieldContainer<double> &localData, bool fittableGlobalDofsOnly) {
   int dataSize = localData.dimension(0);
   if (localData.dimension(1) != dataSize) {
     cout << "Error: localData matrix must be square.\n";
     TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "localData matrix must be square");
   }
-  FieldContainer<double> dataVector(dataSize);
-  FieldContainer<double> intermediateDataMatrix;
-  int mappedDataSize;
-  for (int i=0; i<dataSize; i++) {
-    for (int j=0; j<dataSize; j++) {
-      dataVector(j) = localData(i,j);
-    }
-    FieldContainer<double> mappedDataVector = mapLocalData(dataVector, fittableGlobalDofsOnly);
-    if (i==0) { // size intermediateDataMatrix once we know the entry for the first row
-      mappedDataSize = mappedDataVector.size();
-      intermediateDataMatrix.resize(dataSize,mappedDataSize);
-    }
-    for (int j=0; j<mappedDataSize; j++) {
-      intermediateDataMatrix(i,j) = mappedDataVector(j);
+  // with C^T the local-to-global operator, globalData = C^T * localData * C
+  const LocalToGlobalOperator* op = &localToGlobalOperator(fittableGlobalDofsOnly);
+  
+  int mappedDataSize = _globalIndexToOrdinal.size();
+  if ((mappedDataSize == 0) || (dataSize == 0)) {
+    return FieldContainer<double>(mappedDataSize,mappedDataSize);
+  }
+  
+  // first, intermediateDataMatrix = localData * C
+  FieldContainer<double> intermediateDataMatrix(dataSize,mappedDataSize);
+  for (int j=0; j<dataSize; j++) {
+    for (unsigned k=op->columnOffsets[j]; k<op->columnOffsets[j+1]; k++) {
+      unsigned mappedOrdinal = op->globalOrdinals[k];
+      double weight = op->weights[k];
+      for (int i=0; i<dataSize; i++) {
+        intermediateDataMatrix(i,mappedOrdinal) += localData(i,j) * weight;
+      }
     }
   }
+  
+  // then, globalData = C^T * intermediateDataMatrix
   FieldContainer<double> globalData(mappedDataSize,mappedDataSize);
-  for (int j=0; j<mappedDataSize; j++) {
-    for (int i=0; i<dataSize; i++) {
-      dataVector(i) = intermediateDataMatrix(i,j);
-    }
-    FieldContainer<double> mappedDataVector = mapLocalData(dataVector, fittableGlobalDofsOnly);
-    for (int i=0; i<mappedDataSize; i++) {
-      globalData(i,j) = mappedDataVector(i);
+  for (int i=0; i<dataSize; i++) {
+    const double* intermediateRow = &intermediateDataMatrix(i,0);
+    for (unsigned k=op->columnOffsets[i]; k<op->columnOffsets[i+1]; k++) {
+      double* globalRow = &globalData(op->globalOrdinals[k],0);
+      double weight = op->weights[k];
+      for (int j=0; j<mappedDataSize; j++) {
+        globalRow[j] += weight * intermediateRow[j];
+      }
     }
   }
   return globalData;
@@ -277,6 +312,10 @@ FieldContainer<double> LocalDofMapper::fitLocalCoefficients(const FieldContainer
   return fittableGlobalCoefficients;
 }
 
+void LocalDofMapper::prepareMatrixMapping(bool fittableGlobalDofsOnly) {
+  localToGlobalOperator(fittableGlobalDofsOnly);
+}
+
 FieldContainer<double> LocalDofMapper::mapLocalData(const FieldContainer<double> &localData, bool fittableGlobalDofsOnly) {
   unsigned dofCount;
   if (_varIDToMap == -1) {
@@ -489,4 +528,7 @@ void LocalDofMapper::reverseParity(set<int> fluxVarIDs, set<unsigned int> sideOr
     }
   }
   _localCoefficientsFitMatrix.resize(0); // this will need to be recomputed
+  for (int i=0; i<2; i++) {
+    _localToGlobalOperator[i] = LocalToGlobalOperator(); // so will this
+  }
 }
\ No newline at end of file
@@ -64,6 +64,7 @@
 #include "MeshFactory.h"
 
 #include "MPIWrapper.h"
+#include "PhaseTimers.h"
 
 #include "ZoltanMeshPartitionPolicy.h"
 
@@ -552,6 +553,8 @@ void Mesh::hRefine(const set<GlobalIndexType> &cellIDs, Teuchos::RCP<RefinementP
 void Mesh::hRefine(const set<GlobalIndexType> &cellIDs, Teuchos::RCP<RefinementPattern> refPattern, bool repartitionAndRebuild) {
   if (cellIDs.size() == 0) return;
   
+  ScopedPhaseTimer phaseTimer("h-refinement");
+  
   // send h-refinement message any registered observers (may be meshes)
   for (vector< Teuchos::RCP<RefinementObserver> >::iterator meshIt = _registeredObservers.begin();
        meshIt != _registeredObservers.end(); meshIt++) {
@@ -711,6 +714,10 @@ void Mesh::interpretLocalData(GlobalIndexType cellID, const FieldContainer<doubl
   _gda->interpretLocalData(cellID, localDofs, globalDofs, globalDofIndices);
 }
 
+bool Mesh::prepareForConcurrentInterpretation(const set<GlobalIndexType> &cellIDs) {
+  return _gda->prepareForConcurrentInterpretation(cellIDs);
+}
+
 GlobalIndexType Mesh::numActiveElements() {
   return _meshTopology->activeCellCount();
 }
@@ -803,7 +810,7 @@ FieldContainer<double> Mesh::physicalCellNodesForCell( GlobalIndexType cellID )
   for (int vertex=0; vertex<vertexCount; vertex++) {
     unsigned vertexIndex = vertexIndices[vertex];
     for (int i=0; i<spaceDim; i++) {
-      physicalCellNodes(0,vertex,i) = _meshTopology->getVertex(vertexIndex)[i];
+      physicalCellNodes(0,vertex,i) = _meshTopology->getVertexCoordinate(vertexIndex, i);
     }
   }
   return physicalCellNodes;
@@ -888,6 +895,8 @@ void Mesh::pRefine(const set<GlobalIndexType> &cellIDsForPRefinements){
 void Mesh::pRefine(const set<GlobalIndexType> &cellIDsForPRefinements, int pToAdd) {
   if (cellIDsForPRefinements.size() == 0) return;
   
+  ScopedPhaseTimer phaseTimer("p-refinement");
+  
   // refine any registered meshes
   for (vector< Teuchos::RCP<RefinementObserver> >::iterator meshIt = _registeredObservers.begin();
        meshIt != _registeredObservers.end(); meshIt++) {
@@ -933,6 +942,7 @@ int Mesh::condensedRowSizeUpperBound() {
 }
 
 void Mesh::rebuildLookups() {
+  ScopedPhaseTimer phaseTimer("repartition and rebuild");
   _gda->repartitionAndMigrate();
   _boundary.buildLookupTables();
 }
@@ -1017,7 +1027,7 @@ FieldContainer<double> Mesh::vertexCoordinates(GlobalIndexType vertexIndex) {
   int spaceDim = _meshTopology->getSpaceDim();
   FieldContainer<double> vertex(spaceDim);
   for (int d=0; d<spaceDim; d++) {
-    vertex(d) = _meshTopology->getVertex(vertexIndex)[d];
+    vertex(d) = _meshTopology->getVertexCoordinate(vertexIndex, d);
   }
   return vertex;
 }
@@ -1044,7 +1054,7 @@ void Mesh::verticesForCell(FieldContainer<double>& vertices, GlobalIndexType cel
   //vertices.resize(numVertices,dimension);
   for (unsigned vertexIndex = 0; vertexIndex < numVertices; vertexIndex++) {
     for (int d=0; d<spaceDim; d++) {
-      vertices(vertexIndex,d) = _meshTopology->getVertex(vertexIndices[vertexIndex])[d];
+      vertices(vertexIndex,d) = _meshTopology->getVertexCoordinate(vertexIndices[vertexIndex], d);
     }
   }
 }
@@ -1104,7 +1114,7 @@ void Mesh::verticesForSide(FieldContainer<double>& vertices, GlobalIndexType cel
   
   for (unsigned vertexIndex = 0; vertexIndex < numVertices; vertexIndex++) {
     for (int d=0; d<spaceDim; d++) {
-      vertices(vertexIndex,d) = _meshTopology->getVertex(vertexIndex)[d];
+      vertices(vertexIndex,d) = _meshTopology->getVertexCoordinate(vertexIndex, d);
     }
   }
 }
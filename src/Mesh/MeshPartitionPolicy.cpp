@@ -9,6 +9,7 @@
 #include <iostream>
 
 #include "MeshPartitionPolicy.h"
+#include "SpaceFillingCurvePartitionPolicy.h"
 #include "ZoltanMeshPartitionPolicy.h"
 
 #include "GlobalDofAssignment.h"
@@ -20,22 +21,65 @@ void MeshPartitionPolicy::partitionMesh(Mesh *mesh, PartitionIndexType numPartit
   FieldContainer<GlobalIndexType> partitionedActiveCells(numPartitions,numActiveCells);
   
   partitionedActiveCells.initialize(-1); // cellID == -1 signals end of partition
-  int chunkSize = numActiveCells / numPartitions;
-  int remainder = numActiveCells % numPartitions;
-  IndexType activeCellIndex = 0;
   vector<GlobalIndexType> activeCellIDs;
   set<IndexType> cellIDSet = meshTopology->getActiveCellIndices();
   activeCellIDs.insert(activeCellIDs.begin(),cellIDSet.begin(),cellIDSet.end());
-  for (int i=0; i<numPartitions; i++) {
-    int chunkSizeWithRemainder = (i < remainder) ? chunkSize + 1 : chunkSize;
-    for (int j=0; j<chunkSizeWithRemainder; j++) {
-      partitionedActiveCells(i,j) = activeCellIDs[activeCellIndex];
-      activeCellIndex++;
+  if (_cellCostModel == Teuchos::null) {
+    int chunkSize = numActiveCells / numPartitions;
+    int remainder = numActiveCells % numPartitions;
+    IndexType activeCellIndex = 0;
+    for (int i=0; i<numPartitions; i++) {
+      int chunkSizeWithRemainder = (i < remainder) ? chunkSize + 1 : chunkSize;
+      for (int j=0; j<chunkSizeWithRemainder; j++) {
+        partitionedActiveCells(i,j) = activeCellIDs[activeCellIndex];
+        activeCellIndex++;
+      }
+    }
+  } else {
+    // ...or, with a cost model, into contiguous chunks of equal cost
+    map<GlobalIndexType, double> cellCosts = _cellCostModel->cellCosts(mesh);
+    vector<double> weights(numActiveCells);
+    for (int i=0; i<numActiveCells; i++) {
+      weights[i] = cellCosts[activeCellIDs[i]];
+    }
+    vector< set<GlobalIndexType> > partitions = splitByWeight(activeCellIDs, weights, numPartitions);
+    for (int i=0; i<numPartitions; i++) {
+      int j=0;
+      for (set<GlobalIndexType>::iterator cellIt = partitions[i].begin(); cellIt != partitions[i].end(); cellIt++, j++) {
+        partitionedActiveCells(i,j) = *cellIt;
+      }
     }
   }
   mesh->globalDofAssignment()->setPartitions(partitionedActiveCells);
 }
 
+CellCostModelPtr MeshPartitionPolicy::getCellCostModel() {
+  return _cellCostModel;
+}
+
+void MeshPartitionPolicy::setCellCostModel(CellCostModelPtr cellCostModel) {
+  _cellCostModel = cellCostModel;
+}
+
+vector< set<GlobalIndexType> > MeshPartitionPolicy::splitByWeight(const vector<GlobalIndexType> &orderedCellIDs,
+                                                                  const vector<double> &weights, PartitionIndexType numPartitions) {
+  double totalWeight = 0.0;
+  for (int i=0; i<weights.size(); i++) {
+    totalWeight += weights[i];
+  }
+
+  vector< set<GlobalIndexType> > partitions(numPartitions);
+  double weightBefore = 0.0;
+  for (int i=0; i<orderedCellIDs.size(); i++) {
+    double midpoint = weightBefore + 0.5 * weights[i];
+    PartitionIndexType partitionNumber = (totalWeight > 0.0) ? (PartitionIndexType) (midpoint * numPartitions / totalWeight) : 0;
+    if (partitionNumber >= numPartitions) partitionNumber = numPartitions - 1;
+    partitions[partitionNumber].insert(orderedCellIDs[i]);
+    weightBefore += weights[i];
+  }
+  return partitions;
+}
+
 MeshPartitionPolicyPtr MeshPartitionPolicy::standardPartitionPolicy() {
   MeshPartitionPolicyPtr partitionPolicy = Teuchos::rcp( new ZoltanMeshPartitionPolicy() );
   return partitionPolicy;
@@ -57,4 +101,8 @@ public:
 
 MeshPartitionPolicyPtr MeshPartitionPolicy::oneRankPartitionPolicy(int rankNumber) {
   return Teuchos::rcp( new OneRankPartitionPolicy(rankNumber) );
-}
\ No newline at end of file
+}
+
+MeshPartitionPolicyPtr MeshPartitionPolicy::spaceFillingCurvePartitionPolicy() {
+  return Teuchos::rcp( new SpaceFillingCurvePartitionPolicy() );
+}
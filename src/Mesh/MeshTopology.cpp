@@ -27,16 +27,22 @@ void MeshTopology::init(unsigned spaceDim) {
   // for nontrivial mesh topology, we store entities with dimension sideDim down to vertices, so _spaceDim total possibilities
   // for trivial mesh topology (just a node), we allow storage of 0-dimensional (vertex) entity
   int numEntityDimensions = (_spaceDim > 0) ? _spaceDim : 1;
-  _entities = vector< vector< vector< unsigned > > >(numEntityDimensions);
-  _knownEntities = vector< map< vector<unsigned>, unsigned > >(numEntityDimensions); // map keys are sets of vertices, values are entity indices in _entities[d]
-  _canonicalEntityOrdering = vector< vector< vector<unsigned> > >(numEntityDimensions);
+  _entityVertexOffsets = vector< vector<IndexType> >(numEntityDimensions, vector<IndexType>(1,0));
+  _entityVertices = vector< vector<IndexType> >(numEntityDimensions);
+  _entityHashBucketHeads = vector< vector<IndexType> >(numEntityDimensions);
+  _entityHashNext = vector< vector<IndexType> >(numEntityDimensions);
   _activeCellsForEntities = vector< vector< vector< pair<unsigned, unsigned> > > >(numEntityDimensions); // pair entries are (cellIndex, entityIndexInCell) (entityIndexInCell aka subcord)
   _sidesForEntities = vector< vector< vector< unsigned > > >(numEntityDimensions);
-  _parentEntities = vector< map< unsigned, vector< pair<unsigned, unsigned> > > >(numEntityDimensions); // map to possible parents
+  _entityParents = vector< vector<IndexType> >(numEntityDimensions);
   _generalizedParentEntities = vector< map<unsigned, pair<unsigned,unsigned> > >(numEntityDimensions);
-  _childEntities = vector< map< unsigned, vector< pair<RefinementPatternPtr, vector<unsigned> > > > >(numEntityDimensions);
+  _entityRefinementOrdinals = vector< vector<IndexType> >(numEntityDimensions);
+  _entityRefinements = vector< vector<EntityRefinement> >(numEntityDimensions);
+  _refinedEntityChildren = vector< vector<IndexType> >(numEntityDimensions);
   _entityCellTopologyKeys = vector< vector< CellTopologyKey > >(numEntityDimensions);
   
+  _vertexHashCellWidth = 0; // set when the hash is first built
+  _vertexHashMinCellWidth = 0;
+  
   _gda = NULL;
 }
 
@@ -60,7 +66,7 @@ MeshTopology::MeshTopology(MeshGeometryPtr meshGeometry, vector<PeriodicBCPtr> p
   //  _vertices = meshGeometry->vertices();
   
   //  for (int vertexIndex=0; vertexIndex<_vertices.size(); vertexIndex++) {
-  //    _vertexMap[_vertices[vertexIndex]] = vertexIndex;
+  //    addVertexToHash(vertexIndex);
   //  }
   
   TEUCHOS_TEST_FOR_EXCEPTION(meshGeometry->cellTopos().size() != meshGeometry->elementVertices().size(), std::invalid_argument,
@@ -141,13 +147,9 @@ map<string, long long> MeshTopology::approximateMemoryCosts() {
   
   variableCost["_spaceDim"] = sizeof(_spaceDim);
   
-  variableCost["_vertexMap"] = approximateMapSizeLLVM(_vertexMap);
-  
-  variableCost["_vertices"] = VECTOR_OVERHEAD; // for the outer vector _vertices.
-  for (vector< vector<double> >::iterator entryIt = _vertices.begin(); entryIt != _vertices.end(); entryIt++) {
-    variableCost["_vertices"] += approximateVectorSizeLLVM(*entryIt);
-  }
-  variableCost["_vertices"] += VECTOR_OVERHEAD * (_vertices.capacity() - _vertices.size());
+  variableCost["_vertexCoordinates"] = approximateVectorSizeLLVM(_vertexCoordinates);
+  variableCost["_vertexHashBucketHeads"] = approximateVectorSizeLLVM(_vertexHashBucketHeads);
+  variableCost["_vertexHashNext"] = approximateVectorSizeLLVM(_vertexHashNext);
   
   variableCost["_periodicBCs"] = approximateVectorSizeLLVM(_periodicBCs);
   
@@ -160,35 +162,16 @@ map<string, long long> MeshTopology::approximateMemoryCosts() {
   
   variableCost["_equivalentNodeViaPeriodicBC"] = approximateMapSizeLLVM(_equivalentNodeViaPeriodicBC); // for map _equivalentNodeViaPeriodicBC
   
-  variableCost["_entities"] = VECTOR_OVERHEAD; // for outer vector _entities
-  for (vector< vector< vector<IndexType> > >::iterator entryIt = _entities.begin(); entryIt != _entities.end(); entryIt++) {
-    variableCost["_entities"] += VECTOR_OVERHEAD; //
-    for (vector< vector<IndexType> >::iterator entry2It = entryIt->begin(); entry2It != entryIt->end(); entry2It++) {
-      variableCost["_entities"] += approximateVectorSizeLLVM(*entry2It);
-    }
-    variableCost["_entities"] += VECTOR_OVERHEAD * (entryIt->capacity() - entryIt->size());
-  }
-  variableCost["_entities"] += VECTOR_OVERHEAD * (_entities.capacity() - _entities.size());
-  
-  variableCost["_knownEntities"] = VECTOR_OVERHEAD; // for outer vector _knownEntities
-  for (vector< map< vector<IndexType>, IndexType > >::iterator entryIt = _knownEntities.begin(); entryIt != _knownEntities.end(); entryIt++) {
-    variableCost["_knownEntities"] += MAP_OVERHEAD; // for inner map
-    for (map< vector<IndexType>, IndexType >::iterator entry2It = entryIt->begin(); entry2It != entryIt->end(); entry2It++) {
-      vector<IndexType> entryVector = entry2It->first;
-      variableCost["_knownEntities"] += approximateVectorSizeLLVM(entryVector) + sizeof(IndexType);
-    }
-  }
-  variableCost["_knownEntities"] += MAP_OVERHEAD * (_knownEntities.capacity() - _knownEntities.size());
-  
-  variableCost["_canonicalEntityOrdering"] = VECTOR_OVERHEAD; // for outer vector _canonicalEntityOrdering
-  for (vector< vector< vector<IndexType> > >::iterator entryIt = _canonicalEntityOrdering.begin(); entryIt != _canonicalEntityOrdering.end(); entryIt++) {
-    variableCost["_canonicalEntityOrdering"] += VECTOR_OVERHEAD;
-    for (vector< vector<IndexType> >::iterator entry2It = entryIt->begin(); entry2It != entryIt->end(); entry2It++) {
-      variableCost["_canonicalEntityOrdering"] += approximateVectorSizeLLVM(*entry2It);
-    }
-    variableCost["_canonicalEntityOrdering"] += VECTOR_OVERHEAD * (entryIt->capacity() - entryIt->size());
+  variableCost["_entityVertexOffsets"] = VECTOR_OVERHEAD * (_entityVertexOffsets.capacity() - _entityVertexOffsets.size());
+  variableCost["_entityVertices"] = VECTOR_OVERHEAD * (_entityVertices.capacity() - _entityVertices.size());
+  variableCost["_entityHashBucketHeads"] = VECTOR_OVERHEAD * (_entityHashBucketHeads.capacity() - _entityHashBucketHeads.size());
+  variableCost["_entityHashNext"] = VECTOR_OVERHEAD * (_entityHashNext.capacity() - _entityHashNext.size());
+  for (int d=0; d<_entityVertices.size(); d++) {
+    variableCost["_entityVertexOffsets"] += approximateVectorSizeLLVM(_entityVertexOffsets[d]);
+    variableCost["_entityVertices"] += approximateVectorSizeLLVM(_entityVertices[d]);
+    variableCost["_entityHashBucketHeads"] += approximateVectorSizeLLVM(_entityHashBucketHeads[d]);
+    variableCost["_entityHashNext"] += approximateVectorSizeLLVM(_entityHashNext[d]);
   }
-  variableCost["_canonicalEntityOrdering"] += MAP_OVERHEAD * (_canonicalEntityOrdering.capacity() - _canonicalEntityOrdering.size());
   
   variableCost["_activeCellsForEntities"] += VECTOR_OVERHEAD; // for outer vector _activeCellsForEntities
   for (vector< vector< vector< pair<IndexType, unsigned> > > >::iterator entryIt = _activeCellsForEntities.begin(); entryIt != _activeCellsForEntities.end(); entryIt++) {
@@ -211,43 +194,26 @@ map<string, long long> MeshTopology::approximateMemoryCosts() {
   }
   variableCost["_sidesForEntities"] += VECTOR_OVERHEAD * (_sidesForEntities.capacity() - _sidesForEntities.size());
   
-  variableCost["_cellsForSideEntities"] = approximateMapSizeLLVM(_cellsForSideEntities);
+  variableCost["_cellsForSideEntities"] = approximateVectorSizeLLVM(_cellsForSideEntities);
   
   variableCost["_boundarySides"] = approximateSetSizeLLVM(_boundarySides);
   
-  variableCost["_parentEntities"] = VECTOR_OVERHEAD; // vector _parentEntities
-  for (vector< map< IndexType, vector< pair<IndexType, unsigned> > > >::iterator entryIt = _parentEntities.begin(); entryIt != _parentEntities.end(); entryIt++) {
-    variableCost["_parentEntities"] += MAP_OVERHEAD; // map
-    for (map< IndexType, vector< pair<IndexType, unsigned> > > ::iterator entry2It = entryIt->begin(); entry2It != entryIt->end(); entry2It++) {
-      variableCost["_parentEntities"] += MAP_NODE_OVERHEAD; // map node
-      variableCost["_parentEntities"] += sizeof(IndexType);
-      variableCost["_parentEntities"] += approximateVectorSizeLLVM(entry2It->second);
-    }
-  }
-  variableCost["_parentEntities"] += MAP_OVERHEAD * (_parentEntities.capacity() - _parentEntities.size());
-  
   variableCost["_generalizedParentEntities"] = VECTOR_OVERHEAD; // vector _generalizedParentEntities
   for (vector< map< IndexType, pair<IndexType, unsigned> > >::iterator entryIt = _generalizedParentEntities.begin(); entryIt != _generalizedParentEntities.end(); entryIt++) {
     variableCost["_generalizedParentEntities"] += approximateMapSizeLLVM(*entryIt);
   }
   variableCost["_generalizedParentEntities"] += MAP_OVERHEAD * (_generalizedParentEntities.capacity() - _generalizedParentEntities.size());
   
-  variableCost["_childEntities"] = VECTOR_OVERHEAD; // vector _childEntities
-  for (vector< map< IndexType, vector< pair< RefinementPatternPtr, vector<IndexType> > > > >::iterator entryIt = _childEntities.begin(); entryIt != _childEntities.end(); entryIt++) {
-    variableCost["_childEntities"] += MAP_OVERHEAD; // map
-    for (map< IndexType, vector< pair< RefinementPatternPtr, vector<IndexType> > > >::iterator entry2It = entryIt->begin(); entry2It != entryIt->end(); entry2It++) {
-      variableCost["_childEntities"] += MAP_NODE_OVERHEAD; // map node
-      variableCost["_childEntities"] += sizeof(IndexType);
-      
-      variableCost["_childEntities"] += VECTOR_OVERHEAD; // vector
-      for (vector< pair< RefinementPatternPtr, vector<IndexType> > >::iterator entry3It = entry2It->second.begin(); entry3It != entry2It->second.end(); entry3It++) {
-        variableCost["_childEntities"] += sizeof(RefinementPatternPtr);
-        variableCost["_childEntities"] += approximateVectorSizeLLVM(entry3It->second);
-      }
-      variableCost["_childEntities"] += sizeof(pair< RefinementPatternPtr, vector<IndexType> >) * (entry2It->second.capacity() - entry2It->second.size());
-    }
+  variableCost["_entityParents"] = VECTOR_OVERHEAD * (_entityParents.capacity() - _entityParents.size());
+  variableCost["_entityRefinementOrdinals"] = VECTOR_OVERHEAD * (_entityRefinementOrdinals.capacity() - _entityRefinementOrdinals.size());
+  variableCost["_entityRefinements"] = VECTOR_OVERHEAD * (_entityRefinements.capacity() - _entityRefinements.size());
+  variableCost["_refinedEntityChildren"] = VECTOR_OVERHEAD * (_refinedEntityChildren.capacity() - _refinedEntityChildren.size());
+  for (int d=0; d<_entityParents.size(); d++) {
+    variableCost["_entityParents"] += approximateVectorSizeLLVM(_entityParents[d]);
+    variableCost["_entityRefinementOrdinals"] += approximateVectorSizeLLVM(_entityRefinementOrdinals[d]);
+    variableCost["_entityRefinements"] += approximateVectorSizeLLVM(_entityRefinements[d]);
+    variableCost["_refinedEntityChildren"] += approximateVectorSizeLLVM(_refinedEntityChildren[d]);
   }
-  variableCost["_childEntities"] += MAP_OVERHEAD * (_childEntities.capacity() - _childEntities.size());
   
   variableCost["_entityCellTopologyKeys"] = VECTOR_OVERHEAD; // _entityCellTopologyKeys vector
   for (vector< vector< CellTopologyKey > >::iterator entryIt = _entityCellTopologyKeys.begin(); entryIt != _entityCellTopologyKeys.end(); entryIt++) {
@@ -316,7 +282,7 @@ unsigned MeshTopology::addCell(CellTopoPtr cellTopo, const vector<unsigned> &cel
     else cellEntityPermutations.push_back(vector<unsigned>(0)); // empty vector for d=0 -- we don't track permutations here...
     cellEntityIndices[d] = vector<unsigned>(entityCount);
     for (int j=0; j<entityCount; j++) {
-      // for now, we treat vertices just like all the others--could save a bit of memory, etc. by not storing in _knownEntities[0], etc.
+      // vertices go through addEntity() like all the others, though vertex entities are implicit in the entity tables
       unsigned entityIndex, entityPermutation;
       vector< unsigned > nodes;
       if (d != 0) {
@@ -358,6 +324,9 @@ unsigned MeshTopology::addCell(CellTopoPtr cellTopo, const vector<unsigned> &cel
   _cells.push_back(cell);
   _activeCells.insert(cellIndex);
   _rootCells.insert(cellIndex); // will remove if a parent relationship is established
+  if (parentCellIndex == -1) {
+    _rootCellGridBinOffsets.clear(); // new root cell: point-location grid must be rebuilt
+  }
   if (parentCellIndex != -1) {
     cell->setParent(getCell(parentCellIndex));
   }
@@ -380,7 +349,7 @@ unsigned MeshTopology::addCell(CellTopoPtr cellTopo, const vector<unsigned> &cel
       firstCell->setNeighbor(firstNeighbor.second, secondNeighbor.first, secondNeighbor.second);
       secondCell->setNeighbor(secondNeighbor.second, firstNeighbor.first, firstNeighbor.second);
       if (_boundarySides.find(sideEntityIndex) != _boundarySides.end()) {
-        if (_childEntities[sideDim].find(sideEntityIndex) != _childEntities[sideDim].end()) {
+        if (entityRefinement(sideDim, sideEntityIndex) != NULL) {
           cout << "Unhandled case: boundary side acquired neighbor after being refined.\n";
           TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "Unhandled case: boundary side acquired neighbor after being refined");
         }
@@ -454,7 +423,11 @@ unsigned MeshTopology::addCell(CellTopoPtr cellTopo, const vector<unsigned> &cel
 }
 
 void MeshTopology::addCellForSide(unsigned int cellIndex, unsigned int sideOrdinal, unsigned int sideEntityIndex) {
-  if (_cellsForSideEntities.find(sideEntityIndex) == _cellsForSideEntities.end()) {
+  if (_cellsForSideEntities.size() <= sideEntityIndex) {
+    pair< unsigned, unsigned > noCell = make_pair(-1, -1);
+    _cellsForSideEntities.resize(sideEntityIndex + 1, make_pair(noCell, noCell));
+  }
+  if (_cellsForSideEntities[sideEntityIndex].first.first == -1) {
     pair< unsigned, unsigned > cell1 = make_pair(cellIndex, sideOrdinal);
     pair< unsigned, unsigned > cell2 = make_pair(-1, -1);
     _cellsForSideEntities[sideEntityIndex] = make_pair(cell1, cell2);
@@ -495,10 +468,10 @@ void MeshTopology::addEdgeCurve(pair<unsigned,unsigned> edge, ParametricCurvePtr
   
   std::sort(edgeNodes.begin(), edgeNodes.end());
   
-  if (_knownEntities[edgeDim].find(edgeNodes) == _knownEntities[edgeDim].end() ) {
+  unsigned edgeIndex = findEntity(edgeDim, edgeNodes);
+  if (edgeIndex == -1) {
     TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "edge not found.");
   }
-  unsigned edgeIndex = _knownEntities[edgeDim][edgeNodes];
   if (getChildEntities(edgeDim, edgeIndex).size() > 0) {
     TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "setting curves along broken edges not supported.  Should set for each piece separately.");
   }
@@ -538,6 +511,64 @@ void MeshTopology::addEdgeCurve(pair<unsigned,unsigned> edge, ParametricCurvePtr
   _cellIDsWithCurves.insert(cellID);
 }
 
+// shared by the entity and vertex hashes: folds value into hash
+static unsigned long long mixHash(unsigned long long hash, unsigned long long value) {
+  hash = hash * 0x9E3779B97F4A7C15ULL + value;
+  return hash ^ (hash >> 29);
+}
+
+static const IndexType ENTITY_HASH_NONE = -1;
+static const IndexType ENTITY_NONE = -1; // for the entity parent and refinement tables
+
+IndexType MeshTopology::entityHashBucket(unsigned d, const vector<IndexType> &sortedVertices) {
+  unsigned long long hash = 0;
+  for (int i=0; i<sortedVertices.size(); i++) {
+    hash = mixHash(hash, sortedVertices[i]);
+  }
+  return hash & (_entityHashBucketHeads[d].size() - 1);
+}
+
+void MeshTopology::addEntityToHash(unsigned d, IndexType entityIndex) {
+  // keep the load factor at most 1, doubling the bucket count (and rehashing) as needed
+  if (_entityHashBucketHeads[d].size() <= entityIndex) {
+    IndexType numBuckets = max((IndexType)64, 2 * (IndexType)_entityHashBucketHeads[d].size());
+    _entityHashBucketHeads[d].assign(numBuckets, ENTITY_HASH_NONE);
+    for (IndexType existingEntityIndex=0; existingEntityIndex<entityIndex; existingEntityIndex++) {
+      addEntityToHash(d, existingEntityIndex);
+    }
+  }
+  vector<IndexType> sortedVertices = getEntityVertexIndices(d, entityIndex);
+  std::sort(sortedVertices.begin(), sortedVertices.end());
+  IndexType bucket = entityHashBucket(d, sortedVertices);
+  if (_entityHashNext[d].size() <= entityIndex) _entityHashNext[d].resize(entityIndex + 1);
+  _entityHashNext[d][entityIndex] = _entityHashBucketHeads[d][bucket];
+  _entityHashBucketHeads[d][bucket] = entityIndex;
+}
+
+IndexType MeshTopology::findEntity(unsigned d, const vector<IndexType> &sortedVertices) {
+  if (d==0) {
+    if ((sortedVertices.size() == 1) && (sortedVertices[0] < vertexCount())) return sortedVertices[0];
+    return -1;
+  }
+  if (_entityHashBucketHeads[d].size() == 0) return -1;
+  IndexType bucket = entityHashBucket(d, sortedVertices);
+  for (IndexType entityIndex = _entityHashBucketHeads[d][bucket]; entityIndex != ENTITY_HASH_NONE; entityIndex = _entityHashNext[d][entityIndex]) {
+    IndexType offset = _entityVertexOffsets[d][entityIndex];
+    IndexType vertexCount = _entityVertexOffsets[d][entityIndex+1] - offset;
+    if (vertexCount != sortedVertices.size()) continue;
+    // entities have no repeated vertices, so it suffices to check that each vertex is present
+    bool matches = true;
+    for (IndexType i=0; i<vertexCount; i++) {
+      if (!std::binary_search(sortedVertices.begin(), sortedVertices.end(), _entityVertices[d][offset+i])) {
+        matches = false;
+        break;
+      }
+    }
+    if (matches) return entityIndex;
+  }
+  return -1;
+}
+
 unsigned MeshTopology::addEntity(CellTopoPtr entityTopo, const vector<unsigned> &entityVertices, unsigned &entityPermutation) {
   set< unsigned > nodeSet;
   nodeSet.insert(entityVertices.begin(),entityVertices.end());
@@ -552,10 +583,10 @@ unsigned MeshTopology::addEntity(CellTopoPtr entityTopo, const vector<unsigned>
   
   if ( entityIndex == -1 ) {
     // new entity
-    entityIndex = _entities[d].size();
-    _entities[d].push_back(sortedVertices);
-    _knownEntities[d].insert(make_pair(sortedVertices, entityIndex));
-    if (d != 0) _canonicalEntityOrdering[d].push_back(entityVertices);
+    entityIndex = getEntityCount(d);
+    _entityVertices[d].insert(_entityVertices[d].end(), entityVertices.begin(), entityVertices.end());
+    _entityVertexOffsets[d].push_back(_entityVertices[d].size());
+    addEntityToHash(d, entityIndex);
     entityPermutation = 0;
     if (_knownTopologies.find(entityTopo->getKey()) == _knownTopologies.end()) {
       _knownTopologies[entityTopo->getKey()] = entityTopo;
@@ -565,9 +596,9 @@ unsigned MeshTopology::addEntity(CellTopoPtr entityTopo, const vector<unsigned>
     // existing entity
     vector<IndexType> canonicalVertices = getCanonicalEntityNodesViaPeriodicBCs(d, entityVertices);
     //
-    //    Camellia::print("canonicalEntityOrdering",_canonicalEntityOrdering[d][entityIndex]);
+    //    Camellia::print("canonicalEntityOrdering",getEntityVertexIndices(d, entityIndex));
     if (d==0) entityPermutation = 0;
-    else entityPermutation = CamelliaCellTools::permutationMatchingOrder(entityTopo, _canonicalEntityOrdering[d][entityIndex], canonicalVertices);
+    else entityPermutation = CamelliaCellTools::permutationMatchingOrder(entityTopo, getEntityVertexIndices(d, entityIndex), canonicalVertices);
   }
   return entityIndex;
 }
@@ -620,7 +651,7 @@ vector<IndexType> MeshTopology::getCanonicalEntityNodesViaPeriodicBCs(unsigned d
   vector<IndexType> sortedNodes(myEntityNodes.begin(),myEntityNodes.end());
   std::sort(sortedNodes.begin(), sortedNodes.end());
   
-  if (_knownEntities[d].find(sortedNodes) != _knownEntities[d].end()) {
+  if (findEntity(d, sortedNodes) != -1) {
     return myEntityNodes;
   } else {
     // compute the intersection of the periodic BCs that match each node in nodeSet
@@ -658,7 +689,7 @@ vector<IndexType> MeshTopology::getCanonicalEntityNodesViaPeriodicBCs(unsigned d
       vector<IndexType> sortedEquivalentNodeVector = equivalentNodeVector;
       std::sort(sortedEquivalentNodeVector.begin(), sortedEquivalentNodeVector.end());
       
-      if (_knownEntities[d].find(sortedEquivalentNodeVector) != _knownEntities[d].end()) {
+      if (findEntity(d, sortedEquivalentNodeVector) != -1) {
         return equivalentNodeVector;
       }
     }
@@ -676,8 +707,8 @@ bool MeshTopology::cellHasCurvedEdges(unsigned cellIndex) {
   unsigned edgeDim = 1;
   for (int edgeOrdinal=0; edgeOrdinal<edgeCount; edgeOrdinal++) {
     unsigned edgeIndex = cell->entityIndex(edgeDim, edgeOrdinal);
-    unsigned v0 = _canonicalEntityOrdering[edgeDim][edgeIndex][0];
-    unsigned v1 = _canonicalEntityOrdering[edgeDim][edgeIndex][1];
+    unsigned v0 = _entityVertices[edgeDim][_entityVertexOffsets[edgeDim][edgeIndex]];
+    unsigned v1 = _entityVertices[edgeDim][_entityVertexOffsets[edgeDim][edgeIndex] + 1];
     pair<unsigned, unsigned> edge = make_pair(v0, v1);
     pair<unsigned, unsigned> edgeReversed = make_pair(v1, v0);
     if (_edgeToCurveMap.find(edge) != _edgeToCurveMap.end()) {
@@ -691,17 +722,18 @@ bool MeshTopology::cellHasCurvedEdges(unsigned cellIndex) {
 }
 
 bool MeshTopology::cellContainsPoint(GlobalIndexType cellID, const vector<double> &point, int cubatureDegree) {
-  // note that this design, with a single point being passed in, will be quite inefficient
-  // if there are many points.  TODO: revise to allow multiple points (returning vector<bool>, maybe)
-  int numCells = 1, numPoints = 1;
-  FieldContainer<double> physicalPoints(numCells,numPoints,_spaceDim);
+  FieldContainer<double> points(1,_spaceDim);
   for (int d=0; d<_spaceDim; d++) {
-    physicalPoints(0,0,d) = point[d];
+    points(0,d) = point[d];
   }
-  //  cout << "cell " << elem->cellID() << ": (" << x << "," << y << ") --> ";
-  FieldContainer<double> refPoints(numCells,numPoints,_spaceDim);
-  MeshTopologyPtr thisPtr = Teuchos::rcp(this,false);
-  CamelliaCellTools::mapToReferenceFrame(refPoints, physicalPoints, thisPtr, cellID, cubatureDegree);
+  return cellContainsPoints(cellID, points, cubatureDegree)[0];
+}
+
+vector<bool> MeshTopology::cellContainsPoints(GlobalIndexType cellID, const FieldContainer<double> &points, int cubatureDegree) {
+  // maps all the points to the cell's reference frame at once, so that the setup cost is paid once per cell rather than once per point
+  int numCells = 1, numPoints = points.dimension(0);
+  vector<bool> contained(numPoints,false);
+  if (numPoints == 0) return contained;
   
   CellTopoPtr cellTopo = getCell(cellID)->topology();
   
@@ -710,108 +742,282 @@ bool MeshTopology::cellContainsPoint(GlobalIndexType cellID, const vector<double
     // TODO: implement CamelliaCellTools::checkPointInclusion
   }
   
-  int result = CellTools<double>::checkPointInclusion(&refPoints[0], _spaceDim, cellTopo->getShardsTopology());
-  return result == 1;
+  FieldContainer<double> physicalPoints(numCells,numPoints,_spaceDim);
+  for (int ptOrdinal=0; ptOrdinal<numPoints; ptOrdinal++) {
+    for (int d=0; d<_spaceDim; d++) {
+      physicalPoints(0,ptOrdinal,d) = points(ptOrdinal,d);
+    }
+  }
+  FieldContainer<double> refPoints(numCells,numPoints,_spaceDim);
+  MeshTopologyPtr thisPtr = Teuchos::rcp(this,false);
+  CamelliaCellTools::mapToReferenceFrame(refPoints, physicalPoints, thisPtr, cellID, cubatureDegree);
+  
+  for (int ptOrdinal=0; ptOrdinal<numPoints; ptOrdinal++) {
+    int result = CellTools<double>::checkPointInclusion(&refPoints(0,ptOrdinal,0), _spaceDim, cellTopo->getShardsTopology());
+    contained[ptOrdinal] = (result == 1);
+  }
+  return contained;
+}
+
+void MeshTopology::getCellBoundingBox(IndexType cellIndex, vector<double> &boxMin, vector<double> &boxMax) {
+  CellPtr cell = getCell(cellIndex);
+  const vector<IndexType>* vertexIndices = &cell->vertices();
+  boxMin = getVertex((*vertexIndices)[0]);
+  boxMax = boxMin;
+  for (int vertexOrdinal=1; vertexOrdinal<vertexIndices->size(); vertexOrdinal++) {
+    const double* vertex = &_vertexCoordinates[(*vertexIndices)[vertexOrdinal] * _spaceDim];
+    for (int d=0; d<_spaceDim; d++) {
+      boxMin[d] = min(boxMin[d], vertex[d]);
+      boxMax[d] = max(boxMax[d], vertex[d]);
+    }
+  }
+  // pad the box so that points on the boundary are not lost to round-off
+  for (int d=0; d<_spaceDim; d++) {
+    double tol = 1e-10 * max(boxMax[d] - boxMin[d], max(std::abs(boxMin[d]), std::abs(boxMax[d]))) + 1e-14;
+    boxMin[d] -= tol;
+    boxMax[d] += tol;
+  }
+}
+
+int MeshTopology::rootCellGridBinOrdinal(int d, double x) {
+  double binCoordinate = floor((x - _rootCellGridMin[d]) / _rootCellGridBinWidth[d]);
+  if (binCoordinate < 0) return 0;
+  if (binCoordinate > _rootCellGridBinCounts[d] - 1) return _rootCellGridBinCounts[d] - 1;
+  return (int) binCoordinate;
+}
+
+void MeshTopology::buildRootCellGrid() {
+  int numRootCells = _rootCells.size();
+  _rootCellGridCellIndices.clear();
+  _rootCellGridBoxes.resize(numRootCells * 2 * _spaceDim);
+  _rootCellGridMin = vector<double>(_spaceDim, numeric_limits<double>::max());
+  vector<double> gridMax(_spaceDim, -numeric_limits<double>::max());
+  
+  vector<double> boxMin, boxMax;
+  for (set<IndexType>::iterator rootCellIt = _rootCells.begin(); rootCellIt != _rootCells.end(); rootCellIt++) {
+    int rootOrdinal = _rootCellGridCellIndices.size();
+    _rootCellGridCellIndices.push_back(*rootCellIt);
+    getCellBoundingBox(*rootCellIt, boxMin, boxMax);
+    for (int d=0; d<_spaceDim; d++) {
+      _rootCellGridBoxes[rootOrdinal * 2 * _spaceDim + d] = boxMin[d];
+      _rootCellGridBoxes[rootOrdinal * 2 * _spaceDim + _spaceDim + d] = boxMax[d];
+      _rootCellGridMin[d] = min(_rootCellGridMin[d], boxMin[d]);
+      gridMax[d] = max(gridMax[d], boxMax[d]);
+    }
+  }
+  
+  // roughly one root cell per bin: numRootCells^(1/spaceDim) bins in each dimension
+  int binsPerDimension = max(1, (int) ceil(pow((double) numRootCells, 1.0 / _spaceDim)));
+  _rootCellGridBinCounts = vector<int>(_spaceDim, binsPerDimension);
+  _rootCellGridBinWidth.resize(_spaceDim);
+  int numBins = 1;
+  for (int d=0; d<_spaceDim; d++) {
+    _rootCellGridBinWidth[d] = max((gridMax[d] - _rootCellGridMin[d]) / binsPerDimension, numeric_limits<double>::min());
+    numBins *= binsPerDimension;
+  }
+  
+  // each root cell is entered in every bin its box overlaps; first count, then fill
+  vector< vector<int> > binRanges(numRootCells, vector<int>(2 * _spaceDim));
+  vector<IndexType> binCounts(numBins, 0);
+  for (int pass=0; pass<2; pass++) {
+    vector<IndexType> binFill;
+    if (pass == 1) {
+      _rootCellGridBinOffsets.resize(numBins + 1);
+      _rootCellGridBinOffsets[0] = 0;
+      for (int binOrdinal=0; binOrdinal<numBins; binOrdinal++) {
+        _rootCellGridBinOffsets[binOrdinal+1] = _rootCellGridBinOffsets[binOrdinal] + binCounts[binOrdinal];
+      }
+      _rootCellGridBinEntries.resize(_rootCellGridBinOffsets[numBins]);
+      binFill = vector<IndexType>(_rootCellGridBinOffsets.begin(), _rootCellGridBinOffsets.end() - 1);
+    }
+    for (int rootOrdinal=0; rootOrdinal<numRootCells; rootOrdinal++) {
+      vector<int>* range = &binRanges[rootOrdinal];
+      if (pass == 0) {
+        for (int d=0; d<_spaceDim; d++) {
+          (*range)[d] = rootCellGridBinOrdinal(d, _rootCellGridBoxes[rootOrdinal * 2 * _spaceDim + d]);
+          (*range)[_spaceDim + d] = rootCellGridBinOrdinal(d, _rootCellGridBoxes[rootOrdinal * 2 * _spaceDim + _spaceDim + d]);
+        }
+      }
+      // iterate over the bins in the box, treating the bin indices like an odometer
+      vector<int> binIndex(range->begin(), range->begin() + _spaceDim);
+      while (true) {
+        int binOrdinal = 0;
+        for (int d=_spaceDim-1; d>=0; d--) {
+          binOrdinal = binOrdinal * _rootCellGridBinCounts[d] + binIndex[d];
+        }
+        if (pass == 0) binCounts[binOrdinal]++;
+        else _rootCellGridBinEntries[binFill[binOrdinal]++] = rootOrdinal;
+        int d = 0;
+        while ((d < _spaceDim) && (binIndex[d] == (*range)[_spaceDim + d])) {
+          binIndex[d] = (*range)[d];
+          d++;
+        }
+        if (d == _spaceDim) break;
+        binIndex[d]++;
+      }
+    }
+  }
 }
 
 vector<IndexType> MeshTopology::cellIDsForPoints(const FieldContainer<double> &physicalPoints) {
-  // returns a vector of an active element per point, or null if there is no element including that point
-  vector<GlobalIndexType> cellIDs;
-  //  cout << "entered elementsForPoints: \n" << physicalPoints;
+  // returns a vector of an active element per point, or -1 if there is no element including that point
   int numPoints = physicalPoints.dimension(0);
   
   int spaceDim = this->getSpaceDim();
   
-  set<GlobalIndexType> rootCellIndices = this->getRootCellIndices();
+  vector<GlobalIndexType> cellIDs(numPoints,-1);
+  if (numPoints == 0) return cellIDs;
+  
+  // NOTE: the grid does depend on the domain of the mesh remaining fixed after refinements begin.
+  if (_rootCellGridBinOffsets.size() == 0) {
+    buildRootCellGrid();
+  }
   
-  // NOTE: the above does depend on the domain of the mesh remaining fixed after refinements begin.
+  // vertex bounding boxes don't bound curvilinear cells, so root cells with curved edges are candidates for every point,
+  // and we don't use bounding boxes to rule out children in a curvilinear mesh
+  bool useBoundingBoxes = (_edgeToCurveMap.size() == 0);
+  vector<IndexType> curvedRootCells;
+  if (!useBoundingBoxes) {
+    for (set<IndexType>::iterator rootCellIt = _rootCells.begin(); rootCellIt != _rootCells.end(); rootCellIt++) {
+      if (cellHasCurvedEdges(*rootCellIt)) curvedRootCells.push_back(*rootCellIt);
+    }
+  }
   
+  // group the points by candidate root cell, so that each cell's containment test is done for many points at once
+  map< IndexType, vector<int> > candidatePointsForRootCell;
   for (int pointIndex=0; pointIndex<numPoints; pointIndex++) {
-    vector<double> point;
-    
-    for (int d=0; d<spaceDim; d++) {
-      point.push_back(physicalPoints(pointIndex,d));
+    int binOrdinal = 0;
+    for (int d=spaceDim-1; d>=0; d--) {
+      binOrdinal = binOrdinal * _rootCellGridBinCounts[d] + rootCellGridBinOrdinal(d, physicalPoints(pointIndex,d));
+    }
+    for (IndexType entry=_rootCellGridBinOffsets[binOrdinal]; entry<_rootCellGridBinOffsets[binOrdinal+1]; entry++) {
+      int rootOrdinal = _rootCellGridBinEntries[entry];
+      const double* box = &_rootCellGridBoxes[rootOrdinal * 2 * spaceDim];
+      bool inBox = true;
+      for (int d=0; d<spaceDim; d++) {
+        double x = physicalPoints(pointIndex,d);
+        if ((x < box[d]) || (x > box[spaceDim + d])) {
+          inBox = false;
+          break;
+        }
+      }
+      if (inBox) candidatePointsForRootCell[_rootCellGridCellIndices[rootOrdinal]].push_back(pointIndex);
+    }
+    for (int i=0; i<curvedRootCells.size(); i++) {
+      vector<int>* candidates = &candidatePointsForRootCell[curvedRootCells[i]];
+      if ((candidates->size() == 0) || (candidates->back() != pointIndex)) candidates->push_back(pointIndex);
+    }
+  }
+  
+  // map iterates in increasing cellIndex, so as before the lowest-indexed root cell containing a point wins
+  map< IndexType, vector<int> > pointsForCell;
+  for (map< IndexType, vector<int> >::iterator cellIt = candidatePointsForRootCell.begin(); cellIt != candidatePointsForRootCell.end(); cellIt++) {
+    GlobalIndexType cellID = cellIt->first;
+    vector<int> pointsToTest;
+    for (int i=0; i<cellIt->second.size(); i++) {
+      if (cellIDs[cellIt->second[i]] == -1) pointsToTest.push_back(cellIt->second[i]);
     }
+    if (pointsToTest.size() == 0) continue;
     
-    // find the element from the original mesh that contains this point
-    CellPtr cell;
-    for (set<GlobalIndexType>::iterator cellIt = rootCellIndices.begin(); cellIt != rootCellIndices.end(); cellIt++) {
-      GlobalIndexType cellID = *cellIt;
-      int cubatureDegreeForCell = 1;
-      if (_gda != NULL) {
-        cubatureDegreeForCell = _gda->getCubatureDegree(cellID);
+    int cubatureDegreeForCell = 1;
+    if (_gda != NULL) {
+      cubatureDegreeForCell = _gda->getCubatureDegree(cellID);
+    }
+    FieldContainer<double> points(pointsToTest.size(),spaceDim);
+    for (int i=0; i<pointsToTest.size(); i++) {
+      for (int d=0; d<spaceDim; d++) {
+        points(i,d) = physicalPoints(pointsToTest[i],d);
       }
-      if (cellContainsPoint(cellID,point,cubatureDegreeForCell)) {
-        cell = getCell(cellID);
-        break;
+    }
+    vector<bool> contained = cellContainsPoints(cellID, points, cubatureDegreeForCell);
+    for (int i=0; i<pointsToTest.size(); i++) {
+      if (contained[i]) {
+        cellIDs[pointsToTest[i]] = cellID;
+        pointsForCell[cellID].push_back(pointsToTest[i]);
       }
     }
-    if (cell.get() != NULL) {
-      while ( cell->isParent() ) {
-        int numChildren = cell->numChildren();
-        bool foundMatchingChild = false;
-        for (int childOrdinal = 0; childOrdinal < numChildren; childOrdinal++) {
-          CellPtr child = cell->children()[childOrdinal];
-          int cubatureDegreeForCell = 1;
-          if (_gda != NULL) {
-            cubatureDegreeForCell = _gda->getCubatureDegree(child->cellIndex());
+  }
+  
+  // descend the refinement tree one level at a time, again testing all the points in a parent against each child at once
+  vector<double> boxMin, boxMax;
+  while (pointsForCell.size() > 0) {
+    map< IndexType, vector<int> > pointsForChildCell;
+    for (map< IndexType, vector<int> >::iterator cellIt = pointsForCell.begin(); cellIt != pointsForCell.end(); cellIt++) {
+      CellPtr cell = getCell(cellIt->first);
+      if (!cell->isParent()) continue; // active cell: cellIDs already holds the answer
+      
+      int numChildren = cell->numChildren();
+      vector<int> unmatchedPoints = cellIt->second;
+      for (int childOrdinal = 0; childOrdinal < numChildren; childOrdinal++) {
+        if (unmatchedPoints.size() == 0) break;
+        CellPtr child = cell->children()[childOrdinal];
+        vector<int> pointsToTest, remainingPoints;
+        if (useBoundingBoxes) {
+          getCellBoundingBox(child->cellIndex(), boxMin, boxMax);
+          for (int i=0; i<unmatchedPoints.size(); i++) {
+            bool inBox = true;
+            for (int d=0; d<spaceDim; d++) {
+              double x = physicalPoints(unmatchedPoints[i],d);
+              if ((x < boxMin[d]) || (x > boxMax[d])) {
+                inBox = false;
+                break;
+              }
+            }
+            if (inBox) pointsToTest.push_back(unmatchedPoints[i]);
+            else remainingPoints.push_back(unmatchedPoints[i]);
           }
-          if ( cellContainsPoint(child->cellIndex(),point,cubatureDegreeForCell) ) {
-            cell = child;
-            foundMatchingChild = true;
-            break;
+        } else {
+          pointsToTest = unmatchedPoints;
+        }
+        if (pointsToTest.size() == 0) continue;
+        
+        int cubatureDegreeForCell = 1;
+        if (_gda != NULL) {
+          cubatureDegreeForCell = _gda->getCubatureDegree(child->cellIndex());
+        }
+        FieldContainer<double> points(pointsToTest.size(),spaceDim);
+        for (int i=0; i<pointsToTest.size(); i++) {
+          for (int d=0; d<spaceDim; d++) {
+            points(i,d) = physicalPoints(pointsToTest[i],d);
           }
         }
-        if (!foundMatchingChild) {
-          cout << "parent matches, but none of its children do... will return nearest cell centroid\n";
-          int numVertices = cell->vertices().size();
-          FieldContainer<double> vertices(numVertices,spaceDim);
-          vector<unsigned> vertexIndices = cell->vertices();
-          
-          //vertices.resize(numVertices,dimension);
-          for (unsigned vertexOrdinal = 0; vertexOrdinal < numVertices; vertexOrdinal++) {
-            for (int d=0; d<spaceDim; d++) {
-              vertices(vertexOrdinal,d) = getVertex(vertexIndices[vertexOrdinal])[d];
-            }
+        vector<bool> contained = cellContainsPoints(child->cellIndex(), points, cubatureDegreeForCell);
+        for (int i=0; i<pointsToTest.size(); i++) {
+          if (contained[i]) {
+            cellIDs[pointsToTest[i]] = child->cellIndex();
+            pointsForChildCell[child->cellIndex()].push_back(pointsToTest[i]);
+          } else {
+            remainingPoints.push_back(pointsToTest[i]);
+          }
+        }
+        unmatchedPoints = remainingPoints;
+      }
+      
+      for (int i=0; i<unmatchedPoints.size(); i++) {
+        int pointIndex = unmatchedPoints[i];
+        cout << "parent matches, but none of its children do... will return nearest cell centroid\n";
+        double minDistance = numeric_limits<double>::max();
+        int childSelected = -1;
+        for (int childIndex = 0; childIndex < numChildren; childIndex++) {
+          CellPtr child = cell->children()[childIndex];
+          vector<double> cellCentroid = getCellCentroid(child->cellIndex());
+          double squaredDistance = 0;
+          for (int d=0; d<spaceDim; d++) {
+            squaredDistance += (cellCentroid[d] - physicalPoints(pointIndex,d)) * (cellCentroid[d] - physicalPoints(pointIndex,d));
           }
           
-          cout << "parent vertices:\n" << vertices;
-          double minDistance = numeric_limits<double>::max();
-          int childSelected = -1;
-          for (int childIndex = 0; childIndex < numChildren; childIndex++) {
-            CellPtr child = cell->children()[childIndex];
-            int numVertices = child->vertices().size();
-            FieldContainer<double> vertices(numVertices,spaceDim);
-            vector<unsigned> vertexIndices = child->vertices();
-            
-            //vertices.resize(numVertices,dimension);
-            for (unsigned vertexOrdinal = 0; vertexOrdinal < numVertices; vertexOrdinal++) {
-              for (int d=0; d<spaceDim; d++) {
-                vertices(vertexOrdinal,d) = getVertex(vertexIndices[vertexOrdinal])[d];
-              }
-            }
-            cout << "child " << childIndex << ", vertices:\n" << vertices;
-            vector<double> cellCentroid = getCellCentroid(child->cellIndex());
-            double squaredDistance = 0;
-            for (int d=0; d<spaceDim; d++) {
-              squaredDistance += (cellCentroid[d] - physicalPoints(pointIndex,d)) * (cellCentroid[d] - physicalPoints(pointIndex,d));
-            }
-            
-            double distance = sqrt(squaredDistance);
-            if (distance < minDistance) {
-              minDistance = distance;
-              childSelected = childIndex;
-            }
+          double distance = sqrt(squaredDistance);
+          if (distance < minDistance) {
+            minDistance = distance;
+            childSelected = childIndex;
           }
-          cell = cell->children()[childSelected];
         }
+        IndexType childCellIndex = cell->children()[childSelected]->cellIndex();
+        cellIDs[pointIndex] = childCellIndex;
+        pointsForChildCell[childCellIndex].push_back(pointIndex);
       }
     }
-    GlobalIndexType cellID = -1;
-    if (cell.get() != NULL) {
-      cellID = cell->cellIndex();
-    }
-    cellIDs.push_back(cellID);
+    pointsForCell = pointsForChildCell;
   }
   return cellIDs;
 }
@@ -890,7 +1096,7 @@ vector<double> MeshTopology::getCellCentroid(IndexType cellIndex) {
   for (unsigned vertexOrdinal=0; vertexOrdinal<vertexCount; vertexOrdinal++) {
     unsigned vertexIndex = cell->vertices()[vertexOrdinal];
     for (unsigned d=0; d<_spaceDim; d++) {
-      centroid[d] += _vertices[vertexIndex][d];
+      centroid[d] += _vertexCoordinates[vertexIndex * _spaceDim + d];
     }
   }
   for (unsigned d=0; d<_spaceDim; d++) {
@@ -900,7 +1106,7 @@ vector<double> MeshTopology::getCellCentroid(IndexType cellIndex) {
 }
 
 unsigned MeshTopology::getCellCountForSide(IndexType sideEntityIndex) {
-  if (_cellsForSideEntities.find(sideEntityIndex) == _cellsForSideEntities.end()) {
+  if ((_cellsForSideEntities.size() <= sideEntityIndex) || (_cellsForSideEntities[sideEntityIndex].first.first == -1)) {
     return 0;
   } else {
     pair<IndexType, unsigned> cell1 = _cellsForSideEntities[sideEntityIndex].first;
@@ -914,10 +1120,12 @@ unsigned MeshTopology::getCellCountForSide(IndexType sideEntityIndex) {
 }
 
 pair<IndexType, unsigned> MeshTopology::getFirstCellForSide(IndexType sideEntityIndex) {
+  if (_cellsForSideEntities.size() <= sideEntityIndex) return make_pair(-1,-1);
   return _cellsForSideEntities[sideEntityIndex].first;
 }
 
 pair<IndexType, unsigned> MeshTopology::getSecondCellForSide(IndexType sideEntityIndex) {
+  if (_cellsForSideEntities.size() <= sideEntityIndex) return make_pair(-1,-1);
   return _cellsForSideEntities[sideEntityIndex].second;
 }
 
@@ -927,7 +1135,7 @@ void MeshTopology::deactivateCell(CellPtr cell) {
   for (int d=0; d<_spaceDim; d++) { // start with vertices, and go up to sides
     int entityCount = cellTopo->getSubcellCount(d);
     for (int j=0; j<entityCount; j++) {
-      // for now, we treat vertices just like all the others--could save a bit of memory, etc. by not storing in _knownEntities[0], etc.
+      // for now, we treat vertices just like all the others
       int entityNodeCount = cellTopo->getNodeCount(d, j);
       set< unsigned > nodeSet;
       if (d != 0) {
@@ -1050,12 +1258,10 @@ set<unsigned> MeshTopology::descendants(unsigned d, unsigned entityIndex) {
   set<unsigned> allDescendants;
   
   allDescendants.insert(entityIndex);
-  if (_childEntities[d].find(entityIndex) != _childEntities[d].end()) {
-    set<unsigned> unfollowedDescendants;
-    for (unsigned i=0; i<_childEntities[d][entityIndex].size(); i++) {
-      vector<unsigned> immediateChildren = _childEntities[d][entityIndex][i].second;
-      unfollowedDescendants.insert(immediateChildren.begin(), immediateChildren.end());
-    }
+  const EntityRefinement* refinement = entityRefinement(d, entityIndex);
+  if (refinement != NULL) {
+    vector<unsigned> immediateChildren = entityRefinementChildren(d, refinement);
+    set<unsigned> unfollowedDescendants(immediateChildren.begin(), immediateChildren.end());
     for (set<unsigned>::iterator descIt=unfollowedDescendants.begin(); descIt!=unfollowedDescendants.end(); descIt++) {
       set<unsigned> myDescendants = descendants(d,*descIt);
       allDescendants.insert(myDescendants.begin(),myDescendants.end());
@@ -1066,31 +1272,40 @@ set<unsigned> MeshTopology::descendants(unsigned d, unsigned entityIndex) {
 }
 
 bool MeshTopology::entityHasChildren(unsigned int d, IndexType entityIndex) {
-  if (_childEntities[d].find(entityIndex) == _childEntities[d].end()) return false;
-  return _childEntities[d][entityIndex].size() > 0;
+  return entityRefinement(d, entityIndex) != NULL;
 }
 
 bool MeshTopology::entityHasParent(unsigned d, unsigned entityIndex) {
-  if (_parentEntities[d].find(entityIndex) == _parentEntities[d].end()) return false;
-  return _parentEntities[d][entityIndex].size() > 0;
+  return entityParent(d, entityIndex) != ENTITY_NONE;
 }
 
 bool MeshTopology::entityIsAncestor(unsigned d, unsigned ancestor, unsigned descendent) {
-  map< unsigned, vector< pair<unsigned, unsigned> > >::iterator parentIt = _parentEntities[d].find(descendent);
-  while (parentIt != _parentEntities[d].end()) {
-    vector< pair<unsigned, unsigned> > parents = parentIt->second;
-    unsigned parentEntityIndex = -1;
-    for (vector< pair<unsigned, unsigned> >::iterator entryIt = parents.begin(); entryIt != parents.end(); entryIt++) {
-      parentEntityIndex = entryIt->first;
-      if (parentEntityIndex==ancestor) {
-        return true;
-      }
+  for (IndexType parentEntityIndex = entityParent(d, descendent); parentEntityIndex != ENTITY_NONE;
+       parentEntityIndex = entityParent(d, parentEntityIndex)) {
+    if (parentEntityIndex==ancestor) {
+      return true;
     }
-    parentIt = _parentEntities[d].find(parentEntityIndex);
   }
   return false;
 }
 
+IndexType MeshTopology::entityParent(unsigned d, IndexType entityIndex) {
+  if ((d >= _entityParents.size()) || (entityIndex >= _entityParents[d].size())) return ENTITY_NONE;
+  return _entityParents[d][entityIndex];
+}
+
+const MeshTopology::EntityRefinement* MeshTopology::entityRefinement(unsigned d, IndexType entityIndex) {
+  if ((d >= _entityRefinementOrdinals.size()) || (entityIndex >= _entityRefinementOrdinals[d].size())) return NULL;
+  IndexType refinementOrdinal = _entityRefinementOrdinals[d][entityIndex];
+  if (refinementOrdinal == ENTITY_NONE) return NULL;
+  return &_entityRefinements[d][refinementOrdinal];
+}
+
+vector<IndexType> MeshTopology::entityRefinementChildren(unsigned d, const EntityRefinement* refinement) {
+  const IndexType* children = &_refinedEntityChildren[d][refinement->childOffset];
+  return vector<IndexType>(children, children + refinement->childCount);
+}
+
 unsigned MeshTopology::getActiveCellCount(unsigned int d, unsigned int entityIndex) {
   if (_activeCellsForEntities[d].size() <= entityIndex) {
     return 0;
@@ -1112,8 +1327,8 @@ CellPtr MeshTopology::getCell(unsigned cellIndex) {
 }
 
 unsigned MeshTopology::getEntityCount(unsigned int d) {
-  if (d==0) return _vertices.size();
-  return _entities[d].size();
+  if (d==0) return vertexCount();
+  return _entityVertexOffsets[d].size() - 1;
 }
 
 pair<IndexType, unsigned> MeshTopology::getEntityGeneralizedParent(unsigned int d, IndexType entityIndex) {
@@ -1153,8 +1368,9 @@ unsigned MeshTopology::getEntityIndex(unsigned d, const set<unsigned> &nodeSet)
     }
   }
   vector<unsigned> sortedNodes(nodeSet.begin(),nodeSet.end());
-  if (_knownEntities[d].find(sortedNodes) != _knownEntities[d].end()) {
-    return _knownEntities[d][sortedNodes];
+  IndexType entityIndex = findEntity(d, sortedNodes);
+  if (entityIndex != -1) {
+    return entityIndex;
   } else {
     // look for alternative, equivalent nodeSets, arrived at via periodic BCs
     vector<IndexType> nodeVector(nodeSet.begin(),nodeSet.end());
@@ -1165,9 +1381,7 @@ unsigned MeshTopology::getEntityIndex(unsigned d, const set<unsigned> &nodeSet)
       std::sort(sortedEquivalentNodeVector.begin(), sortedEquivalentNodeVector.end());
       
 //      set<IndexType> equivalentNodeSet(equivalentNodeVector.begin(),equivalentNodeVector.end());
-      if (_knownEntities[d].find(sortedEquivalentNodeVector) != _knownEntities[d].end()) {
-        return _knownEntities[d][sortedEquivalentNodeVector];
-      }
+      return findEntity(d, sortedEquivalentNodeVector);
     }
   }
   return -1;
@@ -1175,7 +1389,8 @@ unsigned MeshTopology::getEntityIndex(unsigned d, const set<unsigned> &nodeSet)
 
 unsigned MeshTopology::getEntityParent(unsigned d, unsigned entityIndex, unsigned parentOrdinal) {
   TEUCHOS_TEST_FOR_EXCEPTION(! entityHasParent(d, entityIndex), std::invalid_argument, "entity does not have parent");
-  return _parentEntities[d][entityIndex][parentOrdinal].first;
+  TEUCHOS_TEST_FOR_EXCEPTION(parentOrdinal != 0, std::invalid_argument, "entities have at most one parent");
+  return entityParent(d, entityIndex);
 }
 
 CellTopoPtr MeshTopology::getEntityTopology(unsigned d, IndexType entityIndex) {
@@ -1195,13 +1410,14 @@ vector<unsigned> MeshTopology::getEntityVertexIndices(unsigned d, unsigned entit
   if (d==_spaceDim) {
     return getCell(entityIndex)->vertices();
   }
-  if (d > _canonicalEntityOrdering.size()) {
+  if (d > _entityVertexOffsets.size()) {
     TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "d out of bounds");
   }
-  if (_canonicalEntityOrdering[d].size() <= entityIndex) {
+  if (getEntityCount(d) <= entityIndex) {
     TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "entityIndex out of bounds");
   }
-  return _canonicalEntityOrdering[d][entityIndex];
+  return vector<IndexType>(_entityVertices[d].begin() + _entityVertexOffsets[d][entityIndex],
+                           _entityVertices[d].begin() + _entityVertexOffsets[d][entityIndex+1]);
 }
 
 set<unsigned> MeshTopology::getEntitiesForSide(unsigned sideEntityIndex, unsigned d) {
@@ -1301,34 +1517,131 @@ unsigned MeshTopology::getSubEntityIndex(unsigned int d, unsigned int entityInde
   return subEntityIndex;
 }
 
-const vector<double>& MeshTopology::getVertex(unsigned vertexIndex) {
-  return _vertices[vertexIndex];
+vector<double> MeshTopology::getVertex(unsigned vertexIndex) {
+  const double* vertex = &_vertexCoordinates[vertexIndex * _spaceDim];
+  return vector<double>(vertex, vertex + _spaceDim);
 }
 
-bool MeshTopology::getVertexIndex(const vector<double> &vertex, IndexType &vertexIndex, double tol) {
-  vector<double> vertexForLowerBound;
+static const IndexType VERTEX_HASH_NONE = -1;
+
+long long MeshTopology::vertexHashGridCoordinate(double x) {
+  double gridCoordinate = floor(x / _vertexHashCellWidth);
+  // clamp so that the conversion is well-defined for very large coordinates; such vertices simply share a bin
+  gridCoordinate = max(-1e18, min(1e18, gridCoordinate));
+  return (long long) gridCoordinate;
+}
+
+IndexType MeshTopology::vertexHashBucket(const vector<long long> &gridCell) {
+  unsigned long long hash = 0;
+  for (int d=0; d<gridCell.size(); d++) {
+    hash = mixHash(hash, (unsigned long long) gridCell[d]);
+  }
+  return hash & (_vertexHashBucketHeads.size() - 1);
+}
+
+void MeshTopology::addVertexToHash(IndexType vertexIndex) {
+  // keep the load factor at most 1, doubling the bucket count (and rehashing) as needed
+  if (_vertexHashBucketHeads.size() <= vertexIndex) {
+    rebuildVertexHash(vertexIndex);
+  }
+  vector<long long> gridCell(_spaceDim);
   for (int d=0; d<_spaceDim; d++) {
-    vertexForLowerBound.push_back(vertex[d]-tol);
+    gridCell[d] = vertexHashGridCoordinate(_vertexCoordinates[vertexIndex * _spaceDim + d]);
   }
+  IndexType bucket = vertexHashBucket(gridCell);
+  if (_vertexHashNext.size() <= vertexIndex) _vertexHashNext.resize(vertexIndex + 1);
+  _vertexHashNext[vertexIndex] = _vertexHashBucketHeads[bucket];
+  _vertexHashBucketHeads[bucket] = vertexIndex;
+}
+
+void MeshTopology::rebuildVertexHash(IndexType numVertices) {
+  IndexType numBuckets = 64;
+  while (numBuckets <= numVertices) numBuckets *= 2;
+  _vertexHashBucketHeads.assign(numBuckets, VERTEX_HASH_NONE);
   
-  map< vector<double>, unsigned >::iterator lowerBoundIt = _vertexMap.lower_bound(vertexForLowerBound);
+  // size the grid cells so that, were the vertices spread evenly over their bounding box, each would get about one;
+  // vertices added since the last rebuild are accounted for at the next doubling
+  IndexType numStoredVertices = _vertexCoordinates.size() / _spaceDim;
+  double extent = 0;
+  for (int d=0; d<_spaceDim; d++) {
+    double coordMin = _vertexCoordinates[d], coordMax = _vertexCoordinates[d];
+    for (IndexType storedVertexIndex=1; storedVertexIndex<numStoredVertices; storedVertexIndex++) {
+      coordMin = min(coordMin, _vertexCoordinates[storedVertexIndex * _spaceDim + d]);
+      coordMax = max(coordMax, _vertexCoordinates[storedVertexIndex * _spaceDim + d]);
+    }
+    extent = max(extent, coordMax - coordMin);
+  }
+  double verticesPerDimension = pow((double)max(numVertices, (IndexType)1), 1.0 / _spaceDim);
+  _vertexHashCellWidth = max(extent / verticesPerDimension, _vertexHashMinCellWidth);
+  if (_vertexHashCellWidth == 0) _vertexHashCellWidth = 1.0; // a single vertex, and no tolerance requested yet
+  
+  for (IndexType existingVertexIndex=0; existingVertexIndex<numVertices; existingVertexIndex++) {
+    addVertexToHash(existingVertexIndex);
+  }
+}
+
+bool MeshTopology::getVertexIndex(const vector<double> &vertex, IndexType &vertexIndex, double tol) {
   long bestMatchIndex = -1;
   double bestMatchDistance = tol;
-  double xDist = 0; // xDist because vector<double> sorts according to the first entry: so we'll end up looking at
-  // all the vertices that are near (x,...) in x...
-  while ((lowerBoundIt != _vertexMap.end()) && (xDist < tol)) {
-    double dist = 0;
-    for (int d=0; d<_spaceDim; d++) {
-      double ddist = (lowerBoundIt->first[d] - vertex[d]);
-      dist += ddist * ddist;
+  
+  IndexType numVertices = vertexCount();
+  if (numVertices == 0) return false;
+  
+  // the tolerance bounds the grid cell width from below, so that the search box spans at most a few grid cells per dimension
+  if (tol > _vertexHashMinCellWidth) {
+    _vertexHashMinCellWidth = tol;
+    if (tol > _vertexHashCellWidth) rebuildVertexHash(numVertices);
+  }
+  
+  // any vertex within tol of the given one lies in one of the grid cells spanned by the box [vertex-tol, vertex+tol]
+  vector<long long> gridCellMin(_spaceDim), gridCellMax(_spaceDim);
+  double numGridCells = 1;
+  for (int d=0; d<_spaceDim; d++) {
+    gridCellMin[d] = vertexHashGridCoordinate(vertex[d] - tol);
+    gridCellMax[d] = vertexHashGridCoordinate(vertex[d] + tol);
+    numGridCells *= (double)(gridCellMax[d] - gridCellMin[d] + 1);
+  }
+  
+  if (numGridCells > numVertices) {
+    // tolerance is large relative to the grid: cheaper just to check every vertex
+    for (IndexType candidateIndex=0; candidateIndex<numVertices; candidateIndex++) {
+      double dist = 0;
+      for (int d=0; d<_spaceDim; d++) {
+        double ddist = (_vertexCoordinates[candidateIndex * _spaceDim + d] - vertex[d]);
+        dist += ddist * ddist;
+      }
+      dist = sqrt( dist );
+      if (dist < bestMatchDistance) {
+        bestMatchDistance = dist;
+        bestMatchIndex = candidateIndex;
+      }
     }
-    dist = sqrt( dist );
-    if (dist < bestMatchDistance) {
-      bestMatchDistance = dist;
-      bestMatchIndex = lowerBoundIt->second;
+  } else {
+    vector<long long> gridCell = gridCellMin;
+    while (true) {
+      IndexType bucket = vertexHashBucket(gridCell);
+      for (IndexType candidateIndex = _vertexHashBucketHeads[bucket]; candidateIndex != VERTEX_HASH_NONE;
+           candidateIndex = _vertexHashNext[candidateIndex]) {
+        double dist = 0;
+        for (int d=0; d<_spaceDim; d++) {
+          double ddist = (_vertexCoordinates[candidateIndex * _spaceDim + d] - vertex[d]);
+          dist += ddist * ddist;
+        }
+        dist = sqrt( dist );
+        if (dist < bestMatchDistance) {
+          bestMatchDistance = dist;
+          bestMatchIndex = candidateIndex;
+        }
+      }
+      // advance to the next grid cell in the box
+      int d = 0;
+      while ((d < _spaceDim) && (gridCell[d] == gridCellMax[d])) {
+        gridCell[d] = gridCellMin[d];
+        d++;
+      }
+      if (d == _spaceDim) break;
+      gridCell[d]++;
     }
-    xDist = abs(lowerBoundIt->first[0] - vertex[0]);
-    lowerBoundIt++;
   }
   if (bestMatchIndex == -1) {
     return false;
@@ -1344,23 +1657,14 @@ unsigned MeshTopology::getVertexIndexAdding(const vector<double> &vertex, double
     return vertexIndex;
   }
   // if we get here, then we should add
-  vertexIndex = _vertices.size();
-  _vertices.push_back(vertex);
-  
-  if (_vertexMap.find(vertex) != _vertexMap.end() ) {
-    cout << "Mesh error: attempting to add existing vertex.\n";
-    TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "Mesh error: attempting to add existing vertex");
+  vertexIndex = vertexCount();
+  for (int d=0; d<_spaceDim; d++) {
+    _vertexCoordinates.push_back(vertex[d]);
   }
-  _vertexMap[vertex] = vertexIndex;
+  addVertexToHash(vertexIndex);
   
   { // update the various entity containers
-    int vertexDim = 0;
-    vector<IndexType> nodeVector(1,vertexIndex);
-    _entities[vertexDim].push_back(nodeVector);
-    _knownEntities[vertexDim][nodeVector] = vertexIndex;
-    vector<IndexType> entityVertices;
-    entityVertices.push_back(vertexIndex);
-    //_canonicalEntityOrdering[vertexDim][vertexIndex] = entityVertices;
+    int vertexDim = 0; // vertex entities are implicit in the entity tables: their entity index is the vertex index
     CellTopoPtr nodeTopo = CellTopology::point();
     if (_knownTopologies.find(nodeTopo->getKey()) == _knownTopologies.end()) {
       _knownTopologies[nodeTopo->getKey()] = nodeTopo;
@@ -1392,7 +1696,7 @@ unsigned MeshTopology::getVertexIndexAdding(const vector<double> &vertex, double
   return vertexIndex;
 }
 
-// key: index in vertices; value: index in _vertices
+// key: index in vertices; value: vertex index
 vector<unsigned> MeshTopology::getVertexIndices(const FieldContainer<double> &vertices) {
   double tol = 1e-14; // tolerance for vertex equality
   
@@ -1408,7 +1712,7 @@ vector<unsigned> MeshTopology::getVertexIndices(const FieldContainer<double> &ve
   return localToGlobalVertexIndex;
 }
 
-// key: index in vertices; value: index in _vertices
+// key: index in vertices; value: vertex index
 map<unsigned, IndexType> MeshTopology::getVertexIndicesMap(const FieldContainer<double> &vertices) {
   map<unsigned, IndexType> vertexMap;
   vector<IndexType> vertexVector = getVertexIndices(vertices);
@@ -1436,24 +1740,18 @@ vector<unsigned> MeshTopology::getChildEntities(unsigned int d, IndexType entity
   if (d==_spaceDim) {
     return getCell(entityIndex)->getChildIndices();
   }
-  if (_childEntities[d].find(entityIndex) == _childEntities[d].end()) return childIndices;
-  vector< pair< RefinementPatternPtr, vector<unsigned> > > childEntries = _childEntities[d][entityIndex];
-  for (vector< pair< RefinementPatternPtr, vector<unsigned> > >::iterator entryIt = childEntries.begin();
-       entryIt != childEntries.end(); entryIt++) {
-    childIndices.insert(childIndices.end(),entryIt->second.begin(),entryIt->second.end());
-  }
-  return childIndices;
+  const EntityRefinement* refinement = entityRefinement(d, entityIndex);
+  if (refinement == NULL) return childIndices;
+  return entityRefinementChildren(d, refinement);
 }
 
 set<unsigned> MeshTopology::getChildEntitiesSet(unsigned int d, unsigned int entityIndex) {
   set<unsigned> childIndices;
   if (d==0) return childIndices;
-  if (_childEntities[d].find(entityIndex) == _childEntities[d].end()) return childIndices;
-  vector< pair< RefinementPatternPtr, vector<unsigned> > > childEntries = _childEntities[d][entityIndex];
-  for (vector< pair< RefinementPatternPtr, vector<unsigned> > >::iterator entryIt = childEntries.begin();
-       entryIt != childEntries.end(); entryIt++) {
-    childIndices.insert(entryIt->second.begin(),entryIt->second.end());
-  }
+  const EntityRefinement* refinement = entityRefinement(d, entityIndex);
+  if (refinement == NULL) return childIndices;
+  vector<unsigned> children = entityRefinementChildren(d, refinement);
+  childIndices.insert(children.begin(), children.end());
   return childIndices;
 }
 
@@ -1527,7 +1825,7 @@ unsigned MeshTopology::getConstrainingEntityIndexOfLikeDimension(unsigned int d,
       for (vector< pair<unsigned,unsigned> >::iterator entryIt=sideAncestry.begin(); entryIt != sideAncestry.end(); entryIt++) {
         // need to map constrained entity index from the current side to its parent in sideAncestry
         unsigned parentSideEntityIndex = entryIt->first;
-        if (_parentEntities[d].find(constrainingEntityIndexForSide) == _parentEntities[d].end()) {
+        if (!entityHasParent(d, constrainingEntityIndexForSide)) {
           // no parent for this entity (may be that it was a refinement-interior edge, e.g.)
           break;
         }
@@ -1540,7 +1838,7 @@ unsigned MeshTopology::getConstrainingEntityIndexOfLikeDimension(unsigned int d,
   return constrainingEntityIndex;
 }
 
-// pair: first is the sideEntityIndex of the ancestor; second is the refinementIndex of the refinement to get from parent to child (see _parentEntities and _childEntities)
+// pair: first is the sideEntityIndex of the ancestor; second is the refinementIndex of the refinement to get from parent to child (see _entityParents and _entityRefinements)
 vector< pair<unsigned,unsigned> > MeshTopology::getConstrainingSideAncestry(unsigned int sideEntityIndex) {
   // three possibilities: 1) compatible side, 2) side is parent, 3) side is child
   // 1) and 2) mean unconstrained.  3) means constrained (by parent)
@@ -1558,23 +1856,15 @@ vector< pair<unsigned,unsigned> > MeshTopology::getConstrainingSideAncestry(unsi
   } else if ((activeCellCountForSide == 0) || (activeCellCountForSide == 1)) {
     // then we're either parent or child of an active side
     // if we are a child, then we should find and return an ancestral path that ends in an active side
-    map< unsigned, vector< pair<unsigned, unsigned> > >::iterator parentIt = _parentEntities[sideDim].find(sideEntityIndex);
-    while (parentIt != _parentEntities[sideDim].end()) {
-      vector< pair<unsigned, unsigned> > parents = parentIt->second;
-      unsigned parentEntityIndex, refinementIndex;
-      for (vector< pair<unsigned, unsigned> >::iterator entryIt = parents.begin(); entryIt != parents.end(); entryIt++) {
-        parentEntityIndex = entryIt->first;
-        refinementIndex = entryIt->second;
-        if (getActiveCellCount(sideDim, parentEntityIndex) > 0) {
-          // active cell; we've found our final ancestor
-          ancestry.push_back(*entryIt);
-          return ancestry;
-        }
-      }
-      // if we get here, then (parentEntityIndex, refinementIndex) points to the last of the possible parents, which by convention must be a regular refinement (more precisely, one whose subentities are at least as fine as all previous possible parents)
-      // this is therefore an acceptable entry in our ancestry path.
+    // each entity has at most one parent, refined at most once, so the refinementIndex is always 0
+    unsigned refinementIndex = 0;
+    for (IndexType parentEntityIndex = entityParent(sideDim, sideEntityIndex); parentEntityIndex != ENTITY_NONE;
+         parentEntityIndex = entityParent(sideDim, parentEntityIndex)) {
       ancestry.push_back(make_pair(parentEntityIndex, refinementIndex));
-      parentIt = _parentEntities[sideDim].find(parentEntityIndex);
+      if (getActiveCellCount(sideDim, parentEntityIndex) > 0) {
+        // active cell; we've found our final ancestor
+        return ancestry;
+      }
     }
     // if no such ancestral path exists, then we are a parent, and are unconstrained (return empty ancestry)
     ancestry.clear();
@@ -1597,10 +1887,12 @@ RefinementBranch MeshTopology::getSideConstraintRefinementBranch(IndexType sideE
        ancestorIt != constrainingSideAncestry.end(); ancestorIt++) {
     IndexType ancestorSideEntityIndex = ancestorIt->first;
     unsigned refinementIndex = ancestorIt->second;
-    pair<RefinementPatternPtr, vector<IndexType> > children = _childEntities[sideDim][ancestorSideEntityIndex][refinementIndex];
-    branchEntry.first = children.first.get();
-    for (int i=0; i<children.second.size(); i++) {
-      if (children.second[i]==previousChild) {
+    TEUCHOS_TEST_FOR_EXCEPTION(refinementIndex != 0, std::invalid_argument, "entities are refined at most once");
+    const EntityRefinement* refinement = entityRefinement(sideDim, ancestorSideEntityIndex);
+    branchEntry.first = refinement->refPattern.get();
+    vector<IndexType> children = entityRefinementChildren(sideDim, refinement);
+    for (int i=0; i<children.size(); i++) {
+      if (children[i]==previousChild) {
         branchEntry.second = i;
         break;
       }
@@ -1636,15 +1928,9 @@ unsigned MeshTopology::getEntityParentForSide(unsigned d, unsigned entityIndex,
   if (entitiesForParentSide.find(entityIndex) != entitiesForParentSide.end()) {
     return entityIndex;
   }
-  vector< pair<unsigned, unsigned> > entityParents = _parentEntities[d][entityIndex];
-  //  cout << "parent entities of entity " << entityIndex << ": ";
-  for (vector< pair<unsigned, unsigned> >::iterator parentIt = entityParents.begin(); parentIt != entityParents.end(); parentIt++) {
-    unsigned parentEntityIndex = parentIt->first;
-    //    cout << parentEntityIndex << " ";
-    if (entitiesForParentSide.find(parentEntityIndex) != entitiesForParentSide.end()) {
-      //      cout << endl;
-      return parentEntityIndex;
-    }
+  unsigned parentEntityIndex = entityParent(d, entityIndex);
+  if ((parentEntityIndex != ENTITY_NONE) && (entitiesForParentSide.find(parentEntityIndex) != entitiesForParentSide.end())) {
+    return parentEntityIndex;
   }
   cout << endl << "entity " << entityIndex << " vertices:\n";
   printEntityVertices(d, entityIndex);
@@ -1703,11 +1989,10 @@ pair<IndexType,IndexType> MeshTopology::owningCellIndexForConstrainingEntity(uns
       IndexType constrainedEntityIndex = *constrainedEntityIt;
       
       // get this entity's immediate children, in case we don't find an active cell on this tier
-      if (_childEntities[d].find(constrainedEntityIndex) != _childEntities[d].end()) {
-        for (unsigned i=0; i<_childEntities[d][constrainedEntityIndex].size(); i++) {
-          vector<unsigned> immediateChildren = _childEntities[d][constrainedEntityIndex][i].second;
-          nextTierConstrainedEntities.insert(immediateChildren.begin(), immediateChildren.end());
-        }
+      const EntityRefinement* refinement = entityRefinement(d, constrainedEntityIndex);
+      if (refinement != NULL) {
+        vector<unsigned> immediateChildren = entityRefinementChildren(d, refinement);
+        nextTierConstrainedEntities.insert(immediateChildren.begin(), immediateChildren.end());
       }
       
       if (_sidesForEntities[d].size() <= constrainingEntityIndex) {
@@ -1775,7 +2060,7 @@ unsigned MeshTopology::getSubEntityPermutation(unsigned d, IndexType entityIndex
   subEntityNodes = getCanonicalEntityNodesViaPeriodicBCs(subEntityDim, subEntityNodes);
   unsigned subEntityIndex = getSubEntityIndex(d, entityIndex, subEntityDim, subEntityOrdinal);
   CellTopoPtr subEntityTopo = getEntityTopology(subEntityDim, subEntityIndex);
-  return CamelliaCellTools::permutationMatchingOrder(subEntityTopo, _canonicalEntityOrdering[subEntityDim][subEntityOrdinal], subEntityNodes);
+  return CamelliaCellTools::permutationMatchingOrder(subEntityTopo, getEntityVertexIndices(subEntityDim, subEntityOrdinal), subEntityNodes);
 }
 
 //pair<IndexType,IndexType> MeshTopology::leastActiveCellIndexContainingEntityConstrainedByConstrainingEntity(unsigned d, unsigned constrainingEntityIndex) {
@@ -1892,7 +2177,7 @@ void MeshTopology::printApproximateMemoryReport() {
 }
 
 void MeshTopology::printConstraintReport(unsigned d) {
-  IndexType entityCount = _entities[d].size();
+  IndexType entityCount = getEntityCount(d);
   cout << "******* MeshTopology, constraints for d = " << d << " *******\n";
   for (IndexType entityIndex=0; entityIndex<entityCount; entityIndex++) {
     pair<IndexType, unsigned> constrainingEntity = getConstrainingEntity(d, entityIndex);
@@ -1906,7 +2191,7 @@ void MeshTopology::printConstraintReport(unsigned d) {
 void MeshTopology::printVertex(unsigned int vertexIndex) {
   cout << "vertex " << vertexIndex << ": (";
   for (unsigned d=0; d<_spaceDim; d++) {
-    cout << _vertices[vertexIndex][d];
+    cout << _vertexCoordinates[vertexIndex * _spaceDim + d];
     if (d != _spaceDim-1) cout << ",";
   }
   cout << ")\n";
@@ -1924,7 +2209,7 @@ void MeshTopology::printEntityVertices(unsigned int d, unsigned int entityIndex)
     printVertex(entityIndex);
     return;
   }
-  vector<unsigned> entityVertices = _canonicalEntityOrdering[d][entityIndex];
+  vector<unsigned> entityVertices = getEntityVertexIndices(d, entityIndex);
   for (vector<unsigned>::iterator vertexIt=entityVertices.begin(); vertexIt !=entityVertices.end(); vertexIt++) {
     printVertex(*vertexIt);
   }
@@ -1990,7 +2275,7 @@ FieldContainer<double> MeshTopology::physicalCellNodesForCell(unsigned int cellI
   for (unsigned vertexOrdinal=0; vertexOrdinal<vertexCount; vertexOrdinal++) {
     unsigned vertexIndex = cell->vertices()[vertexOrdinal];
     for (unsigned d=0; d<_spaceDim; d++) {
-      nodes(vertexOrdinal,d) = _vertices[vertexIndex][d];
+      nodes(vertexOrdinal,d) = _vertexCoordinates[vertexIndex * _spaceDim + d];
     }
   }
   if (includeCellDimension) {
@@ -2007,7 +2292,7 @@ void MeshTopology::refineCell(unsigned cellIndex, RefinementPatternPtr refPatter
   
   for (int vertexIndex=0; vertexIndex < cellNodes.dimension(0); vertexIndex++) {
     for (int d=0; d<_spaceDim; d++) {
-      cellNodes(vertexIndex,d) = _vertices[cell->vertices()[vertexIndex]][d];
+      cellNodes(vertexIndex,d) = _vertexCoordinates[cell->vertices()[vertexIndex] * _spaceDim + d];
     }
   }
   
@@ -2016,7 +2301,7 @@ void MeshTopology::refineCell(unsigned cellIndex, RefinementPatternPtr refPatter
     bool changedVertices = _transformationFunction->mapRefCellPointsUsingExactGeometry(vertices, refPattern->verticesOnReferenceCell(), cellIndex);
     //    cout << "transformed vertices:\n" << vertices;
   }
-  map<unsigned, IndexType> vertexOrdinalToVertexIndex = getVertexIndicesMap(vertices); // key: index in vertices; value: index in _vertices
+  map<unsigned, IndexType> vertexOrdinalToVertexIndex = getVertexIndicesMap(vertices); // key: index in vertices; value: vertex index
   map<unsigned, GlobalIndexType> localToGlobalVertexIndex(vertexOrdinalToVertexIndex.begin(),vertexOrdinalToVertexIndex.end());
   
   // get the children, as vectors of vertex indices:
@@ -2074,13 +2359,13 @@ void MeshTopology::refineCell(unsigned cellIndex, RefinementPatternPtr refPatter
 }
 
 void MeshTopology::refineCellEntities(CellPtr cell, RefinementPatternPtr refPattern) {
-  // ensures that the appropriate child entities exist, and parental relationships are recorded in _parentEntities
+  // ensures that the appropriate child entities exist, and parental relationships are recorded in _entityParents
   
   FieldContainer<double> cellNodes(1,cell->vertices().size(), _spaceDim);
   
   for (int vertexIndex=0; vertexIndex < cellNodes.dimension(1); vertexIndex++) {
     for (int d=0; d<_spaceDim; d++) {
-      cellNodes(0,vertexIndex,d) = _vertices[cell->vertices()[vertexIndex]][d];
+      cellNodes(0,vertexIndex,d) = _vertexCoordinates[cell->vertices()[vertexIndex] * _spaceDim + d];
     }
   }
   
@@ -2106,9 +2391,9 @@ void MeshTopology::refineCellEntities(CellPtr cell, RefinementPatternPtr refPatt
       //      cout << "Refined nodes:\n" << refinedNodes;
       
       unsigned parentIndex = cell->entityIndex(d, subcord);
-      // if we ever allow multiple parentage, then we'll need to record things differently in both _childEntities and _parentEntities
+      // if we ever allow multiple parentage, then we'll need to record things differently in both _entityRefinements and _entityParents
       // (and the if statement just below will need to change in a corresponding way, indexed by the particular refPattern in question maybe
-      if (_childEntities[d].find(parentIndex) == _childEntities[d].end()) {
+      if (entityRefinement(d, parentIndex) == NULL) {
         vector<unsigned> childEntityIndices(childCount);
         for (unsigned childIndex=0; childIndex<childCount; childIndex++) {
           unsigned nodeCount = refinedNodes.dimension(1);
@@ -2146,18 +2431,26 @@ void MeshTopology::refineCellEntities(CellPtr cell, RefinementPatternPtr refPatt
           
           // add vertices as necessary and get their indices
           physicalNodes.resize(nodeCount,_spaceDim);
-          vector<unsigned> childEntityVertices = getVertexIndices(physicalNodes); // key: index in physicalNodes; value: index in _vertices
+          vector<unsigned> childEntityVertices = getVertexIndices(physicalNodes); // key: index in physicalNodes; value: vertex index
           
           unsigned entityPermutation;
           CellTopoPtr childTopo = cellTopo->getSubcell(d, subcord);
           unsigned childEntityIndex = addEntity(childTopo, childEntityVertices, entityPermutation);
           //          cout << "for d=" << d << ", entity index " << childEntityIndex << " is child of " << parentIndex << endl;
-          _parentEntities[d][childEntityIndex] = vector< pair<unsigned,unsigned> >(1, make_pair(parentIndex,0)); // TODO: this is where we want to fill in a proper list of possible parents once we work through recipes
+          if (_entityParents[d].size() <= childEntityIndex) _entityParents[d].resize(childEntityIndex + 1, ENTITY_NONE);
+          _entityParents[d][childEntityIndex] = parentIndex; // TODO: this is where we want to fill in a proper list of possible parents once we work through recipes
           childEntityIndices[childIndex] = childEntityIndex;
           vector< pair<unsigned, unsigned> > parentActiveCells = _activeCellsForEntities[d][parentIndex];
           // TODO: ?? do something with parentActiveCells?  Seems like we just trailed off here...
         }
-        _childEntities[d][parentIndex] = vector< pair<RefinementPatternPtr,vector<unsigned> > >(1, make_pair(subcellRefPattern, childEntityIndices) ); // TODO: this also needs to change when we work through recipes.  Note that the correct parent will vary here...  i.e. in the anisotropic case, the child we're ultimately interested in will have an anisotropic parent, and *its* parent would be the bigger guy referred to here.
+        EntityRefinement refinement;
+        refinement.refPattern = subcellRefPattern;
+        refinement.childOffset = _refinedEntityChildren[d].size();
+        refinement.childCount = childCount;
+        _refinedEntityChildren[d].insert(_refinedEntityChildren[d].end(), childEntityIndices.begin(), childEntityIndices.end());
+        if (_entityRefinementOrdinals[d].size() <= parentIndex) _entityRefinementOrdinals[d].resize(parentIndex + 1, ENTITY_NONE);
+        _entityRefinementOrdinals[d][parentIndex] = _entityRefinements[d].size();
+        _entityRefinements[d].push_back(refinement); // TODO: this also needs to change when we work through recipes.  Note that the correct parent will vary here...  i.e. in the anisotropic case, the child we're ultimately interested in will have an anisotropic parent, and *its* parent would be the bigger guy referred to here.
         if (d==_spaceDim-1) { // side
           if (_boundarySides.find(parentIndex) != _boundarySides.end()) { // parent is a boundary side, so children are, too
             _boundarySides.insert(childEntityIndices.begin(),childEntityIndices.end());
@@ -2173,7 +2466,7 @@ void MeshTopology::determineGeneralizedParentsForRefinement(CellPtr cell, Refine
   
   for (int vertexIndex=0; vertexIndex < cellNodes.dimension(1); vertexIndex++) {
     for (int d=0; d<_spaceDim; d++) {
-      cellNodes(0,vertexIndex,d) = _vertices[cell->vertices()[vertexIndex]][d];
+      cellNodes(0,vertexIndex,d) = _vertexCoordinates[cell->vertices()[vertexIndex] * _spaceDim + d];
     }
   }
   
@@ -2203,10 +2496,9 @@ void MeshTopology::determineGeneralizedParentsForRefinement(CellPtr cell, Refine
       // now, establish generalized parent relationships
       vector< IndexType > parentVertexIndices = this->getEntityVertexIndices(d, parentIndex);
       set<IndexType> parentVertexIndexSet(parentVertexIndices.begin(),parentVertexIndices.end());
-      vector< pair<RefinementPatternPtr,vector<IndexType> > > childEntities = _childEntities[d][parentIndex];
-      for (vector< pair<RefinementPatternPtr,vector<IndexType> > >::iterator refIt = childEntities.begin();
-           refIt != childEntities.end(); refIt++) {
-        vector<IndexType> childEntityIndices = refIt->second;
+      const EntityRefinement* refinement = entityRefinement(d, parentIndex);
+      if (refinement != NULL) {
+        vector<IndexType> childEntityIndices = entityRefinementChildren(d, refinement);
         for (int childOrdinal=0; childOrdinal<childEntityIndices.size(); childOrdinal++) {
           IndexType childEntityIndex = childEntityIndices[childOrdinal];
           if (parentIndex == childEntityIndex) { // "null" refinement pattern -- nothing to do here.
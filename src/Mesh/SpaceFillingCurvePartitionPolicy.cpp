@@ -0,0 +1,264 @@
+//
+//  SpaceFillingCurvePartitionPolicy.cpp
+//  Camellia
+//
+//
+
+#include "SpaceFillingCurvePartitionPolicy.h"
+
+#include "CellDataMigration.h"
+#include "GlobalDofAssignment.h"
+#include "Solution.h"
+
+#include "Epetra_Distributor.h"
+#ifdef HAVE_MPI
+#include "Epetra_MpiComm.h"
+#else
+#include "Epetra_SerialComm.h"
+#endif
+
+#include "Teuchos_GlobalMPISession.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+SpaceFillingCurvePartitionPolicy::SpaceFillingCurvePartitionPolicy(CurveType curveType) {
+  _curveType = curveType;
+}
+
+unsigned long long SpaceFillingCurvePartitionPolicy::curveKey(MeshTopologyPtr meshTopology, GlobalIndexType cellID) {
+  map<GlobalIndexType, unsigned long long>::iterator keyIt = _curveKeys.find(cellID);
+  if (keyIt != _curveKeys.end()) return keyIt->second;
+
+  int spaceDim = meshTopology->getSpaceDim();
+  int bitsPerDimension = min(32, 64 / spaceDim);
+  double maxCoordinate = ldexp(1.0, bitsPerDimension) - 1.0;
+
+  vector<double> centroid = meshTopology->getCellCentroid(cellID);
+  vector<unsigned> coordinates(spaceDim);
+  for (int d=0; d<spaceDim; d++) {
+    double width = _boxMax[d] - _boxMin[d];
+    double relativePosition = (width > 0.0) ? (centroid[d] - _boxMin[d]) / width : 0.0;
+    relativePosition = max(0.0, min(1.0, relativePosition)); // curved cells may poke outside the box
+    coordinates[d] = (unsigned) (relativePosition * maxCoordinate);
+  }
+
+  unsigned long long key;
+  if (_curveType == HILBERT) {
+    key = hilbertIndex(coordinates, bitsPerDimension);
+  } else {
+    key = mortonIndex(coordinates, bitsPerDimension);
+  }
+  _curveKeys[cellID] = key;
+  return key;
+}
+
+unsigned long long SpaceFillingCurvePartitionPolicy::hilbertIndex(vector<unsigned> coordinates, int bitsPerDimension) {
+  // J. Skilling, "Programming the Hilbert curve" (2004): transform the coordinates in place to the "transposed" Hilbert index,
+  // whose bits, interleaved, are the index
+  int n = coordinates.size();
+  TEUCHOS_TEST_FOR_EXCEPTION(n * bitsPerDimension > 64, std::invalid_argument, "Hilbert index would not fit in 64 bits");
+  unsigned M = 1u << (bitsPerDimension - 1);
+
+  // inverse undo
+  for (unsigned Q = M; Q > 1; Q >>= 1) {
+    unsigned P = Q - 1;
+    for (int i=0; i<n; i++) {
+      if (coordinates[i] & Q) {
+        coordinates[0] ^= P; // invert
+      } else {
+        unsigned t = (coordinates[0] ^ coordinates[i]) & P; // exchange
+        coordinates[0] ^= t;
+        coordinates[i] ^= t;
+      }
+    }
+  }
+  // Gray encode
+  for (int i=1; i<n; i++) {
+    coordinates[i] ^= coordinates[i-1];
+  }
+  unsigned t = 0;
+  for (unsigned Q = M; Q > 1; Q >>= 1) {
+    if (coordinates[n-1] & Q) t ^= Q - 1;
+  }
+  for (int i=0; i<n; i++) {
+    coordinates[i] ^= t;
+  }
+
+  return mortonIndex(coordinates, bitsPerDimension);
+}
+
+unsigned long long SpaceFillingCurvePartitionPolicy::mortonIndex(const vector<unsigned> &coordinates, int bitsPerDimension) {
+  int n = coordinates.size();
+  TEUCHOS_TEST_FOR_EXCEPTION(n * bitsPerDimension > 64, std::invalid_argument, "Morton index would not fit in 64 bits");
+  unsigned long long index = 0;
+  for (int bit=bitsPerDimension-1; bit>=0; bit--) {
+    for (int i=0; i<n; i++) {
+      index = (index << 1) | ((coordinates[i] >> bit) & 1u);
+    }
+  }
+  return index;
+}
+
+void SpaceFillingCurvePartitionPolicy::migrateCellData(Mesh *mesh, const map<GlobalIndexType, PartitionIndexType> &exportedCells) {
+  // fixed-size records (cellID, data size, data padded to the largest size on any rank), so that one exchange suffices
+  vector<Solution *> solutions = mesh->globalDofAssignment()->getRegisteredSolutions();
+  if (solutions.size() == 0) return;
+
+#ifdef HAVE_MPI
+  Epetra_MpiComm Comm(MPI_COMM_WORLD);
+#else
+  Epetra_SerialComm Comm;
+#endif
+
+  int myMaxDataSize = 0;
+  for (map<GlobalIndexType, PartitionIndexType>::const_iterator cellIt = exportedCells.begin(); cellIt != exportedCells.end(); cellIt++) {
+    myMaxDataSize = max(myMaxDataSize, CellDataMigration::dataSize(mesh, cellIt->first));
+  }
+  int maxDataSize;
+  Comm.MaxAll(&myMaxDataSize, &maxDataSize, 1);
+  int headerSize = sizeof(GlobalIndexType) + sizeof(int);
+  int recordSize = headerSize + maxDataSize;
+
+  int numExports = exportedCells.size();
+  vector<char> exportBuffer(numExports * recordSize);
+  vector<int> exportRanks(numExports);
+  int exportOrdinal = 0;
+  for (map<GlobalIndexType, PartitionIndexType>::const_iterator cellIt = exportedCells.begin(); cellIt != exportedCells.end(); cellIt++, exportOrdinal++) {
+    GlobalIndexType cellID = cellIt->first;
+    int dataSize = CellDataMigration::dataSize(mesh, cellID);
+    char* record = &exportBuffer[exportOrdinal * recordSize];
+    memcpy(record, &cellID, sizeof(cellID));
+    memcpy(record + sizeof(cellID), &dataSize, sizeof(dataSize));
+    // as in ZoltanMeshPartitionPolicy: children that have no coefficients of their own yet carry their parent's
+    CellPtr cell = mesh->getTopology()->getCell(cellID);
+    bool isChild = cell->getParent().get() != NULL;
+    bool hasData = solutions[0]->cellHasCoefficientsAssigned(cellID);
+    CellDataMigration::packData(mesh, cellID, isChild && !hasData, record + headerSize, dataSize);
+    exportRanks[exportOrdinal] = cellIt->second;
+  }
+
+  Epetra_Distributor* distributor = Comm.CreateDistributor();
+  int numImports;
+  bool deterministic = true;
+  distributor->CreateFromSends(numExports, (numExports > 0) ? &exportRanks[0] : NULL, deterministic, numImports);
+  int importLength = 0;
+  char* importBuffer = NULL;
+  distributor->Do((numExports > 0) ? &exportBuffer[0] : NULL, recordSize, importLength, importBuffer);
+
+  for (int importOrdinal=0; importOrdinal<numImports; importOrdinal++) {
+    const char* record = importBuffer + importOrdinal * recordSize;
+    GlobalIndexType cellID;
+    int dataSize;
+    memcpy(&cellID, record, sizeof(cellID));
+    memcpy(&dataSize, record + sizeof(cellID), sizeof(dataSize));
+    CellDataMigration::unpackData(mesh, cellID, record + headerSize, dataSize);
+  }
+
+  delete[] importBuffer;
+  delete distributor;
+}
+
+vector< set<GlobalIndexType> > SpaceFillingCurvePartitionPolicy::partitionCells(MeshTopologyPtr meshTopology, PartitionIndexType numPartitions) {
+  // comparing RCP nodes rather than addresses: a new topology allocated where a deleted one was is still a new topology
+  // (the weak RCP keeps the old node, though not the old topology, alive)
+  if (!_keyedTopology.shares_resource(meshTopology)) {
+    _keyedTopology = meshTopology.create_weak();
+    _curveKeys.clear();
+
+    int spaceDim = meshTopology->getSpaceDim();
+    _boxMin = vector<double>(spaceDim, 0.0);
+    _boxMax = vector<double>(spaceDim, 0.0);
+    bool firstVertex = true;
+    const set<IndexType>* rootCellIndices = &meshTopology->getRootCellIndices();
+    for (set<IndexType>::const_iterator cellIt = rootCellIndices->begin(); cellIt != rootCellIndices->end(); cellIt++) {
+      vector<IndexType> vertexIndices = meshTopology->getCell(*cellIt)->vertices();
+      for (int vertexOrdinal=0; vertexOrdinal<vertexIndices.size(); vertexOrdinal++) {
+        for (int d=0; d<spaceDim; d++) {
+          double x = meshTopology->getVertexCoordinate(vertexIndices[vertexOrdinal], d);
+          _boxMin[d] = firstVertex ? x : min(_boxMin[d], x);
+          _boxMax[d] = firstVertex ? x : max(_boxMax[d], x);
+        }
+        firstVertex = false;
+      }
+    }
+  }
+
+  const set<IndexType>* activeCellIndices = &meshTopology->getActiveCellIndices();
+  vector< pair<unsigned long long, GlobalIndexType> > curveOrder; // sorting by (key, cellID) breaks ties deterministically
+  curveOrder.reserve(activeCellIndices->size());
+  for (set<IndexType>::const_iterator cellIt = activeCellIndices->begin(); cellIt != activeCellIndices->end(); cellIt++) {
+    curveOrder.push_back(make_pair(curveKey(meshTopology, *cellIt), (GlobalIndexType) *cellIt));
+  }
+  std::sort(curveOrder.begin(), curveOrder.end());
+
+  vector<GlobalIndexType> orderedCellIDs(curveOrder.size());
+  vector<double> weights(curveOrder.size(), 1.0);
+  for (int i=0; i<curveOrder.size(); i++) {
+    orderedCellIDs[i] = curveOrder[i].second;
+    map<GlobalIndexType, double>::iterator weightIt = _cellWeights.find(orderedCellIDs[i]);
+    if (weightIt != _cellWeights.end()) weights[i] = weightIt->second;
+  }
+  return splitByWeight(orderedCellIDs, weights, numPartitions);
+}
+
+void SpaceFillingCurvePartitionPolicy::partitionMesh(Mesh *mesh, PartitionIndexType numPartitions) {
+  MeshTopologyPtr meshTopology = mesh->getTopology();
+  if (_cellCostModel != Teuchos::null) {
+    setCellWeights(_cellCostModel->cellCosts(mesh));
+  }
+  vector< set<GlobalIndexType> > partitions = partitionCells(meshTopology, numPartitions);
+
+  map<GlobalIndexType, PartitionIndexType> newPartitionForCell;
+  int maxPartitionSize = 0;
+  for (PartitionIndexType partitionNumber=0; partitionNumber<numPartitions; partitionNumber++) {
+    for (set<GlobalIndexType>::iterator cellIt = partitions[partitionNumber].begin(); cellIt != partitions[partitionNumber].end(); cellIt++) {
+      newPartitionForCell[*cellIt] = partitionNumber;
+    }
+    maxPartitionSize = max(maxPartitionSize, (int) partitions[partitionNumber].size());
+  }
+
+  // cells leaving this rank; the rank-local set may list refined parents in place of their children
+  int rank = Teuchos::GlobalMPISession::getRank();
+  set<GlobalIndexType> rankLocalCells = mesh->globalDofAssignment()->cellsInPartition(-1);
+  map<GlobalIndexType, PartitionIndexType> exportedCells;
+  for (set<GlobalIndexType>::iterator cellIt = rankLocalCells.begin(); cellIt != rankLocalCells.end(); cellIt++) {
+    CellPtr cell = meshTopology->getCell(*cellIt);
+    vector<IndexType> cellIDs;
+    if (cell->isParent()) {
+      cellIDs = cell->getChildIndices();
+    } else {
+      cellIDs.push_back(*cellIt);
+    }
+    for (int i=0; i<cellIDs.size(); i++) {
+      map<GlobalIndexType, PartitionIndexType>::iterator partitionIt = newPartitionForCell.find(cellIDs[i]);
+      if ((partitionIt != newPartitionForCell.end()) && (partitionIt->second != rank)) {
+        exportedCells[cellIDs[i]] = partitionIt->second;
+      }
+    }
+  }
+
+  FieldContainer<GlobalIndexType> partitionedActiveCells(numPartitions, maxPartitionSize);
+  partitionedActiveCells.initialize(-1); // cellID == -1 signals end of partition
+  for (PartitionIndexType partitionNumber=0; partitionNumber<numPartitions; partitionNumber++) {
+    int i=0;
+    for (set<GlobalIndexType>::iterator cellIt = partitions[partitionNumber].begin(); cellIt != partitions[partitionNumber].end(); cellIt++, i++) {
+      partitionedActiveCells(partitionNumber,i) = *cellIt;
+    }
+  }
+  mesh->globalDofAssignment()->setPartitions(partitionedActiveCells);
+
+  if (numPartitions > 1) {
+    migrateCellData(mesh, exportedCells);
+  }
+}
+
+void SpaceFillingCurvePartitionPolicy::setCellWeights(const map<GlobalIndexType, double> &cellWeights) {
+  for (map<GlobalIndexType, double>::const_iterator weightIt = cellWeights.begin(); weightIt != cellWeights.end(); weightIt++) {
+    TEUCHOS_TEST_FOR_EXCEPTION(weightIt->second < 0.0, std::invalid_argument, "cell weights must be non-negative");
+  }
+  _cellWeights = cellWeights;
+}
@@ -83,7 +83,8 @@ void ZoltanMeshPartitionPolicy::partitionMesh(Mesh *mesh, PartitionIndexType num
     }else{
       zz->Set_Param( "NUM_LID_ENTRIES", "0");  /* local ID is null */
     }
-    zz->Set_Param( "OBJ_WEIGHT_DIM", "0");   
+    bool useWeights = (_cellCostModel != Teuchos::null);
+    zz->Set_Param( "OBJ_WEIGHT_DIM", useWeights ? "1" : "0");
     zz->Set_Param( "DEBUG_LEVEL", _debug_level);
     //  zz->Set_Param( "REFTREE_INITPATH", "CONNECTED"); // no SFC on coarse meshTopology
     zz->Set_Param( "RANDOM_MOVE_FRACTION", "1.0");    /* Zoltan "random" partition param */
@@ -92,9 +93,13 @@ void ZoltanMeshPartitionPolicy::partitionMesh(Mesh *mesh, PartitionIndexType num
     
     Mesh* myData = mesh;
     
+    ObjectListData objectListData;
+    objectListData.mesh = mesh;
+    if (useWeights) objectListData.cellWeights = _cellCostModel->cellCosts(mesh);
+    
     // Testing query functions
     zz->Set_Num_Obj_Fn(&get_number_of_objects, myData);
-    zz->Set_Obj_List_Fn(&get_object_list, myData);
+    zz->Set_Obj_List_Fn(&get_object_list, &objectListData);
     
     // HSFC query functions   
     zz->Set_Num_Geom_Fn(&get_num_geom, myData);
@@ -274,12 +279,17 @@ int ZoltanMeshPartitionPolicy::get_number_of_objects(void *data, int *ierr){
 void ZoltanMeshPartitionPolicy::get_object_list(void *data, int sizeGID, int sizeLID,
                                                 ZOLTAN_ID_PTR globalID, ZOLTAN_ID_PTR localID,
                                                 int wgt_dim, float *obj_wgts, int *ierr) {
-  Mesh* mesh = (Mesh*) data;
+  ObjectListData* objectListData = (ObjectListData*) data;
+  Mesh* mesh = objectListData->mesh;
   
   set<GlobalIndexType> rankLocalCellIDs = getRankLocalCellIDs(mesh);
   int i=0;
   for (set<unsigned>::const_iterator cellIDIt = rankLocalCellIDs.begin(); cellIDIt != rankLocalCellIDs.end(); cellIDIt++) {
     globalID[i]= *cellIDIt;
+    if (wgt_dim > 0) {
+      map<GlobalIndexType, double>::iterator weightIt = objectListData->cellWeights.find(*cellIDIt);
+      obj_wgts[i*wgt_dim] = (weightIt != objectListData->cellWeights.end()) ? weightIt->second : 1.0;
+    }
     i++;
   }
   //  cout << endl;
@@ -12,11 +12,16 @@
 #include "Function.h"
 #include "PreviousSolutionFunction.h"
 #include "LinearTerm.h"
+#include "PhaseTimers.h"
 
 #include "Intrepid_FunctionSpaceTools.hpp"
 
 #include "SerialDenseWrapper.h"
 
+#include <cmath>
+
+static const long long DEFAULT_STIFFNESS_CACHE_MAX_MEMORY_IN_BYTES = 256 * 1024 * 1024; // 256 MB
+
 BFPtr BF::bf(VarFactory &vf) {
   return Teuchos::rcp( new BF(vf) );
 }
@@ -26,9 +31,10 @@ BF::BF(bool isLegacySubclass) {
     TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "This constructor is for legacy subclasses only!  Call a VarFactory version instead");
   }
   _useQRSolveForOptimalTestFunctions = true;
-  _useSPDSolveForOptimalTestFunctions = false;
+  _useSPDSolveForOptimalTestFunctions = true;
   _useIterativeRefinementsWithSPDSolve = false;
   _warnAboutZeroRowsAndColumns = true;
+  initStiffnessCache();
   
   _isLegacySubclass = true;
 }
@@ -41,9 +47,10 @@ BF::BF( VarFactory varFactory ) { // copies (note that external changes in VarFa
   _isLegacySubclass = false;
   
   _useQRSolveForOptimalTestFunctions = true;
-  _useSPDSolveForOptimalTestFunctions = false;
+  _useSPDSolveForOptimalTestFunctions = true;
   _useIterativeRefinementsWithSPDSolve = false;
   _warnAboutZeroRowsAndColumns = true;
+  initStiffnessCache();
 }
 
 BF::BF( VarFactory varFactory, VarFactory::BubnovChoice choice ) {
@@ -53,13 +60,15 @@ BF::BF( VarFactory varFactory, VarFactory::BubnovChoice choice ) {
   _isLegacySubclass = false;
   
   _useQRSolveForOptimalTestFunctions = true;
-  _useSPDSolveForOptimalTestFunctions = false;
+  _useSPDSolveForOptimalTestFunctions = true;
   _useIterativeRefinementsWithSPDSolve = false;
   _warnAboutZeroRowsAndColumns = true;
+  initStiffnessCache();
 }
 
 void BF::addTerm( LinearTermPtr trialTerm, LinearTermPtr testTerm ) {
   _terms.push_back( make_pair( trialTerm, testTerm ) );
+  clearStiffnessCache(); // the cached matrices are for the old terms
 }
 
 void BF::addTerm( VarPtr trialVar, LinearTermPtr testTerm ) {
@@ -651,18 +660,13 @@ IPPtr BF::l2Norm() {
 
 void BF::localStiffnessMatrixAndRHS(FieldContainer<double> &localStiffness, FieldContainer<double> &rhsVector,
                                               IPPtr ip, BasisCachePtr ipBasisCache, RHSPtr rhs, BasisCachePtr basisCache) {
-  double testMatrixAssemblyTime = 0, testMatrixInversionTime = 0, localStiffnessDeterminationFromTestsTime = 0;
-  double rhsIntegrationAgainstOptimalTestsTime = 0;
-  
-#ifdef HAVE_MPI
-  Epetra_MpiComm Comm(MPI_COMM_WORLD);
-  //cout << "rank: " << rank << " of " << numProcs << endl;
-#else
-  Epetra_SerialComm Comm;
-#endif
-  
-  Epetra_Time timer(Comm);
-  
+  FieldContainer<double> optTestCoeffs;
+  localStiffnessMatrixAndRHS(localStiffness, rhsVector, optTestCoeffs, ip, ipBasisCache, rhs, basisCache);
+}
+
+void BF::localStiffnessMatrixAndRHS(FieldContainer<double> &localStiffness, FieldContainer<double> &rhsVector,
+                                    FieldContainer<double> &optTestCoeffs, IPPtr ip, BasisCachePtr ipBasisCache,
+                                    RHSPtr rhs, BasisCachePtr basisCache) {
   // localStiffness should have dim. (numCells, numTrialFields, numTrialFields)
   MeshPtr mesh = basisCache->mesh();
   if (mesh.get() == NULL) {
@@ -686,30 +690,118 @@ void BF::localStiffnessMatrixAndRHS(FieldContainer<double> &localStiffness, Fiel
     TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "localStiffness should have dimensions (C,numTrialFields,numTrialFields).");
   }
   
-  timer.ResetStartTime();
+  // stiffness cache: cells that match a cached cell need only the RHS integrated
+  bool useStiffnessCache = _useStiffnessCache && basisCache->cellsAreAffine() && ipBasisCache->cellsAreAffine();
+  vector<StiffnessCacheKey> cacheKeys;
+  vector<int> missedCellOrdinals; // cells whose stiffness must be computed
+  if (useStiffnessCache) {
+    cacheKeys = stiffnessCacheKeys(elemType, ip, basisCache, ipBasisCache);
+    optTestCoeffs.resize(numCells,numTrialDofs,numTestDofs);
+#ifdef _OPENMP
+#pragma omp critical (BFStiffnessCache)
+#endif
+    {
+      for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+        map< StiffnessCacheKey, StiffnessCacheEntry >::iterator entryIt = _stiffnessCache.find(cacheKeys[cellOrdinal]);
+        if (entryIt == _stiffnessCache.end()) {
+          missedCellOrdinals.push_back(cellOrdinal);
+          continue;
+        }
+        const FieldContainer<double>* stiffness = &entryIt->second.stiffness;
+        const FieldContainer<double>* optimalTestWeights = &entryIt->second.optimalTestWeights;
+        std::copy(&(*stiffness)[0], &(*stiffness)[0] + stiffness->size(), &localStiffness(cellOrdinal,0,0));
+        std::copy(&(*optimalTestWeights)[0], &(*optimalTestWeights)[0] + optimalTestWeights->size(), &optTestCoeffs(cellOrdinal,0,0));
+      }
+      _stiffnessCacheHitCount += numCells - missedCellOrdinals.size();
+    }
+  } else {
+    for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+      missedCellOrdinals.push_back(cellOrdinal);
+    }
+  }
   
-  bool printTimings = false;
+  int numMissedCells = missedCellOrdinals.size();
+  int optSuccess = 0;
+  if (numMissedCells == numCells) {
+    optTestCoeffs.resize(numCells,numTrialDofs,numTestDofs);
+    optSuccess = optimalStiffness(localStiffness, optTestCoeffs, elemType, ip, ipBasisCache, basisCache);
+  } else if (numMissedCells > 0) {
+    // compute just the missed cells, on the caches restricted to them; then restore the caches for the RHS
+    FieldContainer<double> physicalCellNodes = basisCache->getPhysicalCellNodes();
+    FieldContainer<double> cellSideParities = basisCache->getCellSideParities();
+    FieldContainer<double> ipPhysicalCellNodes = ipBasisCache->getPhysicalCellNodes();
+    FieldContainer<double> ipCellSideParities = ipBasisCache->getCellSideParities();
+    vector<GlobalIndexType> allCellIDs = *cellIDs;
+    
+    setBasisCacheCells(ipBasisCache, ipPhysicalCellNodes, ipCellSideParities, allCellIDs, missedCellOrdinals);
+    setBasisCacheCells(basisCache, physicalCellNodes, cellSideParities, allCellIDs, missedCellOrdinals);
+    
+    FieldContainer<double> missedStiffness(numMissedCells,numTrialDofs,numTrialDofs);
+    FieldContainer<double> missedOptTestCoeffs(numMissedCells,numTrialDofs,numTestDofs);
+    optSuccess = optimalStiffness(missedStiffness, missedOptTestCoeffs, elemType, ip, ipBasisCache, basisCache);
+    
+    vector<int> allCellOrdinals(numCells);
+    for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+      allCellOrdinals[cellOrdinal] = cellOrdinal;
+    }
+    setBasisCacheCells(ipBasisCache, ipPhysicalCellNodes, ipCellSideParities, allCellIDs, allCellOrdinals);
+    setBasisCacheCells(basisCache, physicalCellNodes, cellSideParities, allCellIDs, allCellOrdinals);
+    
+    for (int i=0; i<numMissedCells; i++) {
+      int cellOrdinal = missedCellOrdinals[i];
+      std::copy(&missedStiffness(i,0,0), &missedStiffness(i,0,0) + numTrialDofs * numTrialDofs, &localStiffness(cellOrdinal,0,0));
+      std::copy(&missedOptTestCoeffs(i,0,0), &missedOptTestCoeffs(i,0,0) + numTrialDofs * numTestDofs, &optTestCoeffs(cellOrdinal,0,0));
+    }
+  }
   
-  if (printTimings) {
-    cout << "numCells: " << numCells << endl;
-    cout << "numTestDofs: " << numTestDofs << endl;
-    cout << "numTrialDofs: " << numTrialDofs << endl;
+  if (useStiffnessCache && (numMissedCells > 0) && (optSuccess == 0)) {
+    long long entrySize = (numTrialDofs * numTrialDofs + numTrialDofs * numTestDofs) * sizeof(double);
+#ifdef _OPENMP
+#pragma omp critical (BFStiffnessCache)
+#endif
+    {
+      for (int i=0; i<numMissedCells; i++) {
+        int cellOrdinal = missedCellOrdinals[i];
+        if (_stiffnessCache.find(cacheKeys[cellOrdinal]) != _stiffnessCache.end()) continue;
+        if (_stiffnessCacheMemoryInBytes + entrySize > _stiffnessCacheMaxMemoryInBytes) break; // cache is full
+        _stiffnessCacheMemoryInBytes += entrySize;
+        StiffnessCacheEntry* entry = &_stiffnessCache[cacheKeys[cellOrdinal]];
+        entry->elemType = elemType;
+        entry->ip = ip;
+        entry->stiffness.resize(numTrialDofs,numTrialDofs);
+        entry->optimalTestWeights.resize(numTrialDofs,numTestDofs);
+        std::copy(&localStiffness(cellOrdinal,0,0), &localStiffness(cellOrdinal,0,0) + entry->stiffness.size(), &entry->stiffness[0]);
+        std::copy(&optTestCoeffs(cellOrdinal,0,0), &optTestCoeffs(cellOrdinal,0,0) + entry->optimalTestWeights.size(),
+                  &entry->optimalTestWeights[0]);
+      }
+    }
   }
   
-  FieldContainer<double> ipMatrix(numCells,numTestDofs,numTestDofs);
-  ip->computeInnerProductMatrix(ipMatrix, testOrder, ipBasisCache);
+  ScopedPhaseTimer phaseTimer("rhs integration");
+  rhs->integrateAgainstOptimalTests(rhsVector, optTestCoeffs, testOrder, basisCache);
+}
+
+int BF::optimalStiffness(FieldContainer<double> &localStiffness, FieldContainer<double> &optTestCoeffs, ElementTypePtr elemType,
+                         IPPtr ip, BasisCachePtr ipBasisCache, BasisCachePtr basisCache) {
+  DofOrderingPtr testOrder = elemType->testOrderPtr;
+  int numCells = basisCache->cellIDs().size();
+  int numTestDofs = testOrder->totalDofs();
   
-  testMatrixAssemblyTime += timer.ElapsedTime();
+  FieldContainer<double> ipMatrix(numCells,numTestDofs,numTestDofs);
+  {
+    ScopedPhaseTimer phaseTimer("test inner product");
+    ip->computeInnerProductMatrix(ipMatrix, testOrder, ipBasisCache);
+  }
   
   //      cout << "ipMatrix:\n" << ipMatrix;
   
-  timer.ResetStartTime();
-  FieldContainer<double> optTestCoeffs(numCells,numTrialDofs,numTestDofs);
   FieldContainer<double> cellSideParities = basisCache->getCellSideParities();
   
-  int optSuccess = this->optimalTestWeights(optTestCoeffs, ipMatrix, elemType,
-                                            cellSideParities, basisCache);
-  testMatrixInversionTime += timer.ElapsedTime();
+  int optSuccess;
+  {
+    ScopedPhaseTimer phaseTimer("optimal test solve");
+    optSuccess = this->optimalTestWeights(optTestCoeffs, ipMatrix, elemType, cellSideParities, basisCache);
+  }
   //      cout << "optTestCoeffs:\n" << optTestCoeffs;
   
   if ( optSuccess != 0 ) {
@@ -718,21 +810,148 @@ void BF::localStiffnessMatrixAndRHS(FieldContainer<double> &localStiffness, Fiel
   
   //cout << "optTestCoeffs\n" << optTestCoeffs;
   
-  timer.ResetStartTime();
-  
-  BilinearFormUtility::computeStiffnessMatrix(localStiffness,ipMatrix,optTestCoeffs);
-  localStiffnessDeterminationFromTestsTime += timer.ElapsedTime();
+  {
+    ScopedPhaseTimer phaseTimer("stiffness from optimal tests");
+    BilinearFormUtility::computeStiffnessMatrix(localStiffness,ipMatrix,optTestCoeffs);
+  }
   //      cout << "finalStiffness:\n" << finalStiffness;
+  return optSuccess;
+}
+
+void BF::setBasisCacheCells(BasisCachePtr basisCache, const FieldContainer<double> &physicalCellNodes,
+                            const FieldContainer<double> &cellSideParities, const vector<GlobalIndexType> &cellIDs,
+                            const vector<int> &cellOrdinals) {
+  int numCells = cellOrdinals.size();
+  int numNodes = physicalCellNodes.dimension(1), spaceDim = physicalCellNodes.dimension(2);
+  FieldContainer<double> cellsPhysicalNodes(numCells, numNodes, spaceDim);
+  vector<GlobalIndexType> cellsCellIDs(numCells);
+  bool hasParities = (cellSideParities.rank() == 2) && (cellSideParities.dimension(0) == cellIDs.size());
+  int numSides = hasParities ? cellSideParities.dimension(1) : 0;
+  FieldContainer<double> cellsSideParities;
+  if (hasParities) cellsSideParities.resize(numCells, numSides);
+  for (int i=0; i<numCells; i++) {
+    int cellOrdinal = cellOrdinals[i];
+    cellsCellIDs[i] = cellIDs[cellOrdinal];
+    std::copy(&physicalCellNodes(cellOrdinal,0,0), &physicalCellNodes(cellOrdinal,0,0) + numNodes * spaceDim,
+              &cellsPhysicalNodes(i,0,0));
+    for (int sideOrdinal=0; sideOrdinal<numSides; sideOrdinal++) {
+      cellsSideParities(i,sideOrdinal) = cellSideParities(cellOrdinal,sideOrdinal);
+    }
+  }
+  bool createSideCache = (basisCache->getSideBasisCache(0).get() != NULL);
+  basisCache->setPhysicalCellNodes(cellsPhysicalNodes, cellsCellIDs, createSideCache);
+  if (hasParities) basisCache->setCellSideParities(cellsSideParities);
+}
+
+bool BF::StiffnessCacheKey::operator<(const StiffnessCacheKey &other) const {
+  if (elemType != other.elemType) return elemType < other.elemType;
+  if (ip != other.ip) return ip < other.ip;
+  if (cubatureDegree != other.cubatureDegree) return cubatureDegree < other.cubatureDegree;
+  if (ipCubatureDegree != other.ipCubatureDegree) return ipCubatureDegree < other.ipCubatureDegree;
+  if (cubatureDegrees != other.cubatureDegrees) return cubatureDegrees < other.cubatureDegrees;
+  if (ipCubatureDegrees != other.ipCubatureDegrees) return ipCubatureDegrees < other.ipCubatureDegrees;
+  if (jacobianExponent != other.jacobianExponent) return jacobianExponent < other.jacobianExponent;
+  if (jacobian != other.jacobian) return jacobian < other.jacobian;
+  return sideParities < other.sideParities;
+}
+
+vector<BF::StiffnessCacheKey> BF::stiffnessCacheKeys(ElementTypePtr elemType, IPPtr ip, BasisCachePtr basisCache, BasisCachePtr ipBasisCache) {
+  // requires basisCache->cellsAreAffine(), so that the Jacobian at the first point is the Jacobian everywhere;
+  // the stored per-cell Jacobian avoids broadcasting it to every point
+  const FieldContainer<double>* jacobian = &basisCache->getCellJacobian();
+  const FieldContainer<double>* cellSideParities = &basisCache->getCellSideParities();
+  int numCells = jacobian->dimension(0);
+  int spaceDim = jacobian->dimension(2);
+  int numSides = (cellSideParities->rank() == 2) ? cellSideParities->dimension(1) : 0;
   
-  timer.ResetStartTime();
-  rhs->integrateAgainstOptimalTests(rhsVector, optTestCoeffs, testOrder, basisCache);
-  rhsIntegrationAgainstOptimalTestsTime += timer.ElapsedTime();
-  
-  if (printTimings) {
-    cout << "testMatrixAssemblyTime: " << testMatrixAssemblyTime << " seconds.\n";
-    cout << "testMatrixInversionTime: " << testMatrixInversionTime << " seconds.\n";
-    cout << "localStiffnessDeterminationFromTestsTime: " << localStiffnessDeterminationFromTestsTime << " seconds.\n";
-    cout << "rhsIntegrationAgainstOptimalTestsTime: " << rhsIntegrationAgainstOptimalTestsTime << " seconds.\n";
+  vector<StiffnessCacheKey> keys(numCells);
+  for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+    StiffnessCacheKey* key = &keys[cellOrdinal];
+    key->elemType = elemType.get();
+    key->ip = ip.get();
+    // the cached matrices depend on the cubature, so caches with different (e.g. enriched) cubature don't share entries
+    key->cubatureDegree = basisCache->cubatureDegree();
+    key->ipCubatureDegree = ipBasisCache->cubatureDegree();
+    if (key->cubatureDegree < 0) key->cubatureDegrees = basisCache->cubatureDegrees();
+    if (key->ipCubatureDegree < 0) key->ipCubatureDegrees = ipBasisCache->cubatureDegrees();
+    
+    // quantize relative to the largest entry, so that Jacobians that agree up to roundoff get the same key
+    double maxEntry = 0;
+    for (int d1=0; d1<spaceDim; d1++) {
+      for (int d2=0; d2<spaceDim; d2++) {
+        maxEntry = max(maxEntry, abs((*jacobian)(cellOrdinal,0,d1,d2)));
+      }
+    }
+    frexp(maxEntry, &key->jacobianExponent);
+    double quantum = ldexp(1.0, key->jacobianExponent - 36);
+    key->jacobian.resize(spaceDim * spaceDim);
+    for (int d1=0; d1<spaceDim; d1++) {
+      for (int d2=0; d2<spaceDim; d2++) {
+        key->jacobian[d1*spaceDim + d2] = (long long) floor((*jacobian)(cellOrdinal,0,d1,d2) / quantum + 0.5);
+      }
+    }
+    
+    key->sideParities.resize(numSides);
+    for (int sideOrdinal=0; sideOrdinal<numSides; sideOrdinal++) {
+      key->sideParities[sideOrdinal] = ((*cellSideParities)(cellOrdinal,sideOrdinal) > 0) ? 1 : -1;
+    }
+  }
+  return keys;
+}
+
+void BF::initStiffnessCache() {
+  _useStiffnessCache = false;
+  _stiffnessCacheMemoryInBytes = 0;
+  _stiffnessCacheMaxMemoryInBytes = DEFAULT_STIFFNESS_CACHE_MAX_MEMORY_IN_BYTES;
+  _stiffnessCacheHitCount = 0;
+}
+
+void BF::setUseStiffnessCache(bool value) {
+  _useStiffnessCache = value;
+}
+
+bool BF::useStiffnessCache() {
+  return _useStiffnessCache;
+}
+
+void BF::clearStiffnessCache() {
+#ifdef _OPENMP
+#pragma omp critical (BFStiffnessCache)
+#endif
+  {
+    _stiffnessCache.clear();
+    _stiffnessCacheMemoryInBytes = 0;
+    _stiffnessCacheHitCount = 0;
+  }
+}
+
+int BF::stiffnessCacheSize() {
+  return _stiffnessCache.size();
+}
+
+long long BF::stiffnessCacheHitCount() {
+  return _stiffnessCacheHitCount;
+}
+
+long long BF::stiffnessCacheMemoryInBytes() {
+  return _stiffnessCacheMemoryInBytes;
+}
+
+long long BF::stiffnessCacheMaxMemoryInBytes() {
+  return _stiffnessCacheMaxMemoryInBytes;
+}
+
+void BF::setStiffnessCacheMaxMemoryInBytes(long long maxMemory) {
+  _stiffnessCacheMaxMemoryInBytes = maxMemory;
+  if (_stiffnessCacheMemoryInBytes > _stiffnessCacheMaxMemoryInBytes) {
+    // over the new bound: start over; the hit count is kept
+#ifdef _OPENMP
+#pragma omp critical (BFStiffnessCache)
+#endif
+    {
+      _stiffnessCache.clear();
+      _stiffnessCacheMemoryInBytes = 0;
+    }
   }
 }
 
@@ -804,21 +1023,32 @@ int BF::optimalTestWeights(FieldContainer<double> &optimalTestWeights,
   localStiffnessDim[0] = stiffnessMatrix.dimension(1);
   localStiffnessDim[1] = stiffnessMatrix.dimension(2);
   
-  for (int cellIndex=0; cellIndex < numCells; cellIndex++) {
+  vector<int> cellOrdinalsToSolve;
+  if (_useSPDSolveForOptimalTestFunctions) {
+    // the Gram matrices are SPD: one Cholesky solve for the whole batch, writing directly into optimalTestWeights; any
+    // cells that fail fall back to QR (or LU) below
+    SerialDenseWrapper::solveSPDSystemsMultipleRHSTransposed(optimalTestWeights, innerProductMatrix, stiffnessMatrix,
+                                                             cellOrdinalsToSolve);
+    if (cellOrdinalsToSolve.size() > 0) {
+      // may be that we're not SPD numerically
+      cout << "During optimal test weight solution, encountered IP matrix that's not numerically SPD.  Solving with ";
+      cout << (_useQRSolveForOptimalTestFunctions ? "QR" : "LU") << " factorization instead of Cholesky.\n";
+    }
+  } else {
+    for (int cellIndex=0; cellIndex < numCells; cellIndex++) {
+      cellOrdinalsToSolve.push_back(cellIndex);
+    }
+  }
+  
+  for (vector<int>::iterator cellIt = cellOrdinalsToSolve.begin(); cellIt != cellOrdinalsToSolve.end(); cellIt++) {
+    int cellIndex = *cellIt;
     int result = 0;
     FieldContainer<double> cellIPMatrix(localIPDim, &innerProductMatrix(cellIndex,0,0));
     FieldContainer<double> cellStiffness(localStiffnessDim, &stiffnessMatrix(cellIndex,0,0));
     if (_useQRSolveForOptimalTestFunctions) {
       result = SerialDenseWrapper::solveSystemUsingQR(optimalWeightsT, cellIPMatrix, cellStiffness);
-    } else if (_useSPDSolveForOptimalTestFunctions) {
-      result = SerialDenseWrapper::solveSPDSystemMultipleRHS(optimalWeightsT, cellIPMatrix, cellStiffness);
-      if (result != 0) {
-        // may be that we're not SPD numerically
-        cout << "During optimal test weight solution, encountered IP matrix that's not numerically SPD.  Solving with LU factorization instead of Cholesky.\n";
-        result = SerialDenseWrapper::solveSystemMultipleRHS(optimalWeightsT, cellIPMatrix, cellStiffness);
-      }
     } else {
-      SerialDenseWrapper::solveSystemMultipleRHS(optimalWeightsT, cellIPMatrix, cellStiffness);
+      result = SerialDenseWrapper::solveSystemMultipleRHS(optimalWeightsT, cellIPMatrix, cellStiffness);
     }
     // copy/transpose the optimal test weights
     for (int i=0; i<optimalTestWeights.dimension(1); i++) {
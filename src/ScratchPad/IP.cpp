@@ -210,7 +210,7 @@ void IP::computeInnerProductMatrix(FieldContainer<double> &innerProduct,
       for ( vector< LinearTermPtr >:: iterator ltIt = _linearTerms.begin();
            ltIt != _linearTerms.end(); ltIt++) {
         LinearTermPtr lt = *ltIt;
-        // integrate lt against itself
+        // integrate lt against itself (LinearTerm::integrate() detects this and computes only the upper-triangular var blocks)
         lt->integrate(innerProduct,dofOrdering,lt,dofOrdering,basisCache,basisCache->isSideCache());
       }
     }
@@ -351,8 +351,10 @@ void LinearTerm::integrate(Epetra_CrsMatrix* valuesCrsMatrix, FieldContainer<dou
     }
   }
   
-  bool symmetric = false; // turning off a so far buggy attempt at optimization
-  //  bool symmetric = (u.get()==v.get()) && (uOrdering.get() == vOrdering.get());
+  // when u and v are the same term, integrated against the same ordering, the result is symmetric: we compute only
+  // the (uID, vID) blocks with vOrdinal >= uOrdinal, and mirror the off-diagonal blocks into their transposed positions.
+  // The diagonal (uID, uID) blocks are themselves symmetric; we compute their upper triangles and mirror those.
+  bool symmetric = (u.get()==v.get()) && (uOrdering.get() == vOrdering.get());
   
   // values has dimensions (numCells, uFields, vFields)
   int numPoints = basisCache->getPhysicalCubaturePoints().dimension(1);
@@ -452,7 +454,28 @@ void LinearTerm::integrate(Epetra_CrsMatrix* valuesCrsMatrix, FieldContainer<dou
       
       FieldContainer<double> miniMatrix( numCells, uBasisCardinality, vBasisCardinality );
       
-      FunctionSpaceTools::integrate<double>(miniMatrix,uValues,vValues,COMP_BLAS);
+      if (symmetric && (uOrdinal == vOrdinal) && (uValues.size() > 0)) {
+        int valuesPerField = 1; // points times components
+        for (int d=2; d<ltValueDim.size(); d++) {
+          valuesPerField *= ltValueDim[d];
+        }
+        for (int k=0; k < numCells; k++) {
+          for (int i=0; i < uBasisCardinality; i++) {
+            const double *uValue_i = &uValues[(k * uBasisCardinality + i) * valuesPerField];
+            for (int j=i; j < vBasisCardinality; j++) {
+              const double *vValue_j = &vValues[(k * vBasisCardinality + j) * valuesPerField];
+              double sum = 0.0;
+              for (int n=0; n < valuesPerField; n++) {
+                sum += uValue_i[n] * vValue_j[n];
+              }
+              miniMatrix(k,i,j) = sum;
+              miniMatrix(k,j,i) = sum;
+            }
+          }
+        }
+      } else {
+        FunctionSpaceTools::integrate<double>(miniMatrix,uValues,vValues,COMP_BLAS);
+      }
       
       //      cout << "uValues:" << endl << uValues;
       //      cout << "vValues:" << endl << vValues;
@@ -470,7 +493,8 @@ void LinearTerm::integrate(Epetra_CrsMatrix* valuesCrsMatrix, FieldContainer<dou
               int vDofIndex = vDofIndices[j];
               double value = miniMatrix(k,i,j); // separate line for debugger inspection
               valuesFC(k,uDofIndex,vDofIndex) += value;
-              if ((symmetric) && (uOrdinal != vOrdinal)) {  // pretty sure this point is where the bug in symmetric accumulation comes in.  Pretty sure we'll get some double-accumulation.  I'm not sure how to fix it just yet, though.
+              if ((symmetric) && (uOrdinal != vOrdinal)) {
+                // the (vID, uID) block is never computed, so this is its only contribution
                 valuesFC(k,vDofIndex,uDofIndex) += value;
               }
               //            cout << "values(" << k << ", " << uDofIndex << ", " << vDofIndex << ") += " << value << endl;
@@ -483,12 +507,22 @@ void LinearTerm::integrate(Epetra_CrsMatrix* valuesCrsMatrix, FieldContainer<dou
           uDofIndicesFC[i] = uDofIndices[i];
         }
         for (int j=0; j < vBasisCardinality; j++) {
-          vDofIndicesFC[j] = vDofIndicesFC[j];
+          vDofIndicesFC[j] = vDofIndices[j];
         }
         for (int i=0; i < uBasisCardinality; i++) {
           int uDofIndex = uDofIndices[i];
           valuesCrsMatrix->SumIntoGlobalValues(uDofIndex, vBasisCardinality, &miniMatrix(0,i,0), &vDofIndicesFC[0]);
         }
+        if ((symmetric) && (uOrdinal != vOrdinal)) {
+          FieldContainer<double> miniMatrixColumn(uBasisCardinality);
+          for (int j=0; j < vBasisCardinality; j++) {
+            int vDofIndex = vDofIndices[j];
+            for (int i=0; i < uBasisCardinality; i++) {
+              miniMatrixColumn[i] = miniMatrix(0,i,j);
+            }
+            valuesCrsMatrix->SumIntoGlobalValues(vDofIndex, uBasisCardinality, &miniMatrixColumn[0], &uDofIndicesFC[0]);
+          }
+        }
       }
     }
   }
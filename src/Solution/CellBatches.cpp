@@ -0,0 +1,77 @@
+//
+//  CellBatches.cpp
+//  Camellia
+//
+//
+
+#include "CellBatches.h"
+
+#include "Teuchos_GlobalMPISession.hpp"
+
+#include <algorithm>
+
+using namespace Intrepid;
+
+int CellBatches::maxCellBatch(int doublesPerCell) {
+  int maxCellBatch = MAX_BATCH_SIZE_IN_BYTES / 8 / std::max(doublesPerCell, 1);
+  return std::max( maxCellBatch, (int) MIN_BATCH_SIZE_IN_CELLS );
+}
+
+CellBatches::CellBatches(MeshPtr mesh, ElementTypePtr elemType, int doublesPerCell, int maxCellsPerBatch) {
+  int rank = Teuchos::GlobalMPISession::getRank();
+  _cellIDs = mesh->cellIDsOfType(rank, elemType);
+  _physicalCellNodes = mesh->physicalCellNodes(elemType);
+  _cellSideParities = mesh->cellSideParities(elemType);
+  _maxCellBatch = maxCellBatch(doublesPerCell);
+  if (maxCellsPerBatch > 0) _maxCellBatch = std::min(_maxCellBatch, maxCellsPerBatch);
+}
+
+int CellBatches::numCells() const {
+  return _cellIDs.size();
+}
+
+int CellBatches::numBatches() const {
+  return (numCells() + _maxCellBatch - 1) / _maxCellBatch;
+}
+
+int CellBatches::batchStart(int batchOrdinal) const {
+  return batchOrdinal * _maxCellBatch;
+}
+
+int CellBatches::batchSize(int batchOrdinal) const {
+  return std::min(_maxCellBatch, numCells() - batchStart(batchOrdinal));
+}
+
+const std::vector<GlobalIndexType> & CellBatches::cellIDs() const {
+  return _cellIDs;
+}
+
+std::vector<GlobalIndexType> CellBatches::cellIDs(int batchOrdinal) const {
+  int start = batchStart(batchOrdinal);
+  return std::vector<GlobalIndexType>(_cellIDs.begin() + start, _cellIDs.begin() + start + batchSize(batchOrdinal));
+}
+
+FieldContainer<double> CellBatches::cellSideParities(int batchOrdinal) const {
+  Teuchos::Array<int> parityDimensions;
+  _cellSideParities.dimensions(parityDimensions);
+  parityDimensions[0] = batchSize(batchOrdinal);
+  double* parities = const_cast<double*>(&_cellSideParities(batchStart(batchOrdinal),0));
+  return FieldContainer<double>(parityDimensions, parities); // copied on return
+}
+
+void CellBatches::setBasisCache(int batchOrdinal, BasisCachePtr basisCache, bool createSideCache) const {
+  int start = batchStart(batchOrdinal);
+  int numCells = batchSize(batchOrdinal);
+
+  Teuchos::Array<int> nodeDimensions, parityDimensions;
+  _physicalCellNodes.dimensions(nodeDimensions);
+  _cellSideParities.dimensions(parityDimensions);
+  nodeDimensions[0] = numCells;
+  parityDimensions[0] = numCells;
+  // shallow views into the nodes and parities of the whole type
+  FieldContainer<double> physicalCellNodes(nodeDimensions, const_cast<double*>(&_physicalCellNodes(start,0,0)));
+  FieldContainer<double> cellSideParities(parityDimensions, const_cast<double*>(&_cellSideParities(start,0)));
+
+  basisCache->setPhysicalCellNodes(physicalCellNodes, cellIDs(batchOrdinal), createSideCache);
+  basisCache->setCellSideParities(cellSideParities);
+}
@@ -0,0 +1,210 @@
+//
+//  CellCoefficientStore.cpp
+//  Camellia
+//
+//
+
+#include "CellCoefficientStore.h"
+
+#include "Teuchos_TestForException.hpp"
+
+#include <algorithm>
+
+using namespace Intrepid;
+
+void CellCoefficientStore::CoefficientView::setData(double* data, int size) {
+  // the members set here are those FieldContainer's rank-1 constructors set
+  this->data_ = Teuchos::arcp(data, 0, size, false); // false: doesn't own memory
+  this->data_ptr_ = this->data_.begin();
+  this->dimensions_.resize(1);
+  this->dimensions_[0] = size;
+  this->dim0_ = size;
+  this->dim1_ = 0;
+  this->dim2_ = 0;
+  this->dim3_ = 0;
+  this->dim4_ = 0;
+}
+
+CellCoefficientStore::CellCoefficientStore() {
+  _unusedValueCount = 0;
+}
+
+CellCoefficientStore::CellCoefficientStore(const CellCoefficientStore &other) {
+  _values = other._values;
+  _entries = other._entries;
+  _unusedValueCount = other._unusedValueCount;
+  createViews(); // the copied entries share other's views
+}
+
+CellCoefficientStore & CellCoefficientStore::operator=(const CellCoefficientStore &other) {
+  if (this == &other) return *this;
+  _values = other._values;
+  _entries = other._entries;
+  _unusedValueCount = other._unusedValueCount;
+  createViews();
+  return *this;
+}
+
+CellCoefficientStore::Entry & CellCoefficientStore::allocate(GlobalIndexType cellID, int size) {
+  std::map<GlobalIndexType, Entry>::iterator entryIt = _entries.find(cellID);
+  if (entryIt != _entries.end()) {
+    if (entryIt->second.size == size) return entryIt->second;
+    _unusedValueCount += entryIt->second.size;
+  }
+  int offset = _values.size();
+  int newSize = offset + size;
+  if (newSize > _values.capacity()) {
+    // growing the buffer moves it, so the views must be repointed
+    _values.reserve(std::max(newSize, 2 * (int)_values.capacity()));
+    updateViews();
+  }
+  _values.resize(newSize, 0.0);
+
+  Entry* entry = &_entries[cellID];
+  entry->offset = offset;
+  entry->size = size;
+  if (entry->view == Teuchos::null) {
+    entry->view = Teuchos::rcp( new CoefficientView );
+  }
+  updateView(*entry);
+  return *entry;
+}
+
+void CellCoefficientStore::createViews() {
+  for (std::map<GlobalIndexType, Entry>::iterator entryIt = _entries.begin(); entryIt != _entries.end(); entryIt++) {
+    entryIt->second.view = Teuchos::rcp( new CoefficientView );
+    updateView(entryIt->second);
+  }
+}
+
+void CellCoefficientStore::updateView(Entry &entry) {
+  double* data = (entry.size > 0) ? &_values[entry.offset] : NULL;
+  entry.view->setData(data, entry.size);
+}
+
+void CellCoefficientStore::updateViews() {
+  for (std::map<GlobalIndexType, Entry>::iterator entryIt = _entries.begin(); entryIt != _entries.end(); entryIt++) {
+    updateView(entryIt->second);
+  }
+}
+
+void CellCoefficientStore::clear() {
+  _values.clear();
+  _entries.clear();
+  _unusedValueCount = 0;
+}
+
+void CellCoefficientStore::compact() {
+  if (_unusedValueCount == 0) {
+    // still repack if the entries are out of cellID order, so that batches of consecutive cells are contiguous
+    bool inOrder = true;
+    int expectedOffset = 0;
+    for (std::map<GlobalIndexType, Entry>::iterator entryIt = _entries.begin(); entryIt != _entries.end(); entryIt++) {
+      if (entryIt->second.offset != expectedOffset) {
+        inOrder = false;
+        break;
+      }
+      expectedOffset += entryIt->second.size;
+    }
+    if (inOrder) return;
+  }
+
+  std::vector<double> packedValues(_values.size() - _unusedValueCount);
+  int offset = 0;
+  for (std::map<GlobalIndexType, Entry>::iterator entryIt = _entries.begin(); entryIt != _entries.end(); entryIt++) {
+    Entry* entry = &entryIt->second;
+    if (entry->size > 0) {
+      std::copy(&_values[entry->offset], &_values[entry->offset] + entry->size, &packedValues[offset]);
+    }
+    entry->offset = offset;
+    offset += entry->size;
+  }
+  _values.swap(packedValues);
+  _unusedValueCount = 0;
+  updateViews();
+}
+
+bool CellCoefficientStore::hasCoefficients(GlobalIndexType cellID) const {
+  return _entries.find(cellID) != _entries.end();
+}
+
+int CellCoefficientStore::numCells() const {
+  return _entries.size();
+}
+
+std::vector<GlobalIndexType> CellCoefficientStore::cellIDs() const {
+  std::vector<GlobalIndexType> cellIDs;
+  cellIDs.reserve(_entries.size());
+  for (std::map<GlobalIndexType, Entry>::const_iterator entryIt = _entries.begin(); entryIt != _entries.end(); entryIt++) {
+    cellIDs.push_back(entryIt->first);
+  }
+  return cellIDs;
+}
+
+const FieldContainer<double> & CellCoefficientStore::coefficients(GlobalIndexType cellID) const {
+  static const FieldContainer<double> emptyContainer;
+  std::map<GlobalIndexType, Entry>::const_iterator entryIt = _entries.find(cellID);
+  if (entryIt == _entries.end()) return emptyContainer;
+  return *entryIt->second.view;
+}
+
+double* CellCoefficientStore::coefficientValues(GlobalIndexType cellID, int numCoefficients) {
+  Entry* entry = &allocate(cellID, numCoefficients);
+  return (numCoefficients > 0) ? &_values[entry->offset] : NULL;
+}
+
+void CellCoefficientStore::getCoefficientPointers(const std::vector<GlobalIndexType> &cellIDs,
+                                                  std::vector<const double*> &coefficientPointers,
+                                                  std::vector<int> &coefficientCounts) const {
+  int numCells = cellIDs.size();
+  coefficientPointers.resize(numCells);
+  coefficientCounts.resize(numCells);
+  for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+    std::map<GlobalIndexType, Entry>::const_iterator entryIt = _entries.find(cellIDs[cellOrdinal]);
+    if ((entryIt == _entries.end()) || (entryIt->second.size == 0)) {
+      coefficientPointers[cellOrdinal] = NULL;
+      coefficientCounts[cellOrdinal] = 0;
+    } else {
+      coefficientPointers[cellOrdinal] = &_values[entryIt->second.offset];
+      coefficientCounts[cellOrdinal] = entryIt->second.size;
+    }
+  }
+}
+
+void CellCoefficientStore::setCoefficients(GlobalIndexType cellID, const FieldContainer<double> &coefficients) {
+  int size = coefficients.size();
+  Entry* entry = &allocate(cellID, size);
+  if (size > 0) {
+    std::copy(&coefficients[0], &coefficients[0] + size, &_values[entry->offset]);
+  }
+}
+
+void CellCoefficientStore::erase(GlobalIndexType cellID) {
+  std::map<GlobalIndexType, Entry>::iterator entryIt = _entries.find(cellID);
+  if (entryIt == _entries.end()) return;
+  _unusedValueCount += entryIt->second.size;
+  _entries.erase(entryIt);
+}
+
+bool CellCoefficientStore::hasSameLayout(const CellCoefficientStore &other, const std::set<GlobalIndexType> &cellIDs) const {
+  if (_entries.size() != cellIDs.size()) return false;
+  std::set<GlobalIndexType>::const_iterator cellIDIt = cellIDs.begin();
+  for (std::map<GlobalIndexType, Entry>::const_iterator entryIt = _entries.begin(); entryIt != _entries.end(); entryIt++, cellIDIt++) {
+    if (entryIt->first != *cellIDIt) return false;
+    std::map<GlobalIndexType, Entry>::const_iterator otherEntryIt = other._entries.find(entryIt->first);
+    if (otherEntryIt == other._entries.end()) return false;
+    if ((otherEntryIt->second.offset != entryIt->second.offset) || (otherEntryIt->second.size != entryIt->second.size)) return false;
+  }
+  return true;
+}
+
+void CellCoefficientStore::add(double weight, const CellCoefficientStore &other) {
+  // any unused values in either buffer are also updated; that's harmless, and keeps this a single loop
+  int numValues = std::min(_values.size(), other._values.size());
+  if (numValues == 0) return;
+  double* values = &_values[0];
+  const double* otherValues = &other._values[0];
+  for (int i=0; i<numValues; i++) {
+    values[i] += weight * otherValues[i];
+  }
+}
@@ -33,6 +33,7 @@ CondensedDofInterpreter::CondensedDofInterpreter(Mesh* mesh, IPPtr ip, RHSPtr rh
   _rhs = rhs;
   _lagrangeConstraints = lagrangeConstraints;
   _storeLocalStiffnessMatrices = storeLocalStiffnessMatrices;
+  _cacheFieldBlockFactorizations = false;
   _uncondensibleVarIDs.insert(fieldIDsToExclude.begin(),fieldIDsToExclude.end());
   
   int numGlobalConstraints = lagrangeConstraints->numGlobalConstraints();
@@ -54,10 +55,45 @@ void CondensedDofInterpreter::reinitialize() {
   _localLoadVectors.clear();
   _localStiffnessMatrices.clear();
   _localInterpretedDofIndices.clear();
+  _fieldBlockFactorizations.clear();
   
   initializeGlobalDofIndices();
 }
 
+bool CondensedDofInterpreter::factorFieldBlock(const Epetra_SerialDenseMatrix &D, FieldBlockFactorization &factorization) {
+  int N = D.M();
+  if (N == 0) return true;
+  FieldContainer<double> A(1,N,N);
+  for (int i=0; i<N; i++) {
+    for (int j=0; j<N; j++) {
+      A(0,i,j) = D(i,j);
+    }
+  }
+  vector<int> failedCellOrdinals;
+  int err = SerialDenseWrapper::factorSPDSystems(factorization.factor, factorization.scaling, A, failedCellOrdinals);
+  return (err == 0);
+}
+
+void CondensedDofInterpreter::solveFieldBlock(const FieldBlockFactorization &factorization, Epetra_SerialDenseMatrix &B) {
+  int N = B.M();
+  int nRHS = B.N();
+  if ((N == 0) || (nRHS == 0)) return;
+  FieldContainer<double> b(1,N,nRHS);
+  for (int i=0; i<N; i++) {
+    for (int j=0; j<nRHS; j++) {
+      b(0,i,j) = B(i,j);
+    }
+  }
+  FieldContainer<double> xTranspose(1,nRHS,N);
+  int err = SerialDenseWrapper::solveFactoredSPDSystemsTransposed(xTranspose, factorization.factor, factorization.scaling, b);
+  TEUCHOS_TEST_FOR_EXCEPTION(err != 0, std::invalid_argument, "POTRS failed");
+  for (int i=0; i<N; i++) {
+    for (int j=0; j<nRHS; j++) {
+      B(i,j) = xTranspose(0,j,i);
+    }
+  }
+}
+
 void CondensedDofInterpreter::computeAndStoreLocalStiffnessAndLoad(GlobalIndexType cellID) {
 //  cout << "CondensedDofInterpreter: computing stiffness and load for cell " << cellID << endl;
   int numTrialDofs = _mesh->getElementType(cellID)->trialOrderPtr->totalDofs();
@@ -66,6 +102,7 @@ void CondensedDofInterpreter::computeAndStoreLocalStiffnessAndLoad(GlobalIndexTy
   BasisCachePtr ipBasisCache = BasisCache::basisCacheForCell(meshPtr, cellID, true);
   _localStiffnessMatrices[cellID] = FieldContainer<double>(1,numTrialDofs,numTrialDofs);
   _localLoadVectors[cellID] = FieldContainer<double>(1,numTrialDofs);
+  _fieldBlockFactorizations.erase(cellID);
   _mesh->bilinearForm()->localStiffnessMatrixAndRHS(_localStiffnessMatrices[cellID], _localLoadVectors[cellID], _ip, ipBasisCache, _rhs, cellBasisCache);
   
   _localStiffnessMatrices[cellID].resize(numTrialDofs,numTrialDofs);
@@ -79,6 +116,33 @@ void CondensedDofInterpreter::computeAndStoreLocalStiffnessAndLoad(GlobalIndexTy
                                             interpretedStiffnessData, interpretedLoadData, interpretedDofIndices);
   
   _localInterpretedDofIndices[cellID] = interpretedDofIndices;
+  _cellFluxDofIndices.erase(cellID);
+}
+
+const CondensedDofInterpreter::CellFluxDofIndices & CondensedDofInterpreter::cellFluxDofIndices(GlobalIndexType cellID) {
+  if (_cellFluxDofIndices.find(cellID) == _cellFluxDofIndices.end()) {
+    const FieldContainer<GlobalIndexType>* interpretedDofIndices = &_localInterpretedDofIndices[cellID];
+    int numDofs = interpretedDofIndices->size();
+    FieldContainer<GlobalIndexTypeToCast> interpretedDofIndicesCast(numDofs);
+    for (int i=0; i<numDofs; i++) {
+      interpretedDofIndicesCast[i] = (GlobalIndexTypeToCast) (*interpretedDofIndices)[i];
+    }
+    
+    CellFluxDofIndices indices;
+    Epetra_SerialComm SerialComm; // rank-local map
+    indices.interpretedMap = Teuchos::rcp( new Epetra_Map((GlobalIndexTypeToCast)-1, (GlobalIndexTypeToCast)numDofs,
+                                                          (numDofs > 0) ? &interpretedDofIndicesCast[0] : NULL, 0, SerialComm) );
+    indices.globalDofIndices.resize(numDofs, -1);
+    for (int i=0; i<numDofs; i++) {
+      GlobalIndexType interpretedDofIndex = (*interpretedDofIndices)[i];
+      if (_interpretedToGlobalDofIndexMap.find(interpretedDofIndex) != _interpretedToGlobalDofIndexMap.end()) {
+        int lID_interpreted = indices.interpretedMap->LID(interpretedDofIndicesCast[i]);
+        indices.globalDofIndices[lID_interpreted] = _interpretedToGlobalDofIndexMap[interpretedDofIndex];
+      }
+    }
+    _cellFluxDofIndices[cellID] = indices;
+  }
+  return _cellFluxDofIndices[cellID];
 }
 
 void CondensedDofInterpreter::getLocalData(GlobalIndexType cellID, FieldContainer<double> &stiffness, FieldContainer<double> &load, FieldContainer<GlobalIndexType> &interpretedDofIndices) {
@@ -91,76 +155,70 @@ void CondensedDofInterpreter::getLocalData(GlobalIndexType cellID, FieldContaine
   interpretedDofIndices = _localInterpretedDofIndices[cellID];
 }
 
-void CondensedDofInterpreter::getSubmatrices(set<int> fieldIndices, set<int> fluxIndices,
-                                             const FieldContainer<double> &K, Epetra_SerialDenseMatrix &K_field,
+const CondensedDofInterpreter::FieldFluxPartition & CondensedDofInterpreter::fieldFluxPartition(DofOrderingPtr trialOrder) {
+  if (_fieldFluxPartitions.find(trialOrder.get()) == _fieldFluxPartitions.end()) {
+    FieldFluxPartition partition;
+    set<int> fieldIndices, fluxIndices; // sorted, so that the vectors below are in increasing local dof order
+    const set<int>* trialIDs = &trialOrder->getVarIDs();
+    for (set<int>::const_iterator trialIDIt = trialIDs->begin(); trialIDIt != trialIDs->end(); trialIDIt++) {
+      int trialID = *trialIDIt;
+      const vector<int>* sides = &trialOrder->getSidesForVarID(trialID);
+      for (vector<int>::const_iterator sideIt = sides->begin(); sideIt != sides->end(); sideIt++) {
+        int sideOrdinal = *sideIt;
+        vector<int> varIndices = trialOrder->getDofIndices(trialID, sideOrdinal);
+        if (varDofsAreCondensible(trialID, sideOrdinal, trialOrder)) {
+          fieldIndices.insert(varIndices.begin(), varIndices.end());
+        } else {
+          fluxIndices.insert(varIndices.begin(),varIndices.end());
+        }
+      }
+    }
+    partition.fieldIndices.insert(partition.fieldIndices.begin(), fieldIndices.begin(), fieldIndices.end());
+    partition.fluxIndices.insert(partition.fluxIndices.begin(), fluxIndices.begin(), fluxIndices.end());
+    _fieldFluxPartitions[trialOrder.get()] = partition;
+  }
+  return _fieldFluxPartitions[trialOrder.get()];
+}
+
+void CondensedDofInterpreter::getSubmatrices(const vector<int> &fieldIndices, const vector<int> &fluxIndices,
+                                             const double* K, int numDofs, Epetra_SerialDenseMatrix &K_field,
                                              Epetra_SerialDenseMatrix &K_coupl, Epetra_SerialDenseMatrix &K_flux) {
+  // K is row-major, numDofs x numDofs; the Epetra matrices are column-major
   int numFieldDofs = fieldIndices.size();
   int numFluxDofs = fluxIndices.size();
-  K_field.Reshape(numFieldDofs,numFieldDofs);
-  K_flux.Reshape(numFluxDofs,numFluxDofs);
-  K_coupl.Reshape(numFieldDofs,numFluxDofs); // upper right hand corner matrix - symmetry gets the other
-  
-  set<int>::iterator dofIt1;
-  set<int>::iterator dofIt2;
-  
-  int i,j,j_flux,j_field;
-  i = 0;
-  for (dofIt1 = fieldIndices.begin();dofIt1!=fieldIndices.end();dofIt1++){
-    int rowInd = *dofIt1;
-    j_flux = 0;
-    j_field = 0;
-    
-    // get block field matrices
-    for (dofIt2 = fieldIndices.begin();dofIt2!=fieldIndices.end();dofIt2++){
-      int colInd = *dofIt2;
-      //      cout << "rowInd, colInd = " << rowInd << ", " << colInd << endl;
-      K_field(i,j_field) = K(rowInd,colInd);
-      j_field++;
+  K_field.Shape(numFieldDofs,numFieldDofs);
+  K_flux.Shape(numFluxDofs,numFluxDofs);
+  K_coupl.Shape(numFieldDofs,numFluxDofs); // upper right hand corner matrix - symmetry gets the other
+  
+  for (int i=0; i<numFieldDofs; i++) {
+    const double* K_row = &K[fieldIndices[i] * numDofs];
+    for (int j=0; j<numFieldDofs; j++) {
+      K_field(i,j) = K_row[fieldIndices[j]];
     }
-    
-    // get field/flux couplings
-    for (dofIt2 = fluxIndices.begin();dofIt2!=fluxIndices.end();dofIt2++){
-      int colInd = *dofIt2;
-      K_coupl(i,j_flux) = K(rowInd,colInd);
-      j_flux++;
+    for (int j=0; j<numFluxDofs; j++) {
+      K_coupl(i,j) = K_row[fluxIndices[j]];
     }
-    i++;
   }
-  
-  // get flux coupling terms
-  i = 0;
-  for (dofIt1 = fluxIndices.begin();dofIt1!=fluxIndices.end();dofIt1++){
-    int rowInd = *dofIt1;
-    j = 0;
-    for (dofIt2 = fluxIndices.begin();dofIt2!=fluxIndices.end();dofIt2++){
-      int colInd = *dofIt2;
-      K_flux(i,j) = K(rowInd,colInd);
-      j++;
+  for (int i=0; i<numFluxDofs; i++) {
+    const double* K_row = &K[fluxIndices[i] * numDofs];
+    for (int j=0; j<numFluxDofs; j++) {
+      K_flux(i,j) = K_row[fluxIndices[j]];
     }
-    i++;
   }
 }
 
-void CondensedDofInterpreter::getSubvectors(set<int> fieldIndices, set<int> fluxIndices, const FieldContainer<double> &b, Epetra_SerialDenseVector &b_field, Epetra_SerialDenseVector &b_flux){
-  
+void CondensedDofInterpreter::getSubvectors(const vector<int> &fieldIndices, const vector<int> &fluxIndices, const double* b,
+                                            Epetra_SerialDenseVector &b_field, Epetra_SerialDenseVector &b_flux) {
   int numFieldDofs = fieldIndices.size();
   int numFluxDofs = fluxIndices.size();
   
-  b_field.Resize(numFieldDofs);
-  b_flux.Resize(numFluxDofs);
-  set<int>::iterator dofIt;
-  int i;
-  i = 0;
-  for (dofIt=fieldIndices.begin();dofIt!=fieldIndices.end();dofIt++){
-    int ind = *dofIt;
-    b_field(i) = b(ind);
-    i++;
-  }
-  i = 0;
-  for (dofIt=fluxIndices.begin();dofIt!=fluxIndices.end();dofIt++){
-    int ind = *dofIt;
-    b_flux(i) = b(ind);
-    i++;
+  b_field.Size(numFieldDofs);
+  b_flux.Size(numFluxDofs);
+  for (int i=0; i<numFieldDofs; i++) {
+    b_field(i) = b[fieldIndices[i]];
+  }
+  for (int i=0; i<numFluxDofs; i++) {
+    b_flux(i) = b[fluxIndices[i]];
   }
 }
 
@@ -279,6 +337,7 @@ void CondensedDofInterpreter::initializeGlobalDofIndices() {
   _interpretedFluxDofIndices.clear();
   _interpretedToGlobalDofIndexMap.clear();
   _interpretedDofIndicesForBasis.clear();
+  _cellFluxDofIndices.clear();
   
   PartitionIndexType rank = Teuchos::GlobalMPISession::getRank();
   map<GlobalIndexType, IndexType> partitionLocalFluxMap = interpretedFluxMapForPartition(rank, true);
@@ -412,6 +471,45 @@ void CondensedDofInterpreter::interpretLocalData(GlobalIndexType cellID, const F
     computeAndStoreLocalStiffnessAndLoad(cellID);
 //    TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "CondensedDofInterpreter requires both stiffness and load data to be provided.");
   }
+  if (_fieldBlockFactorizations.find(cellID) != _fieldBlockFactorizations.end()) {
+    // stiffness is unchanged, so the condensed load is just b_flux - (D^{-1} B)^T b_field
+    const FieldBlockFactorization* factorization = &_fieldBlockFactorizations[cellID];
+    const FieldFluxPartition* partition = &fieldFluxPartition(_mesh->getElementType(cellID)->trialOrderPtr);
+    if (_storeLocalStiffnessMatrices) {
+      _localLoadVectors[cellID] = localData;
+    }
+    
+    Epetra_SerialDenseVector b_field, b_flux;
+    getSubvectors(partition->fieldIndices, partition->fluxIndices, &localData[0], b_field, b_flux);
+    if ((b_field.Length() > 0) && (b_flux.Length() > 0)) {
+      b_flux.Multiply('T','N',-1.0,factorization->DinvB,b_field,1.0);
+    }
+    
+    FieldContainer<double> condensedLoad(localData.size()); // zero in the field dofs
+    for (int i=0; i<b_flux.Length(); i++) {
+      condensedLoad(partition->fluxIndices[i]) = b_flux(i);
+    }
+    
+    FieldContainer<double> interpretedLoadData;
+    FieldContainer<GlobalIndexType> interpretedDofIndices;
+    _mesh->interpretLocalData(cellID, condensedLoad, interpretedLoadData, interpretedDofIndices);
+    
+    int fluxCount = 0;
+    for (int dofOrdinal=0; dofOrdinal < interpretedDofIndices.size(); dofOrdinal++) {
+      if (_interpretedToGlobalDofIndexMap.find(interpretedDofIndices(dofOrdinal)) != _interpretedToGlobalDofIndexMap.end()) fluxCount++;
+    }
+    globalDofIndices.resize(fluxCount);
+    globalData.resize(fluxCount);
+    int fluxOrdinal = 0;
+    for (int dofOrdinal=0; dofOrdinal < interpretedDofIndices.size(); dofOrdinal++) {
+      map<GlobalIndexType, GlobalIndexType>::iterator entry = _interpretedToGlobalDofIndexMap.find(interpretedDofIndices(dofOrdinal));
+      if (entry == _interpretedToGlobalDofIndexMap.end()) continue; // field
+      globalDofIndices(fluxOrdinal) = entry->second;
+      globalData(fluxOrdinal) = interpretedLoadData(dofOrdinal);
+      fluxOrdinal++;
+    }
+    return;
+  }
   FieldContainer<double> globalStiffnessData; // dummy container
   interpretLocalData(cellID, _localStiffnessMatrices[cellID], localData, globalStiffnessData, globalData, globalDofIndices);
 }
@@ -426,17 +524,6 @@ void CondensedDofInterpreter::interpretLocalData(GlobalIndexType cellID, const F
     TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "cellID does not belong to partition");
   }
   
-//  if (cellID==14) {
-//    cout << "cellID " << cellID << endl;
-//  }
-  
-  FieldContainer<double> interpretedStiffnessData, interpretedLoadData;
-  
-  FieldContainer<GlobalIndexType> interpretedDofIndices;
-  
-  _mesh->DofInterpreter::interpretLocalData(cellID, localStiffnessData, localLoadData,
-                                            interpretedStiffnessData, interpretedLoadData, interpretedDofIndices);
-  
   if (_storeLocalStiffnessMatrices) {
     if (_localStiffnessMatrices.find(cellID) != _localStiffnessMatrices.end()) {
       if (&_localStiffnessMatrices[cellID] != &localStiffnessData) {
@@ -446,110 +533,200 @@ void CondensedDofInterpreter::interpretLocalData(GlobalIndexType cellID, const F
       _localStiffnessMatrices[cellID] = localStiffnessData;
     }
     _localLoadVectors[cellID] = localLoadData;
-    _localInterpretedDofIndices[cellID] = interpretedDofIndices;
   }
   
-  set<int> fieldIndices, fluxIndices; // which are fields and which are fluxes in the interpreted data containers
-//  set<GlobalIndexType> interpretedFluxIndices, interpretedFieldIndices; // debugging
-  for (int dofOrdinal=0; dofOrdinal < interpretedDofIndices.size(); dofOrdinal++) {
-    GlobalIndexType interpretedDofIndex = interpretedDofIndices(dofOrdinal);
-    if (_interpretedToGlobalDofIndexMap.find(interpretedDofIndex) == _interpretedToGlobalDofIndexMap.end()) {
-      fieldIndices.insert(dofOrdinal);
-//      interpretedFieldIndices.insert(interpretedDofIndex); // debugging
-    } else {
-      fluxIndices.insert(dofOrdinal);
-//      interpretedFluxIndices.insert(interpretedDofIndex); // debugging
+  DofOrderingPtr trialOrder = _mesh->getElementType(cellID)->trialOrderPtr;
+  const FieldFluxPartition* partition = &fieldFluxPartition(trialOrder);
+  
+  int numDofs = localLoadData.size();
+  Epetra_SerialDenseMatrix K_flux;
+  Epetra_SerialDenseVector b_flux;
+  condenseCell(cellID, *partition, &localStiffnessData[0], &localLoadData[0], numDofs, K_flux, b_flux);
+  
+  // embed the condensed system in local containers, zero in the field dofs
+  FieldContainer<double> condensedStiffness(numDofs,numDofs);
+  FieldContainer<double> condensedLoad(numDofs);
+  for (int i=0; i<partition->fluxIndices.size(); i++) {
+    int row = partition->fluxIndices[i];
+    condensedLoad(row) = b_flux(i);
+    for (int j=0; j<partition->fluxIndices.size(); j++) {
+      condensedStiffness(row, partition->fluxIndices[j]) = K_flux(i,j);
     }
   }
   
-//  { // DEBUGGING
-//    cout << "CondensedDofInterpreter, field/flux division:\n";
-//    ostringstream cellIDStr;
-//    cellIDStr << "cell " << cellID << ", fields: ";
-//    Camellia::print(cellIDStr.str(), fieldIndices);
-//    Camellia::print("interpreted field indices", interpretedFieldIndices);
-//    
-//    cellIDStr.str("");
-//    cellIDStr << "cell " << cellID << ", fluxes: ";
-//    Camellia::print(cellIDStr.str(), fluxIndices);
-//    
-//    Camellia::print("interpreted flux indices", interpretedFluxIndices);
-//  }
-  
-  int fieldCount = fieldIndices.size();
-  int fluxCount = fluxIndices.size();
+  interpretCondensedLocalData(cellID, condensedStiffness, condensedLoad, globalStiffnessData, globalLoadData, globalDofIndices);
+}
+
+void CondensedDofInterpreter::condenseCell(GlobalIndexType cellID, const FieldFluxPartition &partition, const double* K, const double* b, int numDofs,
+                                           Epetra_SerialDenseMatrix &K_flux, Epetra_SerialDenseVector &b_flux) {
+  // Since the mesh's interpretation acts on fields and fluxes separately (fields are discontinuous, interior-only),
+  // condensing in the local basis and interpreting the Schur complement afterward is equivalent to interpreting first.
+  int fieldCount = partition.fieldIndices.size();
+  int fluxCount = partition.fluxIndices.size();
   
-  Epetra_SerialDenseMatrix D, B, K_flux;
- 
-  getSubmatrices(fieldIndices, fluxIndices, interpretedStiffnessData, D, B, K_flux);
+  Epetra_SerialDenseMatrix D, B;
+  Epetra_SerialDenseVector b_field;
+  getSubmatrices(partition.fieldIndices, partition.fluxIndices, K, numDofs, D, B, K_flux);
+  getSubvectors(partition.fieldIndices, partition.fluxIndices, b, b_field, b_flux);
   
-  // reduce matrix
-  Epetra_SerialDenseMatrix Bcopy = B;
-  Epetra_SerialDenseSolver solver;
-
   Epetra_SerialDenseMatrix DinvB(fieldCount,fluxCount);
-  solver.SetMatrix(D);
-  solver.SetVectors(DinvB, Bcopy);
-  bool equilibrated = false;
-  if ( solver.ShouldEquilibrate() ) {
-    solver.EquilibrateMatrix();
-    solver.EquilibrateRHS();
-    equilibrated = true;
-  }
-  int err = solver.Solve();
-  if (err != 0) {
-    cout << "CondensedDofInterpreter: Epetra_SerialDenseMatrix::Solve() returned error code " << err << endl;
-    cout << "matrix:\n" << D;
+  Epetra_SerialDenseVector Dinvf(fieldCount);
+  
+  bool haveCholeskyFactor = false;
+  if (_cacheFieldBlockFactorizations) {
+    FieldBlockFactorization factorization;
+    if (factorFieldBlock(D, factorization)) {
+      DinvB = B;
+      solveFieldBlock(factorization, DinvB);
+      Dinvf = b_field;
+      solveFieldBlock(factorization, Dinvf);
+      
+      factorization.DinvB = DinvB;
+#ifdef _OPENMP
+#pragma omp critical (CondensedDofInterpreter_storage)
+#endif
+      _fieldBlockFactorizations[cellID] = factorization;
+      haveCholeskyFactor = true;
+    } else {
+#ifdef _OPENMP
+#pragma omp critical (CondensedDofInterpreter_storage)
+#endif
+      _fieldBlockFactorizations.erase(cellID);
+    }
   }
-  if (equilibrated)
-    solver.UnequilibrateLHS();
   
-  K_flux.Multiply('T','N',-1.0,B,DinvB,1.0); // assemble condensed matrix - A - B^T*inv(D)*B
+  if (!haveCholeskyFactor) {
+    // reduce matrix
+    Epetra_SerialDenseMatrix Bcopy = B;
+    Epetra_SerialDenseMatrix Dcopy = D; // the solver may equilibrate its matrix in place
+    Epetra_SerialDenseSolver solver;
+    
+    solver.SetMatrix(Dcopy);
+    solver.SetVectors(DinvB, Bcopy);
+    bool equilibrated = false;
+    if ( solver.ShouldEquilibrate() ) {
+      solver.EquilibrateMatrix();
+      solver.EquilibrateRHS();
+      equilibrated = true;
+    }
+    int err = solver.Solve();
+    if (err != 0) {
+      cout << "CondensedDofInterpreter: Epetra_SerialDenseMatrix::Solve() returned error code " << err << endl;
+      cout << "matrix:\n" << D;
+    }
+    if (equilibrated)
+      solver.UnequilibrateLHS();
+    
+    // reduce vector
+    solver.SetVectors(Dinvf, b_field);
+    equilibrated = false;
+    if ( solver.ShouldEquilibrate() ) {
+      solver.EquilibrateMatrix();
+      solver.EquilibrateRHS();
+      equilibrated = true;
+    }
+    err = solver.Solve();
+    if (err != 0) {
+      cout << "CondensedDofInterpreter: Epetra_SerialDenseMatrix::Solve() returned error code " << err << endl;
+      cout << "matrix:\n" << D;
+    }
+    
+    if (equilibrated)
+      solver.UnequilibrateLHS();
+  }
   
-  // reduce vector
-  Epetra_SerialDenseVector Dinvf(fieldCount);
-  Epetra_SerialDenseVector BtDinvf(fluxCount);
-  Epetra_SerialDenseVector b_field, b_flux;
-  getSubvectors(fieldIndices, fluxIndices, interpretedLoadData, b_field, b_flux);
+  if ((fieldCount > 0) && (fluxCount > 0)) {
+    K_flux.Multiply('T','N',-1.0,B,DinvB,1.0); // assemble condensed matrix - A - B^T*inv(D)*B
+    b_flux.Multiply('T','N',-1.0,B,Dinvf,1.0); // condensed RHS - f - B^T*inv(D)*g
+  }
+}
 
-  solver.SetVectors(Dinvf, b_field);
-  equilibrated = false;
-  //    solver.SetMatrix(D);
-  if ( solver.ShouldEquilibrate() ) {
-    solver.EquilibrateMatrix();
-    solver.EquilibrateRHS();
-    equilibrated = true;
+void CondensedDofInterpreter::condenseLocalData(const vector<GlobalIndexType> &cellIDs, DofOrderingPtr trialOrder,
+                                                FieldContainer<double> &localStiffness, FieldContainer<double> &localLoad) {
+  const FieldFluxPartition* partition;
+#ifdef _OPENMP
+#pragma omp critical (CondensedDofInterpreter_partitions)
+#endif
+  partition = &fieldFluxPartition(trialOrder);
+  
+  int numCells = cellIDs.size();
+  int numDofs = trialOrder->totalDofs();
+  Teuchos::Array<int> localStiffnessDim(2,numDofs);
+  Teuchos::Array<int> localLoadDim(1,numDofs);
+  
+  Epetra_SerialDenseMatrix K_flux;
+  Epetra_SerialDenseVector b_flux;
+  for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+    GlobalIndexType cellID = cellIDs[cellOrdinal];
+    double* K = &localStiffness(cellOrdinal,0,0);
+    double* b = &localLoad(cellOrdinal,0);
+    
+    if (_storeLocalStiffnessMatrices) {
+      FieldContainer<double> cellStiffness(localStiffnessDim, K); // shallow copies
+      FieldContainer<double> cellLoad(localLoadDim, b);
+#ifdef _OPENMP
+#pragma omp critical (CondensedDofInterpreter_storage)
+#endif
+      {
+        _localStiffnessMatrices[cellID] = cellStiffness; // deep copies
+        _localLoadVectors[cellID] = cellLoad;
+      }
+    }
+    
+    condenseCell(cellID, *partition, K, b, numDofs, K_flux, b_flux);
+    
+    for (int i=0; i<numDofs*numDofs; i++) {
+      K[i] = 0.0;
+    }
+    for (int i=0; i<numDofs; i++) {
+      b[i] = 0.0;
+    }
+    int fluxCount = partition->fluxIndices.size();
+    for (int i=0; i<fluxCount; i++) {
+      int row = partition->fluxIndices[i];
+      b[row] = b_flux(i);
+      for (int j=0; j<fluxCount; j++) {
+        K[row * numDofs + partition->fluxIndices[j]] = K_flux(i,j);
+      }
+    }
   }
-  err = solver.Solve();
-  if (err != 0) {
-    cout << "CondensedDofInterpreter: Epetra_SerialDenseMatrix::Solve() returned error code " << err << endl;
-    cout << "matrix:\n" << D;
+}
+
+void CondensedDofInterpreter::interpretCondensedLocalData(GlobalIndexType cellID, const FieldContainer<double> &condensedStiffness,
+                                                          const FieldContainer<double> &condensedLoad, FieldContainer<double> &globalStiffnessData,
+                                                          FieldContainer<double> &globalLoadData, FieldContainer<GlobalIndexType> &globalDofIndices) {
+  FieldContainer<double> interpretedStiffnessData, interpretedLoadData;
+  FieldContainer<GlobalIndexType> interpretedDofIndices;
+  
+  _mesh->DofInterpreter::interpretLocalData(cellID, condensedStiffness, condensedLoad,
+                                            interpretedStiffnessData, interpretedLoadData, interpretedDofIndices);
+  
+  if (_storeLocalStiffnessMatrices) {
+    _localInterpretedDofIndices[cellID] = interpretedDofIndices;
   }
   
-  if (equilibrated)
-    solver.UnequilibrateLHS();
+  vector<int> fluxOrdinals; // which are fluxes in the interpreted data containers (the field rows and columns are zero)
+  fluxOrdinals.reserve(interpretedDofIndices.size());
+  for (int dofOrdinal=0; dofOrdinal < interpretedDofIndices.size(); dofOrdinal++) {
+    GlobalIndexType interpretedDofIndex = interpretedDofIndices(dofOrdinal);
+    if (_interpretedToGlobalDofIndexMap.find(interpretedDofIndex) != _interpretedToGlobalDofIndexMap.end()) {
+      fluxOrdinals.push_back(dofOrdinal);
+    }
+  }
   
-  b_flux.Multiply('T','N',-1.0,B,Dinvf,1.0); // condensed RHS - f - B^T*inv(D)*g
+  int fluxCount = fluxOrdinals.size();
   
   // resize output FieldContainers
   globalDofIndices.resize(fluxCount);
   globalStiffnessData.resize( fluxCount, fluxCount );
   globalLoadData.resize( fluxCount );
   
-  set<int>::iterator indexIt;
-  int i = 0;
-  for (indexIt = fluxIndices.begin();indexIt!=fluxIndices.end();indexIt++){
-    int localFluxIndex = *indexIt;
-    GlobalIndexType interpretedDofIndex = interpretedDofIndices(localFluxIndex);
-    int condensedIndex = _interpretedToGlobalDofIndexMap[interpretedDofIndex];
-    globalDofIndices(i) = condensedIndex;
-    i++;
-  }
-  
   for (int i=0; i<fluxCount; i++) {
-    globalLoadData(i) = b_flux(i);
+    GlobalIndexType interpretedDofIndex = interpretedDofIndices(fluxOrdinals[i]);
+    globalDofIndices(i) = _interpretedToGlobalDofIndexMap[interpretedDofIndex];
+    globalLoadData(i) = interpretedLoadData(fluxOrdinals[i]);
     for (int j=0; j<fluxCount; j++) {
-      globalStiffnessData(i,j) = K_flux(i,j);
+      globalStiffnessData(i,j) = interpretedStiffnessData(fluxOrdinals[i],fluxOrdinals[j]);
     }
   }
 }
@@ -560,58 +737,31 @@ void CondensedDofInterpreter::interpretGlobalCoefficients(GlobalIndexType cellID
   
 //  cout << "CondensedDofInterpreter::interpretGlobalCoefficients for cell " << cellID << endl;
   
+  // with a stored factorization, we need only the load; otherwise, we need the local stiffness, too
+  bool haveFactorization = (_fieldBlockFactorizations.find(cellID) != _fieldBlockFactorizations.end())
+                        && (_localLoadVectors.find(cellID) != _localLoadVectors.end())
+                        && (_localInterpretedDofIndices.find(cellID) != _localInterpretedDofIndices.end());
+  
   // get elem data and submatrix data
   FieldContainer<double> K,rhs;
-  FieldContainer<GlobalIndexType> interpretedDofIndices;
   
-  getLocalData(cellID, K, rhs, interpretedDofIndices);
+  if (!haveFactorization) {
+    FieldContainer<GlobalIndexType> interpretedDofIndices;
+    getLocalData(cellID, K, rhs, interpretedDofIndices);
+  }
   
 //  cout << "CondensedDofInterpreter::interpretGlobalCoefficients, K:\n" << K;
 //  cout << "CondensedDofInterpreter::interpretGlobalCoefficients, rhs:\n" << rhs;
   
-//  if (! _storeLocalStiffnessMatrices ){
-//    // getElemData(elem,K,rhs);
-//    TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "CondensedDofInterpreter::interpretGlobalData() doesn't yet support _storeLocalStiffnessMatrices = false");
-//  } else {
-//    if (_localStiffnessMatrices.find(cellID) == _localStiffnessMatrices.end()) {
-//      cout << "Local stiffness entry for cellID " << cellID << " not found!\n";
-//      TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "Local stiffness entry for cellID not found!");
-//    }
-//    if (_localLoadVectors.find(cellID) == _localLoadVectors.end()) {
-//      cout << "Local load entry for cellID " << cellID << " not found!\n";
-//      TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "Local load entry for cellID not found!");
-//    }
-//    if (_localInterpretedDofIndices.find(cellID) == _localInterpretedDofIndices.end()) {
-//      cout << "Local interpreted dof indices entry for cellID " << cellID << " not found!\n";
-//      TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "Local interpreted dof indices entry for cellID not found!");
-//    }
-//    K = _localStiffnessMatrices[cellID];
-//    rhs = _localLoadVectors[cellID];
-//    interpretedDofIndices = _localInterpretedDofIndices[cellID];
-//  }
-  
-//  cout << "interpretedDofIndices for cell " << cellID << ":\n" << interpretedDofIndices;
-  
-  FieldContainer<GlobalIndexTypeToCast> interpretedDofIndicesCast(interpretedDofIndices.size());
-  for (int i=0; i<interpretedDofIndices.size(); i++) {
-    interpretedDofIndicesCast[i] = (GlobalIndexTypeToCast) interpretedDofIndices[i];
-  }
-  
-  // construct map for interpretedCoefficients:
-  Epetra_SerialComm SerialComm; // rank-local map
-  Epetra_Map    interpretedFluxIndicesMap((GlobalIndexTypeToCast)-1, (GlobalIndexTypeToCast)interpretedDofIndices.size(), &interpretedDofIndicesCast[0], 0, SerialComm);
-  Epetra_MultiVector interpretedCoefficients(interpretedFluxIndicesMap, 1);
-
-  for (int i=0; i<interpretedDofIndices.size(); i++) {
-    GlobalIndexTypeToCast interpretedDofIndex = interpretedDofIndicesCast[i];
-    int lID_interpreted = interpretedFluxIndicesMap.LID(interpretedDofIndex);
-    if (_interpretedToGlobalDofIndexMap.find(interpretedDofIndex) != _interpretedToGlobalDofIndexMap.end()) {
-      GlobalIndexTypeToCast globalDofIndex = _interpretedToGlobalDofIndexMap[interpretedDofIndex];
+  const CellFluxDofIndices* fluxDofIndices = &cellFluxDofIndices(cellID);
+  Epetra_MultiVector interpretedCoefficients(*fluxDofIndices->interpretedMap, 1); // zeros for fields, for now
+
+  int numInterpretedDofs = fluxDofIndices->globalDofIndices.size();
+  for (int lID_interpreted=0; lID_interpreted<numInterpretedDofs; lID_interpreted++) {
+    GlobalIndexTypeToCast globalDofIndex = fluxDofIndices->globalDofIndices[lID_interpreted];
+    if (globalDofIndex >= 0) {
       int lID_global = globalCoefficients.Map().LID(globalDofIndex);
       interpretedCoefficients[0][lID_interpreted] = globalCoefficients[0][lID_global];
-//      cout << "globalCoefficient for globalDofIndex " << globalDofIndex << ": " << globalCoefficients[0][lID_global] << endl;
-    } else {
-      interpretedCoefficients[0][lID_interpreted] = 0; // zeros for fields, for now
     }
   }
   
@@ -621,75 +771,80 @@ void CondensedDofInterpreter::interpretGlobalCoefficients(GlobalIndexType cellID
   
 //  cout << "localCoefficients for cellID " << cellID << ":\n" << localCoefficients;
   
-  set<int> fieldIndices, fluxIndices; // which are fields and which are fluxes in the local cell coefficients
-  set<int> trialIDs = trialOrder->getVarIDs();
-  for (set<int>::iterator trialIDIt = trialIDs.begin(); trialIDIt != trialIDs.end(); trialIDIt++) {
-    int trialID = *trialIDIt;
-    const vector<int>* sides = &trialOrder->getSidesForVarID(trialID);
-    for (vector<int>::const_iterator sideIt = sides->begin(); sideIt != sides->end(); sideIt++) {
-      int sideOrdinal = *sideIt;
-      vector<int> varIndices = trialOrder->getDofIndices(trialID, sideOrdinal);
-      if (varDofsAreCondensible(trialID, sideOrdinal, trialOrder)) {
-        fieldIndices.insert(varIndices.begin(), varIndices.end());
-      } else {
-        fluxIndices.insert(varIndices.begin(),varIndices.end());
-      }
-    }
-  }
+  const FieldFluxPartition* partition = &fieldFluxPartition(trialOrder);
+  const vector<int>* fieldIndices = &partition->fieldIndices;
+  const vector<int>* fluxIndices = &partition->fluxIndices;
   
-  int fieldCount = fieldIndices.size();
-  int fluxCount = fluxIndices.size();
+  int fieldCount = fieldIndices->size();
+  int fluxCount = fluxIndices->size();
   
   Epetra_SerialDenseVector flux_dofs(fluxCount);
-
-  int fluxOrdinal=0;
-  for (set<int>::iterator fluxIt = fluxIndices.begin(); fluxIt != fluxIndices.end(); fluxIt++, fluxOrdinal++) {
-    flux_dofs[fluxOrdinal] = localCoefficients[*fluxIt];
+  for (int fluxOrdinal=0; fluxOrdinal<fluxCount; fluxOrdinal++) {
+    flux_dofs[fluxOrdinal] = localCoefficients[(*fluxIndices)[fluxOrdinal]];
   }
-
-  Epetra_SerialDenseMatrix D, B, fluxMat;
+  
   Epetra_SerialDenseVector b_field, b_flux, field_dofs(fieldCount);
-  getSubmatrices(fieldIndices, fluxIndices, K, D, B, fluxMat);
-  getSubvectors(fieldIndices, fluxIndices, rhs, b_field, b_flux);
   
+  if (haveFactorization) {
+    // u_field = D^{-1} g - (D^{-1} B) u_flux
+    const FieldBlockFactorization* factorization = &_fieldBlockFactorizations[cellID];
+    getSubvectors(*fieldIndices, *fluxIndices, &_localLoadVectors[cellID][0], field_dofs, b_flux);
+    solveFieldBlock(*factorization, field_dofs);
+    if ((fieldCount > 0) && (fluxCount > 0)) {
+      field_dofs.Multiply('N','N',-1.0,factorization->DinvB,flux_dofs,1.0);
+    }
+  } else {
+    Epetra_SerialDenseMatrix D, B, fluxMat;
+    int numDofs = rhs.size();
+    getSubmatrices(*fieldIndices, *fluxIndices, &K[0], numDofs, D, B, fluxMat);
+    getSubvectors(*fieldIndices, *fluxIndices, &rhs[0], b_field, b_flux);
+    
 //  cout << "K:\n" << K;
 //  cout << "D:\n" << D;
 //  cout << "B:\n" << B;
 //  cout << "fluxMat:\n" << fluxMat;
-//  
+//
 //  cout << "b_field:\n" << b_field;
 //  cout << "b_flux:\n" << b_flux;
-  
-  b_field.Multiply('N','N',-1.0,B,flux_dofs,1.0);
-  
-  // solve for field dofs
-  Epetra_SerialDenseSolver solver;
-  solver.SetMatrix(D);
-  solver.SetVectors(field_dofs,b_field);
-  bool equilibrated = false;
-  if ( solver.ShouldEquilibrate() ) {
-    solver.EquilibrateMatrix();
-    solver.EquilibrateRHS();
-    equilibrated = true;
+    
+    b_field.Multiply('N','N',-1.0,B,flux_dofs,1.0);
+    
+    // solve for field dofs
+    Epetra_SerialDenseSolver solver;
+    solver.SetMatrix(D);
+    solver.SetVectors(field_dofs,b_field);
+    bool equilibrated = false;
+    if ( solver.ShouldEquilibrate() ) {
+      solver.EquilibrateMatrix();
+      solver.EquilibrateRHS();
+      equilibrated = true;
+    }
+    solver.Solve();
+    if (equilibrated)
+      solver.UnequilibrateLHS();
   }
-  solver.Solve();
-  if (equilibrated)
-    solver.UnequilibrateLHS();
   
-  int fieldOrdinal = 0; // index into field_dofs
-  for (set<int>::iterator fieldIt = fieldIndices.begin(); fieldIt != fieldIndices.end(); fieldIt++, fieldOrdinal++) {
-    localCoefficients[*fieldIt] = field_dofs[fieldOrdinal];
+  for (int fieldOrdinal=0; fieldOrdinal<fieldCount; fieldOrdinal++) {
+    localCoefficients[(*fieldIndices)[fieldOrdinal]] = field_dofs[fieldOrdinal];
   }
   
 //  cout << "field_dofs:\n" << field_dofs;
 }
 
+void CondensedDofInterpreter::setCacheFieldBlockFactorizations(bool value) {
+  _cacheFieldBlockFactorizations = value;
+  if (!_cacheFieldBlockFactorizations) {
+    _fieldBlockFactorizations.clear();
+  }
+}
+
 void CondensedDofInterpreter::storeLoadForCell(GlobalIndexType cellID, const FieldContainer<double> &load) {
   _localLoadVectors[cellID] = load;
 }
 
 void CondensedDofInterpreter::storeStiffnessForCell(GlobalIndexType cellID, const FieldContainer<double> &stiffness) {
   _localStiffnessMatrices[cellID] = stiffness;
+  _fieldBlockFactorizations.erase(cellID); // factorization belonged to the previous stiffness
 }
 
 const FieldContainer<double> & CondensedDofInterpreter::storedLocalLoadForCell(GlobalIndexType cellID) {
@@ -83,7 +83,9 @@ GMGOperator::GMGOperator(BCPtr zeroBCs, MeshPtr coarseMesh, IPPtr coarseIP,
 
   _coarseSolver = coarseSolver;
   _haveSolvedOnCoarseMesh = false;
+  _fineStiffnessMatrix = Teuchos::null;
 
+  _multigridStrategy = TWO_LEVEL; // default
   _smootherType = IFPACK_ADDITIVE_SCHWARZ; // default
   _smootherOverlap = 0;
 
@@ -141,7 +143,7 @@ void GMGOperator::clearTimings() {
   _timeMapFineToCoarse = 0, _timeMapCoarseToFine = 0, _timeConstruction = 0, _timeCoarseSolve = 0, _timeCoarseImport = 0, _timeLocalCoefficientMapConstruction = 0, _timeComputeCoarseStiffnessMatrix = 0, _timeProlongationOperatorConstruction = 0;
 }
 
-void GMGOperator::computeCoarseStiffnessMatrix(Epetra_CrsMatrix *fineStiffnessMatrix) {
+void GMGOperator::computeCoarseStiffnessMatrix(Teuchos::RCP<Epetra_CrsMatrix> fineStiffnessMatrix) {
   int globalColCount = fineStiffnessMatrix->NumGlobalCols();
   if (_P.get() == NULL) {
     constructProlongationOperator();
@@ -161,7 +163,8 @@ void GMGOperator::computeCoarseStiffnessMatrix(Epetra_CrsMatrix *fineStiffnessMa
 #endif
   Epetra_Time coarseStiffnessTimer(Comm);
   
-  setUpSmoother(fineStiffnessMatrix);
+  _fineStiffnessMatrix = fineStiffnessMatrix;
+  setUpSmoother(fineStiffnessMatrix.get());
 
 //  EpetraExt::RowMatrixToMatrixMarketFile("/tmp/A.dat",*fineStiffnessMatrix, NULL, NULL, false); // false: don't write header
 
@@ -212,6 +215,11 @@ void GMGOperator::computeCoarseStiffnessMatrix(Epetra_CrsMatrix *fineStiffnessMa
   _timeComputeCoarseStiffnessMatrix = coarseStiffnessTimer.ElapsedTime();
   
   _haveSolvedOnCoarseMesh = false; // having recomputed coarseStiffness, any existing factorization is invalid
+  
+  if (_coarseOperator != Teuchos::null) {
+    // recurse: the coarse stiffness is the "fine" stiffness for the next level down
+    _coarseOperator->computeCoarseStiffnessMatrix(coarseStiffness);
+  }
 }
 
 void GMGOperator::constructLocalCoefficientMaps() {
@@ -397,6 +405,10 @@ GlobalIndexType GMGOperator::getCoarseCellID(GlobalIndexType fineCellID) const {
   return ancestor->cellIndex();
 }
 
+Teuchos::RCP<GMGOperator> GMGOperator::getCoarseOperator() {
+  return _coarseOperator;
+}
+
 SolutionPtr GMGOperator::getCoarseSolution() {
   return _coarseSolution;
 }
@@ -405,6 +417,10 @@ SolverPtr GMGOperator::getCoarseSolver() {
   return _coarseSolver;
 }
 
+GMGOperator::MultigridStrategy GMGOperator::getMultigridStrategy() {
+  return _multigridStrategy;
+}
+
 LocalDofMapperPtr GMGOperator::getLocalCoefficientMap(GlobalIndexType fineCellID) const {
   const set<IndexType>* coarseCellIDs = &_coarseMesh->getTopology()->getActiveCellIndices();
   CellPtr fineCell = _fineMesh->getTopology()->getCell(fineCellID);
@@ -612,26 +628,12 @@ LocalDofMapperPtr GMGOperator::getLocalCoefficientMap(GlobalIndexType fineCellID
   return dofMapper;
 }
 
-int GMGOperator::Apply(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const {
-  TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "Unsupported method.");
-}
-
-int GMGOperator::ApplyInverse(const Epetra_MultiVector& X_in, Epetra_MultiVector& Y) const {
-//  cout << "GMGOperator::ApplyInverse.\n";
+void GMGOperator::applyCoarseCorrection(const Epetra_MultiVector &X, Epetra_MultiVector &Y) const {
   int rank = Teuchos::GlobalMPISession::getRank();
   bool printVerboseOutput = (rank==0) && _debugMode;
-  
+
   Epetra_Time timer(Comm());
 
-  Epetra_MultiVector X(X_in); // looks like Y may be stored in the same location as X_in, so that changing Y will change X, too...
-  if (_fineSolverUsesDiagonalScaling) {
-    if (printVerboseOutput) cout << "multiplying X by _diag_sqrt\n";
-    // Here, we assume symmetric diagonal scaling: D^-1/2 A D^-1/2, where A is the fine matrix.
-    // (because the inverse that we otherwise approximate is A^-1, we now approximate D^1/2 A^-1 D^1/2)
-    X.Multiply(1.0, *_diag_sqrt, X, 0);
-    if (printVerboseOutput) cout << "finished multiplying X by _diag_sqrt\n";
-  }
-  
   if (printVerboseOutput) cout << "calling _coarseSolution->getRHSVector()\n";
   Teuchos::RCP<Epetra_FEVector> coarseRHSVector = _coarseSolution->getRHSVector();
   if (printVerboseOutput) cout << "returned from _coarseSolution->getRHSVector()\n";
@@ -643,7 +645,22 @@ int GMGOperator::ApplyInverse(const Epetra_MultiVector& X_in, Epetra_MultiVector
   _timeMapFineToCoarse += timer.ElapsedTime();
 
   timer.ResetStartTime();
-  if (!_haveSolvedOnCoarseMesh) {
+  if (_coarseOperator != Teuchos::null) {
+    // multilevel: approximate the coarse inverse by one (V) or two (W) cycles on the next level
+    if (printVerboseOutput) cout << "cycling on coarse mesh\n";
+    Teuchos::RCP<Epetra_FEVector> coarseLHSVector = _coarseSolution->getLHSVector();
+    _coarseOperator->ApplyInverse(*coarseRHSVector, *coarseLHSVector);
+    if (_multigridStrategy == W_CYCLE) {
+      Teuchos::RCP<Epetra_CrsMatrix> coarseStiffness = _coarseSolution->getStiffnessMatrix();
+      Epetra_MultiVector coarseResidual(*coarseRHSVector);
+      Epetra_MultiVector coarseCorrection(coarseRHSVector->Map(), coarseRHSVector->NumVectors());
+      coarseStiffness->Multiply(false, *coarseLHSVector, coarseResidual);
+      coarseResidual.Update(1.0, *coarseRHSVector, -1.0);
+      _coarseOperator->ApplyInverse(coarseResidual, coarseCorrection);
+      coarseLHSVector->Update(1.0, coarseCorrection, 1.0);
+    }
+    if (printVerboseOutput) cout << "finished cycling on coarse mesh\n";
+  } else if (!_haveSolvedOnCoarseMesh) {
     if (printVerboseOutput) cout << "solving on coarse mesh\n";
     _coarseSolution->setProblem(_coarseSolver);
     _coarseSolution->solveWithPrepopulatedStiffnessAndLoad(_coarseSolver, false);
@@ -665,22 +682,71 @@ int GMGOperator::ApplyInverse(const Epetra_MultiVector& X_in, Epetra_MultiVector
   _P->Multiply(false, *coarseLHSVector, Y);
   if (printVerboseOutput) cout << "finished _P->Multiply(false, *coarseLHSVector, Y)\n";
   _timeMapCoarseToFine += timer.ElapsedTime();
+}
 
-  // if _applySmoothingOperator is set, add S^(-1)X to Y.
-  if (_applySmoothingOperator) {
-    if (printVerboseOutput) cout << "copying X into X2\n";
-    Epetra_MultiVector X2(X); // copy, since I'm not sure ApplyInverse is generally OK with X and Y in same location (though Aztec seems to make that assumption, so it probably is OK).
-    if (printVerboseOutput) cout << "finished copying X into X2\n";
-    if (printVerboseOutput) cout << "calling _smoother->ApplyInverse(X2, X)\n";
-    _smoother->ApplyInverse(X2, X);
-    if (printVerboseOutput) cout << "finished _smoother->ApplyInverse(X2, X)\n";
-    if (printVerboseOutput) cout << "calling Y.Update(1.0, X, 1.0)\n";
-    Y.Update(1.0, X, 1.0);
-    if (printVerboseOutput) cout << "finished Y.Update(1.0, X, 1.0)\n";
-  } else {
-    //    cout << "_diag is NULL.\n";
+int GMGOperator::Apply(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const {
+  TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "Unsupported method.");
+}
+
+int GMGOperator::ApplyInverse(const Epetra_MultiVector& X_in, Epetra_MultiVector& Y) const {
+//  cout << "GMGOperator::ApplyInverse.\n";
+  int rank = Teuchos::GlobalMPISession::getRank();
+  bool printVerboseOutput = (rank==0) && _debugMode;
+
+  Epetra_MultiVector X(X_in); // looks like Y may be stored in the same location as X_in, so that changing Y will change X, too...
+  if (_fineSolverUsesDiagonalScaling) {
+    if (printVerboseOutput) cout << "multiplying X by _diag_sqrt\n";
+    // Here, we assume symmetric diagonal scaling: D^-1/2 A D^-1/2, where A is the fine matrix.
+    // (because the inverse that we otherwise approximate is A^-1, we now approximate D^1/2 A^-1 D^1/2)
+    X.Multiply(1.0, *_diag_sqrt, X, 0);
+    if (printVerboseOutput) cout << "finished multiplying X by _diag_sqrt\n";
   }
+  
+  if (_multigridStrategy == TWO_LEVEL) {
+    applyCoarseCorrection(X, Y);
+
+    // if _applySmoothingOperator is set, add S^(-1)X to Y.
+    if (_applySmoothingOperator) {
+      if (printVerboseOutput) cout << "copying X into X2\n";
+      Epetra_MultiVector X2(X); // copy, since I'm not sure ApplyInverse is generally OK with X and Y in same location (though Aztec seems to make that assumption, so it probably is OK).
+      if (printVerboseOutput) cout << "finished copying X into X2\n";
+      if (printVerboseOutput) cout << "calling _smoother->ApplyInverse(X2, X)\n";
+      _smoother->ApplyInverse(X2, X);
+      if (printVerboseOutput) cout << "finished _smoother->ApplyInverse(X2, X)\n";
+      if (printVerboseOutput) cout << "calling Y.Update(1.0, X, 1.0)\n";
+      Y.Update(1.0, X, 1.0);
+      if (printVerboseOutput) cout << "finished Y.Update(1.0, X, 1.0)\n";
+    } else {
+      //    cout << "_diag is NULL.\n";
+    }
+  } else {
+    // multiplicative cycle: pre-smooth, correct on the coarse level, post-smooth.
+    // Using the same (symmetric) smoother before and after keeps the preconditioner symmetric for CG.
+    TEUCHOS_TEST_FOR_EXCEPTION(_fineStiffnessMatrix == Teuchos::null, std::invalid_argument,
+                               "V- and W-cycles require computeCoarseStiffnessMatrix() to be called before ApplyInverse()");
+    Epetra_MultiVector residual(X);
+    Epetra_MultiVector correction(X.Map(), X.NumVectors());
+
+    if (_applySmoothingOperator) {
+      if (printVerboseOutput) cout << "pre-smoothing\n";
+      _smoother->ApplyInverse(X, Y);
+      _fineStiffnessMatrix->Multiply(false, Y, residual);
+      residual.Update(1.0, X, -1.0); // residual = X - A Y
+    } else {
+      Y.PutScalar(0.0);
+    }
+
+    applyCoarseCorrection(residual, correction);
+    Y.Update(1.0, correction, 1.0);
 
+    if (_applySmoothingOperator) {
+      if (printVerboseOutput) cout << "post-smoothing\n";
+      _fineStiffnessMatrix->Multiply(false, Y, residual);
+      residual.Update(1.0, X, -1.0);
+      _smoother->ApplyInverse(residual, correction);
+      Y.Update(1.0, correction, 1.0);
+    }
+  }
 
   if (_fineSolverUsesDiagonalScaling) {
     if (printVerboseOutput) cout << "calling Y.Multiply(1.0, *_diag_sqrt, Y, 0)\n";
@@ -776,22 +842,6 @@ set<GlobalIndexTypeToCast> GMGOperator::setCoarseRHSVector(const Epetra_MultiVec
   return coarseDofIndicesToImport;
 }
 
-TimeStatistics GMGOperator::getStatistics(double timeValue) const {
-  TimeStatistics stats;
-  int indexBase = 0;
-  int numProcs = Teuchos::GlobalMPISession::getNProc();
-  Epetra_Map timeMap(numProcs,indexBase,Comm());
-  Epetra_Vector timeVector(timeMap);
-  timeVector[0] = timeValue;
-
-  int err = timeVector.Norm1( &stats.sum );
-  err = timeVector.MeanValue( &stats.mean );
-  err = timeVector.MinValue( &stats.min );
-  err = timeVector.MaxValue( &stats.max );
-
-  return stats;
-}
-
 void GMGOperator::reportTimings() const {
   //   mutable double _timeMapFineToCoarse, _timeMapCoarseToFine, _timeCoarseImport, _timeConstruction, _timeCoarseSolve;  // totals over the life of the object
   int rank = Teuchos::GlobalMPISession::getRank();
@@ -807,7 +857,7 @@ void GMGOperator::reportTimings() const {
   reportValues["compute coarse stiffness matrix"] = _timeComputeCoarseStiffnessMatrix;
 
   for (map<string,double>::iterator reportIt = reportValues.begin(); reportIt != reportValues.end(); reportIt++) {
-    TimeStatistics stats = getStatistics(reportIt->second);
+    TimeStatistics stats = PhaseTimers::timeStatistics(reportIt->second);
     if (rank==0) {
       cout << reportIt->first << ":\n";
       cout <<  "mean = " << stats.mean << " seconds\n";
@@ -820,6 +870,17 @@ void GMGOperator::reportTimings() const {
 
 void GMGOperator::setApplySmoothingOperator(bool value) {
   _applySmoothingOperator = value;
+  if (_coarseOperator != Teuchos::null) _coarseOperator->setApplySmoothingOperator(value);
+}
+
+void GMGOperator::setCoarseOperator(Teuchos::RCP<GMGOperator> coarseOperator) {
+  _coarseOperator = coarseOperator;
+  if (_coarseOperator != Teuchos::null) {
+    _coarseOperator->setMultigridStrategy(_multigridStrategy);
+    _coarseOperator->setApplySmoothingOperator(_applySmoothingOperator);
+    _coarseOperator->setSmootherType(_smootherType);
+    _coarseOperator->setSmootherOverlap(_smootherOverlap);
+  }
 }
 
 void GMGOperator::setCoarseSolver(SolverPtr coarseSolver) {
@@ -830,6 +891,11 @@ void GMGOperator::setDebugMode(bool value) {
   _debugMode = value;
 }
 
+void GMGOperator::setMultigridStrategy(MultigridStrategy strategy) {
+  _multigridStrategy = strategy;
+  if (_coarseOperator != Teuchos::null) _coarseOperator->setMultigridStrategy(strategy);
+}
+
 void GMGOperator::setFineMesh(MeshPtr fineMesh, Epetra_Map finePartitionMap) {
   _fineMesh = fineMesh;
   _finePartitionMap = finePartitionMap;
@@ -880,10 +946,12 @@ void GMGOperator::setStiffnessDiagonal(Teuchos::RCP< Epetra_MultiVector> diagona
 
 void GMGOperator::setSmootherOverlap(int overlap) {
   _smootherOverlap = overlap;
+  if (_coarseOperator != Teuchos::null) _coarseOperator->setSmootherOverlap(overlap);
 }
 
 void GMGOperator::setSmootherType(GMGOperator::SmootherChoice smootherType) {
   _smootherType = smootherType;
+  if (_coarseOperator != Teuchos::null) _coarseOperator->setSmootherType(smootherType);
 }
 
 void GMGOperator::setUpSmoother(Epetra_CrsMatrix *fineStiffnessMatrix) {
@@ -20,17 +20,7 @@ GMGSolver::GMGSolver(BCPtr zeroBCs, MeshPtr coarseMesh, IPPtr coarseIP,
                     _finePartitionMap(finePartitionMap),
                     _gmgOperator(zeroBCs,coarseMesh,coarseIP,fineMesh,fineDofInterpreter,
                                  finePartitionMap,coarseSolver, useStaticCondensation, DIAGONAL_SCALING_DEFAULT) {
-  _maxIters = maxIters;
-  _printToConsole = false;
-  _tol = tol;
-  _applySmoothing = true;
-  _diagonalScaling = DIAGONAL_SCALING_DEFAULT;
-                      
-  _computeCondest = true;
-  _azOutput = AZ_warnings;
-                      
-  _useCG = true;
-  _azConvergenceOption = AZ_rhs;
+  initialize(maxIters, tol);
 }
 
 GMGSolver::GMGSolver(SolutionPtr fineSolution, MeshPtr coarseMesh, int maxIters, double tol,
@@ -40,6 +30,113 @@ GMGSolver::GMGSolver(SolutionPtr fineSolution, MeshPtr coarseMesh, int maxIters,
                                  fineSolution->ip(), fineSolution->mesh(), fineSolution->getDofInterpreter(),
                                  _finePartitionMap, coarseSolver, useStaticCondensation, DIAGONAL_SCALING_DEFAULT)
 {
+  initialize(maxIters, tol);
+}
+
+static MeshPtr nextCoarserMesh(const vector<MeshPtr> &coarseMeshes) {
+  TEUCHOS_TEST_FOR_EXCEPTION(coarseMeshes.size() == 0, std::invalid_argument, "coarseMeshes must contain at least one mesh");
+  return coarseMeshes[coarseMeshes.size()-1];
+}
+
+GMGSolver::GMGSolver(SolutionPtr fineSolution, vector<MeshPtr> coarseMeshes, int maxIters, double tol,
+                     Teuchos::RCP<Solver> coarseSolver, bool useStaticCondensation) :
+                    _finePartitionMap(fineSolution->getPartitionMap()),
+                    _gmgOperator(fineSolution->bc()->copyImposingZero(),nextCoarserMesh(coarseMeshes),
+                                 fineSolution->ip(), fineSolution->mesh(), fineSolution->getDofInterpreter(),
+                                 _finePartitionMap, (coarseMeshes.size() == 1) ? coarseSolver : Teuchos::RCP<Solver>(),
+                                 useStaticCondensation, DIAGONAL_SCALING_DEFAULT)
+{
+  initialize(maxIters, tol);
+
+  // each level's coarse Solution supplies the "fine" dofs for the next level down;
+  // only the coarsest level does a direct solve.
+  BCPtr zeroBCs = fineSolution->bc()->copyImposingZero();
+  GMGOperator* finerOperator = &_gmgOperator;
+  for (int level = coarseMeshes.size() - 2; level >= 0; level--) {
+    SolutionPtr levelSolution = finerOperator->getCoarseSolution();
+    Teuchos::RCP<Solver> levelCoarseSolver = (level == 0) ? coarseSolver : Teuchos::RCP<Solver>();
+    bool fineSolverUsesDiagonalScaling = false; // scaling, if any, is handled by the finest level
+    Teuchos::RCP<GMGOperator> coarseOperator = Teuchos::rcp( new GMGOperator(zeroBCs, coarseMeshes[level], fineSolution->ip(),
+                                                                              coarseMeshes[level+1], levelSolution->getDofInterpreter(),
+                                                                              levelSolution->getPartitionMap(), levelCoarseSolver,
+                                                                              useStaticCondensation, fineSolverUsesDiagonalScaling) );
+    finerOperator->setCoarseOperator(coarseOperator);
+    finerOperator = coarseOperator.get();
+  }
+}
+
+vector<MeshPtr> GMGSolver::coarseMeshHierarchy(MeshPtr fineMesh, int coarsestH1Order) {
+  BFPtr bf = fineMesh->bilinearForm();
+  MeshTopologyPtr fineTopology = fineMesh->getTopology();
+  int delta_k = fineMesh->globalDofAssignment()->getTestOrderEnrichment();
+  
+  vector<MeshPtr> meshesFinestFirst;
+  
+  // p-coarsening on the fine topology: halve the polynomial order until we reach coarsestH1Order
+  int H1Order = fineMesh->globalDofAssignment()->getInitialH1Order();
+  while (H1Order > coarsestH1Order) {
+    H1Order = max(coarsestH1Order, H1Order / 2);
+    meshesFinestFirst.push_back(Teuchos::rcp( new Mesh(fineTopology->deepCopy(), bf, H1Order, delta_k) ));
+  }
+  
+  // h-coarsening at the coarsest order.  Mesh does not support h-unrefinement, so each level is rebuilt from the root
+  // topology by replaying a prefix of the fine mesh's refinements.  Replaying them in the order in which their children
+  // were created reproduces the fine cell indices, which GMGOperator relies on to match fine cells to coarse ancestors.
+  map<IndexType, CellPtr> parentsByFirstChild;
+  IndexType cellCount = fineTopology->cellCount();
+  for (IndexType cellIndex=0; cellIndex<cellCount; cellIndex++) {
+    CellPtr cell = fineTopology->getCell(cellIndex);
+    if (cell->isParent()) parentsByFirstChild[cell->children()[0]->cellIndex()] = cell;
+  }
+  vector<CellPtr> parents;
+  for (map<IndexType, CellPtr>::iterator parentIt = parentsByFirstChild.begin(); parentIt != parentsByFirstChild.end(); parentIt++) {
+    parents.push_back(parentIt->second);
+  }
+  
+  int numParents = parents.size();
+  while (numParents > 0) {
+    // drop the trailing refinements none of whose children is refined within the current prefix
+    set<IndexType> refinedCellIndices;
+    for (int parentOrdinal=0; parentOrdinal<numParents; parentOrdinal++) {
+      refinedCellIndices.insert(parents[parentOrdinal]->cellIndex());
+    }
+    while (numParents > 0) {
+      const vector<CellPtr> &children = parents[numParents-1]->children();
+      bool hasRefinedChild = false;
+      for (int childOrdinal=0; childOrdinal<children.size(); childOrdinal++) {
+        if (refinedCellIndices.find(children[childOrdinal]->cellIndex()) != refinedCellIndices.end()) {
+          hasRefinedChild = true;
+          break;
+        }
+      }
+      if (hasRefinedChild) break;
+      numParents--;
+    }
+    
+    MeshPtr coarseMesh = Teuchos::rcp( new Mesh(fineTopology->getRootMeshTopology(), bf, H1Order, delta_k) );
+    int parentOrdinal = 0;
+    while (parentOrdinal < numParents) {
+      // group consecutive refinements that share a pattern, come in increasing cell order (the order in which Mesh
+      // refines a set), and refine cells that already exist
+      RefinementPatternPtr refPattern = parents[parentOrdinal]->refinementPattern();
+      IndexType coarseCellCount = coarseMesh->getTopology()->cellCount();
+      set<GlobalIndexType> cellIDs;
+      cellIDs.insert(parents[parentOrdinal++]->cellIndex());
+      while ((parentOrdinal < numParents) && (parents[parentOrdinal]->refinementPattern() == refPattern)
+             && (parents[parentOrdinal]->cellIndex() > *cellIDs.rbegin())
+             && (parents[parentOrdinal]->cellIndex() < coarseCellCount)) {
+        cellIDs.insert(parents[parentOrdinal++]->cellIndex());
+      }
+      bool repartitionAndRebuild = (parentOrdinal == numParents);
+      coarseMesh->hRefine(cellIDs, refPattern, repartitionAndRebuild);
+    }
+    meshesFinestFirst.push_back(coarseMesh);
+  }
+  
+  return vector<MeshPtr>(meshesFinestFirst.rbegin(), meshesFinestFirst.rend());
+}
+
+void GMGSolver::initialize(int maxIters, double tol) {
   _maxIters = maxIters;
   _printToConsole = false;
   _tol = tol;
@@ -70,6 +167,10 @@ void GMGSolver::setApplySmoothingOperator(bool applySmoothingOp) {
   _gmgOperator.setApplySmoothingOperator(_applySmoothing);
 }
 
+void GMGSolver::setMultigridStrategy(GMGOperator::MultigridStrategy strategy) {
+  _gmgOperator.setMultigridStrategy(strategy);
+}
+
 void GMGSolver::setFineMesh(MeshPtr fineMesh, Epetra_Map finePartitionMap) {
   _gmgOperator.setFineMesh(fineMesh, finePartitionMap);
 }
@@ -97,7 +198,10 @@ int GMGSolver::solve(bool buildCoarseStiffness) {
   
   // in place of doing the scaling ourselves, for the moment I've switched
   // over to using Aztec's built-in scaling.  This appears to be functionally identical.
-  bool useAztecToScaleDiagonally = true;
+  // The exception is a multiplicative (V- or W-) cycle: Aztec scales the matrix in place during Iterate(), but the
+  // cycle's residuals are computed with that same matrix in the unscaled variables.  There we scale the problem
+  // ourselves, and the operator then simply preconditions the scaled system.
+  bool useAztecToScaleDiagonally = (_gmgOperator.getMultigridStrategy() == GMGOperator::TWO_LEVEL);
   
   AztecOO solver(problem());
   
@@ -133,6 +237,8 @@ int GMGSolver::solve(bool buildCoarseStiffness) {
     
     problem().LeftScale(scale_vector);
     problem().RightScale(scale_vector);
+    
+    A->ExtractDiagonalCopy(diagA); // the operator sees the scaled matrix
   }
   
   Teuchos::RCP<Epetra_MultiVector> diagA_ptr = Teuchos::rcp( &diagA, false );
@@ -140,9 +246,10 @@ int GMGSolver::solve(bool buildCoarseStiffness) {
   _gmgOperator.setStiffnessDiagonal(diagA_ptr);
   
   _gmgOperator.setApplySmoothingOperator(_applySmoothing);
-  _gmgOperator.setFineSolverUsesDiagonalScaling(_diagonalScaling);
+  // only when Aztec does the scaling does the operator need to map its input and output back to the unscaled system
+  _gmgOperator.setFineSolverUsesDiagonalScaling(_diagonalScaling && useAztecToScaleDiagonally);
   
-  if (buildCoarseStiffness) _gmgOperator.computeCoarseStiffnessMatrix(A);
+  if (buildCoarseStiffness) _gmgOperator.computeCoarseStiffnessMatrix(Teuchos::rcp(A, false)); // A belongs to the linear problem
   
   if (_diagonalScaling && useAztecToScaleDiagonally) {
     solver.SetAztecOption(AZ_scaling, AZ_sym_diag);
@@ -0,0 +1,409 @@
+//
+//  MatrixFreeOperator.cpp
+//  Camellia
+//
+//
+
+#include "MatrixFreeOperator.h"
+
+#include "BasisCache.h"
+#include "BC.h"
+#include "CellBatches.h"
+#include "CondensedDofInterpreter.h"
+#include "GlobalDofAssignment.h"
+#include "LagrangeConstraints.h"
+#include "Mesh.h"
+
+#include "Teuchos_GlobalMPISession.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+MatrixFreeOperator::MatrixFreeOperator(SolutionPtr solution, bool storeLocalStiffness) : _partitionMap(solution->getPartitionMap()) {
+  _solution = solution;
+  _mesh = solution->mesh();
+  _dofInterpreter = solution->getDofInterpreter();
+  _storeLocalStiffness = storeLocalStiffness;
+
+  bool isCondensed = (dynamic_cast<CondensedDofInterpreter*>(_dofInterpreter.get()) != NULL);
+  TEUCHOS_TEST_FOR_EXCEPTION(isCondensed, std::invalid_argument, "MatrixFreeOperator does not support static condensation");
+  TEUCHOS_TEST_FOR_EXCEPTION(solution->lagrangeConstraints()->numElementConstraints() > 0, std::invalid_argument,
+                             "MatrixFreeOperator does not support Lagrange constraints");
+  TEUCHOS_TEST_FOR_EXCEPTION(solution->getZeroMeanConstraints().size() > 0, std::invalid_argument,
+                             "MatrixFreeOperator does not support zero-mean constraints");
+
+  int rank = Teuchos::GlobalMPISession::getRank();
+
+  // overlapping map for the dofs seen by the rank-local cells, as in Solution::importSolution()
+  set<GlobalIndexType> cellDofs;
+  set<GlobalIndexType> myCellIDs = _mesh->globalDofAssignment()->cellsInPartition(-1);
+  for (set<GlobalIndexType>::iterator cellIDIt = myCellIDs.begin(); cellIDIt != myCellIDs.end(); cellIDIt++) {
+    set<GlobalIndexType> globalDofsForCell = _dofInterpreter->globalDofIndicesForCell(*cellIDIt);
+    cellDofs.insert(globalDofsForCell.begin(), globalDofsForCell.end());
+  }
+  vector<GlobalIndexTypeToCast> cellDofsVector(cellDofs.begin(), cellDofs.end());
+  GlobalIndexTypeToCast* cellDofsPtr = (cellDofsVector.size() > 0) ? &cellDofsVector[0] : NULL;
+  _cellDofsMap = Teuchos::rcp( new Epetra_Map(-1, cellDofsVector.size(), cellDofsPtr, 0, _partitionMap.Comm()) );
+  _cellDofsImporter = Teuchos::rcp( new Epetra_Import(*_cellDofsMap, _partitionMap) );
+
+  // BCs, as in Solution::imposeBCs()
+  set<GlobalIndexType> myGlobalIndicesSet = _dofInterpreter->globalDofIndicesForPartition(rank);
+  FieldContainer<GlobalIndexType> bcGlobalIndices;
+  FieldContainer<double> bcGlobalValues;
+  _mesh->boundary().bcsToImpose(bcGlobalIndices,bcGlobalValues,*(solution->bc().get()), myGlobalIndicesSet, _dofInterpreter.get(), &_partitionMap);
+  for (int i=0; i<bcGlobalIndices.size(); i++) {
+    _bcGlobalIndices.push_back(bcGlobalIndices[i]);
+    _bcGlobalValues.push_back(bcGlobalValues[i]);
+  }
+
+  // local stiffness and load: the load is always assembled; the stiffness is kept only if requested
+  map< ElementType*, FieldContainer<double> > localLoadForType;
+  _elementTypes = _mesh->elementTypes(rank);
+  for (vector< ElementTypePtr >::iterator elemTypeIt = _elementTypes.begin(); elemTypeIt != _elementTypes.end(); elemTypeIt++) {
+    ElementTypePtr elemType = *elemTypeIt;
+    CellBatches batches = cellBatches(elemType);
+    _cellIDsForType[elemType.get()] = batches.cellIDs();
+
+    int numCells = batches.numCells();
+    int numTrialDofs = elemType->trialOrderPtr->totalDofs();
+    FieldContainer<double>* localLoad = &localLoadForType[elemType.get()];
+    localLoad->resize(numCells, numTrialDofs);
+    if (_storeLocalStiffness) {
+      _localStiffnessForType[elemType.get()].resize(numCells, numTrialDofs * (numTrialDofs + 1) / 2);
+    }
+    if (numCells == 0) continue;
+
+    int cubatureEnrichment = _solution->cubatureEnrichmentDegree();
+    BasisCachePtr basisCache = Teuchos::rcp(new BasisCache(elemType, _mesh, false, cubatureEnrichment));
+    BasisCachePtr ipBasisCache = Teuchos::rcp(new BasisCache(elemType, _mesh, true, cubatureEnrichment));
+    for (int batchOrdinal=0; batchOrdinal<batches.numBatches(); batchOrdinal++) {
+      FieldContainer<double> batchStiffness, batchLoad;
+      computeBatchStiffnessAndLoad(elemType, batches, batchOrdinal, basisCache, ipBasisCache, batchStiffness, batchLoad);
+      int batchStart = batches.batchStart(batchOrdinal);
+      std::copy(&batchLoad[0], &batchLoad[0] + batchLoad.size(), &(*localLoad)(batchStart,0));
+      if (_storeLocalStiffness) {
+        storeBatchStiffness(elemType, batchStart, batchStiffness);
+      }
+    }
+  }
+
+  initializeRHS(localLoadForType);
+}
+
+CellBatches MatrixFreeOperator::cellBatches(ElementTypePtr elemType) const {
+  // batch memory as in Solution::populateStiffnessAndLoad()
+  int numTrialDofs = elemType->trialOrderPtr->totalDofs();
+  int numTestDofs = elemType->testOrderPtr->totalDofs();
+  return CellBatches(_mesh, elemType, numTestDofs*numTestDofs + numTestDofs*numTrialDofs + numTrialDofs*numTrialDofs);
+}
+
+void MatrixFreeOperator::computeBatchStiffnessAndLoad(ElementTypePtr elemType, const CellBatches &cellBatches, int batchOrdinal,
+                                                      BasisCachePtr basisCache, BasisCachePtr ipBasisCache,
+                                                      FieldContainer<double> &batchStiffness, FieldContainer<double> &batchLoad) const {
+  int numCells = cellBatches.batchSize(batchOrdinal);
+  int numTrialDofs = elemType->trialOrderPtr->totalDofs();
+
+  bool createSideCacheToo = true;
+  cellBatches.setBasisCache(batchOrdinal, basisCache, createSideCacheToo);
+  cellBatches.setBasisCache(batchOrdinal, ipBasisCache, true);
+
+  batchStiffness.resize(numCells, numTrialDofs, numTrialDofs);
+  batchLoad.resize(numCells, numTrialDofs);
+  _mesh->bilinearForm()->localStiffnessMatrixAndRHS(batchStiffness, batchLoad, _solution->ip(), ipBasisCache, _solution->rhs(), basisCache);
+
+  if (_solution->filter().get()) {
+    _solution->filter()->filter(batchStiffness, batchLoad, basisCache, _mesh, _solution->bc());
+  }
+}
+
+void MatrixFreeOperator::storeBatchStiffness(ElementTypePtr elemType, int cellOffset, const FieldContainer<double> &batchStiffness) {
+  FieldContainer<double>* localStiffness = &_localStiffnessForType[elemType.get()];
+  int numCells = batchStiffness.dimension(0);
+  int numTrialDofs = batchStiffness.dimension(1);
+  double symmetryTol = 1e-10;
+  for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+    double maxEntry = 0.0, maxAsymmetry = 0.0;
+    double* packedStiffness = &(*localStiffness)(cellOffset + cellOrdinal,0);
+    for (int i=0; i<numTrialDofs; i++) {
+      for (int j=i; j<numTrialDofs; j++) {
+        double a_ij = batchStiffness(cellOrdinal,i,j), a_ji = batchStiffness(cellOrdinal,j,i);
+        maxEntry = max(maxEntry, abs(a_ij));
+        maxAsymmetry = max(maxAsymmetry, abs(a_ij - a_ji));
+        *packedStiffness++ = 0.5 * (a_ij + a_ji);
+      }
+    }
+    TEUCHOS_TEST_FOR_EXCEPTION(maxAsymmetry > symmetryTol * maxEntry, std::invalid_argument,
+                               "Stored local stiffness matrices must be symmetric; construct MatrixFreeOperator with storeLocalStiffness = false");
+  }
+}
+
+void MatrixFreeOperator::getStoredCellStiffness(ElementTypePtr elemType, int cellOrdinal, FieldContainer<double> &cellStiffness) const {
+  const FieldContainer<double>* localStiffness = &_localStiffnessForType.find(elemType.get())->second;
+  int numTrialDofs = elemType->trialOrderPtr->totalDofs();
+  cellStiffness.resize(numTrialDofs, numTrialDofs);
+  const double* packedStiffness = &(*localStiffness)(cellOrdinal,0);
+  for (int i=0; i<numTrialDofs; i++) {
+    for (int j=i; j<numTrialDofs; j++) {
+      cellStiffness(i,j) = *packedStiffness;
+      cellStiffness(j,i) = *packedStiffness;
+      packedStiffness++;
+    }
+  }
+}
+
+void MatrixFreeOperator::initializeRHS(const map< ElementType*, FieldContainer<double> > &localLoadForType) {
+  _rhsVector = Teuchos::rcp( new Epetra_FEVector(_partitionMap) );
+
+  FieldContainer<double> interpretedLoad;
+  FieldContainer<GlobalIndexType> globalDofIndices;
+  vector<GlobalIndexTypeToCast> globalDofIndicesCast;
+  for (vector< ElementTypePtr >::iterator elemTypeIt = _elementTypes.begin(); elemTypeIt != _elementTypes.end(); elemTypeIt++) {
+    ElementType* elemType = elemTypeIt->get();
+    const vector<GlobalIndexType>* cellIDs = &_cellIDsForType[elemType];
+    const FieldContainer<double>* localLoad = &localLoadForType.find(elemType)->second;
+    int numTrialDofs = elemType->trialOrderPtr->totalDofs();
+    Teuchos::Array<int> localLoadDim(1,numTrialDofs);
+    for (int cellOrdinal=0; cellOrdinal<cellIDs->size(); cellOrdinal++) {
+      FieldContainer<double> cellLoad(localLoadDim, const_cast<double*>(&(*localLoad)(cellOrdinal,0))); // shallow copy
+      _dofInterpreter->interpretLocalData((*cellIDs)[cellOrdinal], cellLoad, interpretedLoad, globalDofIndices);
+      globalDofIndicesCast.resize(globalDofIndices.size());
+      for (int dofOrdinal=0; dofOrdinal<globalDofIndices.size(); dofOrdinal++) {
+        globalDofIndicesCast[dofOrdinal] = globalDofIndices[dofOrdinal];
+      }
+      if (globalDofIndices.size() > 0) {
+        _rhsVector->SumIntoGlobalValues(globalDofIndices.size(), &globalDofIndicesCast[0], &interpretedLoad[0]);
+      }
+    }
+  }
+  _rhsVector->GlobalAssemble();
+
+  // lift the Dirichlet data, as in Solution::imposeBCs()
+  Epetra_MultiVector v(_partitionMap,1);
+  imposeBCValues(v);
+  Epetra_MultiVector rhsDirichlet(_partitionMap,1);
+  applyWithoutBCs(v, rhsDirichlet);
+  _rhsVector->Update(-1.0,rhsDirichlet,1.0);
+  imposeBCValues(*_rhsVector);
+}
+
+void MatrixFreeOperator::applyWithoutBCs(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const {
+  int numVectors = X.NumVectors();
+
+  // gather: import the coefficients seen by rank-local cells
+  Epetra_MultiVector X_cells(*_cellDofsMap, numVectors);
+  X_cells.Import(X, *_cellDofsImporter, Insert);
+
+  Epetra_FEVector Y_fe(_partitionMap, numVectors);
+
+  FieldContainer<double> localX, localY, interpretedY;
+  FieldContainer<GlobalIndexType> globalDofIndices;
+  vector<GlobalIndexTypeToCast> globalDofIndicesCast;
+  for (vector< ElementTypePtr >::const_iterator elemTypeIt = _elementTypes.begin(); elemTypeIt != _elementTypes.end(); elemTypeIt++) {
+    ElementTypePtr elemType = *elemTypeIt;
+    const vector<GlobalIndexType>* cellIDs = &_cellIDsForType.find(elemType.get())->second;
+    if (cellIDs->size() == 0) continue;
+    int numTrialDofs = elemType->trialOrderPtr->totalDofs();
+
+    const FieldContainer<double>* storedStiffness = NULL;
+    BasisCachePtr basisCache, ipBasisCache;
+    if (_storeLocalStiffness) {
+      storedStiffness = &_localStiffnessForType.find(elemType.get())->second;
+    } else {
+      int cubatureEnrichment = _solution->cubatureEnrichmentDegree();
+      basisCache = Teuchos::rcp(new BasisCache(elemType, _mesh, false, cubatureEnrichment));
+      ipBasisCache = Teuchos::rcp(new BasisCache(elemType, _mesh, true, cubatureEnrichment));
+    }
+
+    CellBatches batches = cellBatches(elemType);
+    localY.resize(numTrialDofs);
+    for (int batchOrdinal=0; batchOrdinal<batches.numBatches(); batchOrdinal++) {
+      FieldContainer<double> batchStiffness, batchLoad;
+      if (!_storeLocalStiffness) {
+        computeBatchStiffnessAndLoad(elemType, batches, batchOrdinal, basisCache, ipBasisCache, batchStiffness, batchLoad);
+      }
+      int batchStart = batches.batchStart(batchOrdinal);
+      for (int batchCellOrdinal=0; batchCellOrdinal<batches.batchSize(batchOrdinal); batchCellOrdinal++) {
+        int cellOrdinal = batchStart + batchCellOrdinal;
+        GlobalIndexType cellID = (*cellIDs)[cellOrdinal];
+        for (int vectorOrdinal=0; vectorOrdinal<numVectors; vectorOrdinal++) {
+          Epetra_MultiVector X_cells_vector(View, X_cells, vectorOrdinal, 1);
+          _dofInterpreter->interpretGlobalCoefficients(cellID, localX, X_cells_vector);
+
+          // multiply by the local stiffness
+          if (_storeLocalStiffness) {
+            // packed upper triangle: each off-diagonal entry contributes to two rows
+            const double* packedStiffness = &(*storedStiffness)(cellOrdinal,0);
+            for (int i=0; i<numTrialDofs; i++) {
+              localY[i] = 0;
+            }
+            for (int i=0; i<numTrialDofs; i++) {
+              double value = (*packedStiffness++) * localX[i];
+              for (int j=i+1; j<numTrialDofs; j++) {
+                double a_ij = *packedStiffness++;
+                value += a_ij * localX[j];
+                localY[j] += a_ij * localX[i];
+              }
+              localY[i] += value;
+            }
+          } else {
+            for (int i=0; i<numTrialDofs; i++) {
+              const double* stiffnessRow = &batchStiffness(batchCellOrdinal,i,0);
+              double value = 0;
+              for (int j=0; j<numTrialDofs; j++) {
+                value += stiffnessRow[j] * localX[j];
+              }
+              localY[i] = value;
+            }
+          }
+
+          // scatter
+          _dofInterpreter->interpretLocalData(cellID, localY, interpretedY, globalDofIndices);
+          globalDofIndicesCast.resize(globalDofIndices.size());
+          for (int dofOrdinal=0; dofOrdinal<globalDofIndices.size(); dofOrdinal++) {
+            globalDofIndicesCast[dofOrdinal] = globalDofIndices[dofOrdinal];
+          }
+          if (globalDofIndices.size() > 0) {
+            Y_fe.SumIntoGlobalValues(globalDofIndices.size(), &globalDofIndicesCast[0], &interpretedY[0], vectorOrdinal);
+          }
+        }
+      }
+    }
+  }
+  Y_fe.GlobalAssemble();
+  Y = Y_fe;
+}
+
+int MatrixFreeOperator::Apply(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const {
+  // BC rows and columns act as the identity: zero the BC entries going in, and copy them through coming out
+  Epetra_MultiVector X_interior(X);
+  for (int i=0; i<_bcGlobalIndices.size(); i++) {
+    int localIndex = _partitionMap.LID(_bcGlobalIndices[i]);
+    for (int vectorOrdinal=0; vectorOrdinal<X.NumVectors(); vectorOrdinal++) {
+      X_interior[vectorOrdinal][localIndex] = 0.0;
+    }
+  }
+  applyWithoutBCs(X_interior, Y);
+  for (int i=0; i<_bcGlobalIndices.size(); i++) {
+    int localIndex = _partitionMap.LID(_bcGlobalIndices[i]);
+    for (int vectorOrdinal=0; vectorOrdinal<X.NumVectors(); vectorOrdinal++) {
+      Y[vectorOrdinal][localIndex] = X[vectorOrdinal][localIndex];
+    }
+  }
+  return 0;
+}
+
+int MatrixFreeOperator::ApplyInverse(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const {
+  return -1; // not supported
+}
+
+Teuchos::RCP<Epetra_MultiVector> MatrixFreeOperator::getDiagonal() const {
+  if (_diag != Teuchos::null) return _diag;
+
+  Epetra_FEVector diag_fe(_partitionMap);
+
+  FieldContainer<double> interpretedStiffness, interpretedLoad;
+  FieldContainer<GlobalIndexType> globalDofIndices;
+  vector<GlobalIndexTypeToCast> globalDofIndicesCast;
+  vector<double> diagonalValues;
+  for (vector< ElementTypePtr >::const_iterator elemTypeIt = _elementTypes.begin(); elemTypeIt != _elementTypes.end(); elemTypeIt++) {
+    ElementTypePtr elemType = *elemTypeIt;
+    const vector<GlobalIndexType>* cellIDs = &_cellIDsForType.find(elemType.get())->second;
+    int numCells = cellIDs->size();
+    if (numCells == 0) continue;
+    int numTrialDofs = elemType->trialOrderPtr->totalDofs();
+
+    BasisCachePtr basisCache, ipBasisCache;
+    if (!_storeLocalStiffness) {
+      int cubatureEnrichment = _solution->cubatureEnrichmentDegree();
+      basisCache = Teuchos::rcp(new BasisCache(elemType, _mesh, false, cubatureEnrichment));
+      ipBasisCache = Teuchos::rcp(new BasisCache(elemType, _mesh, true, cubatureEnrichment));
+    }
+
+    CellBatches batches = cellBatches(elemType);
+    FieldContainer<double> cellStiffness(numTrialDofs,numTrialDofs), cellLoad(numTrialDofs);
+    for (int batchOrdinal=0; batchOrdinal<batches.numBatches(); batchOrdinal++) {
+      FieldContainer<double> batchStiffness, batchLoad;
+      if (!_storeLocalStiffness) {
+        computeBatchStiffnessAndLoad(elemType, batches, batchOrdinal, basisCache, ipBasisCache, batchStiffness, batchLoad);
+      }
+      int batchStart = batches.batchStart(batchOrdinal);
+      for (int batchCellOrdinal=0; batchCellOrdinal<batches.batchSize(batchOrdinal); batchCellOrdinal++) {
+        int cellOrdinal = batchStart + batchCellOrdinal;
+        if (_storeLocalStiffness) {
+          getStoredCellStiffness(elemType, cellOrdinal, cellStiffness);
+        } else {
+          const double* batchCellStiffness = &batchStiffness(batchCellOrdinal,0,0);
+          std::copy(batchCellStiffness, batchCellStiffness + cellStiffness.size(), &cellStiffness[0]);
+        }
+        _dofInterpreter->interpretLocalData((*cellIDs)[cellOrdinal], cellStiffness, cellLoad, interpretedStiffness, interpretedLoad, globalDofIndices);
+        int numGlobalDofs = globalDofIndices.size();
+        globalDofIndicesCast.resize(numGlobalDofs);
+        diagonalValues.resize(numGlobalDofs);
+        for (int dofOrdinal=0; dofOrdinal<numGlobalDofs; dofOrdinal++) {
+          globalDofIndicesCast[dofOrdinal] = globalDofIndices[dofOrdinal];
+          diagonalValues[dofOrdinal] = interpretedStiffness(dofOrdinal,dofOrdinal);
+        }
+        if (numGlobalDofs > 0) {
+          diag_fe.SumIntoGlobalValues(numGlobalDofs, &globalDofIndicesCast[0], &diagonalValues[0]);
+        }
+      }
+    }
+  }
+  diag_fe.GlobalAssemble();
+
+  _diag = Teuchos::rcp( new Epetra_MultiVector(diag_fe) );
+  for (int i=0; i<_bcGlobalIndices.size(); i++) {
+    int localIndex = _partitionMap.LID(_bcGlobalIndices[i]);
+    (*_diag)[0][localIndex] = 1.0;
+  }
+  return _diag;
+}
+
+Teuchos::RCP<Epetra_FEVector> MatrixFreeOperator::getRHSVector() {
+  return _rhsVector;
+}
+
+void MatrixFreeOperator::imposeBCValues(Epetra_MultiVector &vector) const {
+  for (int i=0; i<_bcGlobalIndices.size(); i++) {
+    int localIndex = _partitionMap.LID(_bcGlobalIndices[i]);
+    for (int vectorOrdinal=0; vectorOrdinal<vector.NumVectors(); vectorOrdinal++) {
+      vector[vectorOrdinal][localIndex] = _bcGlobalValues[i];
+    }
+  }
+}
+
+bool MatrixFreeOperator::storesLocalStiffness() const {
+  return _storeLocalStiffness;
+}
+
+double MatrixFreeOperator::NormInf() const {
+  TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "Unsupported method.");
+}
+
+const char * MatrixFreeOperator::Label() const {
+  return "Camellia Matrix-Free DPG Operator";
+}
+
+int MatrixFreeOperator::SetUseTranspose(bool UseTranspose) {
+  return -1; // not supported
+}
+
+bool MatrixFreeOperator::UseTranspose() const {
+  return false;
+}
+
+bool MatrixFreeOperator::HasNormInf() const {
+  return false;
+}
+
+const Epetra_Comm & MatrixFreeOperator::Comm() const {
+  return _partitionMap.Comm();
+}
+
+const Epetra_Map & MatrixFreeOperator::OperatorDomainMap() const {
+  return _partitionMap;
+}
+
+const Epetra_Map & MatrixFreeOperator::OperatorRangeMap() const {
+  return _partitionMap;
+}
@@ -46,6 +46,7 @@
 
 #include "SerialDenseWrapper.h"
 #include "CamelliaDebugUtility.h"
+#include "CellBatches.h"
 #include "GlobalDofAssignment.h"
 
 #include "MPIWrapper.h"
@@ -86,65 +87,149 @@ map<GlobalIndexType,FieldContainer<double> > RieszRep::integrateFunctional() {
   return cellRHS;
 }
 
-void RieszRep::computeRieszRep(int cubatureEnrichment){
-#ifdef HAVE_MPI
-  Epetra_MpiComm Comm(MPI_COMM_WORLD);
-  //cout << "rank: " << rank << " of " << numProcs << endl;
-#else
-  Epetra_SerialComm Comm;
-#endif  
-
-  set<GlobalIndexType> cellIDs = _mesh->cellIDsInPartition();
-  for (set<GlobalIndexType>::iterator cellIDIt=cellIDs.begin(); cellIDIt !=cellIDs.end(); cellIDIt++){
-    GlobalIndexType cellID = *cellIDIt;
+void RieszRep::setCacheGramFactorizations(bool value) {
+  _cacheGramFactorizations = value;
+  if (!value) clearGramFactorizations();
+}
 
-    ElementTypePtr elemTypePtr = _mesh->getElementType(cellID);
-    DofOrderingPtr testOrderingPtr = elemTypePtr->testOrderPtr;
-    int numTestDofs = testOrderingPtr->totalDofs();
+void RieszRep::clearGramFactorizations() {
+  _gramFactorBatches.clear();
+}
 
-    BasisCachePtr basisCache = BasisCache::basisCacheForCell(_mesh,cellID,true,cubatureEnrichment);
+void RieszRep::setMaxCellsPerBatch(int value) {
+  _maxCellsPerBatch = value;
+  clearGramFactorizations(); // the stored batches follow the old batch sizes
+}
 
-    FieldContainer<double> rhsValues(1,numTestDofs);
-    _functional->integrate(rhsValues, testOrderingPtr, basisCache);
-    if (_printAll){
-      cout << "RieszRep: LinearTerm values for cell " << cellID << ":\n " << rhsValues << endl;
-    }
+bool RieszRep::gramFactorizationsMatchMesh(int cubatureEnrichment) {
+  if ((_gramFactorBatches.size() == 0) || (cubatureEnrichment != _gramFactorCubatureEnrichment)) return false;
   
-    FieldContainer<double> ipMatrix(1,numTestDofs,numTestDofs);      
-    _ip->computeInnerProductMatrix(ipMatrix,testOrderingPtr, basisCache);
-
-    bool printOutRiesz = false;
-    if (printOutRiesz){
-      cout << " ============================ In RIESZ ==========================" << endl;
-      cout << "matrix: \n" << ipMatrix;
+  int rank = Teuchos::GlobalMPISession::getRank();
+  vector< ElementTypePtr > elementTypes = _mesh->elementTypes(rank);
+  int batchOrdinal = 0;
+  for (vector< ElementTypePtr >::iterator elemTypeIt = elementTypes.begin(); elemTypeIt != elementTypes.end(); elemTypeIt++) {
+    vector<GlobalIndexType> cellIDs = _mesh->cellIDsOfType(rank, *elemTypeIt);
+    int cellOffset = 0;
+    while (cellOffset < cellIDs.size()) {
+      if (batchOrdinal >= _gramFactorBatches.size()) return false;
+      const GramFactorBatch* batch = &_gramFactorBatches[batchOrdinal++];
+      if (batch->elemType.get() != elemTypeIt->get()) return false;
+      if (cellOffset + batch->cellIDs.size() > cellIDs.size()) return false;
+      if (!std::equal(batch->cellIDs.begin(), batch->cellIDs.end(), cellIDs.begin() + cellOffset)) return false;
+      cellOffset += batch->cellIDs.size();
     }
+  }
+  return batchOrdinal == _gramFactorBatches.size();
+}
+
+void RieszRep::computeRieszRep(int cubatureEnrichment){
+  int rank = Teuchos::GlobalMPISession::getRank();
+  
+  bool reuseFactorizations = _cacheGramFactorizations && gramFactorizationsMatchMesh(cubatureEnrichment);
+  if (!reuseFactorizations) {
+    _gramFactorBatches.clear();
+    _gramFactorCubatureEnrichment = cubatureEnrichment;
+  }
+  
+  // cells are processed in batches by element type; the IP matrices are SPD, so we use Cholesky, falling back on QR
+  // for any cell where that fails.  batchOrdinal counts batches across element types, indexing _gramFactorBatches.
+  int batchOrdinal = 0;
+  vector< ElementTypePtr > elementTypes = _mesh->elementTypes(rank);
+  for (vector< ElementTypePtr >::iterator elemTypeIt = elementTypes.begin(); elemTypeIt != elementTypes.end(); elemTypeIt++) {
+    ElementTypePtr elemTypePtr = *elemTypeIt;
+    DofOrderingPtr testOrderingPtr = elemTypePtr->testOrderPtr;
+    int numTestDofs = testOrderingPtr->totalDofs();
     
-    FieldContainer<double> rieszRepDofs(numTestDofs,1);
-    ipMatrix.resize(numTestDofs,numTestDofs);
-    rhsValues.resize(numTestDofs,1);
-    int success = SerialDenseWrapper::solveSystemUsingQR(rieszRepDofs, ipMatrix, rhsValues);
+    BasisCachePtr basisCache = Teuchos::rcp( new BasisCache(elemTypePtr, _mesh, true, cubatureEnrichment) );
     
-    if (success != 0) {
-      cout << "RieszRep::computeRieszRep: Solve FAILED with error: " << success << endl;
-    }
-
-//    rieszRepDofs.Multiply(true,rhsVectorCopy, normSq); // equivalent to e^T * R_V * e
-    double normSquared = SerialDenseWrapper::dot(rieszRepDofs, rhsValues);
-    _rieszRepNormSquared[cellID] = normSquared;
-
-//    cout << "normSquared for cell " << cellID << ": " << _rieszRepNormSquared[cellID] << endl;
+    CellBatches cellBatches(_mesh, elemTypePtr, 2 * numTestDofs * numTestDofs + 2 * numTestDofs, _maxCellsPerBatch);
     
-    if (printOutRiesz){
-      cout << "rhs: \n" << rhsValues;
-      cout << "dofs: \n" << rieszRepDofs;
-      cout << " ================================================================" << endl;
-    }
-
-    FieldContainer<double> dofs(numTestDofs);
-    for (int i = 0;i<numTestDofs;i++){
-      dofs(i) = rieszRepDofs(i,0);
+    for (int typeBatchOrdinal=0; typeBatchOrdinal<cellBatches.numBatches(); typeBatchOrdinal++) {
+      int numCells = cellBatches.batchSize(typeBatchOrdinal);
+      vector<GlobalIndexType> cellIDs = cellBatches.cellIDs(typeBatchOrdinal);
+      
+      cellBatches.setBasisCache(typeBatchOrdinal, basisCache, true);
+      
+      FieldContainer<double> rhsValues(numCells,numTestDofs);
+      _functional->integrate(rhsValues, testOrderingPtr, basisCache);
+      if (_printAll){
+        for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+          cout << "RieszRep: LinearTerm values for cell " << cellIDs[cellOrdinal] << ":\n ";
+          for (int i=0; i<numTestDofs; i++) {
+            cout << rhsValues(cellOrdinal,i) << " ";
+          }
+          cout << endl;
+        }
+      }
+      
+      GramFactorBatch localBatch;
+      GramFactorBatch* batch;
+      if (reuseFactorizations) {
+        batch = &_gramFactorBatches[batchOrdinal];
+        TEUCHOS_TEST_FOR_EXCEPTION(batch->cellIDs != cellIDs, std::invalid_argument,
+                                   "cached Gram factorizations do not match the cell batches");
+      } else {
+        if (_cacheGramFactorizations) {
+          _gramFactorBatches.push_back(GramFactorBatch());
+          batch = &_gramFactorBatches.back();
+        } else {
+          batch = &localBatch;
+        }
+        batch->elemType = elemTypePtr;
+        batch->cellIDs = cellIDs;
+        
+        FieldContainer<double> ipMatrix(numCells,numTestDofs,numTestDofs);
+        _ip->computeInnerProductMatrix(ipMatrix,testOrderingPtr, basisCache);
+        
+        SerialDenseWrapper::factorSPDSystems(batch->factors, batch->scaling, ipMatrix, batch->failedCellOrdinals);
+        for (int i=0; i<batch->failedCellOrdinals.size(); i++) {
+          int cellOrdinal = batch->failedCellOrdinals[i];
+          FieldContainer<double> cellIPMatrix(numTestDofs,numTestDofs);
+          for (int j=0; j<numTestDofs; j++) {
+            for (int k=0; k<numTestDofs; k++) {
+              cellIPMatrix(j,k) = ipMatrix(cellOrdinal,j,k);
+            }
+          }
+          batch->gramMatricesForFailedCells[cellOrdinal] = cellIPMatrix;
+        }
+      }
+      batchOrdinal++;
+      
+      FieldContainer<double> rieszRepDofs(numCells,1,numTestDofs);
+      rhsValues.resize(numCells,numTestDofs,1);
+      int success = SerialDenseWrapper::solveFactoredSPDSystemsTransposed(rieszRepDofs, batch->factors, batch->scaling,
+                                                                          rhsValues, batch->failedCellOrdinals);
+      if (success != 0) {
+        cout << "RieszRep::computeRieszRep: Solve FAILED with error: " << success << endl;
+      }
+      for (int i=0; i<batch->failedCellOrdinals.size(); i++) {
+        int cellOrdinal = batch->failedCellOrdinals[i];
+        FieldContainer<double> cellRieszRepDofs(numTestDofs,1);
+        FieldContainer<double> cellRHS(numTestDofs,1);
+        for (int j=0; j<numTestDofs; j++) {
+          cellRHS(j,0) = rhsValues(cellOrdinal,j,0);
+        }
+        success = SerialDenseWrapper::solveSystemUsingQR(cellRieszRepDofs, batch->gramMatricesForFailedCells[cellOrdinal], cellRHS);
+        if (success != 0) {
+          cout << "RieszRep::computeRieszRep: Solve FAILED with error: " << success << endl;
+        }
+        for (int j=0; j<numTestDofs; j++) {
+          rieszRepDofs(cellOrdinal,0,j) = cellRieszRepDofs(j,0);
+        }
+      }
+      
+      for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+        GlobalIndexType cellID = cellIDs[cellOrdinal];
+        FieldContainer<double> dofs(numTestDofs);
+        double normSquared = 0.0; // equivalent to e^T * R_V * e
+        for (int i=0; i<numTestDofs; i++) {
+          dofs(i) = rieszRepDofs(cellOrdinal,0,i);
+          normSquared += dofs(i) * rhsValues(cellOrdinal,i,0);
+        }
+        _rieszRepNormSquared[cellID] = normSquared;
+        _rieszRepDofs[cellID] = dofs;
+      }
     }
-    _rieszRepDofs[cellID] = dofs;
   }
   distributeDofs();
   _repsNotComputed = false;
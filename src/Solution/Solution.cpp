@@ -82,6 +82,10 @@
 
 #include <stdlib.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "Solution.h"
 
 // Camellia includes:
@@ -90,15 +94,18 @@
 #include "BasisCache.h"
 #include "BasisSumFunction.h"
 #include "CamelliaCellTools.h"
+#include "CellBatches.h"
 #include "CondensedDofInterpreter.h"
 #include "CubatureFactory.h"
 #include "Function.h"
 #include "IP.h"
 #include "GlobalDofAssignment.h"
 #include "LagrangeConstraints.h"
+#include "MatrixFreeOperator.h"
 #include "Mesh.h"
 #include "MeshFactory.h"
 #include "MPIWrapper.h"
+#include "PhaseTimers.h"
 #include "PreviousSolutionFunction.h"
 #include "Projector.h"
 #include "RHS.h"
@@ -138,8 +145,20 @@ void Solution::setCubatureEnrichmentDegree(int value) {
   _cubatureEnrichmentDegree = value;
 }
 
-static const int MAX_BATCH_SIZE_IN_BYTES = 3*1024*1024; // 3 MB
-static const int MIN_BATCH_SIZE_IN_CELLS = 1; // overrides the above, if it results in too-small batches
+int Solution::numAssemblyThreads() const {
+  return _numAssemblyThreads;
+}
+
+void Solution::setNumAssemblyThreads(int value) {
+  TEUCHOS_TEST_FOR_EXCEPTION(value < 1, std::invalid_argument, "numAssemblyThreads must be at least 1");
+#ifndef _OPENMP
+  if (value > 1) {
+    int rank = Teuchos::GlobalMPISession::getRank();
+    if (rank==0) cout << "Warning: Camellia was built without OpenMP; local stiffness computation will run on a single thread.\n";
+  }
+#endif
+  _numAssemblyThreads = value;
+}
 
 // copy constructor:
 Solution::Solution(const Solution &soln) {
@@ -157,6 +176,14 @@ Solution::Solution(const Solution &soln) {
   _writeMatrixToMatrixMarketFile = false;
   _writeRHSToMatrixMarketFile = false;
   _cubatureEnrichmentDegree = soln.cubatureEnrichmentDegree();
+  _numAssemblyThreads = soln.numAssemblyThreads();
+  _reuseStiffness = false; // the copy does not share soln's stiffness matrix
+  _stiffnessIsReusable = false;
+  _numStoredStiffnessSolves = 0;
+  _stiffnessGraphDofInterpreter = NULL;
+  _stiffnessGraphDofAssignmentVersion = -1;
+  _stiffnessGraphMatrix = NULL;
+  _stiffnessUsesStaticGraph = false;
 }
 
 Solution::Solution(Teuchos::RCP<Mesh> mesh, Teuchos::RCP<BC> bc, Teuchos::RCP<RHS> rhs, IPPtr ip) {
@@ -189,6 +216,14 @@ void Solution::initialize() {
   _reportTimingResults = false;
   _globalSystemConditionEstimate = -1;
   _cubatureEnrichmentDegree = 0;
+  _numAssemblyThreads = 1;
+  _reuseStiffness = false;
+  _stiffnessIsReusable = false;
+  _numStoredStiffnessSolves = 0;
+  _stiffnessGraphDofInterpreter = NULL;
+  _stiffnessGraphDofAssignmentVersion = -1;
+  _stiffnessGraphMatrix = NULL;
+  _stiffnessUsesStaticGraph = false;
 
   _zmcsAsRankOneUpdate = false; // I believe this works, but it's slow!
   _zmcRho = -1; // default value: stabilization parameter for zero-mean constraints
@@ -207,31 +242,41 @@ void Solution::addSolution(Teuchos::RCP<Solution> otherSoln, double weight, bool
   // in case otherSoln has a distinct mesh partitioning, import data for this's cells that is off-rank in otherSoln
   otherSoln->importSolutionForOffRankCells(myCellIDs);
 
-  for (set<GlobalIndexType>::iterator cellIDIt = myCellIDs.begin(); cellIDIt != myCellIDs.end(); cellIDIt++) {
-    GlobalIndexType cellID = *cellIDIt;
+  // when both solutions store exactly this rank's cells in the same layout (the usual case for solutions
+  // on the same mesh), add the coefficient buffers in a single pass
+  bool sameLayout = _solutionForCellIDGlobal.hasSameLayout(otherSoln->solutionForCellIDGlobal(), myCellIDs);
+  if (sameLayout) {
+    _solutionForCellIDGlobal.add(weight, otherSoln->solutionForCellIDGlobal());
+  }
 
-    FieldContainer<double> myCoefficients;
-    if (_solutionForCellIDGlobal.find(cellID) != _solutionForCellIDGlobal.end()) {
-      myCoefficients = _solutionForCellIDGlobal[cellID];
-    } else {
-      myCoefficients.resize(_mesh->getElementType(cellID)->trialOrderPtr->totalDofs());
-    }
+  if (!sameLayout || replaceBoundaryTerms) {
+    for (set<GlobalIndexType>::iterator cellIDIt = myCellIDs.begin(); cellIDIt != myCellIDs.end(); cellIDIt++) {
+      GlobalIndexType cellID = *cellIDIt;
 
-    bool warnAboutOffRank = false;
-    FieldContainer<double> otherCoefficients = otherSoln->allCoefficientsForCellID(cellID, warnAboutOffRank);
+      DofOrderingPtr trialOrder = _mesh->getElementType(cellID)->trialOrderPtr;
+      int numCoefficients = trialOrder->totalDofs();
+      double* myCoefficients = _solutionForCellIDGlobal.coefficientValues(cellID, numCoefficients);
 
-    SerialDenseWrapper::addFCs(myCoefficients, otherCoefficients, weight);
+      bool warnAboutOffRank = false;
+      const FieldContainer<double>* otherCoefficients = &otherSoln->allCoefficientsForCellID(cellID, warnAboutOffRank);
 
-    if (replaceBoundaryTerms) {
-      // then copy the flux/field terms from otherCoefficients, without weighting with weight (used to weight with weight; changed 2/5/15)
-      DofOrderingPtr trialOrder = _mesh->getElementType(cellID)->trialOrderPtr;
-      set<int> traceDofIndices = trialOrder->getTraceDofIndices();
-      for (set<int>::iterator traceDofIndexIt = traceDofIndices.begin(); traceDofIndexIt != traceDofIndices.end(); traceDofIndexIt++) {
-        int traceDofIndex = *traceDofIndexIt;
-        myCoefficients[traceDofIndex] = otherCoefficients[traceDofIndex];
+      if (!sameLayout) {
+        TEUCHOS_TEST_FOR_EXCEPTION(otherCoefficients->size() != numCoefficients, std::invalid_argument,
+                                   "otherSoln's coefficient count for cell does not match this solution's");
+        for (int i=0; i<numCoefficients; i++) {
+          myCoefficients[i] += weight * (*otherCoefficients)[i];
+        }
+      }
+
+      if (replaceBoundaryTerms) {
+        // then copy the flux/field terms from otherCoefficients, without weighting with weight (used to weight with weight; changed 2/5/15)
+        set<int> traceDofIndices = trialOrder->getTraceDofIndices();
+        for (set<int>::iterator traceDofIndexIt = traceDofIndices.begin(); traceDofIndexIt != traceDofIndices.end(); traceDofIndexIt++) {
+          int traceDofIndex = *traceDofIndexIt;
+          myCoefficients[traceDofIndex] = (*otherCoefficients)[traceDofIndex];
+        }
       }
     }
-    _solutionForCellIDGlobal[cellID] = myCoefficients;
   }
 
   setGlobalSolutionFromCellLocalCoefficients();
@@ -337,30 +382,23 @@ void Solution::addSolution(Teuchos::RCP<Solution> otherSoln, double weight, set<
   for (set<GlobalIndexType>::iterator cellIDIt = myCellIDs.begin(); cellIDIt != myCellIDs.end(); cellIDIt++) {
     GlobalIndexType cellID = *cellIDIt;
 
-    FieldContainer<double> myCoefficients;
-    if (_solutionForCellIDGlobal.find(cellID) != _solutionForCellIDGlobal.end()) {
-      myCoefficients = _solutionForCellIDGlobal[cellID];
-    } else {
-      myCoefficients.resize(_mesh->getElementType(cellID)->trialOrderPtr->totalDofs());
-    }
+    DofOrderingPtr trialOrder = _mesh->getElementType(cellID)->trialOrderPtr;
+    double* myCoefficients = _solutionForCellIDGlobal.coefficientValues(cellID, trialOrder->totalDofs());
 
-    FieldContainer<double> otherCoefficients = otherSoln->allCoefficientsForCellID(cellID);
+    const FieldContainer<double>* otherCoefficients = &otherSoln->allCoefficientsForCellID(cellID);
 
-    DofOrderingPtr trialOrder = _mesh->getElementType(cellID)->trialOrderPtr;
     for (set<int>::iterator varIDIt = varsToAdd.begin(); varIDIt != varsToAdd.end(); varIDIt++) {
       int varID = *varIDIt;
       const vector<int>* sidesForVar = &trialOrder->getSidesForVarID(varID);
       for (vector<int>::const_iterator sideIt = sidesForVar->begin(); sideIt != sidesForVar->end(); sideIt++) {
         int sideOrdinal = *sideIt;
-        vector<int> dofIndices = trialOrder->getDofIndices(varID, sideOrdinal);
-        for (vector<int>::iterator dofIndexIt = dofIndices.begin(); dofIndexIt != dofIndices.end(); dofIndexIt++) {
+        const vector<int>* dofIndices = &trialOrder->getDofIndices(varID, sideOrdinal);
+        for (vector<int>::const_iterator dofIndexIt = dofIndices->begin(); dofIndexIt != dofIndices->end(); dofIndexIt++) {
           int dofIndex = *dofIndexIt;
-          myCoefficients[dofIndex] += weight * otherCoefficients[dofIndex];
+          myCoefficients[dofIndex] += weight * (*otherCoefficients)[dofIndex];
         }
       }
     }
-
-    _solutionForCellIDGlobal[cellID] = myCoefficients;
   }
 
   setGlobalSolutionFromCellLocalCoefficients();
@@ -390,7 +428,7 @@ void Solution::addSolution(Teuchos::RCP<Solution> otherSoln, double weight, set<
 }
 
 bool Solution::cellHasCoefficientsAssigned(GlobalIndexType cellID) {
-  return _solutionForCellIDGlobal.find(cellID) != _solutionForCellIDGlobal.end();
+  return _solutionForCellIDGlobal.hasCoefficients(cellID);
 }
 
 int Solution::solve() {
@@ -403,21 +441,31 @@ int Solution::solve() {
 
 int Solution::solve(bool useMumps) {
   Teuchos::RCP<Solver> solver;
+  bool saveFactorization = _reuseStiffness; // so that load-only solves can reuse it
 #ifdef HAVE_AMESOS_MUMPS
   if (useMumps) {
-    solver = Teuchos::rcp(new MumpsSolver());
+    int maxMemoryPerCoreMB = 512;
+    solver = Teuchos::rcp(new MumpsSolver(maxMemoryPerCoreMB, saveFactorization));
   } else {
-    solver = Teuchos::rcp(new KluSolver());
+    solver = Teuchos::rcp(new KluSolver(saveFactorization));
   }
 #else
-  solver = Teuchos::rcp(new KluSolver());
+  solver = Teuchos::rcp(new KluSolver(saveFactorization));
 #endif
   return solve(solver);
 }
 
 void Solution::setSolution(Teuchos::RCP<Solution> otherSoln) {
   _solutionForCellIDGlobal = otherSoln->solutionForCellIDGlobal();
-  _lhsVector = Teuchos::rcp( new Epetra_FEVector(*otherSoln->getLHSVector()) );
+  Teuchos::RCP<Epetra_FEVector> otherLHSVector = otherSoln->getLHSVector();
+  if ((_lhsVector.get() != NULL) && (otherLHSVector.get() != NULL) && _lhsVector->Map().SameAs(otherLHSVector->Map())
+      && (_lhsVector->NumVectors() == otherLHSVector->NumVectors())) {
+    // copy in place: a stored solver's linear problem points to _lhsVector
+    _lhsVector->Update(1.0, *otherLHSVector, 0.0);
+  } else {
+    _lhsVector = Teuchos::rcp( new Epetra_FEVector(*otherLHSVector) );
+    clearReusableStiffness();
+  }
   clearComputedResiduals();
 }
 
@@ -426,20 +474,97 @@ void Solution::initializeLHSVector() {
   Epetra_Map partMap = getPartitionMap();
   _lhsVector = Teuchos::rcp(new Epetra_FEVector(partMap,1,true));
 
+  // the mesh calls this after refinement and repartitioning (via GlobalDofAssignment::repartitionAndMigrate()),
+  // so this is where we repack the cell coefficients, and where any stored stiffness becomes invalid
+  _solutionForCellIDGlobal.compact();
+  clearReusableStiffness();
+
   setGlobalSolutionFromCellLocalCoefficients();
   clearComputedResiduals();
 }
 
+bool Solution::stiffnessGraphApplies() {
+  // the graph covers cell couplings only; the rows and columns added for Lagrange and zero-mean constraints aren't in it
+  return (_lagrangeConstraints->numElementConstraints() == 0) && (_lagrangeConstraints->numGlobalConstraints() == 0)
+         && (getZeroMeanConstraints().size() == 0);
+}
+
+Teuchos::RCP<Epetra_FECrsGraph> Solution::buildStiffnessGraph(const Epetra_Map &partMap) {
+  // each rank-local cell couples all of its global dofs; off-rank rows are communicated by GlobalAssemble()
+  int maxRowSize = _mesh->rowSizeUpperBound(); // only for the temporary, unoptimized storage
+  Teuchos::RCP<Epetra_FECrsGraph> graph = Teuchos::rcp( new Epetra_FECrsGraph(::Copy, partMap, maxRowSize) );
+
+  vector<GlobalIndexTypeToCast> cellDofs;
+  const set<GlobalIndexType>* myCellIDs = &_mesh->globalDofAssignment()->cellsInPartition(-1);
+  for (set<GlobalIndexType>::const_iterator cellIDIt = myCellIDs->begin(); cellIDIt != myCellIDs->end(); cellIDIt++) {
+    set<GlobalIndexType> globalDofsForCell = _dofInterpreter->globalDofIndicesForCell(*cellIDIt);
+    if (globalDofsForCell.size() == 0) continue;
+    cellDofs.assign(globalDofsForCell.begin(), globalDofsForCell.end());
+    graph->InsertGlobalIndices(cellDofs.size(), &cellDofs[0], cellDofs.size(), &cellDofs[0]);
+  }
+  graph->GlobalAssemble();
+  graph->OptimizeStorage(); // exact allocation for each row
+
+  _stiffnessGraphDofInterpreter = _dofInterpreter.get();
+  _stiffnessGraphDofAssignmentVersion = _mesh->globalDofAssignment()->dofAssignmentVersion();
+  return graph;
+}
+
 void Solution::initializeStiffnessAndLoad() {
+  // a stored solver refers to the matrix and vectors replaced here
+  clearReusableStiffness();
+
   Epetra_Map partMap = getPartitionMap();
 
-  int maxRowSize = _mesh->rowSizeUpperBound();
+  _stiffnessUsesStaticGraph = stiffnessGraphApplies();
+  if (_stiffnessUsesStaticGraph) {
+    bool graphIsCurrent = (_stiffnessGraph.get() != NULL) && (_stiffnessGraphDofInterpreter == _dofInterpreter.get())
+                          && (_stiffnessGraphDofAssignmentVersion == _mesh->globalDofAssignment()->dofAssignmentVersion());
+    if (graphIsCurrent && (_globalStiffMatrix.get() != NULL) && (_globalStiffMatrix.get() == _stiffnessGraphMatrix)
+        && (_globalStiffMatrix.strong_count() == 1)) {
+      // no one else holds the matrix, so we can zero it rather than reallocating
+      _globalStiffMatrix->PutScalar(0.0);
+    } else {
+      if (!graphIsCurrent) {
+        _stiffnessGraph = buildStiffnessGraph(partMap);
+      }
+      _globalStiffMatrix = Teuchos::rcp(new Epetra_FECrsMatrix(::Copy, *_stiffnessGraph));
+      _stiffnessGraphMatrix = _globalStiffMatrix.get();
+    }
+  } else {
+    int maxRowSize = _mesh->rowSizeUpperBound();
 
-  _globalStiffMatrix = Teuchos::rcp(new Epetra_FECrsMatrix(::Copy, partMap, maxRowSize));
+    _globalStiffMatrix = Teuchos::rcp(new Epetra_FECrsMatrix(::Copy, partMap, maxRowSize));
+  }
   _rhsVector = Teuchos::rcp(new Epetra_FEVector(partMap));
 }
 
+void Solution::interpretLocalDataForBatch(const vector<GlobalIndexType> &cellIDs, FieldContainer<double> &localStiffness,
+                                          FieldContainer<double> &localRHS, vector< FieldContainer<double> > &interpretedStiffness,
+                                          vector< FieldContainer<double> > &interpretedRHS,
+                                          vector< FieldContainer<GlobalIndexType> > &globalDofIndices) {
+  CondensedDofInterpreter* condensedDofInterpreter = dynamic_cast<CondensedDofInterpreter*>(_dofInterpreter.get());
+  int numTrialDofs = localStiffness.dimension(1);
+  Teuchos::Array<int> localStiffnessDim(2,numTrialDofs);
+  Teuchos::Array<int> localRHSDim(1,numTrialDofs);
+  for (int cellIndex=0; cellIndex<cellIDs.size(); cellIndex++) {
+    GlobalIndexType cellID = cellIDs[cellIndex];
+    FieldContainer<double> cellStiffness(localStiffnessDim,&localStiffness(cellIndex,0,0)); // shallow copy
+    FieldContainer<double> cellRHS(localRHSDim,&localRHS(cellIndex,0)); // shallow copy
+
+    if (condensedDofInterpreter != NULL) {
+      condensedDofInterpreter->interpretCondensedLocalData(cellID, cellStiffness, cellRHS, interpretedStiffness[cellIndex],
+                                                           interpretedRHS[cellIndex], globalDofIndices[cellIndex]);
+    } else {
+      _dofInterpreter->interpretLocalData(cellID, cellStiffness, cellRHS, interpretedStiffness[cellIndex],
+                                          interpretedRHS[cellIndex], globalDofIndices[cellIndex]);
+    }
+  }
+}
+
 void Solution::populateStiffnessAndLoad() {
+  ScopedPhaseTimer phaseTimer("assembly");
+
   int numProcs=Teuchos::GlobalMPISession::getNProc();;
   int rank = Teuchos::GlobalMPISession::getRank();
 
@@ -464,181 +589,179 @@ void Solution::populateStiffnessAndLoad() {
   vector< ElementTypePtr >::iterator elemTypeIt;
 
   //cout << "process " << rank << " about to loop over elementTypes.\n";
-  int indexBase = 0;
-  Epetra_Map timeMap(numProcs,indexBase,Comm);
   Epetra_Time timer(Comm);
-  Epetra_Time subTimer(Comm);
 
-  double testMatrixAssemblyTime = 0, testMatrixInversionTime = 0, localStiffnessDeterminationFromTestsTime = 0;
-  double localStiffnessInterpretationTime = 0, rhsIntegrationAgainstOptimalTestsTime = 0, filterApplicationTime = 0;
+  int numThreads = 1;
+#ifdef _OPENMP
+  numThreads = max(_numAssemblyThreads, 1);
+#endif
+
+  // for condensed solves, the static condensation runs in the threaded part of the loop below, batched with the local stiffness
+  CondensedDofInterpreter* condensedDofInterpreter = dynamic_cast<CondensedDofInterpreter*>(_dofInterpreter.get());
+  // filters must be applied before condensation; they run inside the critical section, so condensation moves there too
+  bool condenseConcurrently = (condensedDofInterpreter != NULL) && (_filter.get() == NULL);
+
+  // for load-only reassembly, keep the optimal test weights
+  // (populateLoad() refills only element loads and BC rows, so problems with Lagrange or zero-mean constraints,
+  // whose RHS rows are filled below, always assemble in full)
+  bool storeForReuse = _reuseStiffness && (condensedDofInterpreter == NULL) && (_filter.get() == NULL)
+                       && (_lagrangeConstraints->numElementConstraints() == 0)
+                       && (_lagrangeConstraints->numGlobalConstraints() == 0) && (getZeroMeanConstraints().size() == 0);
+  _optimalTestWeightsForCell.clear();
+  _localStiffnessTimeForCell.clear();
+  // stiffness cache hits would make cells look nearly free to the measured cost model, so we don't measure then
+  bool measureLocalStiffness = !_mesh->bilinearForm()->useStiffnessCache();
+
+  // dof interpretation leaves the critical section when the dof interpreter supports concurrent calls
+  // (the condensed interpreter stores per-cell data as it interprets, so it does not)
+  bool interpretConcurrently = false;
+  if ((numThreads > 1) && (condensedDofInterpreter == NULL)) {
+    interpretConcurrently = _dofInterpreter->prepareForConcurrentInterpretation(_mesh->cellIDsInPartition());
+  }
 
   //  cout << "Computing local matrices" << endl;
   for (elemTypeIt = elementTypes.begin(); elemTypeIt != elementTypes.end(); elemTypeIt++) {
     //cout << "Solution: elementType loop, iteration: " << elemTypeNumber++ << endl;
     ElementTypePtr elemTypePtr = *(elemTypeIt);
-    BasisCachePtr basisCache = Teuchos::rcp(new BasisCache(elemTypePtr, _mesh, false, _cubatureEnrichmentDegree));
-    BasisCachePtr ipBasisCache = Teuchos::rcp(new BasisCache(elemTypePtr,_mesh,true, _cubatureEnrichmentDegree));
+
+    // each worker thread gets its own BasisCache pair; we construct these outside the parallel region
+    vector<BasisCachePtr> basisCacheForThread(numThreads), ipBasisCacheForThread(numThreads);
+    for (int threadOrdinal=0; threadOrdinal<numThreads; threadOrdinal++) {
+      basisCacheForThread[threadOrdinal] = Teuchos::rcp(new BasisCache(elemTypePtr, _mesh, false, _cubatureEnrichmentDegree));
+      ipBasisCacheForThread[threadOrdinal] = Teuchos::rcp(new BasisCache(elemTypePtr,_mesh,true, _cubatureEnrichmentDegree));
+    }
 
     DofOrderingPtr trialOrderingPtr = elemTypePtr->trialOrderPtr;
     DofOrderingPtr testOrderingPtr = elemTypePtr->testOrderPtr;
     int numTrialDofs = trialOrderingPtr->totalDofs();
     int numTestDofs = testOrderingPtr->totalDofs();
-    int maxCellBatch = MAX_BATCH_SIZE_IN_BYTES / 8 / (numTestDofs*numTestDofs + numTestDofs*numTrialDofs + numTrialDofs*numTrialDofs);
-    maxCellBatch = max( maxCellBatch, MIN_BATCH_SIZE_IN_CELLS );
-    //cout << "numTestDofs^2:" << numTestDofs*numTestDofs << endl;
-    //cout << "maxCellBatch: " << maxCellBatch << endl;
-
-    FieldContainer<double> myPhysicalCellNodesForType = _mesh->physicalCellNodes(elemTypePtr);
-    FieldContainer<double> myCellSideParitiesForType = _mesh->cellSideParities(elemTypePtr);
-    int totalCellsForType = myPhysicalCellNodesForType.dimension(0);
-    int startCellIndexForBatch = 0;
-    Teuchos::Array<int> nodeDimensions, parityDimensions;
-    myPhysicalCellNodesForType.dimensions(nodeDimensions);
-    myCellSideParitiesForType.dimensions(parityDimensions);
-    while (startCellIndexForBatch < totalCellsForType) {
-      int cellsLeft = totalCellsForType - startCellIndexForBatch;
-      int numCells = min(maxCellBatch,cellsLeft);
-
-      // determine cellIDs
-      vector<GlobalIndexType> cellIDs;
-      for (int cellIndex=0; cellIndex<numCells; cellIndex++) {
-        GlobalIndexType cellID = _mesh->cellID(elemTypePtr, cellIndex+startCellIndexForBatch, rank);
-        cellIDs.push_back(cellID);
-      }
-
-      //cout << "testDofOrdering: " << *testOrderingPtr;
-      //cout << "trialDofOrdering: " << *trialOrderingPtr;
-      nodeDimensions[0] = numCells;
-      parityDimensions[0] = numCells;
-      FieldContainer<double> physicalCellNodes(nodeDimensions,&myPhysicalCellNodesForType(startCellIndexForBatch,0,0));
-      FieldContainer<double> cellSideParities(parityDimensions,&myCellSideParitiesForType(startCellIndexForBatch,0));
-
-      bool createSideCacheToo = true;
-      basisCache->setPhysicalCellNodes(physicalCellNodes,cellIDs,createSideCacheToo);
-      basisCache->setCellSideParities(cellSideParities);
+    CellBatches cellBatches(_mesh, elemTypePtr, numTestDofs*numTestDofs + numTestDofs*numTrialDofs + numTrialDofs*numTrialDofs);
+    int numBatches = cellBatches.numBatches();
+
+    // Batches are distributed across threads; computation of the local stiffness matrices proceeds concurrently,
+    // while filtering, interpretation, and insertion into the global matrix happen one batch at a time.
+    // Note that concurrent use requires that the Functions in the BF, IP, and RHS be thread-safe, and that
+    // Trilinos be built with thread-safe Teuchos::RCP reference counting.
+    // (Phase timers ignore calls from within an active parallel region, so with several threads only "element loop" is recorded.)
+    {
+      ScopedPhaseTimer phaseTimer("element loop");
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+#endif
+      for (int batchOrdinal=0; batchOrdinal<numBatches; batchOrdinal++) {
+        int threadOrdinal = 0;
+#ifdef _OPENMP
+        threadOrdinal = omp_get_thread_num();
+#endif
+        BasisCachePtr basisCache = basisCacheForThread[threadOrdinal];
+        BasisCachePtr ipBasisCache = ipBasisCacheForThread[threadOrdinal];
 
-      // hard-coding creating side cache for IP for now, since _ip->hasBoundaryTerms() only recognizes terms explicitly passed in as boundary terms:
-      ipBasisCache->setPhysicalCellNodes(physicalCellNodes,cellIDs,true);//_ip->hasBoundaryTerms()); // create side cache if ip has boundary values
-      ipBasisCache->setCellSideParities(cellSideParities); // I don't anticipate these being needed, though
+        int numCells = cellBatches.batchSize(batchOrdinal);
+        vector<GlobalIndexType> cellIDs = cellBatches.cellIDs(batchOrdinal);
 
-      //int numCells = physicalCellNodes.dimension(0);
-//      CellTopoPtrLegacy cellTopoPtr = elemTypePtr->cellTopoPtr;
-//
-//      //      { // this block is not necessary for the solution.  Here just to produce debugging output
-//      //        FieldContainer<double> preStiffness(numCells,numTestDofs,numTrialDofs );
-//      //
-//      //        BilinearFormUtility::computeStiffnessMatrix(preStiffness, _mesh->bilinearForm(),
-//      //                                                    trialOrderingPtr, testOrderingPtr, *(cellTopoPtr.get()),
-//      //                                                    physicalCellNodes, cellSideParities);
-//      //        FieldContainer<double> preStiffnessTransposed(numCells,numTrialDofs,numTestDofs );
-//      //        BilinearFormUtility::transposeFCMatrices(preStiffnessTransposed,preStiffness);
-//      //
-//      ////        cout << "preStiffness:\n" << preStiffness;
-//      //      }
-//
-//      subTimer.ResetStartTime();
-//
-//      FieldContainer<double> ipMatrix(numCells,numTestDofs,numTestDofs);
-//
-//      _ip->computeInnerProductMatrix(ipMatrix,testOrderingPtr, ipBasisCache);
-//
-//      testMatrixAssemblyTime += subTimer.ElapsedTime();
-//
-//      //      cout << "ipMatrix:\n" << ipMatrix;
-//
-//      subTimer.ResetStartTime();
-//      FieldContainer<double> optTestCoeffs(numCells,numTrialDofs,numTestDofs);
-//
-//      int optSuccess = _mesh->bilinearForm()->optimalTestWeights(optTestCoeffs, ipMatrix, elemTypePtr,
-//                                                                 cellSideParities, basisCache);
-//      testMatrixInversionTime += subTimer.ElapsedTime();
-////      cout << "optTestCoeffs:\n" << optTestCoeffs;
-//
-//      if ( optSuccess != 0 ) {
-//        cout << "**** WARNING: in Solution.solve(), optimal test function computation failed with error code " << optSuccess << ". ****\n";
-//      }
-//
-//      //cout << "optTestCoeffs\n" << optTestCoeffs;
-//
-//      subTimer.ResetStartTime();
-//      FieldContainer<double> finalStiffness(numCells,numTrialDofs,numTrialDofs);
-//
-//      BilinearFormUtility::computeStiffnessMatrix(finalStiffness,ipMatrix,optTestCoeffs);
-//      localStiffnessDeterminationFromTestsTime += subTimer.ElapsedTime();
-////      cout << "finalStiffness:\n" << finalStiffness;
-//
-//      subTimer.ResetStartTime();
-//      FieldContainer<double> localRHSVector(numCells, numTrialDofs);
-//      _rhs->integrateAgainstOptimalTests(localRHSVector, optTestCoeffs, testOrderingPtr, basisCache);
-//      rhsIntegrationAgainstOptimalTestsTime += subTimer.ElapsedTime();
+        Epetra_Time batchTimer(Comm); // measures per-cell cost, for cost-weighted partitioning
 
-      FieldContainer<double> localStiffness(numCells,numTrialDofs,numTrialDofs);
-      FieldContainer<double> localRHSVector(numCells,numTrialDofs);
+        bool createSideCacheToo = true;
+        cellBatches.setBasisCache(batchOrdinal, basisCache, createSideCacheToo);
 
-      _mesh->bilinearForm()->localStiffnessMatrixAndRHS(localStiffness, localRHSVector, _ip, ipBasisCache, _rhs, basisCache);
+        // hard-coding creating side cache for IP for now, since _ip->hasBoundaryTerms() only recognizes terms explicitly passed in as boundary terms:
+        cellBatches.setBasisCache(batchOrdinal, ipBasisCache, true);
 
-      // apply filter(s) (e.g. penalty method, preconditioners, etc.)
-      if (_filter.get()) {
-        subTimer.ResetStartTime();
-        _filter->filter(localStiffness,localRHSVector,basisCache,_mesh,_bc);
-        filterApplicationTime += subTimer.ElapsedTime();
-        //        _filter->filter(localRHSVector,physicalCellNodes,cellIDs,_mesh,_bc);
-      }
+        FieldContainer<double> localStiffness(numCells,numTrialDofs,numTrialDofs);
+        FieldContainer<double> localRHSVector(numCells,numTrialDofs);
+        FieldContainer<double> optTestCoeffs(numCells,numTrialDofs,numTestDofs);
 
-//      cout << "local stiffness matrices:\n" << localStiffness;
-//      cout << "local loads:\n" << localRHSVector;
+        {
+          ScopedPhaseTimer phaseTimer("local stiffness");
+          _mesh->bilinearForm()->localStiffnessMatrixAndRHS(localStiffness, localRHSVector, optTestCoeffs, _ip, ipBasisCache, _rhs, basisCache);
+        }
 
-      subTimer.ResetStartTime();
+        if (condenseConcurrently) {
+          ScopedPhaseTimer phaseTimer("static condensation");
+          condensedDofInterpreter->condenseLocalData(cellIDs, trialOrderingPtr, localStiffness, localRHSVector);
+        }
+        double batchTime = batchTimer.ElapsedTime();
 
-      FieldContainer<GlobalIndexType> globalDofIndices;
+#ifdef _OPENMP
+#pragma omp critical (Solution_populateStiffnessAndLoad)
+#endif
+        {
+        if (measureLocalStiffness) {
+          for (int cellIndex=0; cellIndex<numCells; cellIndex++) {
+            _localStiffnessTimeForCell[cellIDs[cellIndex]] = batchTime / numCells;
+          }
+        }
 
-      FieldContainer<GlobalIndexTypeToCast> globalDofIndicesCast;
+        // apply filter(s) (e.g. penalty method, preconditioners, etc.)
+        if (_filter.get()) {
+          ScopedPhaseTimer phaseTimer("filter");
+          _filter->filter(localStiffness,localRHSVector,basisCache,_mesh,_bc);
+          //        _filter->filter(localRHSVector,physicalCellNodes,cellIDs,_mesh,_bc);
+        }
 
-      Teuchos::Array<int> localStiffnessDim(2,numTrialDofs);
-      Teuchos::Array<int> localRHSDim(1,numTrialDofs);
+        if ((condensedDofInterpreter != NULL) && !condenseConcurrently) {
+          ScopedPhaseTimer phaseTimer("static condensation");
+          condensedDofInterpreter->condenseLocalData(cellIDs, trialOrderingPtr, localStiffness, localRHSVector);
+        }
 
-      FieldContainer<double> interpretedStiffness;
-      FieldContainer<double> interpretedRHS;
+        if (storeForReuse) {
+          for (int cellIndex=0; cellIndex<numCells; cellIndex++) {
+            FieldContainer<double>* cellWeights = &_optimalTestWeightsForCell[cellIDs[cellIndex]];
+            cellWeights->resize(numTrialDofs,numTestDofs);
+            std::copy(&optTestCoeffs(cellIndex,0,0), &optTestCoeffs(cellIndex,0,0) + cellWeights->size(), &(*cellWeights)[0]);
+          }
+        }
+        } // end critical section
 
-      Teuchos::Array<int> dim;
+//      cout << "local stiffness matrices:\n" << localStiffness;
+//      cout << "local loads:\n" << localRHSVector;
 
-      for (int cellIndex=0; cellIndex<numCells; cellIndex++) {
-        GlobalIndexType cellID = _mesh->cellID(elemTypePtr,cellIndex+startCellIndexForBatch,rank);
-        FieldContainer<double> cellStiffness(localStiffnessDim,&localStiffness(cellIndex,0,0)); // shallow copy
-        FieldContainer<double> cellRHS(localRHSDim,&localRHSVector(cellIndex,0)); // shallow copy
+        vector< FieldContainer<double> > interpretedStiffness(numCells), interpretedRHS(numCells);
+        vector< FieldContainer<GlobalIndexType> > interpretedDofIndices(numCells);
+        if (interpretConcurrently) {
+          ScopedPhaseTimer phaseTimer("dof interpretation");
+          interpretLocalDataForBatch(cellIDs, localStiffness, localRHSVector, interpretedStiffness, interpretedRHS, interpretedDofIndices);
+        }
 
-        _dofInterpreter->interpretLocalData(cellID, cellStiffness, cellRHS, interpretedStiffness, interpretedRHS, globalDofIndices);
+#ifdef _OPENMP
+#pragma omp critical (Solution_populateStiffnessAndLoad)
+#endif
+        {
+        if (!interpretConcurrently) {
+          ScopedPhaseTimer phaseTimer("dof interpretation");
+          interpretLocalDataForBatch(cellIDs, localStiffness, localRHSVector, interpretedStiffness, interpretedRHS, interpretedDofIndices);
+        }
 
-        // cast whatever the global index type is to a type that Epetra supports
-        globalDofIndices.dimensions(dim);
-        globalDofIndicesCast.resize(dim);
+        ScopedPhaseTimer phaseTimer("global insertion");
+        FieldContainer<GlobalIndexTypeToCast> globalDofIndicesCast;
+        for (int cellIndex=0; cellIndex<numCells; cellIndex++) {
+          const FieldContainer<GlobalIndexType>* globalDofIndices = &interpretedDofIndices[cellIndex];
+          int numGlobalDofs = globalDofIndices->size();
+          if (numGlobalDofs == 0) continue;
+
+          // cast whatever the global index type is to a type that Epetra supports
+          globalDofIndicesCast.resize(numGlobalDofs);
+          for (int dofOrdinal = 0; dofOrdinal < numGlobalDofs; dofOrdinal++) {
+            globalDofIndicesCast[dofOrdinal] = (*globalDofIndices)[dofOrdinal];
+          }
 
-        for (int dofOrdinal = 0; dofOrdinal < globalDofIndices.size(); dofOrdinal++) {
-          globalDofIndicesCast[dofOrdinal] = globalDofIndices[dofOrdinal];
+          if (_stiffnessUsesStaticGraph) {
+            globalStiffness->SumIntoGlobalValues(numGlobalDofs,&globalDofIndicesCast(0),
+                                                 numGlobalDofs,&globalDofIndicesCast(0),&interpretedStiffness[cellIndex][0]);
+          } else {
+            globalStiffness->InsertGlobalValues(numGlobalDofs,&globalDofIndicesCast(0),
+                                                numGlobalDofs,&globalDofIndicesCast(0),&interpretedStiffness[cellIndex][0]);
+          }
+          _rhsVector->SumIntoGlobalValues(numGlobalDofs,&globalDofIndicesCast(0),&interpretedRHS[cellIndex][0]);
         }
-
-        globalStiffness->InsertGlobalValues(globalDofIndices.size(),&globalDofIndicesCast(0),
-                                               globalDofIndices.size(),&globalDofIndicesCast(0),&interpretedStiffness[0]);
-        _rhsVector->SumIntoGlobalValues(globalDofIndices.size(),&globalDofIndicesCast(0),&interpretedRHS[0]);
+        } // end critical section
       }
-      localStiffnessInterpretationTime += subTimer.ElapsedTime();
-
-      startCellIndexForBatch += numCells;
     }
   }
-  {
-/*    cout << "testMatrixAssemblyTime: " << testMatrixAssemblyTime << " seconds.\n";
-    cout << "testMatrixInversionTime: " << testMatrixInversionTime << " seconds.\n";
-    cout << "localStiffnessDeterminationFromTestsTime: " << localStiffnessDeterminationFromTestsTime << " seconds.\n";
-    cout << "localStiffnessInterpretationTime: " << localStiffnessInterpretationTime << " seconds.\n";
-    cout << "rhsIntegrationAgainstOptimalTestsTime: " << rhsIntegrationAgainstOptimalTestsTime << " seconds.\n";
-    cout << "filterApplicationTime: " << filterApplicationTime << " seconds.\n";*/
-  }
 
   double timeLocalStiffness = timer.ElapsedTime();
   //  cout << "Done computing local matrices" << endl;
-  Epetra_Vector timeLocalStiffnessVector(timeMap);
-  timeLocalStiffnessVector[0] = timeLocalStiffness;
+  _timeLocalStiffness = PhaseTimers::timeStatistics(timeLocalStiffness);
 
   int localRowIndex = myGlobalIndicesSet.size(); // starts where the dofs left off
 
@@ -815,6 +938,7 @@ void Solution::populateStiffnessAndLoad() {
 
   Comm.Barrier();  // for cleaner time measurements, let everyone else catch up before calling ResetStartTime() and GlobalAssemble()
   timer.ResetStartTime();
+  PhaseTimers::phaseTimers()->start("global assembly");
 
   _rhsVector->GlobalAssemble();
 
@@ -822,9 +946,10 @@ void Solution::populateStiffnessAndLoad() {
 
   globalStiffness->GlobalAssemble(); // will call globalStiffMatrix.FillComplete();
 
+  PhaseTimers::phaseTimers()->stop("global assembly");
+
   double timeGlobalAssembly = timer.ElapsedTime();
-  Epetra_Vector timeGlobalAssemblyVector(timeMap);
-  timeGlobalAssemblyVector[0] = timeGlobalAssembly;
+  _timeGlobalAssembly = PhaseTimers::timeStatistics(timeGlobalAssembly);
 
 //  cout << "debugging: outputting stiffness matrix before BC imposition to /tmp/stiffness_noBCs.dat\n";
 //  EpetraExt::RowMatrixToMatlabFile("/tmp/stiffness_noBCs.dat",*_globalStiffMatrix);
@@ -833,11 +958,11 @@ void Solution::populateStiffnessAndLoad() {
 
   timer.ResetStartTime();
 
+  _stiffnessIsReusable = storeForReuse; // imposeBCs() keeps what it needs to impose BCs on later loads
   imposeBCs();
 
   double timeBCImposition = timer.ElapsedTime();
-  Epetra_Vector timeBCImpositionVector(timeMap);
-  timeBCImpositionVector[0] = timeBCImposition;
+  _timeBCImposition = PhaseTimers::timeStatistics(timeBCImposition);
 
   _rhsVector->GlobalAssemble();
 
@@ -859,22 +984,6 @@ void Solution::populateStiffnessAndLoad() {
   if (_writeMatrixToMatrixMarketFile){
     EpetraExt::RowMatrixToMatrixMarketFile(_matrixFilePath.c_str(),*_globalStiffMatrix,NULL,NULL,false);
   }
-
-  int err = timeLocalStiffnessVector.Norm1( &_totalTimeLocalStiffness );
-  err = timeGlobalAssemblyVector.Norm1( &_totalTimeGlobalAssembly );
-  err = timeBCImpositionVector.Norm1( &_totalTimeBCImposition );
-
-  err = timeLocalStiffnessVector.MeanValue( &_meanTimeLocalStiffness );
-  err = timeGlobalAssemblyVector.MeanValue( &_meanTimeGlobalAssembly );
-  err = timeBCImpositionVector.MeanValue( &_meanTimeBCImposition );
-
-  err = timeLocalStiffnessVector.MinValue( &_minTimeLocalStiffness );
-  err = timeGlobalAssemblyVector.MinValue( &_minTimeGlobalAssembly );
-  err = timeBCImpositionVector.MinValue( &_minTimeBCImposition );
-
-  err = timeLocalStiffnessVector.MaxValue( &_maxTimeLocalStiffness );
-  err = timeGlobalAssemblyVector.MaxValue( &_maxTimeGlobalAssembly );
-  err = timeBCImpositionVector.MaxValue( &_maxTimeBCImposition );
 }
 
 void Solution::setProblem(Teuchos::RCP<Solver> solver) {
@@ -901,8 +1010,6 @@ int Solution::solveWithPrepopulatedStiffnessAndLoad(Teuchos::RCP<Solver> solver,
   vector< ElementTypePtr >::iterator elemTypeIt;
 
   //cout << "process " << rank << " about to loop over elementTypes.\n";
-  int indexBase = 0;
-  Epetra_Map timeMap(numProcs,indexBase,Comm);
   Epetra_Time timer(Comm);
 
   if (_reportConditionNumber) {
@@ -927,10 +1034,13 @@ int Solution::solveWithPrepopulatedStiffnessAndLoad(Teuchos::RCP<Solver> solver,
 //  cout << "(On rank " << rank << ", mesh sees " << _mesh->globalDofCount() << " dofs.)\n";
 
   int solveSuccess;
-  if (!callResolveInsteadOfSolve) {
-    solveSuccess = solver->solve();
-  } else {
-    solveSuccess = solver->resolve();
+  {
+    ScopedPhaseTimer phaseTimer("linear solve");
+    if (!callResolveInsteadOfSolve) {
+      solveSuccess = solver->solve();
+    } else {
+      solveSuccess = solver->resolve();
+    }
   }
 
 //  if (rank==0) cout << "Returned from global solver.\n";
@@ -942,18 +1052,26 @@ int Solution::solveWithPrepopulatedStiffnessAndLoad(Teuchos::RCP<Solver> solver,
   }
 
   double timeSolve = timer.ElapsedTime();
-  Epetra_Vector timeSolveVector(timeMap);
-  timeSolveVector[0] = timeSolve;
-
-  int err = timeSolveVector.Norm1( &_totalTimeSolve );
-  err = timeSolveVector.MeanValue( &_meanTimeSolve );
-  err = timeSolveVector.MinValue( &_minTimeSolve );
-  err = timeSolveVector.MaxValue( &_maxTimeSolve );
+  _timeSolve = PhaseTimers::timeStatistics(timeSolve);
 
   return solveSuccess;
 }
 
 int Solution::solve(Teuchos::RCP<Solver> solver) {
+  int solveSuccess;
+  {
+    ScopedPhaseTimer phaseTimer("solve");
+    if (_reuseStiffness && _stiffnessIsReusable && (_reusableSolver.get() != NULL)) {
+      solveSuccess = solveWithStoredStiffness();
+    } else {
+      solveSuccess = assembleAndSolve(solver);
+    }
+  }
+  PhaseTimers::phaseTimers()->solveCompleted();
+  return solveSuccess;
+}
+
+int Solution::assembleAndSolve(Teuchos::RCP<Solver> solver) {
 //  int rank = Teuchos::GlobalMPISession::getRank();
 
   if (_oldDofInterpreter.get() != NULL) { // proxy for having a condensation interpreter
@@ -968,6 +1086,9 @@ int Solution::solve(Teuchos::RCP<Solver> solver) {
   setProblem(solver);
   populateStiffnessAndLoad();
   int solveSuccess = solveWithPrepopulatedStiffnessAndLoad(solver);
+  if (_stiffnessIsReusable) {
+    _reusableSolver = solver;
+  }
 //  cout << "about to call importSolution on rank " << rank << endl;
   importSolution();
 //  cout << "calling importGlobalSolution (this doesn't scale well, especially in its current form).\n";
@@ -983,37 +1104,62 @@ int Solution::solve(Teuchos::RCP<Solver> solver) {
   return solveSuccess;
 }
 
+int Solution::solveMatrixFree(Teuchos::RCP<Solver> solver, bool storeLocalStiffness) {
+  int rank = Teuchos::GlobalMPISession::getRank();
+
+  initializeLHSVector(); // (also discards any stored stiffness, which refers to the matrix and vectors replaced here)
+  _globalStiffMatrix = Teuchos::null; // the point is not to have an assembled matrix around
+
+  Teuchos::RCP<MatrixFreeOperator> stiffness = Teuchos::rcp( new MatrixFreeOperator(Teuchos::rcp(this,false), storeLocalStiffness) );
+  _matrixFreeStiffness = stiffness;
+  _rhsVector = stiffness->getRHSVector();
+  stiffness->imposeBCValues(*_lhsVector);
+
+  Teuchos::RCP<Epetra_LinearProblem> problem = Teuchos::rcp( new Epetra_LinearProblem(stiffness.get(), &*_lhsVector, &*_rhsVector));
+  solver->setProblem(problem);
+
+  int solveSuccess = solver->solve();
+  if (solveSuccess != 0 ) {
+    if (rank==0) cout << "**** WARNING: in Solution.solveMatrixFree(), solver->solve() failed with error code " << solveSuccess << ". ****\n";
+  }
+
+  importSolution();
+  clearComputedResiduals(); // now that we've solved, will need to recompute residuals...
+
+  return solveSuccess;
+}
+
 void Solution::reportTimings() {
   int rank = Teuchos::GlobalMPISession::getRank();
 
   if (rank == 0) {
     cout << "****** SUM OF TIMING REPORTS ******\n";
-    cout << "localStiffness: " << _totalTimeLocalStiffness << " sec." << endl;
-    cout << "globalAssembly: " << _totalTimeGlobalAssembly << " sec." << endl;
-    cout << "impose BCs:     " << _totalTimeBCImposition << " sec." << endl;
-    cout << "solve:          " << _totalTimeSolve << " sec." << endl;
-    cout << "dist. solution: " << _totalTimeDistributeSolution << " sec." << endl << endl;
+    cout << "localStiffness: " << _timeLocalStiffness.sum << " sec." << endl;
+    cout << "globalAssembly: " << _timeGlobalAssembly.sum << " sec." << endl;
+    cout << "impose BCs:     " << _timeBCImposition.sum << " sec." << endl;
+    cout << "solve:          " << _timeSolve.sum << " sec." << endl;
+    cout << "dist. solution: " << _timeDistributeSolution.sum << " sec." << endl << endl;
 
     cout << "****** MEAN OF TIMING REPORTS ******\n";
-    cout << "localStiffness: " << _meanTimeLocalStiffness << " sec." << endl;
-    cout << "globalAssembly: " << _meanTimeGlobalAssembly << " sec." << endl;
-    cout << "impose BCs:     " << _meanTimeBCImposition << " sec." << endl;
-    cout << "solve:          " << _meanTimeSolve << " sec." << endl;
-    cout << "dist. solution: " << _meanTimeDistributeSolution << " sec." << endl << endl;
+    cout << "localStiffness: " << _timeLocalStiffness.mean << " sec." << endl;
+    cout << "globalAssembly: " << _timeGlobalAssembly.mean << " sec." << endl;
+    cout << "impose BCs:     " << _timeBCImposition.mean << " sec." << endl;
+    cout << "solve:          " << _timeSolve.mean << " sec." << endl;
+    cout << "dist. solution: " << _timeDistributeSolution.mean << " sec." << endl << endl;
 
     cout << "****** MAX OF TIMING REPORTS ******\n";
-    cout << "localStiffness: " << _maxTimeLocalStiffness << " sec." << endl;
-    cout << "globalAssembly: " << _maxTimeGlobalAssembly << " sec." << endl;
-    cout << "impose BCs:     " << _maxTimeBCImposition << " sec." << endl;
-    cout << "solve:          " << _maxTimeSolve << " sec." << endl;
-    cout << "dist. solution: " << _maxTimeDistributeSolution << " sec." << endl << endl;
+    cout << "localStiffness: " << _timeLocalStiffness.max << " sec." << endl;
+    cout << "globalAssembly: " << _timeGlobalAssembly.max << " sec." << endl;
+    cout << "impose BCs:     " << _timeBCImposition.max << " sec." << endl;
+    cout << "solve:          " << _timeSolve.max << " sec." << endl;
+    cout << "dist. solution: " << _timeDistributeSolution.max << " sec." << endl << endl;
 
     cout << "****** MIN OF TIMING REPORTS ******\n";
-    cout << "localStiffness: " << _minTimeLocalStiffness << " sec." << endl;
-    cout << "globalAssembly: " << _minTimeGlobalAssembly << " sec." << endl;
-    cout << "impose BCs:     " << _minTimeBCImposition << " sec." << endl;
-    cout << "solve:          " << _minTimeSolve << " sec." << endl;
-    cout << "dist. solution: " << _minTimeDistributeSolution << " sec." << endl;
+    cout << "localStiffness: " << _timeLocalStiffness.min << " sec." << endl;
+    cout << "globalAssembly: " << _timeGlobalAssembly.min << " sec." << endl;
+    cout << "impose BCs:     " << _timeBCImposition.min << " sec." << endl;
+    cout << "solve:          " << _timeSolve.min << " sec." << endl;
+    cout << "dist. solution: " << _timeDistributeSolution.min << " sec." << endl;
   }
 }
 
@@ -1038,6 +1184,8 @@ Teuchos::RCP<RHS> Solution::rhs() const {
 }
 
 void Solution::importSolution() {
+  ScopedPhaseTimer phaseTimer("import solution");
+
 #ifdef HAVE_MPI
   Epetra_MpiComm Comm(MPI_COMM_WORLD);
   //cout << "rank: " << rank << " of " << numProcs << endl;
@@ -1079,27 +1227,19 @@ void Solution::importSolution() {
   solnCoeff.Import(*_lhsVector, solnImporter, Insert);
 //  cout << "on rank " << rank << ", returned from Import\n";
 
-  // copy the dof coefficients into our data structure
+  // copy the dof coefficients into our data structure; the interpreter may reshape what it is given, so it fills a
+  // container of our own, which the store then copies (in place, when the cell's size is unchanged)
+  FieldContainer<double> cellDofs;
   for (set<GlobalIndexType>::iterator cellIDIt = myCellIDs.begin(); cellIDIt != myCellIDs.end(); cellIDIt++) {
     GlobalIndexType cellID = *cellIDIt;
 //    cout << "on rank " << rank << ", about to interpret data for cell " << cellID << "\n";
-    FieldContainer<double> cellDofs(_mesh->getElementType(cellID)->trialOrderPtr->totalDofs());
+    cellDofs.resize(_mesh->getElementType(cellID)->trialOrderPtr->totalDofs());
     _dofInterpreter->interpretGlobalCoefficients(cellID,cellDofs,solnCoeff);
-    _solutionForCellIDGlobal[cellID] = cellDofs;
+    _solutionForCellIDGlobal.setCoefficients(cellID, cellDofs);
   }
 //  cout << "on rank " << rank << ", finished interpretation\n";
   double timeDistributeSolution = timer.ElapsedTime();
-
-  int numProcs = Teuchos::GlobalMPISession::getNProc();
-  int indexBase = 0;
-  Epetra_Map timeMap(numProcs,indexBase,Comm);
-  Epetra_Vector timeDistributeSolutionVector(timeMap);
-  timeDistributeSolutionVector[0] = timeDistributeSolution;
-
-  int err = timeDistributeSolutionVector.Norm1( &_totalTimeDistributeSolution );
-  err = timeDistributeSolutionVector.MeanValue( &_meanTimeDistributeSolution );
-  err = timeDistributeSolutionVector.MinValue( &_minTimeDistributeSolution );
-  err = timeDistributeSolutionVector.MaxValue( &_maxTimeDistributeSolution );
+  _timeDistributeSolution = PhaseTimers::timeStatistics(timeDistributeSolution);
 }
 
 void Solution::importSolutionForOffRankCells(std::set<GlobalIndexType> cellIDs) {
@@ -1167,7 +1307,7 @@ void Solution::importSolutionForOffRankCells(std::set<GlobalIndexType> cellIDs)
       TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "requested cellID does not belong to this rank!");
     }
 
-    FieldContainer<double>* solnCoeffs = &_solutionForCellIDGlobal[cellID];
+    const FieldContainer<double>* solnCoeffs = &_solutionForCellIDGlobal.coefficients(cellID);
     sizes[cellOrdinal] = solnCoeffs->size();
     for (int dofOrdinal=0; dofOrdinal < solnCoeffs->size(); dofOrdinal++) {
       dataToExport.push_back((*solnCoeffs)[dofOrdinal]);
@@ -1190,18 +1330,16 @@ void Solution::importSolutionForOffRankCells(std::set<GlobalIndexType> cellIDs)
   int dofsImported = 0;
   for (vector<GlobalIndexTypeToCast>::iterator cellIDIt = myRequest.begin(); cellIDIt != myRequest.end(); cellIDIt++) {
     GlobalIndexType cellID = *cellIDIt;
-    FieldContainer<double> cellDofs(_mesh->getElementType(cellID)->trialOrderPtr->totalDofs());
-    if (cellDofs.size() + dofsImported > numDofsImport) {
+    int cellDofCount = _mesh->getElementType(cellID)->trialOrderPtr->totalDofs();
+    if (cellDofCount + dofsImported > numDofsImport) {
       cout << "ERROR: not enough dofs provided to this rank!\n";
       TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "Attempt to go beyond array bounds because not enough dofs were imported.");
     }
 
-    double* copyToLocation = &cellDofs[0];
-    memcpy(copyToLocation, copyFromLocation, objSize * cellDofs.size());
-    copyFromLocation += objSize * cellDofs.size();
-    copyToLocation += cellDofs.size(); // copyToLocation has type double*, so this moves the pointer the same # of bytes
-    dofsImported += cellDofs.size();
-    _solutionForCellIDGlobal[cellID] = cellDofs;
+    double* copyToLocation = _solutionForCellIDGlobal.coefficientValues(cellID, cellDofCount);
+    memcpy(copyToLocation, copyFromLocation, objSize * cellDofCount);
+    copyFromLocation += objSize * cellDofCount;
+    dofsImported += cellDofCount;
   }
 
   if( cellIDsToExport != 0 ) delete [] cellIDsToExport;
@@ -1210,6 +1348,8 @@ void Solution::importSolutionForOffRankCells(std::set<GlobalIndexType> cellIDs)
 }
 
 void Solution::importGlobalSolution() {
+  ScopedPhaseTimer phaseTimer("import solution");
+
 #ifdef HAVE_MPI
   Epetra_MpiComm Comm(MPI_COMM_WORLD);
   //cout << "rank: " << rank << " of " << numProcs << endl;
@@ -1236,45 +1376,34 @@ void Solution::importGlobalSolution() {
   solnCoeff.Import(*_lhsVector, solnImporter, Insert);
 
   set<GlobalIndexType> globalActiveCellIDs = _mesh->getActiveCellIDs();
-  // copy the dof coefficients into our data structure
+  // copy the dof coefficients into our data structure; the interpreter may reshape what it is given, so it fills a
+  // container of our own, which the store then copies (in place, when the cell's size is unchanged)
+  FieldContainer<double> cellDofs;
   for (set<GlobalIndexType>::iterator cellIDIt = globalActiveCellIDs.begin(); cellIDIt != globalActiveCellIDs.end(); cellIDIt++) {
     GlobalIndexType cellID = *cellIDIt;
-    FieldContainer<double> cellDofs(_mesh->getElementType(cellID)->trialOrderPtr->totalDofs());
+    cellDofs.resize(_mesh->getElementType(cellID)->trialOrderPtr->totalDofs());
     _dofInterpreter->interpretGlobalCoefficients(cellID,cellDofs,solnCoeff);
-    _solutionForCellIDGlobal[cellID] = cellDofs;
+    _solutionForCellIDGlobal.setCoefficients(cellID, cellDofs);
   }
   double timeDistributeSolution = timer.ElapsedTime();
-
-  int numProcs = Teuchos::GlobalMPISession::getNProc();
-  int indexBase = 0;
-  Epetra_Map timeMap(numProcs,indexBase,Comm);
-  Epetra_Vector timeDistributeSolutionVector(timeMap);
-  timeDistributeSolutionVector[0] = timeDistributeSolution;
-
-  int err = timeDistributeSolutionVector.Norm1( &_totalTimeDistributeSolution );
-  err = timeDistributeSolutionVector.MeanValue( &_meanTimeDistributeSolution );
-  err = timeDistributeSolutionVector.MinValue( &_minTimeDistributeSolution );
-  err = timeDistributeSolutionVector.MaxValue( &_maxTimeDistributeSolution );
+  _timeDistributeSolution = PhaseTimers::timeStatistics(timeDistributeSolution);
 }
 
 IPPtr Solution::ip() const {
   return _ip;
 }
 
-void Solution::imposeBCs() {
+void Solution::determineBCs(FieldContainer<GlobalIndexTypeToCast> &bcGlobalIndicesCast, FieldContainer<double> &bcGlobalValues) {
   int rank     = Teuchos::GlobalMPISession::getRank();
 
   FieldContainer<GlobalIndexType> bcGlobalIndices;
-  FieldContainer<double> bcGlobalValues;
 
   set<GlobalIndexType> myGlobalIndicesSet = _dofInterpreter->globalDofIndicesForPartition(rank);
   //  cout << "rank " << rank << " has " << myGlobalIndicesSet.size() << " locally-owned dof indices.\n";
   Epetra_Map partMap = getPartitionMap();
 
   _mesh->boundary().bcsToImpose(bcGlobalIndices,bcGlobalValues,*(_bc.get()), myGlobalIndicesSet, _dofInterpreter.get(), &partMap);
-  int numBCs = bcGlobalIndices.size();
 
-  FieldContainer<GlobalIndexTypeToCast> bcGlobalIndicesCast;
   // cast whatever the global index type is to a type that Epetra supports
   Teuchos::Array<int> dim;
   bcGlobalIndices.dimensions(dim);
@@ -1284,6 +1413,13 @@ void Solution::imposeBCs() {
   }
 //  cout << "bcGlobalIndices:" << endl << bcGlobalIndices;
   //  cout << "bcGlobalValues:" << endl << bcGlobalValues;
+}
+
+void Solution::applyBCValues(const FieldContainer<GlobalIndexTypeToCast> &bcGlobalIndicesCast, const FieldContainer<double> &bcGlobalValues,
+                             const Epetra_Operator &unconstrainedStiffness) {
+  // moves the BC values to the right-hand side, and sets them in the lhs and rhs vectors
+  Epetra_Map partMap = getPartitionMap();
+  int numBCs = bcGlobalIndicesCast.size();
 
   Epetra_MultiVector v(partMap,1);
   v.PutScalar(0.0);
@@ -1292,7 +1428,7 @@ void Solution::imposeBCs() {
   }
 
   Epetra_MultiVector rhsDirichlet(partMap,1);
-  _globalStiffMatrix->Apply(v,rhsDirichlet);
+  unconstrainedStiffness.Apply(v,rhsDirichlet);
 
   // Update right-hand side
   _rhsVector->Update(-1.0,rhsDirichlet,1.0);
@@ -1309,10 +1445,65 @@ void Solution::imposeBCs() {
       cout << "ERROR: rhsVector.ReplaceGlobalValues(): some indices non-local...\n";
     }
   }
+}
+
+Teuchos::RCP<Epetra_CrsMatrix> Solution::dirichletLift(const FieldContainer<GlobalIndexTypeToCast> &bcGlobalIndicesCast) {
+  // the entries of _globalStiffMatrix in columns that belong to BC dofs; these are all that's needed to move BC values
+  // to the right-hand side once BCs have been imposed on the matrix.  BC dofs are determined by their owning rank, so
+  // we import an indicator to find the columns that belong to BC dofs owned elsewhere.
+  Epetra_Vector isBCDof(_globalStiffMatrix->DomainMap());
+  for (int i = 0; i < bcGlobalIndicesCast.size(); i++) {
+    isBCDof.ReplaceGlobalValue(bcGlobalIndicesCast(i), 0, 1.0);
+  }
+  Epetra_Vector isBCColumn(_globalStiffMatrix->ColMap());
+  Epetra_Import importer(_globalStiffMatrix->ColMap(), _globalStiffMatrix->DomainMap());
+  isBCColumn.Import(isBCDof, importer, Insert);
+
+  Teuchos::RCP<Epetra_CrsMatrix> lift = Teuchos::rcp( new Epetra_CrsMatrix(::Copy, _globalStiffMatrix->RowMap(), _globalStiffMatrix->ColMap(), 0) );
+  vector<double> liftValues;
+  vector<int> liftColumns;
+  for (int localRow = 0; localRow < _globalStiffMatrix->NumMyRows(); localRow++) {
+    int numEntries;
+    double* values;
+    int* localColumns;
+    _globalStiffMatrix->ExtractMyRowView(localRow, numEntries, values, localColumns);
+    liftValues.clear();
+    liftColumns.clear();
+    for (int entry = 0; entry < numEntries; entry++) {
+      if (isBCColumn[localColumns[entry]] != 0.0) {
+        liftValues.push_back(values[entry]);
+        liftColumns.push_back(localColumns[entry]);
+      }
+    }
+    if (liftColumns.size() > 0) {
+      lift->InsertMyValues(localRow, liftColumns.size(), &liftValues[0], &liftColumns[0]);
+    }
+  }
+  lift->FillComplete(_globalStiffMatrix->DomainMap(), _globalStiffMatrix->RangeMap());
+  return lift;
+}
+
+void Solution::imposeBCs() {
+  ScopedPhaseTimer phaseTimer("impose BCs");
+
+  FieldContainer<GlobalIndexTypeToCast> bcGlobalIndicesCast;
+  FieldContainer<double> bcGlobalValues;
+
+  determineBCs(bcGlobalIndicesCast, bcGlobalValues);
+  int numBCs = bcGlobalIndicesCast.size();
+
+  if (_stiffnessIsReusable) {
+    // keep what we need to impose BCs on later loads (see populateLoad())
+    _dirichletLift = dirichletLift(bcGlobalIndicesCast);
+    _dirichletLiftBCIndices = bcGlobalIndicesCast;
+  }
+
+  applyBCValues(bcGlobalIndicesCast, bcGlobalValues, *_globalStiffMatrix);
+
   // Zero out rows and columns of stiffness matrix corresponding to Dirichlet edges
   //  and add one to diagonal.
-  FieldContainer<int> bcLocalIndices(bcGlobalIndices.dimension(0));
-  for (int i=0; i<bcGlobalIndices.dimension(0); i++) {
+  FieldContainer<int> bcLocalIndices(bcGlobalIndicesCast.dimension(0));
+  for (int i=0; i<bcGlobalIndicesCast.dimension(0); i++) {
     bcLocalIndices(i) = _globalStiffMatrix->LRID(bcGlobalIndicesCast(i));
   }
   if (numBCs == 0) {
@@ -1322,6 +1513,126 @@ void Solution::imposeBCs() {
   }
 }
 
+void Solution::populateLoad() {
+  ScopedPhaseTimer phaseTimer("load assembly");
+
+  int rank = Teuchos::GlobalMPISession::getRank();
+
+  // the problem held by _reusableSolver points to _lhsVector and _rhsVector, so we refill them rather than replacing them
+  _rhsVector->PutScalar(0.0);
+  _lhsVector->PutScalar(0.0);
+
+  vector< ElementTypePtr > elementTypes = _mesh->elementTypes(rank);
+  vector< ElementTypePtr >::iterator elemTypeIt;
+  for (elemTypeIt = elementTypes.begin(); elemTypeIt != elementTypes.end(); elemTypeIt++) {
+    ElementTypePtr elemTypePtr = *(elemTypeIt);
+    BasisCachePtr basisCache = Teuchos::rcp(new BasisCache(elemTypePtr, _mesh, false, _cubatureEnrichmentDegree));
+
+    DofOrderingPtr testOrderingPtr = elemTypePtr->testOrderPtr;
+    int numTrialDofs = elemTypePtr->trialOrderPtr->totalDofs();
+    int numTestDofs = testOrderingPtr->totalDofs();
+    CellBatches cellBatches(_mesh, elemTypePtr, numTestDofs*numTrialDofs + numTrialDofs);
+
+    for (int batchOrdinal=0; batchOrdinal<cellBatches.numBatches(); batchOrdinal++) {
+      int numCells = cellBatches.batchSize(batchOrdinal);
+      vector<GlobalIndexType> cellIDs = cellBatches.cellIDs(batchOrdinal);
+
+      bool createSideCacheToo = true;
+      cellBatches.setBasisCache(batchOrdinal, basisCache, createSideCacheToo);
+
+      FieldContainer<double> optTestCoeffs(numCells,numTrialDofs,numTestDofs);
+      for (int cellIndex=0; cellIndex<numCells; cellIndex++) {
+        map< GlobalIndexType, FieldContainer<double> >::iterator weightsIt = _optimalTestWeightsForCell.find(cellIDs[cellIndex]);
+        TEUCHOS_TEST_FOR_EXCEPTION(weightsIt == _optimalTestWeightsForCell.end(), std::invalid_argument,
+                                   "No stored optimal test weights for cell; was the mesh changed without a call to clearReusableStiffness()?");
+        const FieldContainer<double>* cellWeights = &weightsIt->second;
+        std::copy(&(*cellWeights)[0], &(*cellWeights)[0] + cellWeights->size(), &optTestCoeffs(cellIndex,0,0));
+      }
+
+      FieldContainer<double> localRHSVector(numCells,numTrialDofs);
+      _rhs->integrateAgainstOptimalTests(localRHSVector, optTestCoeffs, testOrderingPtr, basisCache);
+
+      Teuchos::Array<int> localRHSDim(1,numTrialDofs);
+      FieldContainer<double> interpretedRHS;
+      FieldContainer<GlobalIndexType> globalDofIndices;
+      FieldContainer<GlobalIndexTypeToCast> globalDofIndicesCast;
+      Teuchos::Array<int> dim;
+      for (int cellIndex=0; cellIndex<numCells; cellIndex++) {
+        FieldContainer<double> cellRHS(localRHSDim,&localRHSVector(cellIndex,0)); // shallow copy
+        _dofInterpreter->interpretLocalData(cellIDs[cellIndex], cellRHS, interpretedRHS, globalDofIndices);
+
+        // cast whatever the global index type is to a type that Epetra supports
+        globalDofIndices.dimensions(dim);
+        globalDofIndicesCast.resize(dim);
+        for (int dofOrdinal = 0; dofOrdinal < globalDofIndices.size(); dofOrdinal++) {
+          globalDofIndicesCast[dofOrdinal] = globalDofIndices[dofOrdinal];
+        }
+        _rhsVector->SumIntoGlobalValues(globalDofIndices.size(),&globalDofIndicesCast(0),&interpretedRHS[0]);
+      }
+    }
+  }
+
+  _rhsVector->GlobalAssemble();
+
+  FieldContainer<GlobalIndexTypeToCast> bcGlobalIndicesCast;
+  FieldContainer<double> bcGlobalValues;
+  determineBCs(bcGlobalIndicesCast, bcGlobalValues);
+
+  // the stored matrix has BCs imposed on a particular set of dofs; if that set has changed, we can't use it
+  bool sameBCDofs = (bcGlobalIndicesCast.size() == _dirichletLiftBCIndices.size());
+  for (int i=0; sameBCDofs && (i < bcGlobalIndicesCast.size()); i++) {
+    sameBCDofs = (bcGlobalIndicesCast[i] == _dirichletLiftBCIndices[i]);
+  }
+  sameBCDofs = (MPIWrapper::sum((int)!sameBCDofs) == 0);
+  if (!sameBCDofs) {
+    clearReusableStiffness();
+    return;
+  }
+
+  applyBCValues(bcGlobalIndicesCast, bcGlobalValues, *_dirichletLift);
+
+  _rhsVector->GlobalAssemble();
+}
+
+int Solution::solveWithStoredStiffness() {
+  // the stiffness matrix and its factorization are unchanged; only the load needs to be assembled
+  Teuchos::RCP<Solver> solver = _reusableSolver;
+  populateLoad();
+  if (!_stiffnessIsReusable) {
+    // populateLoad() found that the stored matrix can't be reused; assemble everything
+    return assembleAndSolve(solver);
+  }
+
+  bool callResolveInsteadOfSolve = true;
+  int solveSuccess = solveWithPrepopulatedStiffnessAndLoad(solver, callResolveInsteadOfSolve);
+  _numStoredStiffnessSolves++;
+  importSolution();
+  clearComputedResiduals();
+
+  if (_reportTimingResults ) {
+    reportTimings();
+  }
+
+  return solveSuccess;
+}
+
+void Solution::setReuseStiffness(bool value) {
+  _reuseStiffness = value;
+  if (!value) clearReusableStiffness();
+}
+
+int Solution::numStoredStiffnessSolves() const {
+  return _numStoredStiffnessSolves;
+}
+
+void Solution::clearReusableStiffness() {
+  _stiffnessIsReusable = false;
+  _reusableSolver = Teuchos::null;
+  _optimalTestWeightsForCell.clear();
+  _dirichletLift = Teuchos::null;
+  _dirichletLiftBCIndices.resize(0);
+}
+
 Teuchos::RCP<LocalStiffnessMatrixFilter> Solution::filter() const{
   return _filter;
 }
@@ -1332,6 +1643,8 @@ Teuchos::RCP<DofInterpreter> Solution::getDofInterpreter() const {
 
 void Solution::setDofInterpreter(Teuchos::RCP<DofInterpreter> dofInterpreter) {
   _dofInterpreter = dofInterpreter;
+  clearReusableStiffness();
+  _stiffnessGraph = Teuchos::null;
   Epetra_Map map = getPartitionMap();
   Teuchos::RCP<Epetra_Map> mapPtr = Teuchos::rcp( new Epetra_Map(map) ); // copy map to RCP
 //  _mesh->boundary().setDofInterpreter(_dofInterpreter.get(), mapPtr);
@@ -2112,6 +2425,8 @@ const map<GlobalIndexType,double> & Solution::rankLocalEnergyError() {
     return _energyErrorForCell;
   }
 
+  ScopedPhaseTimer phaseTimer("error estimation");
+
   computeErrorRepresentation();
 
   set<GlobalIndexType> rankLocalCells = _mesh->cellIDsInPartition();
@@ -2141,109 +2456,141 @@ void Solution::computeErrorRepresentation() {
   if (!_residualsComputed) {
     computeResiduals();
   }
-  set<GlobalIndexType> rankLocalCells = _mesh->cellIDsInPartition();
-  for (set<GlobalIndexType>::iterator cellIDIt = rankLocalCells.begin(); cellIDIt != rankLocalCells.end(); cellIDIt++) {
-    GlobalIndexType cellID = *cellIDIt;
+  ScopedPhaseTimer phaseTimer("error representation");
 
-    BasisCachePtr ipBasisCache = BasisCache::basisCacheForCell(_mesh, cellID, true);
+  int rank = Teuchos::GlobalMPISession::getRank();
 
-    ElementTypePtr elemTypePtr = _mesh->getElementType(cellID);
+  // Gram matrices are computed and factored a batch of cells at a time, by element type
+  vector< ElementTypePtr > elementTypes = _mesh->elementTypes(rank);
+  for (vector< ElementTypePtr >::iterator elemTypeIt = elementTypes.begin(); elemTypeIt != elementTypes.end(); elemTypeIt++) {
+    ElementTypePtr elemTypePtr = *elemTypeIt;
 
     Teuchos::RCP<DofOrdering> testOrdering = elemTypePtr->testOrderPtr;
-    CellTopoPtr cellTopo = elemTypePtr->cellTopoPtr;
-
-    int numCells = 1;
     int numTestDofs = testOrdering->totalDofs();
 
-    FieldContainer<double> representationMatrix(numTestDofs, 1);
-    FieldContainer<double> errorRepresentation(numCells,numTestDofs);
+    BasisCachePtr ipBasisCache = Teuchos::rcp(new BasisCache(elemTypePtr, _mesh, true));
 
-    FieldContainer<double> ipMatrix(1,numTestDofs,numTestDofs);
-    _ip->computeInnerProductMatrix(ipMatrix,testOrdering, ipBasisCache);
-    FieldContainer<double> rhsMatrix = _residualForCell[cellID];
-    // transpose residual :
-    rhsMatrix.resize(numTestDofs, 1);
+    CellBatches cellBatches(_mesh, elemTypePtr, numTestDofs*numTestDofs + 2*numTestDofs);
 
-    // strip cell dimension:
-    ipMatrix.resize(ipMatrix.dimension(1),ipMatrix.dimension(2));
-    int result = SerialDenseWrapper::solveSystemUsingQR(representationMatrix, ipMatrix, rhsMatrix);
-    if (result != 0) {
-      cout << "WARNING: computeErrorRepresentation: call to solveSystemUsingQR failed with error code " << result << endl;
-    }
-    for (int i=0; i<numTestDofs; i++) {
-      errorRepresentation(0,i) = representationMatrix(i,0);
+    for (int batchOrdinal=0; batchOrdinal<cellBatches.numBatches(); batchOrdinal++) {
+      int numCells = cellBatches.batchSize(batchOrdinal);
+      vector<GlobalIndexType> cellIDs = cellBatches.cellIDs(batchOrdinal);
+
+      cellBatches.setBasisCache(batchOrdinal, ipBasisCache, true);
+
+      FieldContainer<double> ipMatrix(numCells,numTestDofs,numTestDofs);
+      _ip->computeInnerProductMatrix(ipMatrix,testOrdering, ipBasisCache);
+
+      FieldContainer<double> residuals(numCells,numTestDofs,1);
+      for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+        FieldContainer<double>* residual = &_residualForCell[cellIDs[cellOrdinal]];
+        for (int i=0; i<numTestDofs; i++) {
+          residuals(cellOrdinal,i,0) = (*residual)(0,i);
+        }
+      }
+
+      // the Gram matrix is SPD for any sensible IP; Cholesky-solve the whole batch, falling back to QR for cells where that fails
+      FieldContainer<double> errorRepresentations(numCells,1,numTestDofs);
+      vector<int> failedCellOrdinals;
+      SerialDenseWrapper::solveSPDSystemsMultipleRHSTransposed(errorRepresentations, ipMatrix, residuals, failedCellOrdinals);
+
+      for (int i=0; i<failedCellOrdinals.size(); i++) {
+        int cellOrdinal = failedCellOrdinals[i];
+        FieldContainer<double> cellIPMatrix(numTestDofs,numTestDofs);
+        FieldContainer<double> rhsMatrix(numTestDofs,1);
+        FieldContainer<double> representationMatrix(numTestDofs,1);
+        for (int j=0; j<numTestDofs; j++) {
+          for (int k=0; k<numTestDofs; k++) {
+            cellIPMatrix(j,k) = ipMatrix(cellOrdinal,j,k);
+          }
+          rhsMatrix(j,0) = residuals(cellOrdinal,j,0);
+        }
+        int result = SerialDenseWrapper::solveSystemUsingQR(representationMatrix, cellIPMatrix, rhsMatrix);
+        if (result != 0) {
+          cout << "WARNING: computeErrorRepresentation: call to solveSystemUsingQR failed with error code " << result << endl;
+        }
+        for (int j=0; j<numTestDofs; j++) {
+          errorRepresentations(cellOrdinal,0,j) = representationMatrix(j,0);
+        }
+      }
+
+      for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+        FieldContainer<double> errorRepresentation(1,numTestDofs);
+        for (int i=0; i<numTestDofs; i++) {
+          errorRepresentation(0,i) = errorRepresentations(cellOrdinal,0,i);
+        }
+        _errorRepresentationForCell[cellIDs[cellOrdinal]] = errorRepresentation;
+      }
     }
-    _errorRepresentationForCell[cellID] = errorRepresentation;
   }
 }
 
 void Solution::computeResiduals() {
-  set<GlobalIndexType> rankLocalCells = _mesh->cellIDsInPartition();
-  for (set<GlobalIndexType>::iterator cellIDIt = rankLocalCells.begin(); cellIDIt != rankLocalCells.end(); cellIDIt++) {
-    GlobalIndexType cellID = *cellIDIt;
+  ScopedPhaseTimer phaseTimer("residuals");
 
-    ElementTypePtr elemTypePtr = _mesh->getElementType(cellID);
+  int rank = Teuchos::GlobalMPISession::getRank();
+
+  // residuals are computed a batch of cells at a time, by element type, as in populateStiffnessAndLoad()
+  vector< ElementTypePtr > elementTypes = _mesh->elementTypes(rank);
+  for (vector< ElementTypePtr >::iterator elemTypeIt = elementTypes.begin(); elemTypeIt != elementTypes.end(); elemTypeIt++) {
+    ElementTypePtr elemTypePtr = *elemTypeIt;
 
     Teuchos::RCP<DofOrdering> trialOrdering = elemTypePtr->trialOrderPtr;
     Teuchos::RCP<DofOrdering> testOrdering = elemTypePtr->testOrderPtr;
 
-    int numCells = 1;
     int numTrialDofs = trialOrdering->totalDofs();
     int numTestDofs  = testOrdering->totalDofs();
 
-    // compute l(v) and store in residuals:
-    FieldContainer<double> residual(1,numTestDofs);
+    BasisCachePtr basisCache = Teuchos::rcp(new BasisCache(elemTypePtr, _mesh, false, _cubatureEnrichmentDegree));
 
-    Teuchos::Array<int> oneCellDim(2);
-    oneCellDim[0] = 1;
-    oneCellDim[1] = numTestDofs;
+    CellBatches cellBatches(_mesh, elemTypePtr, numTestDofs*numTrialDofs + numTestDofs + numTrialDofs);
 
-    FieldContainer<double> localCoefficients;
-    if (_solutionForCellIDGlobal.find(cellID) != _solutionForCellIDGlobal.end()) {
-      localCoefficients = _solutionForCellIDGlobal[cellID];
-    } else {
-      localCoefficients.resize(numTrialDofs);
-    }
+    for (int batchOrdinal=0; batchOrdinal<cellBatches.numBatches(); batchOrdinal++) {
+      int numCells = cellBatches.batchSize(batchOrdinal);
+      vector<GlobalIndexType> cellIDs = cellBatches.cellIDs(batchOrdinal);
 
-    BasisCachePtr basisCache = BasisCache::basisCacheForCell(_mesh, cellID, false, _cubatureEnrichmentDegree);
-    _rhs->integrateAgainstStandardBasis(residual, testOrdering, basisCache);
+      cellBatches.setBasisCache(batchOrdinal, basisCache, true);
 
-    // compute b(u, v):
-    FieldContainer<double> preStiffness(1,numTestDofs,numTrialDofs );
-    FieldContainer<double> cellSideParitiesForCell = _mesh->cellSideParitiesForCell(cellID);
-    _mesh->bilinearForm()->stiffnessMatrix(preStiffness, elemTypePtr, cellSideParitiesForCell, basisCache);
+      // compute l(v) and store in residuals:
+      FieldContainer<double> residuals(numCells,numTestDofs);
+      _rhs->integrateAgainstStandardBasis(residuals, testOrdering, basisCache);
 
-    for (int i=0; i<numTestDofs; i++) {
-      for (int j=0; j<numTrialDofs; j++) {
-        residual(0,i) -= localCoefficients(j) * preStiffness(0,i,j);
+      // compute b(u, v):
+      FieldContainer<double> preStiffness(numCells,numTestDofs,numTrialDofs );
+      FieldContainer<double> cellSideParities = cellBatches.cellSideParities(batchOrdinal);
+      _mesh->bilinearForm()->stiffnessMatrix(preStiffness, elemTypePtr, cellSideParities, basisCache);
+
+      for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+        GlobalIndexType cellID = cellIDs[cellOrdinal];
+        FieldContainer<double> residual(1,numTestDofs);
+        for (int i=0; i<numTestDofs; i++) {
+          residual(0,i) = residuals(cellOrdinal,i);
+        }
+        if (_solutionForCellIDGlobal.hasCoefficients(cellID)) {
+          const FieldContainer<double>* localCoefficients = &_solutionForCellIDGlobal.coefficients(cellID);
+          for (int i=0; i<numTestDofs; i++) {
+            for (int j=0; j<numTrialDofs; j++) {
+              residual(0,i) -= (*localCoefficients)(j) * preStiffness(cellOrdinal,i,j);
+            }
+          }
+        }
+        _residualForCell[cellID] = residual;
       }
     }
-    
-    _residualForCell[cellID] = residual;
-//    cout << "computed residual vector for cell " << cellID << "; nonzeros:\n";
-//    double tol = 1e-15;
-//    for (int i=0; i< _residualForCell[cellID].size(); i++) {
-//      if (abs(_residualForCell[cellID][i]) > tol) {
-//        cout << setw(10) << i << setw(25) << _residualForCell[cellID][i] << endl;
-//      }
-//    }
   }
   _residualsComputed = true;
 }
 
 void Solution::discardInactiveCellCoefficients() {
   set< GlobalIndexType > activeCellIDs = _mesh->getActiveCellIDs();
-  vector<GlobalIndexType> cellIDsToErase;
-  for (map< GlobalIndexType, FieldContainer<double> >::iterator solnIt = _solutionForCellIDGlobal.begin();
-       solnIt != _solutionForCellIDGlobal.end(); solnIt++) {
-    GlobalIndexType cellID = solnIt->first;
+  vector<GlobalIndexType> cellIDsWithCoefficients = _solutionForCellIDGlobal.cellIDs();
+  for (vector<GlobalIndexType>::iterator cellIDIt = cellIDsWithCoefficients.begin(); cellIDIt != cellIDsWithCoefficients.end(); cellIDIt++) {
+    GlobalIndexType cellID = *cellIDIt;
     if ( activeCellIDs.find(cellID) == activeCellIDs.end() ) {
-      cellIDsToErase.push_back(cellID);
+      _solutionForCellIDGlobal.erase(cellID);
     }
   }
-  for (vector<GlobalIndexType>::iterator it = cellIDsToErase.begin();it !=cellIDsToErase.end();it++){
-    _solutionForCellIDGlobal.erase(*it);
-  }
+  _solutionForCellIDGlobal.compact();
 }
 
 Teuchos::RCP<Epetra_FEVector> Solution::getRHSVector() {
@@ -2256,6 +2603,7 @@ Teuchos::RCP<Epetra_CrsMatrix> Solution::getStiffnessMatrix() {
 
 void Solution::setStiffnessMatrix(Teuchos::RCP<Epetra_CrsMatrix> stiffness) {
   _globalStiffMatrix = stiffness;
+  _stiffnessGraphMatrix = NULL;
 }
 
 void Solution::solutionValues(FieldContainer<double> &values, int trialID, BasisCachePtr basisCache,
@@ -2281,71 +2629,80 @@ void Solution::solutionValues(FieldContainer<double> &values, int trialID, Basis
   }
   int spaceDim = basisCache->getSpaceDim();
   int numPoints = basisCache->getPhysicalCubaturePoints().dimension(1);
+
+  // gather the coefficients for the whole batch up front
+  vector<const double*> cellCoefficients;
+  vector<int> cellCoefficientCounts;
+  _solutionForCellIDGlobal.getCoefficientPointers(cellIDs, cellCoefficients, cellCoefficientCounts);
+
+  // cells in a batch usually share a trial ordering; reuse the basis and its values until it changes
+  DofOrdering* lastTrialOrder = NULL;
+  BasisPtr basis;
+  Teuchos::RCP<const FieldContainer<double> > transformedValues;
+  const vector<int> *dofIndices = NULL;
+
   for (int cellIndex = 0; cellIndex < numCells; cellIndex++) {
     GlobalIndexType cellID = cellIDs[cellIndex];
 
-
-    if ( _solutionForCellIDGlobal.find(cellID) == _solutionForCellIDGlobal.end() ) {
+    const double* solnCoeffs = cellCoefficients[cellIndex];
+    if (solnCoeffs == NULL) {
       // cellID not known -- default values for that cell to 0
-//      int rank = Teuchos::GlobalMPISession::getRank();
-//      cout << "In Solution::solutionValues() on rank " << rank << ", data for cellID " << cellID << " not found; defaulting to 0.\n" ;
       continue;
-    } else {
-      int rank = Teuchos::GlobalMPISession::getRank();
-//      cout << "In Solution::solutionValues() on rank " << rank << ", data for cellID " << cellID << " found; container size is " << _solutionForCellIDGlobal[cellID].size() << endl;
     }
 
-    FieldContainer<double>* solnCoeffs = &_solutionForCellIDGlobal[cellID];
-
     DofOrderingPtr trialOrder = _mesh->getElement(cellID)->elementType()->trialOrderPtr;
 
-    BasisPtr basis;
-    if (fluxOrTrace) {
-      if (! trialOrder->hasBasisEntry(trialID, sideIndex)) continue;
-      basis = trialOrder->getBasis(trialID, sideIndex);
-    } else {
-      basis = trialOrder->getBasis(trialID);
-    }
-
-    int basisCardinality = basis->getCardinality();
-
-    Teuchos::RCP<const FieldContainer<double> > transformedValues;
-    if (weightForCubature) {
-      if (forceVolumeCoords) {
-        transformedValues = basisCache->getVolumeBasisCache()->getTransformedWeightedValues(basis,op,sideIndex,true);
+    if (trialOrder.get() != lastTrialOrder) {
+      lastTrialOrder = trialOrder.get();
+      if (fluxOrTrace) {
+        if (! trialOrder->hasBasisEntry(trialID, sideIndex)) {
+          basis = Teuchos::null;
+          continue;
+        }
+        basis = trialOrder->getBasis(trialID, sideIndex);
       } else {
-        transformedValues = basisCache->getTransformedWeightedValues(basis, op);
+        basis = trialOrder->getBasis(trialID);
       }
-    } else {
-      if (forceVolumeCoords) {
-        transformedValues = basisCache->getVolumeBasisCache()->getTransformedValues(basis, op, sideIndex, true);
+
+      if (weightForCubature) {
+        if (forceVolumeCoords) {
+          transformedValues = basisCache->getVolumeBasisCache()->getTransformedWeightedValues(basis,op,sideIndex,true);
+        } else {
+          transformedValues = basisCache->getTransformedWeightedValues(basis, op);
+        }
       } else {
-        transformedValues = basisCache->getTransformedValues(basis, op);
+        if (forceVolumeCoords) {
+          transformedValues = basisCache->getVolumeBasisCache()->getTransformedValues(basis, op, sideIndex, true);
+        } else {
+          transformedValues = basisCache->getTransformedValues(basis, op);
+        }
       }
-    }
 
-//    cout << "solnCoeffs:\n" << *solnCoeffs;
+      dofIndices = fluxOrTrace ? &(trialOrder->getDofIndices(trialID,sideIndex))
+                               : &(trialOrder->getDofIndices(trialID));
+    } else if (basis.get() == NULL) {
+      continue; // same trial ordering as the last cell, which has no basis for trialID on this side
+    }
 
-    const vector<int> *dofIndices = fluxOrTrace ? &(trialOrder->getDofIndices(trialID,sideIndex))
-    : &(trialOrder->getDofIndices(trialID));
+    int basisCardinality = basis->getCardinality();
 
     int rank = transformedValues->rank() - 3; // 3 ==> scalar valued, 4 ==> vector, etc.
 
     // now, apply coefficient weights:
     for (int dofOrdinal=0; dofOrdinal < basisCardinality; dofOrdinal++) {
       int localDofIndex = (*dofIndices)[dofOrdinal];
-      //      cout << "localDofIndex " << localDofIndex << " solnCoeffs(localDofIndex): " << solnCoeffs(localDofIndex) << endl;
+      double coefficient = solnCoeffs[localDofIndex];
       for (int ptIndex=0; ptIndex < numPoints; ptIndex++) {
         if (rank == 0) {
-          values(cellIndex,ptIndex) += (*transformedValues)(cellIndex,dofOrdinal,ptIndex) * (*solnCoeffs)(localDofIndex);
+          values(cellIndex,ptIndex) += (*transformedValues)(cellIndex,dofOrdinal,ptIndex) * coefficient;
         } else if (rank == 1) {
           for (int i=0; i<spaceDim; i++) {
-            values(cellIndex,ptIndex,i) += (*transformedValues)(cellIndex,dofOrdinal,ptIndex,i) * (*solnCoeffs)(localDofIndex);
+            values(cellIndex,ptIndex,i) += (*transformedValues)(cellIndex,dofOrdinal,ptIndex,i) * coefficient;
           }
         } else if (rank == 2) {
           for (int i=0; i<spaceDim; i++) {
             for (int j=0; j<spaceDim; j++) {
-              values(cellIndex,ptIndex,i,j) += (*transformedValues)(cellIndex,dofOrdinal,ptIndex,i,j) * (*solnCoeffs)(localDofIndex);
+              values(cellIndex,ptIndex,i,j) += (*transformedValues)(cellIndex,dofOrdinal,ptIndex,i,j) * coefficient;
             }
           }
         } else {
@@ -2543,11 +2900,11 @@ void Solution::writeStatsToFile(const string &filePath, int precision) {
   ofstream fout(filePath.c_str());
   fout << setprecision(precision);
   fout << "stat.\tmean\tmin\tmax\ttotal\n";
-  fout << "localStiffness\t" << _meanTimeLocalStiffness << "\t" <<_minTimeLocalStiffness << "\t" <<_maxTimeLocalStiffness << "\t" << _totalTimeLocalStiffness << endl;
-  fout << "globalAssembly\t" <<  _meanTimeGlobalAssembly << "\t" <<_minTimeGlobalAssembly << "\t" <<_maxTimeGlobalAssembly << "\t" << _totalTimeGlobalAssembly << endl;
-  fout << "impose BCs\t" <<  _meanTimeBCImposition << "\t" <<_minTimeBCImposition << "\t" <<_maxTimeBCImposition << "\t" << _totalTimeBCImposition << endl;
-  fout << "solve\t" << _meanTimeSolve << "\t" <<_minTimeSolve << "\t" <<_maxTimeSolve << "\t" << _totalTimeSolve << endl;
-  fout << "dist. solution\t" <<  _meanTimeDistributeSolution << "\t" << _minTimeDistributeSolution << "\t" <<_maxTimeDistributeSolution << "\t" << _totalTimeDistributeSolution << endl;
+  fout << "localStiffness\t" << _timeLocalStiffness.mean << "\t" <<_timeLocalStiffness.min << "\t" <<_timeLocalStiffness.max << "\t" << _timeLocalStiffness.sum << endl;
+  fout << "globalAssembly\t" <<  _timeGlobalAssembly.mean << "\t" <<_timeGlobalAssembly.min << "\t" <<_timeGlobalAssembly.max << "\t" << _timeGlobalAssembly.sum << endl;
+  fout << "impose BCs\t" <<  _timeBCImposition.mean << "\t" <<_timeBCImposition.min << "\t" <<_timeBCImposition.max << "\t" << _timeBCImposition.sum << endl;
+  fout << "solve\t" << _timeSolve.mean << "\t" <<_timeSolve.min << "\t" <<_timeSolve.max << "\t" << _timeSolve.sum << endl;
+  fout << "dist. solution\t" <<  _timeDistributeSolution.mean << "\t" << _timeDistributeSolution.min << "\t" <<_timeDistributeSolution.max << "\t" << _timeDistributeSolution.sum << endl;
 }
 
 void Solution::writeToFile(int trialID, const string &filePath) {
@@ -2736,9 +3093,9 @@ FieldContainer<double> Solution::solutionForElementTypeGlobal(ElementTypePtr ele
     int globalCellIndex = (*elemIt)->globalCellIndex();
     int cellID = (*elemIt)->cellID();
     for (int dofIndex=0; dofIndex<numDofsForType; dofIndex++) {
-      if (( _solutionForCellIDGlobal.find(cellID) != _solutionForCellIDGlobal.end())
-          && (_solutionForCellIDGlobal[cellID].size() == numDofsForType)) {
-        solutionCoeffs(globalCellIndex,dofIndex) = _solutionForCellIDGlobal[cellID](dofIndex);
+      const FieldContainer<double>* cellCoeffs = &_solutionForCellIDGlobal.coefficients(cellID);
+      if (cellCoeffs->size() == numDofsForType) {
+        solutionCoeffs(globalCellIndex,dofIndex) = (*cellCoeffs)(dofIndex);
       } else { // no solution set for that cellID, return 0
         solutionCoeffs(globalCellIndex,dofIndex) = 0.0;
       }
@@ -2771,7 +3128,7 @@ void Solution::basisCoeffsForTrialOrder(FieldContainer<double> &basisCoeffs, Dof
 void Solution::solnCoeffsForCellID(FieldContainer<double> &solnCoeffs, GlobalIndexType cellID, int trialID, int sideIndex) {
   Teuchos::RCP< DofOrdering > trialOrder = _mesh->getElement(cellID)->elementType()->trialOrderPtr;
 
-  if (_solutionForCellIDGlobal.find(cellID) == _solutionForCellIDGlobal.end() ) {
+  if (! _solutionForCellIDGlobal.hasCoefficients(cellID) ) {
     cout << "Warning: solution for cellID " << cellID << " not found; returning 0.\n";
     BasisPtr basis = trialOrder->getBasis(trialID,sideIndex);
     int basisCardinality = basis->getCardinality();
@@ -2780,7 +3137,7 @@ void Solution::solnCoeffsForCellID(FieldContainer<double> &solnCoeffs, GlobalInd
     return;
   }
 
-  basisCoeffsForTrialOrder(solnCoeffs, trialOrder, _solutionForCellIDGlobal[cellID], trialID, sideIndex);
+  basisCoeffsForTrialOrder(solnCoeffs, trialOrder, _solutionForCellIDGlobal.coefficients(cellID), trialID, sideIndex);
 }
 
 const FieldContainer<double>& Solution::allCoefficientsForCellID(GlobalIndexType cellID, bool warnAboutOffRankImports) {
@@ -2789,13 +3146,13 @@ const FieldContainer<double>& Solution::allCoefficientsForCellID(GlobalIndexType
 
   bool cellIsRankLocal = (cellRank == myRank);
   if (cellIsRankLocal) {
-    return _solutionForCellIDGlobal[cellID];
+    return _solutionForCellIDGlobal.coefficients(cellID);
   } else {
     if ((warnAboutOffRankImports) && (cellRank != -1)) { // we don't warn about cells that don't have ranks (can happen on refinement, say)
       cout << "Warning: allCoefficientsForCellID() called on rank " << myRank << " for non-rank-local cell " << cellID;
       cout << ", which belongs to rank " << cellRank << endl;
     }
-    return _solutionForCellIDGlobal[cellID];
+    return _solutionForCellIDGlobal.coefficients(cellID);
   }
 }
 
@@ -2805,16 +3162,19 @@ void Solution::setBC( Teuchos::RCP<BC> bc) {
 
 void Solution::setFilter(Teuchos::RCP<LocalStiffnessMatrixFilter> newFilter) {
   _filter = newFilter;
+  clearReusableStiffness();
 }
 
 void Solution::setIP( IPPtr ip) {
   _ip = ip;
   // any computed residuals will need to be recomputed with the new IP
   clearComputedResiduals();
+  clearReusableStiffness();
 }
 
 void Solution::setLagrangeConstraints( Teuchos::RCP<LagrangeConstraints> lagrangeConstraints) {
   _lagrangeConstraints = lagrangeConstraints;
+  clearReusableStiffness();
 }
 
 void Solution::setReportConditionNumber(bool value) {
@@ -2828,7 +3188,7 @@ void Solution::setLocalCoefficientsForCell(GlobalIndexType cellID, const FieldCo
   if (coefficients.rank() != 1) {
     TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "coefficients container doesn't have the right shape; should be rank 1");
   }
-  _solutionForCellIDGlobal[cellID] = coefficients;
+  _solutionForCellIDGlobal.setCoefficients(cellID, coefficients);
 }
 
 void Solution::setReportTimingResults(bool value) {
@@ -2841,7 +3201,7 @@ void Solution::setRHS( Teuchos::RCP<RHS> rhs) {
 }
 
 void Solution::setSolnCoeffsForCellID(FieldContainer<double> &solnCoeffsToSet, GlobalIndexType cellID){
-  _solutionForCellIDGlobal[cellID] = solnCoeffsToSet;
+  _solutionForCellIDGlobal.setCoefficients(cellID, solnCoeffsToSet);
   _mesh->globalDofAssignment()->interpretLocalCoefficients(cellID,solnCoeffsToSet,*_lhsVector);
 }
 
@@ -2852,18 +3212,12 @@ void Solution::setSolnCoeffsForCellID(FieldContainer<double> &solnCoeffsToSet, G
   BasisPtr basis = trialOrder->getBasis(trialID,sideIndex);
 
   int basisCardinality = basis->getCardinality();
-  if ( _solutionForCellIDGlobal.find(cellID) == _solutionForCellIDGlobal.end() ) {
-    // allocate new storage
-    _solutionForCellIDGlobal[cellID] = FieldContainer<double>(trialOrder->totalDofs());
-  }
-  if (_solutionForCellIDGlobal[cellID].size() != trialOrder->totalDofs()) {
-    // resize
-    _solutionForCellIDGlobal[cellID].resize(trialOrder->totalDofs());
-  }
+  // allocates new storage if there is none, or if it has the wrong size
+  double* cellCoefficients = _solutionForCellIDGlobal.coefficientValues(cellID, trialOrder->totalDofs());
   TEUCHOS_TEST_FOR_EXCEPTION(solnCoeffsToSet.size() != basisCardinality, std::invalid_argument, "solnCoeffsToSet.size() != basisCardinality");
   for (int dofOrdinal=0; dofOrdinal < basisCardinality; dofOrdinal++) {
     int localDofIndex = trialOrder->getDofIndex(trialID, dofOrdinal, sideIndex);
-    _solutionForCellIDGlobal[cellID](localDofIndex) = solnCoeffsToSet[dofOrdinal];
+    cellCoefficients[localDofIndex] = solnCoeffsToSet[dofOrdinal];
   }
   FieldContainer<double> globalCoefficients;
   FieldContainer<GlobalIndexType> globalDofIndices;
@@ -2879,7 +3233,7 @@ void Solution::setSolnCoeffsForCellID(FieldContainer<double> &solnCoeffsToSet, G
 }
 
 // protected method; used for solution comparison...
-const map< GlobalIndexType, FieldContainer<double> > & Solution::solutionForCellIDGlobal() const {
+const CellCoefficientStore & Solution::solutionForCellIDGlobal() const {
   return _solutionForCellIDGlobal;
 }
 
@@ -2913,7 +3267,9 @@ void Solution::condensedSolve(Teuchos::RCP<Solver> globalSolver, bool reduceMemo
   // override reduceMemoryFootprint for now (since CondensedDofInterpreter doesn't yet support a true value)
   reduceMemoryFootprint = false;
 
-  Teuchos::RCP<DofInterpreter> dofInterpreter = Teuchos::rcp(new CondensedDofInterpreter(_mesh.get(), _ip, _rhs, _lagrangeConstraints.get(), fieldsToExclude, !reduceMemoryFootprint) );
+  CondensedDofInterpreter* condensedDofInterpreter = new CondensedDofInterpreter(_mesh.get(), _ip, _rhs, _lagrangeConstraints.get(), fieldsToExclude, !reduceMemoryFootprint);
+  condensedDofInterpreter->setCacheFieldBlockFactorizations(!reduceMemoryFootprint); // makes field recovery after the solve a triangular solve per cell
+  Teuchos::RCP<DofInterpreter> dofInterpreter = Teuchos::rcp(condensedDofInterpreter);
 
   Teuchos::RCP<DofInterpreter> oldDofInterpreter = _dofInterpreter;
 
@@ -3130,83 +3486,87 @@ void Solution::writeFluxesToFile(int trialID, const string &filePath){
 }
 
 double Solution::totalTimeLocalStiffness() {
-  return _totalTimeLocalStiffness;
+  return _timeLocalStiffness.sum;
 }
 
 double Solution::totalTimeGlobalAssembly() {
-  return _totalTimeGlobalAssembly;
+  return _timeGlobalAssembly.sum;
 }
 
 double Solution::totalTimeBCImposition() {
-  return _totalTimeBCImposition;
+  return _timeBCImposition.sum;
 }
 
 double Solution::totalTimeSolve() {
-  return _totalTimeSolve;
+  return _timeSolve.sum;
 }
 
 double Solution::totalTimeDistributeSolution() {
-  return _totalTimeDistributeSolution;
+  return _timeDistributeSolution.sum;
 }
 
 double Solution::meanTimeLocalStiffness() {
-  return _meanTimeLocalStiffness;
+  return _timeLocalStiffness.mean;
 }
 
 double Solution::meanTimeGlobalAssembly() {
-  return _meanTimeGlobalAssembly;
+  return _timeGlobalAssembly.mean;
 }
 
 double Solution::meanTimeBCImposition() {
-  return _meanTimeBCImposition;
+  return _timeBCImposition.mean;
 }
 
 double Solution::meanTimeSolve() {
-  return _meanTimeSolve;
+  return _timeSolve.mean;
 }
 
 double Solution::meanTimeDistributeSolution() {
-  return _meanTimeDistributeSolution;
+  return _timeDistributeSolution.mean;
 }
 
 double Solution::maxTimeLocalStiffness() {
-  return _maxTimeLocalStiffness;
+  return _timeLocalStiffness.max;
 }
 
 double Solution::maxTimeGlobalAssembly() {
-  return _maxTimeGlobalAssembly;
+  return _timeGlobalAssembly.max;
 }
 
 double Solution::maxTimeBCImposition() {
-  return _maxTimeBCImposition;
+  return _timeBCImposition.max;
 }
 
 double Solution::maxTimeSolve() {
-  return _maxTimeSolve;
+  return _timeSolve.max;
 }
 
 double Solution::maxTimeDistributeSolution() {
-  return _maxTimeDistributeSolution;
+  return _timeDistributeSolution.max;
 }
 
 double Solution::minTimeLocalStiffness() {
-  return _minTimeLocalStiffness;
+  return _timeLocalStiffness.min;
 }
 
 double Solution::minTimeGlobalAssembly() {
-  return _minTimeGlobalAssembly;
+  return _timeGlobalAssembly.min;
 }
 
 double Solution::minTimeBCImposition() {
-  return _minTimeBCImposition;
+  return _timeBCImposition.min;
 }
 
 double Solution::minTimeSolve() {
-  return _minTimeSolve;
+  return _timeSolve.min;
 }
 
 double Solution::minTimeDistributeSolution() {
-  return _minTimeDistributeSolution;
+  return _timeDistributeSolution.min;
+}
+
+const map<GlobalIndexType, double> & Solution::localStiffnessTimes() {
+  return _localStiffnessTimeForCell;
 }
 
 Epetra_Map Solution::getPartitionMap() {
@@ -3307,14 +3667,14 @@ void Solution::processSideUpgrades( const map<GlobalIndexType, pair< ElementType
        upgradeIt != cellSideUpgrades.end(); upgradeIt++) {
     GlobalIndexType cellID = upgradeIt->first;
     if (cellIDsToSkip.find(cellID) != cellIDsToSkip.end() ) continue;
-    if (_solutionForCellIDGlobal.find(cellID) == _solutionForCellIDGlobal.end())
+    if (! _solutionForCellIDGlobal.hasCoefficients(cellID))
       continue; // no previous solution for this cell
     DofOrderingPtr oldTrialOrdering = (upgradeIt->second).first->trialOrderPtr;
     DofOrderingPtr newTrialOrdering = (upgradeIt->second).second->trialOrderPtr;
     FieldContainer<double> newCoefficients(newTrialOrdering->totalDofs());
-    newTrialOrdering->copyLikeCoefficients( newCoefficients, oldTrialOrdering, _solutionForCellIDGlobal[cellID] );
+    newTrialOrdering->copyLikeCoefficients( newCoefficients, oldTrialOrdering, _solutionForCellIDGlobal.coefficients(cellID) );
     //    cout << "processSideUpgrades: setting solution for cell ID " << cellID << endl;
-    _solutionForCellIDGlobal[cellID] = newCoefficients;
+    _solutionForCellIDGlobal.setCoefficients(cellID, newCoefficients);
   }
 }
 
@@ -3422,14 +3782,15 @@ void Solution::projectOldCellOntoNewCells(GlobalIndexType cellID,
                                           const vector<GlobalIndexType> &childIDs) {
   int rank = Teuchos::GlobalMPISession::getRank();
 
-  if (_solutionForCellIDGlobal.find(cellID) == _solutionForCellIDGlobal.end()) {
+  if (! _solutionForCellIDGlobal.hasCoefficients(cellID)) {
 //    cout << "on rank " << rank << ", no solution for " << cellID << "; skipping projection onto children.\n";
     return; // zero solution on cell
   }
 //  cout << "on rank " << rank << ", projecting " << cellID << " data onto children.\n";
-  const FieldContainer<double>* oldData = &_solutionForCellIDGlobal[cellID];
-//  cout << "cell " << cellID << " data: \n" << *oldData;
-  projectOldCellOntoNewCells(cellID, oldElemType, *oldData, childIDs);
+  // copy: storing the children's coefficients may move the parent's
+  FieldContainer<double> oldData = _solutionForCellIDGlobal.coefficients(cellID);
+//  cout << "cell " << cellID << " data: \n" << oldData;
+  projectOldCellOntoNewCells(cellID, oldElemType, oldData, childIDs);
 }
 
 void Solution::projectOldCellOntoNewCells(GlobalIndexType cellID,
@@ -3555,7 +3916,7 @@ void Solution::projectOldCellOntoNewCells(GlobalIndexType cellID,
     }
 
     // (re)initialize the FieldContainer storing the solution--element type may have changed (in case of p-refinement)
-    _solutionForCellIDGlobal[childID] = FieldContainer<double>(childType->trialOrderPtr->totalDofs());
+    FieldContainer<double> childCoefficients(childType->trialOrderPtr->totalDofs());
     // project fields
     FieldContainer<double> basisCoefficients;
     for (map<int,FunctionPtr>::iterator fieldFxnIt=fieldMap.begin(); fieldFxnIt != fieldMap.end(); fieldFxnIt++) {
@@ -3569,7 +3930,7 @@ void Solution::projectOldCellOntoNewCells(GlobalIndexType cellID,
 
       for (int basisOrdinal=0; basisOrdinal<basisCoefficients.size(); basisOrdinal++) {
         int dofIndex = childType->trialOrderPtr->getDofIndex(varID, basisOrdinal);
-        _solutionForCellIDGlobal[childID][dofIndex] = basisCoefficients[basisOrdinal];
+        childCoefficients[dofIndex] = basisCoefficients[basisOrdinal];
       }
     }
 
@@ -3595,12 +3956,13 @@ void Solution::projectOldCellOntoNewCells(GlobalIndexType cellID,
         Projector::projectFunctionOntoBasisInterpolating(basisCoefficients, traceFxn, childBasis, basisCacheForSide);
         for (int basisOrdinal=0; basisOrdinal<basisCoefficients.size(); basisOrdinal++) {
           int dofIndex = childType->trialOrderPtr->getDofIndex(varID, basisOrdinal, sideOrdinal);
-          _solutionForCellIDGlobal[childID][dofIndex] = basisCoefficients[basisOrdinal];
+          childCoefficients[dofIndex] = basisCoefficients[basisOrdinal];
           // worth noting that as now set up, the "field traces" may stomp on the true traces, depending on in what order the sides
           // are mapped to global dof ordinals.  For right now, I'm not too worried about this.
         }
       }
     }
+    _solutionForCellIDGlobal.setCoefficients(childID, childCoefficients);
   }
 
   clearComputedResiduals(); // force recomputation of energy error (could do something more incisive, just computing the energy error for the new cells)
@@ -3644,7 +4006,7 @@ void Solution::readFromFile(const string &filePath) {
         dofValues[dofOrdinal++] = dofValue;
       }
 
-      _solutionForCellIDGlobal[cellID] = dofValues;
+      _solutionForCellIDGlobal.setCoefficients(cellID, dofValues);
     }
   }
   fin.close();
@@ -3657,10 +4019,10 @@ SolutionPtr Solution::solution(MeshPtr mesh, BCPtr bc, RHSPtr rhs, IPPtr ip ) {
 void Solution::writeToFile(const string &filePath) {
   ofstream fout(filePath.c_str());
 
-  for (map<GlobalIndexType, FieldContainer<double> >::iterator solnEntryIt = _solutionForCellIDGlobal.begin();
-       solnEntryIt != _solutionForCellIDGlobal.end(); solnEntryIt++) {
-    GlobalIndexType cellID = solnEntryIt->first;
-    FieldContainer<double>* solnCoeffs = &(solnEntryIt->second);
+  vector<GlobalIndexType> cellIDs = _solutionForCellIDGlobal.cellIDs();
+  for (vector<GlobalIndexType>::iterator cellIDIt = cellIDs.begin(); cellIDIt != cellIDs.end(); cellIDIt++) {
+    GlobalIndexType cellID = *cellIDIt;
+    const FieldContainer<double>* solnCoeffs = &_solutionForCellIDGlobal.coefficients(cellID);
     fout << cellID << " " << solnCoeffs->size() << " ";
     for (int i=0; i<solnCoeffs->size(); i++) {
       fout << (*solnCoeffs)[i] << " ";
@@ -3753,10 +4115,10 @@ void Solution::setGlobalSolutionFromCellLocalCoefficients() {
   set<GlobalIndexType> cellIDs = _mesh->cellIDsInPartition();
   for (set<GlobalIndexType>::iterator cellIDIt = cellIDs.begin(); cellIDIt != cellIDs.end(); cellIDIt++) {
     GlobalIndexType cellID = *cellIDIt;
-    if (_solutionForCellIDGlobal.find(cellID) != _solutionForCellIDGlobal.end()) {
+    if (_solutionForCellIDGlobal.hasCoefficients(cellID)) {
       int localTrialDofCount = _mesh->getElementType(cellID)->trialOrderPtr->totalDofs();
-      if (localTrialDofCount==_solutionForCellIDGlobal[cellID].size()) { // guard against cases when solutions not registered with their meshes have their meshes p-refined beneath them.  In such a case, we'll just ignore the previous solution coefficients on the cell.
-        _dofInterpreter->interpretLocalCoefficients(cellID, _solutionForCellIDGlobal[cellID], *_lhsVector);
+      if (localTrialDofCount==_solutionForCellIDGlobal.coefficients(cellID).size()) { // guard against cases when solutions not registered with their meshes have their meshes p-refined beneath them.  In such a case, we'll just ignore the previous solution coefficients on the cell.
+        _dofInterpreter->interpretLocalCoefficients(cellID, _solutionForCellIDGlobal.coefficients(cellID), *_lhsVector);
       }
     }
   }
@@ -3781,7 +4143,9 @@ void Solution::setUseCondensedSolve(bool value) {
 
       _oldDofInterpreter = _dofInterpreter;
 
-      Teuchos::RCP<DofInterpreter> dofInterpreter = Teuchos::rcp(new CondensedDofInterpreter(_mesh.get(), _ip, _rhs, _lagrangeConstraints.get(), fieldsToExclude, !reduceMemoryFootprint) );
+      CondensedDofInterpreter* condensedDofInterpreter = new CondensedDofInterpreter(_mesh.get(), _ip, _rhs, _lagrangeConstraints.get(), fieldsToExclude, !reduceMemoryFootprint);
+      condensedDofInterpreter->setCacheFieldBlockFactorizations(!reduceMemoryFootprint);
+      Teuchos::RCP<DofInterpreter> dofInterpreter = Teuchos::rcp(condensedDofInterpreter);
 
       setDofInterpreter(dofInterpreter);
     }
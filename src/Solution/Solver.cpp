@@ -50,6 +50,19 @@ Teuchos::RCP<Solver> Solver::getSolver(SolverChoice choice, bool saveFactorizati
       
       return Teuchos::rcp(gmgSolver);
     }
+    case GMGSolver_Multilevel:
+    {
+      vector<MeshPtr> coarseMeshes = GMGSolver::coarseMeshHierarchy(fineSolution->mesh());
+      TEUCHOS_TEST_FOR_EXCEPTION(coarseMeshes.size() == 0, std::invalid_argument,
+                                 "GMGSolver_Multilevel requires a fine mesh that is h-refined or above the coarsest H1 order");
+      if (coarseSolver == Teuchos::null) coarseSolver = getDirectSolver(true);
+      bool useCondensedSolve = false;
+      GMGSolver* gmgSolver = new GMGSolver(fineSolution, coarseMeshes, maxIterations, residualTolerance, coarseSolver, useCondensedSolve);
+      gmgSolver->setMultigridStrategy(GMGOperator::V_CYCLE);
+      gmgSolver->setComputeConditionNumberEstimate(false); // faster if we don't compute it
+      
+      return Teuchos::rcp(gmgSolver);
+    }
     default:
       cout << "Solver choice " << solverChoiceString(choice) << " not recognized.\n";
       TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "Solver choice not recognized!");
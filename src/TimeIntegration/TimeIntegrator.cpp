@@ -17,6 +17,8 @@ TimeIntegrator::TimeIntegrator(BFPtr steadyJacobian, SteadyResidual &steadyResid
   _timestep = 0;
   _nlTolerance = 1e-6;
   _nlIterationMax = 20;
+  _reuseStiffness = false;
+  _stiffnessDt = -1;
   _commRank = Teuchos::GlobalMPISession::getRank();
 
   _rhs = RHS::rhs();
@@ -44,6 +46,13 @@ TimeIntegrator::TimeIntegrator(BFPtr steadyJacobian, SteadyResidual &steadyResid
   }
 }
 
+void TimeIntegrator::setReuseStiffness(bool value)
+{
+  // in the nonlinear case, the stiffness depends on the previous iterate
+  _reuseStiffness = value && !_nonlinear;
+  _solution->setReuseStiffness(_reuseStiffness);
+}
+
 FunctionPtr TimeIntegrator::invDt()
 {
   return _invDt;
@@ -108,6 +117,7 @@ void TimeIntegrator::calcNextTimeStep(double dt)
   }
   else
   {
+    setStiffnessDt(dt);
     _solution->solve(false);
     _prevTimeSolution->setSolution(_solution);
   }
@@ -115,6 +125,16 @@ void TimeIntegrator::calcNextTimeStep(double dt)
   _timestep++;
 }
 
+void TimeIntegrator::setStiffnessDt(double dt)
+{
+  if (_reuseStiffness && (dt != _stiffnessDt))
+  {
+    // the 1/dt terms in the stiffness have changed
+    _solution->clearReusableStiffness();
+  }
+  _stiffnessDt = dt;
+}
+
 void TimeIntegrator::printTimeStepMessage()
 {
   if (_commRank == 0)
@@ -329,6 +349,9 @@ void ESDIRKIntegrator::calcNextTimeStep(double dt)
     }
     else
     {
+      // the stage's stiffness carries 1/(a[k][k]*dt); a stiffness stored by an earlier stage or step is only
+      // reused when that matches (as it does between stages, all of which share the diagonal coefficient)
+      setStiffnessDt(a[k][k]*dt);
       _solution->solve(false);
       _stageSolution[k]->setSolution(_solution);
     }
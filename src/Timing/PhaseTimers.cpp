@@ -0,0 +1,331 @@
+//
+//  PhaseTimers.cpp
+//  Camellia
+//
+//
+
+#include "PhaseTimers.h"
+
+#include "MPIWrapper.h"
+
+#include "Epetra_Map.h"
+#include "Epetra_MultiVector.h"
+#include "Epetra_Vector.h"
+
+#ifdef HAVE_MPI
+#include "Epetra_MpiComm.h"
+#else
+#include "Epetra_SerialComm.h"
+#endif
+
+#include "Teuchos_GlobalMPISession.hpp"
+#include "Teuchos_TestForException.hpp"
+#include "Teuchos_Time.hpp"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+  bool ignoreCallsHere() {
+#ifdef _OPENMP
+    return omp_in_parallel();
+#else
+    return false;
+#endif
+  }
+
+  vector<string> splitPathString(const string &pathString, char separator) {
+    vector<string> path;
+    istringstream pathStream(pathString);
+    string name;
+    while (getline(pathStream, name, separator)) {
+      path.push_back(name);
+    }
+    return path;
+  }
+
+  string jsonEscaped(const string &value) {
+    string escaped;
+    for (int i=0; i<value.size(); i++) {
+      if ((value[i] == '"') || (value[i] == '\\')) escaped += '\\';
+      escaped += value[i];
+    }
+    return escaped;
+  }
+}
+
+PhaseTimers::PhaseTimers() {
+  _exportFormat = CSV;
+  _solveOrdinal = 0;
+}
+
+PhaseTimers* PhaseTimers::phaseTimers() { // shared/static instance
+  static PhaseTimers timers;
+  return &timers;
+}
+
+void PhaseTimers::start(const string &phaseName) {
+  if (ignoreCallsHere()) return;
+  TEUCHOS_TEST_FOR_EXCEPTION((phaseName.find('\t') != string::npos) || (phaseName.find('\n') != string::npos),
+                             std::invalid_argument, "phase names may not contain tabs or newlines");
+  _activePath.push_back(phaseName);
+  _activeStartTimes.push_back(Teuchos::Time::wallTime());
+}
+
+void PhaseTimers::stop(const string &phaseName) {
+  if (ignoreCallsHere()) return;
+  // find the innermost running phase with this name; if there is none, there's nothing to stop
+  int depth = _activePath.size() - 1;
+  while ((depth >= 0) && (_activePath[depth] != phaseName)) depth--;
+  if (depth < 0) return;
+
+  double stopTime = Teuchos::Time::wallTime();
+  while (_activePath.size() > depth) {
+    Phase* phase = &_phases[_activePath]; // new entries are zero-initialized
+    phase->totalTime += stopTime - _activeStartTimes.back();
+    phase->callCount++;
+    _activePath.pop_back();
+    _activeStartTimes.pop_back();
+  }
+}
+
+void PhaseTimers::clear() {
+  _phases.clear();
+}
+
+double PhaseTimers::totalTime(const string &pathString) const {
+  map< vector<string>, Phase >::const_iterator phaseIt = _phases.find(splitPathString(pathString, '/'));
+  if (phaseIt == _phases.end()) return 0.0;
+  return phaseIt->second.totalTime;
+}
+
+int PhaseTimers::callCount(const string &pathString) const {
+  map< vector<string>, Phase >::const_iterator phaseIt = _phases.find(splitPathString(pathString, '/'));
+  if (phaseIt == _phases.end()) return 0;
+  return phaseIt->second.callCount;
+}
+
+vector< vector<string> > PhaseTimers::allRankPhasePaths() const {
+  // serialize our paths (components separated by tabs, paths by newlines), and gather everyone's
+  string myPaths;
+  for (map< vector<string>, Phase >::const_iterator phaseIt = _phases.begin(); phaseIt != _phases.end(); phaseIt++) {
+    for (int i=0; i<phaseIt->first.size(); i++) {
+      if (i > 0) myPaths += '\t';
+      myPaths += phaseIt->first[i];
+    }
+    myPaths += '\n';
+  }
+
+  int numProcs = Teuchos::GlobalMPISession::getNProc();
+  FieldContainer<int> lengths(numProcs);
+  MPIWrapper::allGather(lengths, (int) myPaths.size());
+  int maxLength = 1; // FieldContainers can't be empty
+  for (int i=0; i<numProcs; i++) {
+    maxLength = max(maxLength, lengths[i]);
+  }
+
+  FieldContainer<int> myCharacters(maxLength);
+  for (int i=0; i<myPaths.size(); i++) {
+    myCharacters[i] = myPaths[i];
+  }
+  FieldContainer<int> allCharacters(numProcs, maxLength);
+  MPIWrapper::allGather(allCharacters, myCharacters);
+
+  set< vector<string> > pathSet;
+  for (int rank=0; rank<numProcs; rank++) {
+    string rankPaths(lengths[rank], ' ');
+    for (int i=0; i<lengths[rank]; i++) {
+      rankPaths[i] = (char) allCharacters(rank,i);
+    }
+    vector<string> pathStrings = splitPathString(rankPaths, '\n');
+    for (int i=0; i<pathStrings.size(); i++) {
+      pathSet.insert(splitPathString(pathStrings[i], '\t'));
+    }
+  }
+  return vector< vector<string> >(pathSet.begin(), pathSet.end());
+}
+
+string PhaseTimers::pathString(const vector<string> &path) {
+  string pathString;
+  for (int i=0; i<path.size(); i++) {
+    if (i > 0) pathString += '/';
+    pathString += path[i];
+  }
+  return pathString;
+}
+
+vector<PhaseTimers::PhaseStatistics> PhaseTimers::statistics() const {
+  vector< vector<string> > paths = allRankPhasePaths();
+  int numPhases = paths.size();
+  vector<PhaseStatistics> stats(numPhases);
+  if (numPhases == 0) return stats;
+
+#ifdef HAVE_MPI
+  Epetra_MpiComm Comm(MPI_COMM_WORLD);
+#else
+  Epetra_SerialComm Comm;
+#endif
+
+  // one entry per rank, one vector per phase
+  int indexBase = 0;
+  int numProcs = Teuchos::GlobalMPISession::getNProc();
+  Epetra_Map rankMap(numProcs,indexBase,Comm);
+  Epetra_MultiVector times(rankMap, numPhases);
+  Epetra_MultiVector callCounts(rankMap, numPhases);
+  for (int phaseOrdinal=0; phaseOrdinal<numPhases; phaseOrdinal++) {
+    map< vector<string>, Phase >::const_iterator phaseIt = _phases.find(paths[phaseOrdinal]);
+    if (phaseIt != _phases.end()) {
+      times[phaseOrdinal][0] = phaseIt->second.totalTime;
+      callCounts[phaseOrdinal][0] = phaseIt->second.callCount;
+    }
+  }
+
+  vector<double> sums(numPhases), means(numPhases), mins(numPhases), maxes(numPhases), maxCallCounts(numPhases);
+  times.Norm1(&sums[0]);
+  times.MeanValue(&means[0]);
+  times.MinValue(&mins[0]);
+  times.MaxValue(&maxes[0]);
+  callCounts.MaxValue(&maxCallCounts[0]);
+
+  for (int phaseOrdinal=0; phaseOrdinal<numPhases; phaseOrdinal++) {
+    PhaseStatistics* phaseStats = &stats[phaseOrdinal];
+    phaseStats->path = paths[phaseOrdinal];
+    phaseStats->time.sum = sums[phaseOrdinal];
+    phaseStats->time.mean = means[phaseOrdinal];
+    phaseStats->time.min = mins[phaseOrdinal];
+    phaseStats->time.max = maxes[phaseOrdinal];
+    phaseStats->imbalance = (means[phaseOrdinal] > 0.0) ? maxes[phaseOrdinal] / means[phaseOrdinal] : 1.0;
+    phaseStats->maxCallCount = (int) maxCallCounts[phaseOrdinal];
+  }
+  return stats;
+}
+
+void PhaseTimers::report(ostream &out) const {
+  vector<PhaseStatistics> stats = statistics();
+  if (Teuchos::GlobalMPISession::getRank() != 0) return;
+
+  int nameWidth = 5; // "phase"
+  for (int i=0; i<stats.size(); i++) {
+    nameWidth = max(nameWidth, (int) (2 * (stats[i].path.size() - 1) + stats[i].path.back().size()));
+  }
+  nameWidth += 2;
+
+  ios_base::fmtflags flags = out.flags();
+  streamsize precision = out.precision();
+  out << left << setw(nameWidth) << "phase" << right << setw(8) << "calls" << setw(12) << "min (s)"
+      << setw(12) << "mean (s)" << setw(12) << "max (s)" << setw(11) << "imbalance" << endl;
+  out << fixed;
+  for (int i=0; i<stats.size(); i++) {
+    string indentedName = string(2 * (stats[i].path.size() - 1), ' ') + stats[i].path.back();
+    out << left << setw(nameWidth) << indentedName << right << setw(8) << stats[i].maxCallCount
+        << setprecision(4) << setw(12) << stats[i].time.min << setw(12) << stats[i].time.mean << setw(12) << stats[i].time.max
+        << setprecision(2) << setw(11) << stats[i].imbalance << endl;
+  }
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void PhaseTimers::writeCSVRows(ostream &out, const vector<PhaseStatistics> &stats, int solveOrdinal) const {
+  for (int i=0; i<stats.size(); i++) {
+    // phase names are code literals; we quote the path in case one contains a comma
+    out << solveOrdinal << ",\"" << pathString(stats[i].path) << "\"," << stats[i].path.size() - 1 << ",";
+    out << stats[i].maxCallCount << "," << stats[i].time.min << "," << stats[i].time.mean << ",";
+    out << stats[i].time.max << "," << stats[i].time.sum << "," << stats[i].imbalance << "\n";
+  }
+}
+
+void PhaseTimers::writeJSONObject(ostream &out, const vector<PhaseStatistics> &stats, int solveOrdinal) const {
+  int numProcs = Teuchos::GlobalMPISession::getNProc();
+  out << "{\"solve\": " << solveOrdinal << ", \"ranks\": " << numProcs << ", \"phases\": [";
+  for (int i=0; i<stats.size(); i++) {
+    if (i > 0) out << ", ";
+    out << "{\"path\": \"" << jsonEscaped(pathString(stats[i].path)) << "\", \"name\": \"" << jsonEscaped(stats[i].path.back());
+    out << "\", \"depth\": " << stats[i].path.size() - 1 << ", \"calls\": " << stats[i].maxCallCount;
+    out << ", \"min\": " << stats[i].time.min << ", \"mean\": " << stats[i].time.mean << ", \"max\": " << stats[i].time.max;
+    out << ", \"sum\": " << stats[i].time.sum << ", \"imbalance\": " << stats[i].imbalance << "}";
+  }
+  out << "]}";
+}
+
+void PhaseTimers::writeCSV(const string &filePath) const {
+  vector<PhaseStatistics> stats = statistics();
+  if (Teuchos::GlobalMPISession::getRank() != 0) return;
+  ofstream fout(filePath.c_str());
+  fout << setprecision(6);
+  fout << "solve,phase,depth,calls,min,mean,max,sum,imbalance\n";
+  writeCSVRows(fout, stats, _solveOrdinal);
+}
+
+void PhaseTimers::writeJSON(const string &filePath) const {
+  vector<PhaseStatistics> stats = statistics();
+  if (Teuchos::GlobalMPISession::getRank() != 0) return;
+  ofstream fout(filePath.c_str());
+  fout << setprecision(6);
+  writeJSONObject(fout, stats, _solveOrdinal);
+  fout << endl;
+}
+
+void PhaseTimers::setSolveExportFile(const string &filePath, ExportFormat format) {
+  _exportFilePath = filePath;
+  _exportFormat = format;
+  _solveOrdinal = 0;
+}
+
+void PhaseTimers::solveCompleted() {
+  if (_exportFilePath == "") return;
+
+  vector<PhaseStatistics> stats = statistics();
+  if (Teuchos::GlobalMPISession::getRank() == 0) {
+    // the first solve creates the file; later solves append to it
+    ofstream fout(_exportFilePath.c_str(), (_solveOrdinal == 0) ? ios_base::out : ios_base::app);
+    fout << setprecision(6);
+    if (_exportFormat == CSV) {
+      if (_solveOrdinal == 0) fout << "solve,phase,depth,calls,min,mean,max,sum,imbalance\n";
+      writeCSVRows(fout, stats, _solveOrdinal);
+    } else {
+      writeJSONObject(fout, stats, _solveOrdinal);
+      fout << endl;
+    }
+  }
+  _solveOrdinal++;
+  clear();
+}
+
+TimeStatistics PhaseTimers::timeStatistics(double localValue) {
+#ifdef HAVE_MPI
+  Epetra_MpiComm Comm(MPI_COMM_WORLD);
+#else
+  Epetra_SerialComm Comm;
+#endif
+
+  TimeStatistics stats;
+  int indexBase = 0;
+  int numProcs = Teuchos::GlobalMPISession::getNProc();
+  Epetra_Map timeMap(numProcs,indexBase,Comm);
+  Epetra_Vector timeVector(timeMap);
+  timeVector[0] = localValue;
+
+  timeVector.Norm1( &stats.sum );
+  timeVector.MeanValue( &stats.mean );
+  timeVector.MinValue( &stats.min );
+  timeVector.MaxValue( &stats.max );
+
+  return stats;
+}
+
+ScopedPhaseTimer::ScopedPhaseTimer(const string &phaseName) {
+  _phaseName = phaseName;
+  PhaseTimers::phaseTimers()->start(_phaseName);
+}
+
+ScopedPhaseTimer::~ScopedPhaseTimer() {
+  PhaseTimers::phaseTimers()->stop(_phaseName);
+}
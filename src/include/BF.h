@@ -27,6 +27,39 @@ class BF {
   VarFactory _varFactory;
   
   bool _isLegacySubclass;
+  
+  // opt-in cache of local stiffness matrices and optimal test weights for affine cells; see setUseStiffnessCache()
+  struct StiffnessCacheKey {
+    ElementType* elemType;
+    IP* ip;
+    int cubatureDegree, ipCubatureDegree; // these include any cubature enrichment
+    vector<int> cubatureDegrees, ipCubatureDegrees; // used in place of the above when those are -1
+    int jacobianExponent;
+    vector<long long> jacobian; // quantized, relative to 2^jacobianExponent
+    vector<int> sideParities;
+    
+    bool operator<(const StiffnessCacheKey &other) const;
+  };
+  struct StiffnessCacheEntry {
+    ElementTypePtr elemType; // keep elemType and ip alive, so that their addresses aren't reused
+    IPPtr ip;
+    FieldContainer<double> stiffness;
+    FieldContainer<double> optimalTestWeights;
+  };
+  bool _useStiffnessCache;
+  map< StiffnessCacheKey, StiffnessCacheEntry > _stiffnessCache;
+  long long _stiffnessCacheMemoryInBytes, _stiffnessCacheMaxMemoryInBytes;
+  long long _stiffnessCacheHitCount; // in cells
+  
+  vector<StiffnessCacheKey> stiffnessCacheKeys(ElementTypePtr elemType, IPPtr ip, BasisCachePtr basisCache, BasisCachePtr ipBasisCache);
+  void initStiffnessCache();
+  // the optimal test weights and stiffness for the cells of basisCache; returns the optimalTestWeights() error code
+  int optimalStiffness(FieldContainer<double> &localStiffness, FieldContainer<double> &optTestCoeffs, ElementTypePtr elemType,
+                       IPPtr ip, BasisCachePtr ipBasisCache, BasisCachePtr basisCache);
+  // sets basisCache to the cells at cellOrdinals among the given cells
+  static void setBasisCacheCells(BasisCachePtr basisCache, const FieldContainer<double> &physicalCellNodes,
+                                 const FieldContainer<double> &cellSideParities, const vector<GlobalIndexType> &cellIDs,
+                                 const vector<int> &cellOrdinals);
   //members that used to be part of BilinearForm:
 protected:
   vector< int > _trialIDs, _testIDs;
@@ -83,6 +116,11 @@ public:
                                           IPPtr ip, BasisCachePtr ipBasisCache,
                                           RHSPtr rhs,  BasisCachePtr basisCache);
   
+  // as above, but also returns the optimal test weights, with dimensions (numCells, numTrialDofs, numTestDofs)
+  void localStiffnessMatrixAndRHS(FieldContainer<double> &localStiffness, FieldContainer<double> &rhsVector,
+                                  FieldContainer<double> &optimalTestWeights, IPPtr ip, BasisCachePtr ipBasisCache,
+                                  RHSPtr rhs, BasisCachePtr basisCache);
+  
   virtual int optimalTestWeights(FieldContainer<double> &optimalTestWeights, FieldContainer<double> &innerProductMatrix,
                                  ElementTypePtr elemType, FieldContainer<double> &cellSideParities,
                                  BasisCachePtr stiffnessBasisCache);
@@ -120,11 +158,29 @@ public:
   virtual VarFactory varFactory();
   
   // non-virtual methods (originally from BilinearForm):
+  // on by default: optimal test weights come from one batched Cholesky solve of the (SPD) Gram matrices, with
+  // per-cell QR for any cell whose Gram matrix is not numerically SPD; when off, every cell is solved by QR
   void setUseSPDSolveForOptimalTestFunctions(bool value);
   void setUseIterativeRefinementsWithSPDSolve(bool value);
   void setUseExtendedPrecisionSolveForOptimalTestFunctions(bool value);
   void setWarnAboutZeroRowsAndColumns(bool value);
   
+  // When enabled, localStiffnessMatrixAndRHS() reuses the stiffness and optimal test weights of any previously
+  // computed affine cell with the same element type, Jacobian, side parities and inner product; only the RHS is
+  // integrated for such cells.  This is only valid when the BF and IP coefficients are constant in space (cells
+  // that differ by a translation must have the same stiffness); call clearStiffnessCache() if coefficients change.
+  // (addTerm() clears the cache.)  Only the cells of a batch that miss the cache have their stiffness computed.
+  // Memory is bounded: once the cached matrices reach stiffnessCacheMaxMemoryInBytes(), new cells are computed but
+  // not cached.  clearStiffnessCache() also resets the hit count.
+  void setUseStiffnessCache(bool value);
+  bool useStiffnessCache();
+  void clearStiffnessCache();
+  int stiffnessCacheSize();
+  long long stiffnessCacheHitCount(); // cells whose stiffness came from the cache
+  long long stiffnessCacheMemoryInBytes();
+  long long stiffnessCacheMaxMemoryInBytes();
+  void setStiffnessCacheMaxMemoryInBytes(long long maxMemory);
+  
   const vector< int > & trialIDs();
   const vector< int > & testIDs();
   
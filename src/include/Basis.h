@@ -13,12 +13,22 @@
 #include "Intrepid_FieldContainer.hpp"
 #include "Shards_CellTopology.hpp"
 
+#include <map>
+#include <vector>
+
 #include "CellTopology.h"
 #include "CamelliaIntrepidExtendedTypes.h"
 
 namespace Camellia {
   template<class Scalar=double, class ArrayScalar=Intrepid::FieldContainer<Scalar> > class Basis;
   
+  // a cached result of Basis::getUniqueComponentPoints() (not a template, so that it can be OpenMP threadprivate)
+  struct UniqueComponentPoints {
+    std::vector<double> refPoints; // the (P,D) points, flattened, for which the others were computed
+    std::vector<double> uniquePoints; // (P',D') flattened
+    std::vector<int> pointOrdinalMap;
+  };
+  
   template<class Scalar, class ArrayScalar> class Basis {
   protected:
     Basis();
@@ -63,6 +73,26 @@ namespace Camellia {
      \li     tagToOrdinal_[subcDim][subcOrd][subcDofOrd] = Degree-of-freedom ordinal
      */
     mutable std::vector<std::vector<std::vector<int> > > _tagToOrdinal;
+
+    /** \brief  Extracts the distinct values of a subset of the point coordinates.
+
+     Tensor-product cubatures repeat each component point many times; tensor-product bases use this to
+     evaluate their component (or 1D) bases once per distinct component point, rather than once per point.
+     This saves only component evaluations: the tensor-product values are still formed, and integrated,
+     point by point.
+
+     \param  refPoints        [in] - points, dimensions (P,D).
+     \param  firstCoordinate  [in] - the first coordinate of the component.
+     \param  numCoordinates   [in] - the number of coordinates in the component (may be 0).
+     \param  uniquePoints    [out] - the distinct component points, dimensions (P', max(numCoordinates,1)).
+     \param  pointOrdinalMap [out] - for each of the P points, the ordinal of its component point in uniquePoints.
+
+     The result depends only on the arguments, so each thread keeps the result for its most recent point set
+     of each shape and component, shared by all bases; repeated evaluation on the same points (e.g. the same
+     cubature for each cell) then does not repeat the search, and threads do not contend for the cache.
+     */
+    void getUniqueComponentPoints(const ArrayScalar &refPoints, int firstCoordinate, int numCoordinates,
+                                  ArrayScalar &uniquePoints, std::vector<int> &pointOrdinalMap) const;
   public:
     virtual int getCardinality() const;
     virtual int getDegree() const;
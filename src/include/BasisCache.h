@@ -85,9 +85,12 @@ private:
   Intrepid::FieldContainer<double> _cubPoints, _cubWeights;
   Intrepid::FieldContainer<double> _allCubPoints, _allCubWeights; // when using phased cubature points, these store the whole set
   
+  // when _cellsAreAffine, these hold a single point per cell, (C,1,D,D) and (C,1); Intrepid's transformations broadcast
+  // them over the points, and getJacobian() and friends broadcast them to (C,P,D,D) and (C,P) only on request
   Intrepid::FieldContainer<double> _cellJacobian;
   Intrepid::FieldContainer<double> _cellJacobInv;
   Intrepid::FieldContainer<double> _cellJacobDet;
+  Intrepid::FieldContainer<double> _pointwiseJacobian, _pointwiseJacobInv, _pointwiseJacobDet; // affine cells only; empty until requested
   Intrepid::FieldContainer<double> _weightedMeasure;
   Intrepid::FieldContainer<double> _physCubPoints;
   Intrepid::FieldContainer<double> _cellSideParities;
@@ -113,6 +116,14 @@ private:
   
   CellTopoPtr _cellTopo;
   
+  // true when _cubPoints (and _cubPointsSideRefCell) are the standard cubature points for _cellTopo, _sideIndex and the
+  // cubature degree, so that reference values can be shared with other instances through the ReferenceValueCache
+  bool _referencePointsAreStandard;
+  
+  // true when every cell has a constant Jacobian (see CamelliaCellTools::cellsAreAffine); determineJacobian() then
+  // computes and stores the Jacobian, its inverse and its determinant once per cell
+  bool _cellsAreAffine;
+  
   map< pair< Camellia::Basis<>*, Camellia::EOperator >,
   Teuchos::RCP< const Intrepid::FieldContainer<double> > > _knownValues;
   
@@ -135,6 +146,7 @@ private:
 
   void determineJacobian();
   void determinePhysicalPoints();
+  void broadcastAffineJacobian(); // fills the _pointwiseJacob* containers
   
   // (private) side cache constructor:
   BasisCache(int sideIndex, Teuchos::RCP<BasisCache> volumeCache, int trialDegree, int testDegree, BasisPtr multiBasisIfAny);
@@ -149,8 +161,11 @@ private:
   void findMaximumDegreeBasisForSides(DofOrdering &trialOrdering);
   
   void recomputeMeasures();
+  
+  Teuchos::RCP< const Intrepid::FieldContainer<double> > computeReferenceValues(BasisPtr basis, Camellia::EOperator op,
+                                                                                bool useCubPointsSideRefCell);
 protected:
-  BasisCache() { _isSideCache = false; } // for the sake of some hackish subclassing
+  BasisCache() { _isSideCache = false; _referencePointsAreStandard = false; _cellsAreAffine = false; } // for the sake of some hackish subclassing
   
   std::vector< BasisPtr > _maxDegreeBasisForSide; // stored in volume cache so we can get cubature right on sides, including broken sides (if this is a multiBasis)
   int _maxTestDegree, _maxTrialDegree;
@@ -190,6 +205,7 @@ public:
   CellTopoPtr cellTopology();
   
   int cubatureDegree();
+  const vector<int> & cubatureDegrees(); // per tensor component; used when cubatureDegree() is -1
   
   int getCubaturePhaseCount();
   void setMaxPointsPerCubaturePhase(int maxPoints);
@@ -200,9 +216,12 @@ public:
   
   void discardPhysicalNodeInfo(); // discards physicalNodes and all transformed basis values.
   
+  bool cellsAreAffine(); // true if the Jacobian is constant on each of the cells
   const Intrepid::FieldContainer<double> & getJacobian();
   const Intrepid::FieldContainer<double> & getJacobianDet();
   const Intrepid::FieldContainer<double> & getJacobianInv();
+  // the Jacobian as stored: (C,1,D,D) when cellsAreAffine(), (C,P,D,D) otherwise.  Unlike getJacobian(), never broadcasts.
+  const Intrepid::FieldContainer<double> & getCellJacobian();
   
   Intrepid::FieldContainer<double> computeParametricPoints();
   
@@ -7,6 +7,9 @@
 //
 #include "Teuchos_TestForException.hpp"
 
+#include <map>
+#include <vector>
+
 #include "Intrepid_Basis.hpp"
 //#include "Intrepid_HGRAD_QUAD_Cn_FEM.hpp"
 
@@ -57,6 +60,84 @@ namespace Camellia {
     return this->_basisCardinality;
   }
 
+  template<class Scalar, class ArrayScalar>
+  void Basis<Scalar,ArrayScalar>::getUniqueComponentPoints(const ArrayScalar &refPoints, int firstCoordinate, int numCoordinates,
+                                                           ArrayScalar &uniquePoints, std::vector<int> &pointOrdinalMap) const {
+    // bases are shared across the threads of threaded assembly, so each thread keeps its own cache
+    // key: (firstCoordinate, numCoordinates, number of points)
+    static std::map< std::vector<int>, UniqueComponentPoints > uniqueComponentPointsCache;
+#ifdef _OPENMP
+#pragma omp threadprivate(uniqueComponentPointsCache)
+#endif
+    std::vector<int> componentKey(3);
+    componentKey[0] = firstCoordinate;
+    componentKey[1] = numCoordinates;
+    componentKey[2] = refPoints.dimension(0);
+    int numValues = refPoints.size();
+    std::map< std::vector<int>, UniqueComponentPoints >::iterator cachedIt = uniqueComponentPointsCache.find(componentKey);
+    if ((cachedIt != uniqueComponentPointsCache.end()) && (cachedIt->second.refPoints.size() == numValues)) {
+      bool found = true;
+      for (int i=0; i<numValues; i++) {
+        if (cachedIt->second.refPoints[i] != refPoints[i]) {
+          found = false;
+          break;
+        }
+      }
+      if (found) {
+        const std::vector<double>* cachedUniquePoints = &cachedIt->second.uniquePoints;
+        int numComponentCoordinates = std::max(numCoordinates,1);
+        uniquePoints.resize(cachedUniquePoints->size() / numComponentCoordinates, numComponentCoordinates);
+        for (int i=0; i<cachedUniquePoints->size(); i++) {
+          uniquePoints[i] = (*cachedUniquePoints)[i];
+        }
+        pointOrdinalMap = cachedIt->second.pointOrdinalMap;
+        return;
+      }
+    }
+    
+    int numPoints = refPoints.dimension(0);
+    pointOrdinalMap.resize(numPoints);
+
+    // exact comparison is what we want here: tensor-product cubatures repeat component points verbatim
+    std::map< std::vector<Scalar>, int > uniquePointOrdinals;
+    std::vector< std::vector<Scalar> > uniquePointList;
+    std::vector<Scalar> componentPoint(numCoordinates);
+    for (int pointOrdinal=0; pointOrdinal<numPoints; pointOrdinal++) {
+      for (int d=0; d<numCoordinates; d++) {
+        componentPoint[d] = refPoints(pointOrdinal,firstCoordinate+d);
+      }
+      typename std::map< std::vector<Scalar>, int >::iterator foundIt = uniquePointOrdinals.find(componentPoint);
+      if (foundIt == uniquePointOrdinals.end()) {
+        int uniqueOrdinal = uniquePointList.size();
+        uniquePointOrdinals[componentPoint] = uniqueOrdinal;
+        uniquePointList.push_back(componentPoint);
+        pointOrdinalMap[pointOrdinal] = uniqueOrdinal;
+      } else {
+        pointOrdinalMap[pointOrdinal] = foundIt->second;
+      }
+    }
+
+    int numUniquePoints = uniquePointList.size();
+    uniquePoints.resize(numUniquePoints, std::max(numCoordinates,1)); // 0-dimensional components still get a (zero) coordinate
+    uniquePoints.initialize(0.0);
+    for (int uniqueOrdinal=0; uniqueOrdinal<numUniquePoints; uniqueOrdinal++) {
+      for (int d=0; d<numCoordinates; d++) {
+        uniquePoints(uniqueOrdinal,d) = uniquePointList[uniqueOrdinal][d];
+      }
+    }
+    
+    UniqueComponentPoints* entry = &uniqueComponentPointsCache[componentKey];
+    entry->refPoints.resize(numValues);
+    for (int i=0; i<numValues; i++) {
+      entry->refPoints[i] = refPoints[i];
+    }
+    entry->uniquePoints.resize(uniquePoints.size());
+    for (int i=0; i<uniquePoints.size(); i++) {
+      entry->uniquePoints[i] = uniquePoints[i];
+    }
+    entry->pointOrdinalMap = pointOrdinalMap;
+  }
+
   template<class Scalar, class ArrayScalar>
   int Basis<Scalar,ArrayScalar>::getDegree() const {
     return this->_basisDegree;
@@ -209,6 +209,9 @@ public:
   //! Take refPoints on reference cell, take as physical nodes the specified permutation of the reference cell points.  Permuted points are then the physical points mapped.
   static void permutedReferenceCellPoints(CellTopoPtr cellTopo, unsigned permutation, const FieldContainer<double> &refPoints, FieldContainer<double> &permutedPoints);
   
+  //! Returns true if the reference-to-physical map is affine (constant Jacobian) on every cell in cellWorkset: simplices, parallelograms and parallelepipeds
+  static bool cellsAreAffine(const FieldContainer<double> &cellWorkset, CellTopoPtr cellTopo);
+  
   //! Computes the Jacobian matrix DF of the reference-to-physical frame map
   static void setJacobian (FieldContainer<double> &jacobian, const FieldContainer<double> &points, const FieldContainer<double> &cellWorkset, CellTopoPtr cellTopo, const int &whichCell=-1);
   
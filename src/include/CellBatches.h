@@ -0,0 +1,55 @@
+//
+//  CellBatches.h
+//  Camellia
+//
+//
+
+#ifndef __Camellia__CellBatches__
+#define __Camellia__CellBatches__
+
+#include "Intrepid_FieldContainer.hpp"
+
+#include "BasisCache.h"
+#include "ElementType.h"
+#include "IndexType.h"
+#include "Mesh.h"
+
+#include <vector>
+
+//! The rank-local cells of one element type, split into batches that bound the memory used for per-cell work.
+/*!
+ Batch sizes are chosen so that doublesPerCell values per cell fit in MAX_BATCH_SIZE_IN_BYTES, with at least
+ MIN_BATCH_SIZE_IN_CELLS cells per batch.  Local stiffness, load, residual, and Riesz computations size their
+ batches this way; doublesPerCell should count the per-cell containers the caller allocates for a batch.
+
+ setBasisCache() only reads the batches, so several threads may set up their own BasisCaches concurrently.
+ */
+class CellBatches {
+  std::vector<GlobalIndexType> _cellIDs;
+  Intrepid::FieldContainer<double> _physicalCellNodes; // (C,V,D)
+  Intrepid::FieldContainer<double> _cellSideParities;  // (C,S)
+  int _maxCellBatch;
+public:
+  static const int MAX_BATCH_SIZE_IN_BYTES = 3*1024*1024; // 3 MB
+  static const int MIN_BATCH_SIZE_IN_CELLS = 1; // overrides the above, if it results in too-small batches
+
+  // the number of cells per batch when each cell needs doublesPerCell values
+  static int maxCellBatch(int doublesPerCell);
+
+  // when positive, maxCellsPerBatch further caps the batch size (e.g. to exercise multiple batches in tests)
+  CellBatches(MeshPtr mesh, ElementTypePtr elemType, int doublesPerCell, int maxCellsPerBatch = -1);
+
+  int numCells() const;
+  int numBatches() const;
+  int batchStart(int batchOrdinal) const; // ordinal of the batch's first cell among all the cells of the type
+  int batchSize(int batchOrdinal) const;
+
+  const std::vector<GlobalIndexType> & cellIDs() const; // all the cells of the type, in batch order
+  std::vector<GlobalIndexType> cellIDs(int batchOrdinal) const;
+  Intrepid::FieldContainer<double> cellSideParities(int batchOrdinal) const;
+
+  // sets the batch's physical cell nodes, cellIDs, and side parities on basisCache
+  void setBasisCache(int batchOrdinal, BasisCachePtr basisCache, bool createSideCache) const;
+};
+
+#endif /* defined(__Camellia__CellBatches__) */
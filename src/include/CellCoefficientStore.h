@@ -0,0 +1,88 @@
+//
+//  CellCoefficientStore.h
+//  Camellia
+//
+//
+
+#ifndef __Camellia__CellCoefficientStore__
+#define __Camellia__CellCoefficientStore__
+
+#include "Intrepid_FieldContainer.hpp"
+#include "Teuchos_RCP.hpp"
+
+#include "IndexType.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+//! Cell-local coefficients for a set of cells, stored in a single contiguous buffer.
+/*!
+ Each cell's coefficients occupy a contiguous range of the buffer; a cellID -> offset index locates them.
+ Overwriting a cell's coefficients with the same number of values happens in place; new cells, and cells
+ whose size changes, get fresh storage at the end of the buffer.  compact() repacks the buffer in cellID
+ order, reclaiming storage left behind by erase() and by resizing; Solution calls it after refinement and
+ repartitioning.
+
+ The containers returned by coefficients() are shallow views into the buffer.  Each cell keeps the same view
+ object for as long as it has coefficients; when the buffer moves (it grows, or is compacted) or the cell's
+ size changes, the view is pointed at the new storage.  References to a cell's coefficients therefore remain
+ valid, and see current values, until the cell is erased or the store is cleared or destroyed.  The views are
+ const: resizing or assigning a differently-shaped container through one would silently detach it from the
+ buffer.  Writes go through coefficientValues() or setCoefficients().
+ */
+class CellCoefficientStore {
+  // a rank-1 FieldContainer over storage it does not own, which can be pointed elsewhere in place
+  class CoefficientView : public Intrepid::FieldContainer<double> {
+  public:
+    void setData(double* data, int size);
+  };
+
+  struct Entry {
+    int offset;
+    int size;
+    Teuchos::RCP<CoefficientView> view; // shallow, into _values; owned by this store, not shared with copies
+  };
+
+  std::vector<double> _values;
+  std::map<GlobalIndexType, Entry> _entries;
+  int _unusedValueCount; // values left behind by erase() or by resizing; reclaimed by compact()
+
+  Entry & allocate(GlobalIndexType cellID, int size);
+  void createViews(); // fresh view objects for all entries, as after copying another store's entries
+  void updateView(Entry &entry);
+  void updateViews();
+public:
+  CellCoefficientStore();
+  CellCoefficientStore(const CellCoefficientStore &other);
+  CellCoefficientStore & operator=(const CellCoefficientStore &other);
+
+  void clear();
+  void compact();
+
+  bool hasCoefficients(GlobalIndexType cellID) const;
+  int numCells() const;
+  std::vector<GlobalIndexType> cellIDs() const; // in increasing order
+
+  // returns an empty container if no coefficients are stored for cellID
+  const Intrepid::FieldContainer<double> & coefficients(GlobalIndexType cellID) const;
+
+  // returns a pointer to cellID's numCoefficients values, allocating zero-valued storage if none exists or if it has a
+  // different size.  The pointer is valid until the store next allocates, erases, or compacts.
+  double* coefficientValues(GlobalIndexType cellID, int numCoefficients);
+
+  // batched gather: for each cellID, a pointer to its coefficients (NULL if none are stored), and their count
+  void getCoefficientPointers(const std::vector<GlobalIndexType> &cellIDs,
+                              std::vector<const double*> &coefficientPointers, std::vector<int> &coefficientCounts) const;
+
+  void setCoefficients(GlobalIndexType cellID, const Intrepid::FieldContainer<double> &coefficients);
+  void erase(GlobalIndexType cellID);
+
+  // true if other stores exactly the cells in cellIDs at the same offsets and sizes as this does
+  bool hasSameLayout(const CellCoefficientStore &other, const std::set<GlobalIndexType> &cellIDs) const;
+
+  // this += weight * other, over the whole buffer; requires hasSameLayout(other, ...)
+  void add(double weight, const CellCoefficientStore &other);
+};
+
+#endif /* defined(__Camellia__CellCoefficientStore__) */
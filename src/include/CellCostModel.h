@@ -0,0 +1,44 @@
+//
+//  CellCostModel.h
+//  Camellia
+//
+//
+
+#ifndef Camellia_CellCostModel_h
+#define Camellia_CellCostModel_h
+
+#include "Teuchos_RCP.hpp"
+
+#include "IndexType.h"
+
+#include <map>
+
+class Mesh;
+class Solution;
+
+class CellCostModel;
+typedef Teuchos::RCP<CellCostModel> CellCostModelPtr;
+
+//! Estimates the relative cost of each active cell, for use as partition weights (see MeshPartitionPolicy::setCellCostModel()).
+class CellCostModel {
+public:
+  virtual ~CellCostModel() {}
+
+  //! Costs for all of the mesh's active cells.  Collective; the result is the same on every rank.
+  virtual std::map<GlobalIndexType, double> cellCosts(Mesh *mesh) = 0;
+
+  //! Flop count for the local DPG solve: Cholesky factorization of the Gram matrix, the solve for the optimal test
+  //! functions, and the product that forms the local stiffness matrix.
+  static double localSolveCost(int numTrialDofs, int numTestDofs);
+
+  //! Cost of each cell is localSolveCost() for its element type.
+  static CellCostModelPtr dofCountCostModel();
+
+  //! Cost of each cell is its local stiffness time in the solution's last full assembly (see Solution::localStiffnessTimes()).
+  //! Cells without a measurement, e.g. those created by refinement since, are estimated by the DOF-count model, scaled to
+  //! agree with the measured cells.  Nothing is measured while the BF's stiffness cache is on, and load-only solves keep
+  //! the previous measurements.  The model holds the solution weakly; once it is destroyed, the DOF-count model is used.
+  static CellCostModelPtr measuredCostModel(Teuchos::RCP<Solution> solution);
+};
+
+#endif
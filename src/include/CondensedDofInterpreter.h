@@ -50,11 +50,45 @@ private:
   
   map<GlobalIndexType, GlobalIndexType> _interpretedToGlobalDofIndexMap; // maps from the interpreted dof indices to the new ("outer") global dof indices (we only store the ones that are seen by the local MPI rank)
   
-  void getSubmatrices(set<int> fieldIndices, set<int> fluxIndices,
-                      const FieldContainer<double> &K, Epetra_SerialDenseMatrix &K_field,
+  // Cholesky factor of the field block D and D^{-1} B, kept from the condensation pass so that field recovery
+  // (interpretGlobalCoefficients) and load-only condensation need no further factorization.
+  struct FieldBlockFactorization {
+    FieldContainer<double> factor;   // (1,N,N) and (1,N), as computed by SerialDenseWrapper::factorSPDSystems()
+    FieldContainer<double> scaling;
+    Epetra_SerialDenseMatrix DinvB;  // fieldCount x fluxCount
+  };
+  bool _cacheFieldBlockFactorizations;
+  map<GlobalIndexType, FieldBlockFactorization> _fieldBlockFactorizations;
+  
+  static bool factorFieldBlock(const Epetra_SerialDenseMatrix &D, FieldBlockFactorization &factorization); // returns false if D is not SPD
+  static void solveFieldBlock(const FieldBlockFactorization &factorization, Epetra_SerialDenseMatrix &B); // overwrites B with D^{-1} B
+  
+  // local dof indices of the condensible (field) and uncondensible (flux) dofs, computed once per trial ordering
+  struct FieldFluxPartition {
+    vector<int> fieldIndices, fluxIndices;
+  };
+  map<DofOrdering*, FieldFluxPartition> _fieldFluxPartitions;
+  const FieldFluxPartition & fieldFluxPartition(DofOrderingPtr trialOrder);
+  
+  // for interpretGlobalCoefficients(): a rank-local map on the cell's interpreted (GDA) dofs, and the outer global dof
+  // index of each, in the map's local order (-1 for dofs that do not enter the global solve).  Built once per cell.
+  struct CellFluxDofIndices {
+    Teuchos::RCP<Epetra_Map> interpretedMap;
+    vector<GlobalIndexTypeToCast> globalDofIndices;
+  };
+  map<GlobalIndexType, CellFluxDofIndices> _cellFluxDofIndices;
+  const CellFluxDofIndices & cellFluxDofIndices(GlobalIndexType cellID); // requires _localInterpretedDofIndices[cellID]
+  
+  // K is row-major, numDofs x numDofs
+  void getSubmatrices(const vector<int> &fieldIndices, const vector<int> &fluxIndices,
+                      const double* K, int numDofs, Epetra_SerialDenseMatrix &K_field,
                       Epetra_SerialDenseMatrix &K_coupl, Epetra_SerialDenseMatrix &K_flux);
   
-  void getSubvectors(set<int> fieldIndices, set<int> fluxIndices, const FieldContainer<double> &b, Epetra_SerialDenseVector &b_field, Epetra_SerialDenseVector &b_flux);
+  void getSubvectors(const vector<int> &fieldIndices, const vector<int> &fluxIndices, const double* b, Epetra_SerialDenseVector &b_field, Epetra_SerialDenseVector &b_flux);
+  
+  // Schur complement of the local (uninterpreted) stiffness and load onto the flux dofs; safe to call concurrently for distinct cells
+  void condenseCell(GlobalIndexType cellID, const FieldFluxPartition &partition, const double* K, const double* b, int numDofs,
+                    Epetra_SerialDenseMatrix &K_flux, Epetra_SerialDenseVector &b_flux);
   
   void initializeGlobalDofIndices();
   map<GlobalIndexType, GlobalIndexType> interpretedFluxMapForPartition(PartitionIndexType partition, bool storeFluxDofIndices);
@@ -81,6 +115,16 @@ public:
   void interpretLocalData(GlobalIndexType cellID, const FieldContainer<double> &localStiffnessData, const FieldContainer<double> &localLoadData,
                           FieldContainer<double> &globalStiffnessData, FieldContainer<double> &globalLoadData, FieldContainer<GlobalIndexType> &globalDofIndices);
   
+  // Batched condensation, for assembly: cellIDs share trialOrder, localStiffness is (C,N,N), localLoad is (C,N).
+  // Each cell's data is replaced by its Schur complement onto the flux dofs (field rows and columns are zeroed).
+  // May be called concurrently for disjoint sets of cells; pass the results to interpretCondensedLocalData().
+  void condenseLocalData(const vector<GlobalIndexType> &cellIDs, DofOrderingPtr trialOrder,
+                         FieldContainer<double> &localStiffness, FieldContainer<double> &localLoad);
+  
+  // Interprets one cell's output from condenseLocalData(), producing the same global data as interpretLocalData() would for the uncondensed input.
+  void interpretCondensedLocalData(GlobalIndexType cellID, const FieldContainer<double> &condensedStiffness, const FieldContainer<double> &condensedLoad,
+                                   FieldContainer<double> &globalStiffnessData, FieldContainer<double> &globalLoadData, FieldContainer<GlobalIndexType> &globalDofIndices);
+  
   virtual void interpretLocalCoefficients(GlobalIndexType cellID, const FieldContainer<double> &localCoefficients, Epetra_MultiVector &globalCoefficients);
   
   void interpretLocalBasisCoefficients(GlobalIndexType cellID, int varID, int sideOrdinal, const FieldContainer<double> &basisCoefficients,
@@ -94,6 +138,11 @@ public:
   
   bool varDofsAreCondensible(int varID, int sideOrdinal, DofOrderingPtr dofOrdering);
   
+  // when set, interpretLocalData keeps each cell's field-block Cholesky factor and D^{-1} B, so that
+  // interpretGlobalCoefficients recovers the field dofs with a triangular solve and a matrix-vector product.
+  // Cells whose field block is not SPD fall back to the LU path.  Defaults to false.
+  void setCacheFieldBlockFactorizations(bool value);
+  
   void storeLoadForCell(GlobalIndexType cellID, const FieldContainer<double> &load);
   void storeStiffnessForCell(GlobalIndexType cellID, const FieldContainer<double> &stiffness);
   
@@ -48,6 +48,10 @@ public:
   //!! MPI-communicating method.  Must be called on all ranks.
   virtual std::set<GlobalIndexType> importGlobalIndicesForCells(const std::vector<GlobalIndexType> &cellIDs);
   
+  //!! Prepares whatever interpretLocalData() caches for the given cells.  Returns true if, afterward, interpretLocalData() may be
+  //!! called concurrently for distinct cells among these (until the mesh changes).  The default returns false.
+  virtual bool prepareForConcurrentInterpretation(const std::set<GlobalIndexType> &cellIDs) { return false; }
+  
   virtual ~DofInterpreter() {}
 };
 
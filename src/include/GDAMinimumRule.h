@@ -53,6 +53,28 @@ class GDAMinimumRule : public GlobalDofAssignment {
   map< GlobalIndexType, map<int, map<int, LocalDofMapperPtr> > > _dofMapperForVariableOnSideCache; // cellID --> side --> variable --> LocalDofMapper
   map< GlobalIndexType, SubCellDofIndexInfo> _ownedGlobalDofIndicesCache; // (cellID --> SubCellDofIndexInfo)
   
+  // the dofs a cell owns, relative to its first owned dof; like the constraints, independent of partitioning and of other cells' offsets
+  struct CellDofLayout {
+    IndexType ownedDofCount;
+    map<int, vector<IndexType> > dofOffsetsForVarID;
+    vector<IndexType> fluxDofOffsets;
+    vector<IndexType> traceDofOffsets;
+  };
+  map< GlobalIndexType, CellDofLayout > _cellDofLayoutCache;
+  map< GlobalIndexType, set<GlobalIndexType> > _cellsReferencingCell; // (cellID -> cells whose cached constraints name it as a constraining or owning cell)
+  
+  // rebuildLookups() keeps cached constraints and layouts for cells away from those changed since the last rebuild
+  set<GlobalIndexType> _cellsChangedSinceRebuild; // refined parents and their children; p-refined cells and their ancestors
+  bool _fullRebuildRequired;
+  MeshTopology* _meshTopologyAtRebuild; // if the topology has been swapped or refined behind our back, we rebuild from scratch
+  IndexType _expectedCellCount;
+  
+  const CellDofLayout &getCellDofLayout(GlobalIndexType cellID);
+  set<GlobalIndexType> cellsNearChangedCells();
+  set<GlobalIndexType> cellsReferencingCells(const set<GlobalIndexType> &cellIDs);
+  static set<GlobalIndexType> referencedCellIDs(const CellConstraints &constraints);
+  void invalidateCachesForCells(const set<GlobalIndexType> &cellIDs);
+  
   vector<unsigned> allBasisDofOrdinalsVector(int basisCardinality);
   
   void filterSubBasisConstraintData(set<unsigned> &basisDofOrdinals,vector<GlobalIndexType> &globalDofOrdinals,
@@ -111,12 +133,14 @@ public:
   void interpretLocalBasisCoefficients(GlobalIndexType cellID, int varID, int sideOrdinal, const FieldContainer<double> &basisCoefficients,
                                FieldContainer<double> &globalCoefficients, FieldContainer<GlobalIndexType> &globalDofIndices);
   void interpretGlobalCoefficients(GlobalIndexType cellID, FieldContainer<double> &localCoefficients, const Epetra_MultiVector &globalCoefficients);
+  bool prepareForConcurrentInterpretation(const set<GlobalIndexType> &cellIDs); // builds the cells' constraints and dof mappers
   IndexType localDofCount(); // local to the MPI node
 
   PartitionIndexType partitionForGlobalDofIndex( GlobalIndexType globalDofIndex );
   void printConstraintInfo(GlobalIndexType cellID);
   void printGlobalDofInfo();
   void rebuildLookups();
+  void requireFullRebuild(); // the next rebuildLookups() discards all cached constraints, layouts, and dof mappers
 };
 
 #endif /* defined(__Camellia_debug__GDAMinimumRule__) */
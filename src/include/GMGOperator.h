@@ -17,6 +17,7 @@
 
 #include "BasisReconciliation.h"
 #include "LocalDofMapper.h"
+#include "PhaseTimers.h"
 
 #include "Ifpack_Preconditioner.h"
 
@@ -26,13 +27,6 @@
 
 using namespace std;
 
-struct TimeStatistics {
-  double min;
-  double max;
-  double mean;
-  double sum;
-};
-
 class GMGOperator : public Epetra_Operator {
   bool _debugMode; // in debug mode, output verbose info about what we're doing on rank 0
   
@@ -48,9 +42,8 @@ class GMGOperator : public Epetra_Operator {
   bool _applySmoothingOperator; // almost always true; false for some tests
   BCPtr _bc;
 
-  TimeStatistics getStatistics(double timeValue) const;
-  
   Teuchos::RCP<Solver> _coarseSolver;
+  Teuchos::RCP<GMGOperator> _coarseOperator; // when set, replaces the direct coarse solve with a cycle on the next-coarser level
   
   mutable BasisReconciliation _br;
   mutable map< pair< pair<int,int>, RefinementBranch >, LocalDofMapperPtr > _localCoefficientMap; // pair(fineH1Order,coarseH1Order)
@@ -66,6 +59,11 @@ class GMGOperator : public Epetra_Operator {
   Teuchos::RCP<Epetra_CrsMatrix> _P; // prolongation operator
   
   Teuchos::RCP<Epetra_Operator> _smoother;
+  
+  Teuchos::RCP<Epetra_CrsMatrix> _fineStiffnessMatrix; // the matrix most recently passed to computeCoarseStiffnessMatrix()
+  
+  // Y = P * (approximate coarse inverse) * P^T * X
+  void applyCoarseCorrection(const Epetra_MultiVector &X, Epetra_MultiVector &Y) const;
 public: // promoted these two to public for testing purposes:
   LocalDofMapperPtr getLocalCoefficientMap(GlobalIndexType fineCellID) const;
   GlobalIndexType getCoarseCellID(GlobalIndexType fineCellID) const;
@@ -129,7 +127,7 @@ public:
   
   void constructLocalCoefficientMaps(); // we'll do this lazily if this is not called; this is mostly a way to separate out the time costs
   
-  void computeCoarseStiffnessMatrix(Epetra_CrsMatrix *fineStiffnessMatrix);
+  void computeCoarseStiffnessMatrix(Teuchos::RCP<Epetra_CrsMatrix> fineStiffnessMatrix); // V- and W-cycles keep fineStiffnessMatrix for residual computations
   
   Teuchos::RCP<Epetra_CrsMatrix> constructProlongationOperator(); // rows belong to the fine grid, columns to the coarse
   
@@ -206,6 +204,26 @@ public:
   //! set the coarse Solver
   void setCoarseSolver(SolverPtr coarseSolver);
   
+  //! Use a GMGOperator on the next-coarser level in place of the direct coarse solve.
+  /*! The coarse operator's fine mesh should be this operator's coarse mesh, and its fine DofInterpreter and
+   partition map should be those of getCoarseSolution().  Only the coarsest operator in such a chain needs a coarse Solver.
+   */
+  void setCoarseOperator(Teuchos::RCP<GMGOperator> coarseOperator);
+  
+  //! Returns the operator for the next-coarser level (null for a two-level operator).
+  Teuchos::RCP<GMGOperator> getCoarseOperator();
+  
+  //! how the smoother and coarse correction are combined on each level.
+  enum MultigridStrategy {
+    TWO_LEVEL, // additive: Y = P A_c^{-1} P^T X + S^{-1} X, with A_c^{-1} approximated by the coarse operator, if one is set
+    V_CYCLE,   // multiplicative: pre-smooth, one coarse cycle on the residual, post-smooth
+    W_CYCLE    // as V_CYCLE, but with two coarse cycles on each level
+  };
+  
+  //! sets the multigrid strategy on this level and all coarser levels.
+  void setMultigridStrategy(MultigridStrategy strategy);
+  MultigridStrategy getMultigridStrategy();
+  
   void setSchwarzFactorizationType(FactorType choice);
   
   enum SmootherChoice {
@@ -242,6 +260,7 @@ public:
   //! Returns the Solution object used in the coarse solve.
   SolutionPtr getCoarseSolution();
 private:
+  MultigridStrategy _multigridStrategy;
   SmootherChoice _smootherType;
   int _smootherOverlap;
   
@@ -41,12 +41,22 @@ class GMGSolver : public Solver {
   
   std::vector< int > _iterationCountLog; // each time solve() is called, we push_back the number of iterations we run
   
+  void initialize(int maxIters, double tol);
+  
   int solve(bool rebuildCoarseStiffness);
 public:
   GMGSolver(BCPtr zeroBCs, MeshPtr coarseMesh, IPPtr coarseIP, MeshPtr fineMesh, Teuchos::RCP<DofInterpreter> fineDofInterpreter,
             Epetra_Map finePartitionMap, int maxIters, double tol, Teuchos::RCP<Solver> coarseSolver, bool useStaticCondensation);
   GMGSolver(SolutionPtr fineSolution, MeshPtr coarseMesh, int maxIters, double tol, Teuchos::RCP<Solver> coarseSolver, bool useStaticCondensation);
   
+  // multilevel: coarseMeshes are ordered coarsest first; the last entry is the level just below fineSolution's mesh.
+  // coarseSolver is used only on coarseMeshes[0].
+  GMGSolver(SolutionPtr fineSolution, vector<MeshPtr> coarseMeshes, int maxIters, double tol, Teuchos::RCP<Solver> coarseSolver, bool useStaticCondensation);
+  
+  // coarse levels for the multilevel constructor (coarsest first).  Moving down from fineMesh: the fine topology with its
+  // H1 order halved down to coarsestH1Order, then successively fewer of the fine mesh's h-refinements, down to the root mesh.
+  static vector<MeshPtr> coarseMeshHierarchy(MeshPtr fineMesh, int coarsestH1Order = 1);
+  
   double condest();
   
   int iterationCount();
@@ -58,6 +68,8 @@ public:
   
   void setApplySmoothingOperator(bool applySmoothingOp);
   
+  void setMultigridStrategy(GMGOperator::MultigridStrategy strategy);
+  
   void setComputeConditionNumberEstimate(bool value);
   
   void setUseDiagonalScaling(bool value);
@@ -57,6 +57,8 @@ protected:
   
   unsigned _numPartitions;
   
+  int _dofAssignmentVersion; // incremented by rebuildLookups()
+  
   vector< Solution* > _registeredSolutions; // solutions that should be modified upon refinement (by subclasses--maximum rule has to worry about cell side upgrades, whereas minimum rule does not, so there's not a great way to do this in the abstract superclass.)
   
   void assignInitialElementType( GlobalIndexType cellID ); // this is the "natural" element type, before side modifications for constraints (when using maximum rule)
@@ -75,6 +77,9 @@ public:
                       bool enforceConformityLocally);
 
   GlobalIndexType activeCellOffset();
+  
+  // changes whenever global dofs are reassigned (refinement, repartitioning); lets clients tell when cached dof data is stale
+  int dofAssignmentVersion();
   Teuchos::RCP<Epetra_Map> getActiveCellMap();
   
   // ! copies
@@ -190,39 +190,69 @@ namespace Camellia {
   void LobattoHDIV_QuadBasis_separable<Scalar,ArrayScalar>::getValues(ArrayScalar &values, const ArrayScalar &refPoints, Intrepid::EOperator operatorType) const {
     this->CHECK_VALUES_ARGUMENTS(values,refPoints,operatorType);
     
-    ArrayScalar lobattoValues_x(_degree_x+1), lobattoValues_y(_degree_y+1);
-    ArrayScalar lobattoValues_dx(_degree_x+1), lobattoValues_dy(_degree_y+1);
+    // evaluate the 1D Lobatto polynomials once per distinct coordinate, rather than once per point
+    ArrayScalar xPoints, yPoints;
+    std::vector<int> xPointOrdinals, yPointOrdinals;
+    this->getUniqueComponentPoints(refPoints, 0, 1, xPoints, xPointOrdinals);
+    this->getUniqueComponentPoints(refPoints, 1, 1, yPoints, yPointOrdinals);
+    
+    int numPoints_x = xPoints.dimension(0), numPoints_y = yPoints.dimension(0);
+    ArrayScalar lobattoValues_x(numPoints_x,_degree_x+1), lobattoValues_y(numPoints_y,_degree_y+1);
+    ArrayScalar lobattoValues_dx(numPoints_x,_degree_x+1), lobattoValues_dy(numPoints_y,_degree_y+1);
 //    ArrayScalar lobattoValues_dx_dx(_degree_x+1), lobattoValues_dy_dy(_degree_y+1);
     
+    ArrayScalar lobattoValues_1D(_degree_x+1), lobattoValues_d_1D(_degree_x+1);
+    for (int xPointOrdinal=0; xPointOrdinal < numPoints_x; xPointOrdinal++) {
+      Lobatto<Scalar,ArrayScalar>::values(lobattoValues_1D,lobattoValues_d_1D, xPoints(xPointOrdinal,0),_degree_x,_conforming);
+      for (int i=0; i<_degree_x+1; i++) {
+        lobattoValues_x(xPointOrdinal,i) = lobattoValues_1D(i);
+        lobattoValues_dx(xPointOrdinal,i) = lobattoValues_d_1D(i);
+      }
+    }
+    lobattoValues_1D.resize(_degree_y+1);
+    lobattoValues_d_1D.resize(_degree_y+1);
+    for (int yPointOrdinal=0; yPointOrdinal < numPoints_y; yPointOrdinal++) {
+      Lobatto<Scalar,ArrayScalar>::values(lobattoValues_1D,lobattoValues_d_1D, yPoints(yPointOrdinal,0),_degree_y,_conforming);
+      for (int j=0; j<_degree_y+1; j++) {
+        lobattoValues_y(yPointOrdinal,j) = lobattoValues_1D(j);
+        lobattoValues_dy(yPointOrdinal,j) = lobattoValues_d_1D(j);
+      }
+    }
+    
+    // the scaling factors depend only on (i,j); compute them once
+    ArrayScalar divFreeScalingFactors(_degree_x+1,_degree_y+1), nonDivFreeScalingFactors(_degree_x+1,_degree_y+1);
+    for (int i=0; i<_degree_x+1; i++) {
+      for (int j=0; j<_degree_y+1; j++) {
+//        double divFreeScalingFactor = 2 * sqrt(_legendreL2normsSquared(i) * _legendreL2normsSquared(j));
+//        if (divFreeScalingFactor == 0) divFreeScalingFactor = 1;
+        divFreeScalingFactors(i,j) = sqrt(  _legendreL2normsSquared(i) * _lobattoL2normsSquared(j)
+                                          + _legendreL2normsSquared(j) * _lobattoL2normsSquared(i) );
+        nonDivFreeScalingFactors(i,j) = sqrt(4 *  ( _legendreL2normsSquared(i) * _legendreL2normsSquared(j) ));
+      }
+    }
+    
     int numPoints = refPoints.dimension(0);
     for (int pointIndex=0; pointIndex < numPoints; pointIndex++) {
-      double x = refPoints(pointIndex,0);
-      double y = refPoints(pointIndex,1);
+      int xPointOrdinal = xPointOrdinals[pointIndex];
+      int yPointOrdinal = yPointOrdinals[pointIndex];
       
-//      if (operatorType == Intrepid::OPERATOR_CURL) { // want second derivatives
-//        Lobatto<Scalar,ArrayScalar>::values(lobattoValues_x,lobattoValues_dx,lobattoValues_dx_dx, x,_degree_x,_conforming);
-//        Lobatto<Scalar,ArrayScalar>::values(lobattoValues_y,lobattoValues_dy,lobattoValues_dy_dy, y,_degree_y,_conforming);
-//      } else { // first derivatives suffice
-      Lobatto<Scalar,ArrayScalar>::values(lobattoValues_x,lobattoValues_dx, x,_degree_x,_conforming);
-      Lobatto<Scalar,ArrayScalar>::values(lobattoValues_y,lobattoValues_dy, y,_degree_y,_conforming);
-//      }
       for (int i=0; i<_degree_x+1; i++) {
+        double x_value = lobattoValues_x(xPointOrdinal,i);
+        double x_deriv = lobattoValues_dx(xPointOrdinal,i);
         for (int j=0; j<_degree_y+1; j++) {
           if ((j==0) && (i==0)) continue; // no (0,0) basis function
+          double y_value = lobattoValues_y(yPointOrdinal,j);
+          double y_deriv = lobattoValues_dy(yPointOrdinal,j);
           // first, set the divergence-free basis values
           int fieldIndex = dofOrdinalMap(i,j,true);
 
-//          double divFreeScalingFactor = 2 * sqrt(_legendreL2normsSquared(i) * _legendreL2normsSquared(j));
-//          if (divFreeScalingFactor == 0) divFreeScalingFactor = 1;
-          double divFreeScalingFactor = (  _legendreL2normsSquared(i) * _lobattoL2normsSquared(j)
-                                         + _legendreL2normsSquared(j) * _lobattoL2normsSquared(i) );
-          divFreeScalingFactor = sqrt(divFreeScalingFactor);
+          double divFreeScalingFactor = divFreeScalingFactors(i,j);
           
           switch (operatorType) {
             case Intrepid::OPERATOR_VALUE:
             {
-              values(fieldIndex,pointIndex,0) =  lobattoValues_x(i) * lobattoValues_dy(j) / divFreeScalingFactor;
-              values(fieldIndex,pointIndex,1) = -lobattoValues_dx(i) * lobattoValues_y(j) / divFreeScalingFactor;
+              values(fieldIndex,pointIndex,0) =  x_value * y_deriv / divFreeScalingFactor;
+              values(fieldIndex,pointIndex,1) = -x_deriv * y_value / divFreeScalingFactor;
             }
               break;
             case Intrepid::OPERATOR_DIV:
@@ -244,17 +274,16 @@ namespace Camellia {
             // now, set the non-divergence-free basis values:
             if ((i > 0) && (j > 0)) { // then there will be some non-divergence-free members
               fieldIndex = dofOrdinalMap(i,j,false);
-              double nonDivFreeScalingFactor = 4 *  ( _legendreL2normsSquared(i) * _legendreL2normsSquared(j) );
-              nonDivFreeScalingFactor = sqrt(nonDivFreeScalingFactor);
+              double nonDivFreeScalingFactor = nonDivFreeScalingFactors(i,j);
               // TODO: change back to the nonDivFreeScalingFactor--trying the divFreeScalingFactor to see if it affects mass matrix conditioning
 //              nonDivFreeScalingFactor = divFreeScalingFactor;
               switch (operatorType) {
                 case Intrepid::OPERATOR_VALUE:
-                  values(fieldIndex,pointIndex,0) = lobattoValues_x(i) * lobattoValues_dy(j) / nonDivFreeScalingFactor;
-                  values(fieldIndex,pointIndex,1) = lobattoValues_dx(i) * lobattoValues_y(j) / nonDivFreeScalingFactor;
+                  values(fieldIndex,pointIndex,0) = x_value * y_deriv / nonDivFreeScalingFactor;
+                  values(fieldIndex,pointIndex,1) = x_deriv * y_value / nonDivFreeScalingFactor;
                   break;
                 case Intrepid::OPERATOR_DIV:
-                  values(fieldIndex,pointIndex) = ( lobattoValues_dx(i) * lobattoValues_dy(j) + lobattoValues_dx(i) * lobattoValues_dy(j) ) / nonDivFreeScalingFactor;
+                  values(fieldIndex,pointIndex) = ( x_deriv * y_deriv + x_deriv * y_deriv ) / nonDivFreeScalingFactor;
                   break;
                   
 //                case Intrepid::OPERATOR_CURL: // the "2D" curl operator, with scalar range
@@ -153,36 +153,71 @@ namespace Camellia {
   void LobattoHGRAD_QuadBasis<Scalar,ArrayScalar>::getValues(ArrayScalar &values, const ArrayScalar &refPoints, Intrepid::EOperator operatorType) const {
     this->CHECK_VALUES_ARGUMENTS(values,refPoints,operatorType);
     
-    ArrayScalar lobattoValues_x(_degree_x+1), lobattoValues_y(_degree_y+1);
-    ArrayScalar lobattoValues_dx(_degree_x+1), lobattoValues_dy(_degree_y+1);
+    // evaluate the 1D Lobatto polynomials once per distinct coordinate, rather than once per point
+    // (on tensor-product cubatures, P points have only sqrt(P) distinct x and y coordinates)
+    ArrayScalar xPoints, yPoints;
+    std::vector<int> xPointOrdinals, yPointOrdinals;
+    this->getUniqueComponentPoints(refPoints, 0, 1, xPoints, xPointOrdinals);
+    this->getUniqueComponentPoints(refPoints, 1, 1, yPoints, yPointOrdinals);
+    
+    int numPoints_x = xPoints.dimension(0), numPoints_y = yPoints.dimension(0);
+    ArrayScalar lobattoValues_x(numPoints_x,_degree_x+1), lobattoValues_y(numPoints_y,_degree_y+1);
+    ArrayScalar lobattoValues_dx(numPoints_x,_degree_x+1), lobattoValues_dy(numPoints_y,_degree_y+1);
+    
+    ArrayScalar lobattoValues_1D(_degree_x+1), lobattoValues_d_1D(_degree_x+1);
+    for (int xPointOrdinal=0; xPointOrdinal < numPoints_x; xPointOrdinal++) {
+      Lobatto<Scalar,ArrayScalar>::values(lobattoValues_1D,lobattoValues_d_1D, xPoints(xPointOrdinal,0),_degree_x,_conforming);
+      for (int i=0; i<_degree_x+1; i++) {
+        lobattoValues_x(xPointOrdinal,i) = lobattoValues_1D(i);
+        lobattoValues_dx(xPointOrdinal,i) = lobattoValues_d_1D(i);
+      }
+    }
+    lobattoValues_1D.resize(_degree_y+1);
+    lobattoValues_d_1D.resize(_degree_y+1);
+    for (int yPointOrdinal=0; yPointOrdinal < numPoints_y; yPointOrdinal++) {
+      Lobatto<Scalar,ArrayScalar>::values(lobattoValues_1D,lobattoValues_d_1D, yPoints(yPointOrdinal,0),_degree_y,_conforming);
+      for (int j=0; j<_degree_y+1; j++) {
+        lobattoValues_y(yPointOrdinal,j) = lobattoValues_1D(j);
+        lobattoValues_dy(yPointOrdinal,j) = lobattoValues_d_1D(j);
+      }
+    }
+    
+    // the scaling factors depend only on (i,j); compute their inverses once
+    ArrayScalar inverseScalingFactors(_degree_x+1,_degree_y+1);
+    for (int i=0; i<_degree_x+1; i++) {
+      for (int j=0; j<_degree_y+1; j++) {
+        double scalingFactor = _legendreL2normsSquared(i) * _lobattoL2normsSquared(j)
+                             + _legendreL2normsSquared(j) * _lobattoL2normsSquared(i);
+        if (scalingFactor==0) scalingFactor = 1; // the (0,0) scaling factor will be 0 because we're scaling according to (grad e_ij, grad e_ij)--and e_00 = 1.
+        inverseScalingFactors(i,j) = 1.0 / sqrt(scalingFactor);
+      }
+    }
     
     int numPoints = refPoints.dimension(0);
     for (int pointIndex=0; pointIndex < numPoints; pointIndex++) {
-      double x = refPoints(pointIndex,0);
-      double y = refPoints(pointIndex,1);
+      int xPointOrdinal = xPointOrdinals[pointIndex];
+      int yPointOrdinal = yPointOrdinals[pointIndex];
       
-      Lobatto<Scalar,ArrayScalar>::values(lobattoValues_x,lobattoValues_dx, x,_degree_x,_conforming);
-      Lobatto<Scalar,ArrayScalar>::values(lobattoValues_y,lobattoValues_dy, y,_degree_y,_conforming);
       for (int i=0; i<_degree_x+1; i++) {
+        double x_value = lobattoValues_x(xPointOrdinal,i);
+        double x_deriv = lobattoValues_dx(xPointOrdinal,i);
         for (int j=0; j<_degree_y+1; j++) {
           int fieldIndex = dofOrdinalMap(i,j);
-          double scalingFactor = _legendreL2normsSquared(i) * _lobattoL2normsSquared(j)
-                               + _legendreL2normsSquared(j) * _lobattoL2normsSquared(i);
-//          cout << "scaling factor squared for " << i << " " << j << ": " << scalingFactor << endl;
-          if (scalingFactor==0) scalingFactor = 1; // the (0,0) scaling factor will be 0 because we're scaling according to (grad e_ij, grad e_ij)--and e_00 = 1.
-          scalingFactor = sqrt(scalingFactor);
+          double y_value = lobattoValues_y(yPointOrdinal,j);
+          double y_deriv = lobattoValues_dy(yPointOrdinal,j);
+          double inverseScalingFactor = inverseScalingFactors(i,j);
           
           switch (operatorType) {
             case Intrepid::OPERATOR_VALUE:
-              values(fieldIndex,pointIndex) = lobattoValues_x(i) * lobattoValues_y(j) / scalingFactor;
+              values(fieldIndex,pointIndex) = x_value * y_value * inverseScalingFactor;
               break;
             case Intrepid::OPERATOR_GRAD:
-              values(fieldIndex,pointIndex,0) = lobattoValues_dx(i) * lobattoValues_y(j) / scalingFactor;
-              values(fieldIndex,pointIndex,1) = lobattoValues_x(i) * lobattoValues_dy(j) / scalingFactor;
+              values(fieldIndex,pointIndex,0) = x_deriv * y_value * inverseScalingFactor;
+              values(fieldIndex,pointIndex,1) = x_value * y_deriv * inverseScalingFactor;
               break;
             case Intrepid::OPERATOR_CURL:
-              values(fieldIndex,pointIndex,0) =  lobattoValues_x(i) * lobattoValues_dy(j) / scalingFactor;
-              values(fieldIndex,pointIndex,1) = -lobattoValues_dx(i) * lobattoValues_y(j) / scalingFactor;
+              values(fieldIndex,pointIndex,0) =  x_value * y_deriv * inverseScalingFactor;
+              values(fieldIndex,pointIndex,1) = -x_deriv * y_value * inverseScalingFactor;
               break;
             default:
               TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,"Unsupported operatorType");
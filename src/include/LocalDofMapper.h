@@ -40,6 +40,16 @@ class LocalDofMapper { // maps a whole trial ordering
   
   FieldContainer<double> _localCoefficientsFitMatrix; // used for fitLocalCoefficients
   
+  // sparse representation of the (linear) local-to-global map, stored in compressed columns: the local dof with index j
+  // contributes weights[k] to the mapped ordinal globalOrdinals[k], for columnOffsets[j] <= k < columnOffsets[j+1]
+  struct LocalToGlobalOperator {
+    vector<unsigned> columnOffsets; // empty until built
+    vector<unsigned> globalOrdinals;
+    vector<double> weights;
+  };
+  LocalToGlobalOperator _localToGlobalOperator[2]; // index is fittableGlobalDofsOnly; built lazily by mapLocalDataMatrix()
+  const LocalToGlobalOperator & localToGlobalOperator(bool fittableGlobalDofsOnly);
+  
 public:
   LocalDofMapper(DofOrderingPtr dofOrdering, map< int, BasisMap > volumeMaps,
                  set<GlobalIndexType> fittableGlobalDofOrdinalsInVolume,
@@ -49,6 +59,7 @@ public:
                  int varIDToMap = -1, int sideOrdinalToMap = -1);
   
   FieldContainer<double> mapLocalData(const FieldContainer<double> &localData, bool fittableGlobalDofsOnly);
+  void prepareMatrixMapping(bool fittableGlobalDofsOnly); // builds the operator that matrix mapping caches, so that mapLocalData() no longer modifies the mapper
   void mapLocalDataSide(const FieldContainer<double> &localData, FieldContainer<double> &mappedData, bool fittableGlobalDofsOnly, int sideOrdinal);
   void mapLocalDataVolume(const FieldContainer<double> &localData, FieldContainer<double> &mappedData, bool fittableGlobalDofsOnly);
   
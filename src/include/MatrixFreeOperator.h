@@ -0,0 +1,157 @@
+//
+//  MatrixFreeOperator.h
+//  Camellia
+//
+//
+
+#ifndef __Camellia__MatrixFreeOperator__
+#define __Camellia__MatrixFreeOperator__
+
+#include "Epetra_Operator.h"
+#include "Epetra_FEVector.h"
+#include "Epetra_Import.h"
+#include "Epetra_Map.h"
+
+#include "BasisCache.h"
+#include "CellBatches.h"
+#include "DofInterpreter.h"
+#include "ElementType.h"
+#include "Solution.h"
+
+#include <map>
+#include <vector>
+
+using namespace std;
+
+//! Applies the global DPG stiffness matrix of a Solution without assembling it.
+/*!
+ Apply() gathers each rank-local cell's coefficients through the Solution's DofInterpreter, multiplies by the cell's
+ local stiffness matrix, and scatters the result back.  By default, the local stiffness matrices are recomputed
+ a batch of cells at a time on each application (see CellBatches), so that memory use does not grow with the mesh.
+ Alternatively, they may be kept; since DPG stiffness matrices are symmetric, only the upper triangle of each is
+ stored, one (C,N*(N+1)/2) container per element type.  Dirichlet BCs are imposed as in Solution::imposeBCs():
+ BC rows and columns act as the identity.
+
+ Static condensation, Lagrange constraints, and zero-mean constraints are not supported.
+ */
+class MatrixFreeOperator : public Epetra_Operator {
+  SolutionPtr _solution;
+  MeshPtr _mesh;
+  Teuchos::RCP<DofInterpreter> _dofInterpreter;
+
+  Epetra_Map _partitionMap;
+  Teuchos::RCP<Epetra_Map> _cellDofsMap; // the global dofs seen by rank-local cells (overlapping)
+  Teuchos::RCP<Epetra_Import> _cellDofsImporter; // from _partitionMap to _cellDofsMap
+
+  bool _storeLocalStiffness;
+  vector< ElementTypePtr > _elementTypes;
+  map< ElementType*, vector<GlobalIndexType> > _cellIDsForType;
+  map< ElementType*, FieldContainer<double> > _localStiffnessForType; // (C,N*(N+1)/2) packed upper triangles, in the order of _cellIDsForType; empty unless _storeLocalStiffness
+
+  vector<GlobalIndexTypeToCast> _bcGlobalIndices; // rank-local Dirichlet dofs
+  vector<double> _bcGlobalValues;
+
+  Teuchos::RCP<Epetra_FEVector> _rhsVector; // with BCs imposed
+  mutable Teuchos::RCP<Epetra_MultiVector> _diag;
+
+  // the batches in which the rank-local cells of the given type are computed; their order matches _cellIDsForType
+  CellBatches cellBatches(ElementTypePtr elemType) const;
+
+  // computes the (C,N,N) local stiffness and (C,N) load for one batch of cells
+  void computeBatchStiffnessAndLoad(ElementTypePtr elemType, const CellBatches &cellBatches, int batchOrdinal,
+                                    BasisCachePtr basisCache, BasisCachePtr ipBasisCache,
+                                    FieldContainer<double> &batchStiffness, FieldContainer<double> &batchLoad) const;
+
+  // packs the upper triangles of a batch's local stiffness matrices into _localStiffnessForType, starting at cellOffset
+  void storeBatchStiffness(ElementTypePtr elemType, int cellOffset, const FieldContainer<double> &batchStiffness);
+
+  // unpacks a stored local stiffness matrix into the (N,N) container cellStiffness
+  void getStoredCellStiffness(ElementTypePtr elemType, int cellOrdinal, FieldContainer<double> &cellStiffness) const;
+
+  // Y = A * X for the global matrix A before BC imposition; X must be defined on _partitionMap
+  void applyWithoutBCs(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const;
+
+  void initializeRHS(const map< ElementType*, FieldContainer<double> > &localLoadForType);
+public:
+  //! @name Constructor
+  //@{
+  //! Computes the local stiffness matrices and the load vector for the Solution's current mesh, BC, RHS, and IP.
+  /*!
+   \param In
+   solution - the Solution whose system we apply.
+   \param In
+   storeLocalStiffness - if true, keep the upper triangles of the local stiffness matrices; otherwise, recompute them on every Apply().
+   */
+  MatrixFreeOperator(SolutionPtr solution, bool storeLocalStiffness = false);
+  //@}
+
+  //! @name Destructor
+  //@{
+  //! Destructor
+  ~MatrixFreeOperator() {}
+  //@}
+
+  //! Returns the load vector, with BCs imposed as in Solution::imposeBCs().
+  Teuchos::RCP<Epetra_FEVector> getRHSVector();
+
+  //! Returns the diagonal of the (BC-imposed) stiffness matrix; suitable for GMGOperator::setStiffnessDiagonal().
+  Teuchos::RCP<Epetra_MultiVector> getDiagonal() const;
+
+  //! Sets the Dirichlet BC entries of the vector to their imposed values.
+  void imposeBCValues(Epetra_MultiVector &vector) const;
+
+  //! Returns true if the local stiffness matrices are stored, false if they are recomputed on each Apply().
+  bool storesLocalStiffness() const;
+
+  //! @name Attribute set methods
+  //@{
+
+  //! Transpose is not supported; returns -1.
+  int SetUseTranspose(bool UseTranspose);
+  //@}
+
+  //! @name Mathematical functions
+  //@{
+
+  //! Returns the result of a Epetra_Operator applied to a Epetra_MultiVector X in Y.
+  /*!
+   \param In
+   X - A Epetra_MultiVector of dimension NumVectors to multiply with matrix.
+   \param Out
+   Y -A Epetra_MultiVector of dimension NumVectors containing result.
+
+   \return Integer error code, set to 0 if successful.
+   */
+  int Apply(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const;
+
+  //! Not supported; returns -1.
+  int ApplyInverse(const Epetra_MultiVector& X, Epetra_MultiVector& Y) const;
+
+  //! Not supported.
+  double NormInf() const;
+  //@}
+
+  //! @name Attribute access functions
+  //@{
+
+  //! Returns a character string describing the operator
+  const char * Label() const;
+
+  //! Returns the current UseTranspose setting.
+  bool UseTranspose() const;
+
+  //! Returns true if the \e this object can provide an approximate Inf-norm, false otherwise.
+  bool HasNormInf() const;
+
+  //! Returns a pointer to the Epetra_Comm communicator associated with this operator.
+  const Epetra_Comm & Comm() const;
+
+  //! Returns the Epetra_Map object associated with the domain of this operator.
+  const Epetra_Map & OperatorDomainMap() const;
+
+  //! Returns the Epetra_Map object associated with the range of this operator.
+  const Epetra_Map & OperatorRangeMap() const;
+  //@}
+};
+
+#endif /* defined(__Camellia__MatrixFreeOperator__) */
@@ -281,6 +281,7 @@ public:
                                        FieldContainer<double> &globalCoefficients, FieldContainer<GlobalIndexType> &globalDofIndices);
   void interpretLocalData(GlobalIndexType cellID, const FieldContainer<double> &localData,
                           FieldContainer<double> &globalData, FieldContainer<GlobalIndexType> &globalDofIndices);
+  bool prepareForConcurrentInterpretation(const set<GlobalIndexType> &cellIDs);
   
   bool meshUsesMaximumRule();
   bool meshUsesMinimumRule();
@@ -18,14 +18,27 @@ typedef Teuchos::RCP<MeshPartitionPolicy> MeshPartitionPolicyPtr;
 using namespace Intrepid;
 
 #include "Mesh.h"
+#include "CellCostModel.h"
 
 class MeshPartitionPolicy {
+protected:
+  CellCostModelPtr _cellCostModel; // null: all cells have equal weight
+
+  // assigns each cell, in the order given, to the partition containing the midpoint of its share of the total weight,
+  // so that partitions are contiguous in that order and have (approximately) equal weight
+  static std::vector< std::set<GlobalIndexType> > splitByWeight(const std::vector<GlobalIndexType> &orderedCellIDs,
+                                                                const std::vector<double> &weights, PartitionIndexType numPartitions);
 public:
   virtual ~MeshPartitionPolicy() {}
   virtual void partitionMesh(Mesh *mesh, PartitionIndexType numPartitions);
+
+  // when set, partitions balance the modeled (or measured) cost of their cells rather than the cell count
+  void setCellCostModel(CellCostModelPtr cellCostModel);
+  CellCostModelPtr getCellCostModel();
   
   static MeshPartitionPolicyPtr standardPartitionPolicy(); // aims to balance across all MPI ranks; present implementation uses Zoltan
   static MeshPartitionPolicyPtr oneRankPartitionPolicy(int rank=0); // all cells belong to the rank specified
+  static MeshPartitionPolicyPtr spaceFillingCurvePartitionPolicy(); // Hilbert-curve ordering of cell centroids; does not require Zoltan
 };
 
 #endif
@@ -36,31 +36,63 @@ typedef Teuchos::RCP<Cell> CellPtr;
 class MeshTopology {
   unsigned _spaceDim; // dimension of the mesh
   
-  map< vector<double>, IndexType > _vertexMap; // maps into indices in the vertices list -- here just for vertex identification (i.e. so we don't add the same vertex twice)
-  vector< vector<double> > _vertices; // vertex locations
+  vector<double> _vertexCoordinates; // vertex locations, stored flat: (vertexIndex, d)
+  
+  // spatial hash for vertex identification (i.e. so we don't add the same vertex twice).  Vertices are binned into grid
+  // cells of width _vertexHashCellWidth, which is set from the vertices' bounding box and count each time the hash is rebuilt
+  // (about one vertex per grid cell), but never below _vertexHashMinCellWidth, the largest tolerance requested so far;
+  // each hash bucket heads a linked list threaded through _vertexHashNext.
+  double _vertexHashCellWidth;
+  double _vertexHashMinCellWidth;
+  vector<IndexType> _vertexHashBucketHeads; // first vertex in each bucket, or -1; size is a power of 2
+  vector<IndexType> _vertexHashNext; // next vertex in the same bucket, or -1; one entry per vertex
   
   vector< PeriodicBCPtr > _periodicBCs;
   map<IndexType, set< pair<int, int> > > _periodicBCIndicesMatchingNode; // pair: first = index in _periodicBCs; second: 0 or 1, indicating first or second part of the identification matches.  IndexType is the vertex index.
   map< pair<IndexType, pair<int,int> >, IndexType > _equivalentNodeViaPeriodicBC;
   
   // the following entity vectors are indexed on dimension of the entities
-  vector< vector< vector<IndexType> > > _entities; // vertices, edges, faces, solids, etc., up to dimension (_spaceDim - 1).  Innermost container is sorted by value of IndexType (nodes). The outer two indices are entityDim, entityIndex.
-  vector< map< vector<IndexType>, IndexType > > _knownEntities; // map keys are vectors of sorted vertex indices, values are entity indices in _entities[d]
-  vector< vector< vector<IndexType> > > _canonicalEntityOrdering;
+  // entities of dimension 1 through (_spaceDim - 1) are stored compressed-sparse-row style: the vertices of entity entityIndex, in canonical
+  // order, are _entityVertices[d][_entityVertexOffsets[d][entityIndex]] up to (not including) _entityVertices[d][_entityVertexOffsets[d][entityIndex+1]].
+  // Vertices (d = 0) are implicit: a vertex's entity index is its vertex index.
+  vector< vector<IndexType> > _entityVertexOffsets;
+  vector< vector<IndexType> > _entityVertices;
+  // hashed lookup from sorted vertex indices to entity index; each bucket heads a linked list threaded through _entityHashNext[d]
+  vector< vector<IndexType> > _entityHashBucketHeads; // size is a power of 2; -1 marks an empty bucket
+  vector< vector<IndexType> > _entityHashNext;
   vector< vector< vector< pair<IndexType, unsigned> > > > _activeCellsForEntities; // inner vector entries are sorted (cellIndex, entityIndexInCell) (entityIndexInCell aka subcord)--I'm vascillating on whether this should contain entries for active ancestral cells.  Today, I think it should not.  I think we should have another set of activeEntities.  Things in that list either themselves have active cells or an ancestor that has an active cell.  So if your parent is inactive and you don't have any active cells of your own, then you know you can deactivate.
   vector< vector< vector<IndexType> > > _sidesForEntities; // vector indices: dimension d, entity index; innermost container stores entity indices of dimension _spaceDim-1 belonging to cells that contain the indicated entity, sorted by index.
-  map< IndexType, pair< pair<IndexType, unsigned>, pair<IndexType, unsigned> > > _cellsForSideEntities; // key: sideEntityIndex.  value.first is (cellIndex1, sideOrdinal1), value.second is (cellIndex2, sideOrdinal2).  On initialization, (cellIndex2, sideOrdinal2) == ((IndexType)-1,(IndexType)-1).
+  vector< pair< pair<IndexType, unsigned>, pair<IndexType, unsigned> > > _cellsForSideEntities; // index: sideEntityIndex.  value.first is (cellIndex1, sideOrdinal1), value.second is (cellIndex2, sideOrdinal2).  On initialization, (cellIndex2, sideOrdinal2) == ((IndexType)-1,(IndexType)-1); sides without cells have cellIndex1 == (IndexType)-1.
   set<IndexType> _boundarySides; // entities of dimension _spaceDim-1 on the mesh boundary
-  vector< map< IndexType, vector< pair<IndexType, unsigned> > > > _parentEntities; // map from entity to its possible parents.  Not every entity has a parent.  We support entities having multiple parents.  Such things will be useful in the context of anisotropic refinements.  The pair entries here are (parentEntityIndex, refinementOrdinal), where the refinementOrdinal is the index into the _childEntities[d][parentEntityIndex] vector.
   
   vector< map< IndexType, pair<IndexType, unsigned> > > _generalizedParentEntities; // map from entity to its nearest generalized parent.  map entries are (parentEntityIndex, parentEntityDimension).  Generalized parents may be higher-dimensional or equal-dimensional to the child entity.
-  vector< map< IndexType, vector< pair< RefinementPatternPtr, vector<IndexType> > > > > _childEntities; // map from parent to child entities, together with the RefinementPattern to get from one to the other.
+  // parent-child relations for entities of dimension 1 through (_spaceDim - 1).  Each entity has at most one parent, and each refined
+  // entity one recorded refinement.  The children of a refinement are stored contiguously in _refinedEntityChildren[d], in the
+  // order the refinements were made; per-entity tables are indexed by entity index, are grown as needed, and hold -1 for "none".
+  struct EntityRefinement {
+    RefinementPatternPtr refPattern;
+    IndexType childOffset; // first child is _refinedEntityChildren[d][childOffset]
+    IndexType childCount;
+  };
+  vector< vector<IndexType> > _entityParents; // (d, entityIndex) -> parent entity index
+  vector< vector<IndexType> > _entityRefinementOrdinals; // (d, entityIndex) -> index into _entityRefinements[d]
+  vector< vector<EntityRefinement> > _entityRefinements;
+  vector< vector<IndexType> > _refinedEntityChildren;
   vector< vector< Camellia::CellTopologyKey > > _entityCellTopologyKeys;
   
   vector< CellPtr > _cells;
   set< IndexType > _activeCells;
   set< IndexType > _rootCells; // cells without parents
   
+  // uniform grid over the vertex bounding boxes of the root cells, used by cellIDsForPoints() to find candidate root cells.
+  // Built lazily; _rootCellGridBinOffsets is empty when the grid needs to be (re)built.
+  vector<IndexType> _rootCellGridCellIndices; // root ordinal --> cellIndex
+  vector<double> _rootCellGridBoxes; // (root ordinal, 2 * spaceDim): box min coordinates followed by box max coordinates
+  vector<double> _rootCellGridMin, _rootCellGridBinWidth;
+  vector<int> _rootCellGridBinCounts;
+  vector<IndexType> _rootCellGridBinOffsets; // CSR offsets into _rootCellGridBinEntries, one per bin plus one
+  vector<IndexType> _rootCellGridBinEntries; // root ordinals
+  
   // these guys presently only support 2D:
   set< IndexType > _cellIDsWithCurves;
   map< pair<IndexType, IndexType>, ParametricCurvePtr > _edgeToCurveMap;
@@ -76,6 +108,9 @@ class MeshTopology {
   void addEdgeCurve(pair<IndexType,IndexType> edge, ParametricCurvePtr curve);
 //  IndexType addEntity(const shards::CellTopology &entityTopo, const vector<IndexType> &entityVertices, unsigned &entityPermutation); // returns the entityIndex
   IndexType addEntity(CellTopoPtr entityTopo, const vector<IndexType> &entityVertices, unsigned &entityPermutation); // returns the entityIndex
+  void addEntityToHash(unsigned d, IndexType entityIndex);
+  IndexType entityHashBucket(unsigned d, const vector<IndexType> &sortedVertices);
+  IndexType findEntity(unsigned d, const vector<IndexType> &sortedVertices); // returns -1 if no entity has these vertices
 
   void deactivateCell(CellPtr cell);
   set<IndexType> descendants(unsigned d, IndexType entityIndex);
@@ -86,6 +121,11 @@ class MeshTopology {
   void determineGeneralizedParentsForRefinement(CellPtr cell, RefinementPatternPtr refPattern);
   
   IndexType getVertexIndexAdding(const vector<double> &vertex, double tol);
+  void addVertexToHash(IndexType vertexIndex);
+  void rebuildVertexHash(IndexType numVertices); // resets the grid cell width and rehashes vertices [0, numVertices)
+  IndexType vertexHashBucket(const vector<long long> &gridCell);
+  long long vertexHashGridCoordinate(double x);
+  IndexType vertexCount() { return _vertexHashNext.size(); }
   vector<IndexType> getVertexIndices(const FieldContainer<double> &vertices);
   vector<IndexType> getVertexIndices(const vector< vector<double> > &vertices);
   map<unsigned, IndexType> getVertexIndicesMap(const FieldContainer<double> &vertices);
@@ -94,7 +134,10 @@ class MeshTopology {
   unsigned maxConstraint(unsigned d, IndexType entityIndex1, IndexType entityIndex2);
   void printVertex(IndexType vertexIndex);
   void printVertices(set<IndexType> vertexIndices);
-  void refineCellEntities(CellPtr cell, RefinementPatternPtr refPattern); // ensures that the appropriate child entities exist, and parental relationships are recorded in _parentEntities
+  void refineCellEntities(CellPtr cell, RefinementPatternPtr refPattern); // ensures that the appropriate child entities exist, and parental relationships are recorded in _entityParents
+  IndexType entityParent(unsigned d, IndexType entityIndex); // -1 if the entity has no parent
+  const EntityRefinement* entityRefinement(unsigned d, IndexType entityIndex); // NULL if the entity has not been refined
+  vector<IndexType> entityRefinementChildren(unsigned d, const EntityRefinement* refinement);
   void setEntityGeneralizedParent(unsigned entityDim, IndexType entityIndex, unsigned parentDim, IndexType parentEntityIndex);
   
   GlobalDofAssignment* _gda; // for cubature degree lookups
@@ -103,6 +146,10 @@ class MeshTopology {
   
   void addSideForEntity(unsigned entityDim, IndexType entityIndex, IndexType sideEntityIndex); // maintains _sidesForEntities container
   
+  void buildRootCellGrid();
+  void getCellBoundingBox(IndexType cellIndex, vector<double> &boxMin, vector<double> &boxMax); // box is padded slightly to allow for round-off
+  int rootCellGridBinOrdinal(int d, double x); // clamped to the grid
+  
   // ! private method for deep-copying Cells during MeshToplogy::deepCopy()
   void deepCopyCells();
 public:
@@ -131,6 +178,7 @@ public:
   bool cellHasCurvedEdges(IndexType cellIndex);
   
   bool cellContainsPoint(GlobalIndexType cellID, const std::vector<double> &point, int cubatureDegree);
+  std::vector<bool> cellContainsPoints(GlobalIndexType cellID, const FieldContainer<double> &points, int cubatureDegree); // points: (P,D)
   std::vector<IndexType> cellIDsForPoints(const FieldContainer<double> &physicalPoints);
   
   bool entityIsAncestor(unsigned d, IndexType ancestor, IndexType descendent);
@@ -168,7 +216,8 @@ public:
   IndexType getSubEntityIndex(unsigned d, IndexType entityIndex, unsigned subEntityDim, unsigned subEntityOrdinal);
   unsigned getSubEntityPermutation(unsigned d, IndexType entityIndex, unsigned subEntityDim, unsigned subEntityOrdinal);
   bool getVertexIndex(const vector<double> &vertex, IndexType &vertexIndex, double tol=1e-14);
-  const vector<double>& getVertex(IndexType vertexIndex);
+  vector<double> getVertex(IndexType vertexIndex);
+  double getVertexCoordinate(IndexType vertexIndex, unsigned d) { return _vertexCoordinates[vertexIndex * _spaceDim + d]; }
   FieldContainer<double> physicalCellNodesForCell(unsigned cellIndex, bool includeCellDimension = false);
   void refineCell(IndexType cellIndex, RefinementPatternPtr refPattern);
   IndexType cellCount();
@@ -201,7 +250,7 @@ public:
   
   
   // ! This method exposed for the sake of tests
-  vector< pair<IndexType,unsigned> > getConstrainingSideAncestry(IndexType sideEntityIndex);   // pair: first is the sideEntityIndex of the ancestor; second is the refinementIndex of the refinement to get from parent to child (see _parentEntities and _childEntities)
+  vector< pair<IndexType,unsigned> > getConstrainingSideAncestry(IndexType sideEntityIndex);   // pair: first is the sideEntityIndex of the ancestor; second is the refinementIndex of the refinement to get from parent to child (see _entityParents and _entityRefinements)
   
   // ! Creates a new MeshTopology object containing only the root cells from this MeshTopology.
   Teuchos::RCP<MeshTopology> getRootMeshTopology();
@@ -0,0 +1,109 @@
+//
+//  PhaseTimers.h
+//  Camellia
+//
+//
+
+#ifndef __Camellia__PhaseTimers__
+#define __Camellia__PhaseTimers__
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+struct TimeStatistics {
+  double min;
+  double max;
+  double mean;
+  double sum;
+};
+
+//! Process-wide registry of nested, named phase timers.
+/*!
+ Phases are started and stopped in stack order; a phase started while another is running is recorded as its child,
+ so the same name may appear under several parents (e.g. "dof interpretation" under both "assembly" and "refinement").
+ Each phase accumulates its wall time and call count until clear() is called.  Use ScopedPhaseTimer where possible,
+ so that phases are stopped when an exception unwinds the stack.
+
+ Calls made inside an active OpenMP parallel region are ignored: the registry tracks the master thread's phases only,
+ and a phase that contains a threaded loop is charged the loop's wall time.
+
+ statistics(), report(), writeCSV(), writeJSON() and solveCompleted() are collective: each rank contributes its times,
+ and phases that only some ranks entered are reported with zero time on the others.
+ */
+class PhaseTimers {
+public:
+  enum ExportFormat {
+    CSV,
+    JSON_LINES // one JSON object per line, one line per solve
+  };
+
+  struct PhaseStatistics {
+    std::vector<std::string> path; // outermost phase first
+    TimeStatistics time;
+    double imbalance; // max / mean across ranks; 1.0 when perfectly balanced
+    int maxCallCount; // across ranks
+  };
+private:
+  struct Phase {
+    double totalTime;
+    int callCount;
+  };
+
+  std::map< std::vector<std::string>, Phase > _phases; // ordered so that each phase is followed by its children
+  std::vector<std::string> _activePath;
+  std::vector<double> _activeStartTimes;
+
+  std::string _exportFilePath;
+  ExportFormat _exportFormat;
+  int _solveOrdinal;
+
+  PhaseTimers();
+
+  std::vector< std::vector<std::string> > allRankPhasePaths() const;
+  static std::string pathString(const std::vector<std::string> &path);
+  void writeCSVRows(std::ostream &out, const std::vector<PhaseStatistics> &stats, int solveOrdinal) const;
+  void writeJSONObject(std::ostream &out, const std::vector<PhaseStatistics> &stats, int solveOrdinal) const;
+public:
+  static PhaseTimers* phaseTimers(); // shared, global instance
+
+  void start(const std::string &phaseName);
+  void stop(const std::string &phaseName); // also stops any phases started within phaseName that are still running
+
+  //! Discards recorded times; phases that are running continue, and are recorded when they stop.
+  void clear();
+
+  // local (this rank) values; pathString components are joined with '/', e.g. "solve/assembly"
+  double totalTime(const std::string &pathString) const;
+  int callCount(const std::string &pathString) const;
+
+  //! Cross-rank statistics for every phase entered on any rank, parents before children.  Collective.
+  std::vector<PhaseStatistics> statistics() const;
+
+  //! Prints the phase tree with min/mean/max/imbalance on rank 0.  Collective.
+  void report(std::ostream &out = std::cout) const;
+
+  //! Write the current statistics to a file on rank 0.  Collective.
+  void writeCSV(const std::string &filePath) const;
+  void writeJSON(const std::string &filePath) const;
+
+  //! When set, each solveCompleted() appends the statistics for that solve to filePath and then calls clear().
+  void setSolveExportFile(const std::string &filePath, ExportFormat format);
+
+  //! Called by Solution at the end of each solve.  Collective when an export file is set; otherwise does nothing.
+  void solveCompleted();
+
+  //! Cross-rank statistics for a single value.  Collective.
+  static TimeStatistics timeStatistics(double localValue);
+};
+
+//! Starts a phase on construction, and stops it on destruction.
+class ScopedPhaseTimer {
+  std::string _phaseName;
+public:
+  ScopedPhaseTimer(const std::string &phaseName);
+  ~ScopedPhaseTimer();
+};
+
+#endif /* defined(__Camellia__PhaseTimers__) */
@@ -0,0 +1,85 @@
+//
+//  ReferenceValueCache.h
+//  Camellia
+//
+//
+
+#ifndef __Camellia__ReferenceValueCache__
+#define __Camellia__ReferenceValueCache__
+
+#include "Intrepid_FieldContainer.hpp"
+#include "Teuchos_RCP.hpp"
+
+#include "Basis.h"
+#include "CamelliaIntrepidExtendedTypes.h"
+#include "CellTopology.h"
+
+#include <map>
+#include <vector>
+
+//! Process-wide cache of cubature rules and of basis values at reference cubature points.
+/*!
+ BasisCache instances memoize reference values per instance; this cache shares them across instances, so that
+ creating a new BasisCache (per solve, or per cell) doesn't re-evaluate the bases.  Entries are keyed by the
+ basis, the operator, and the point set: the cell topology, the cubature degree(s), the side ordinal (-1 for
+ volume points), and whether side points are expressed in side or volume coordinates.
+
+ Lookups and insertions are thread-safe (sharing values across threads requires Trilinos built with thread-safe
+ Teuchos::RCP reference counting, as threaded assembly in Solution does).  Values are returned as read-only RCPs
+ that share ownership with the cache, so they remain valid after clear().  Memory is bounded: once the stored values
+ reach maxMemoryInBytes(), new values are computed and returned but not stored; lowering the bound below the
+ current usage discards the stored values.
+ */
+class ReferenceValueCache {
+public:
+  struct PointSetKey {
+    Camellia::CellTopology::CellTopologyKey cellTopoKey;
+    int cubatureDegree; // -1 when cubatureDegrees is used
+    std::vector<int> cubatureDegrees;
+    int sideOrdinal; // -1 for volume points
+    bool sidePointsInVolumeCoordinates;
+
+    bool operator<(const PointSetKey &other) const;
+  };
+private:
+  typedef std::pair< std::pair<Camellia::Basis<>*, Camellia::EOperator>, PointSetKey > ValuesKey;
+  struct ValuesEntry {
+    BasisPtr basis; // keeps the basis alive, so that its address isn't reused for another basis
+    Teuchos::RCP< const Intrepid::FieldContainer<double> > values;
+  };
+  struct CubatureEntry {
+    Intrepid::FieldContainer<double> points;
+    Intrepid::FieldContainer<double> weights;
+  };
+
+  std::map< ValuesKey, ValuesEntry > _values;
+  std::map< PointSetKey, CubatureEntry > _cubatureRules; // sideOrdinal is always -1 in these keys
+
+  long long _memoryInBytes;
+  long long _maxMemoryInBytes;
+  long long _hitCount, _missCount;
+
+  ReferenceValueCache();
+public:
+  static ReferenceValueCache* referenceValueCache(); // shared, global instance
+
+  //! Returns the values of basis under op at points, which must be the point set identified by pointSetKey.
+  Teuchos::RCP< const Intrepid::FieldContainer<double> > getValues(BasisPtr basis, Camellia::EOperator op,
+                                                                   const PointSetKey &pointSetKey,
+                                                                   const Intrepid::FieldContainer<double> &points);
+
+  //! Fills points and weights with the cubature rule for cellTopo; pass cubatureDegree = -1 to use cubatureDegrees.
+  void getCubature(CellTopoPtr cellTopo, int cubatureDegree, const std::vector<int> &cubatureDegrees,
+                   Intrepid::FieldContainer<double> &points, Intrepid::FieldContainer<double> &weights);
+
+  //! Discards all entries, and resets the hit and miss counts.  Values already returned by getValues() remain valid.
+  void clear();
+
+  long long hitCount() const;
+  long long missCount() const;
+  long long memoryInBytes() const;
+  long long maxMemoryInBytes() const;
+  void setMaxMemoryInBytes(long long maxMemory);
+};
+
+#endif /* defined(__Camellia__ReferenceValueCache__) */
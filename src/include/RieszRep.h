@@ -46,6 +46,22 @@ class RieszRep {
   LinearTermPtr _functional;  // the RHS stuff here and below is misnamed -- should just be called functional
   bool _printAll;
   bool _repsNotComputed;
+  
+  // Gram matrix factorizations for one batch of rank-local cells of a single element type
+  struct GramFactorBatch {
+    ElementTypePtr elemType;
+    vector<GlobalIndexType> cellIDs;
+    FieldContainer<double> factors; // (C,N,N), from SerialDenseWrapper::factorSPDSystems()
+    FieldContainer<double> scaling; // (C,N)
+    vector<int> failedCellOrdinals; // cells whose Gram matrix could not be Cholesky-factored; these are solved by QR
+    map<int, FieldContainer<double> > gramMatricesForFailedCells; // (N,N) Gram matrix for each failed cell ordinal
+  };
+  bool _cacheGramFactorizations;
+  int _gramFactorCubatureEnrichment;
+  vector<GramFactorBatch> _gramFactorBatches; // kept between calls to computeRieszRep() when _cacheGramFactorizations is set
+  int _maxCellsPerBatch; // -1 to size batches by memory alone
+  
+  bool gramFactorizationsMatchMesh(int cubatureEnrichment);
  
  public:
   RieszRep(MeshPtr mesh, IPPtr ip, LinearTermPtr functional){
@@ -54,6 +70,9 @@ class RieszRep {
     _functional = functional;
     _printAll = false;
     _repsNotComputed = true;
+    _cacheGramFactorizations = false;
+    _gramFactorCubatureEnrichment = 0;
+    _maxCellsPerBatch = -1;
   }
 
   void setPrintOption(bool printAll){
@@ -72,6 +91,16 @@ class RieszRep {
   map<GlobalIndexType,FieldContainer<double> > integrateFunctional();
 
   void computeRieszRep(int cubatureEnrichment=0);
+  
+  // ! When set, the Gram matrix factorizations are kept between calls to computeRieszRep(), so that recomputing the
+  // ! representation of a new functional costs only its integration and the back-solves.  The factorizations are
+  // ! discarded automatically when the rank-local cells or their element types change; call clearGramFactorizations()
+  // ! if the IP or the mesh geometry is modified in place.
+  void setCacheGramFactorizations(bool value);
+  void clearGramFactorizations();
+
+  // ! Caps the number of cells per batch (beyond the usual memory bound); -1, the default, sets no cap.
+  void setMaxCellsPerBatch(int value);
 
   double getNorm();
 
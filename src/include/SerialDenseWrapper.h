@@ -8,6 +8,8 @@
 #ifndef SerialDenseWrapper_h
 #define SerialDenseWrapper_h
 
+#include <vector>
+
 #include "Intrepid_FieldContainer.hpp"
 
 #include "Epetra_SerialDenseMatrix.h"
@@ -70,6 +72,47 @@ class SerialDenseWrapper {
       }
     }
   }
+  
+  // the single equilibrated Cholesky path behind the SPD batch solves: we factor S A S = L L^T, where S = diag(1/sqrt(A_ii)),
+  // and solve A x = b as x = S (S A S)^{-1} S b.  A is N x N (symmetric, so the storage order does not matter); factor and
+  // scaling are written on output.  Returns 0 on success, -1 for a nonpositive diagonal, or the POTRF error code.
+  static int factorSPDSystem(double *factor, double *scaling, const double *A, int N) {
+    for (int i=0; i<N; i++) {
+      double diag = A[i*N + i];
+      if (diag <= 0.0) return -1;
+      scaling[i] = 1.0 / sqrt(diag);
+    }
+    for (int i=0; i<N; i++) {
+      for (int j=0; j<N; j++) {
+        factor[i*N + j] = scaling[i] * A[i*N + j] * scaling[j];
+      }
+    }
+    Teuchos::LAPACK<int, double> lapack;
+    int err;
+    lapack.POTRF('L', N, factor, N, &err);
+    return err;
+  }
+  
+  // solves with the output of factorSPDSystem(); b is N x nRHS in row-major order, and xTranspose (nRHS x N, row-major) is
+  // X in column-major order.  Returns 0 on success, or the POTRS error code.
+  static int solveFactoredSPDSystemTransposed(double *xTranspose, const double *factor, const double *scaling,
+                                              const double *b, int N, int nRHS) {
+    for (int i=0; i<N; i++) {
+      for (int j=0; j<nRHS; j++) {
+        xTranspose[j*N + i] = scaling[i] * b[i*nRHS + j];
+      }
+    }
+    Teuchos::LAPACK<int, double> lapack;
+    int err;
+    lapack.POTRS('L', N, nRHS, factor, N, xTranspose, N, &err);
+    if (err != 0) return err;
+    for (int j=0; j<nRHS; j++) {
+      for (int i=0; i<N; i++) {
+        xTranspose[j*N + i] *= scaling[i];
+      }
+    }
+    return 0;
+  }
 public:
   // gives X = scalarA*A+scalarB*B (overwrites A)
   static void add(Intrepid::FieldContainer<double> &X, const Intrepid::FieldContainer<double> &A, const Intrepid::FieldContainer<double> &B, double scalarA = 1.0, double scalarB = 1.0){
@@ -565,6 +608,232 @@ public:
     return result;
   }
 
+  //! Solves the C symmetric positive definite systems A(c) X(c) = B(c) using Cholesky factorization, batched across cells, writing the transpose of each solution into xTranspose.
+  /*!
+   \param xTranspose Out
+   A rank-3 FieldContainer with shape (C,M,N); on output, xTranspose(c,j,i) = X(c)(i,j).  This is the layout of BF's optimal test weights.
+   \param A_SPD In
+   A rank-3 FieldContainer with shape (C,N,N).  Left unmodified.
+   \param b In
+   A rank-3 FieldContainer with shape (C,N,M).
+   \param failedCellOrdinals Out
+   Ordinals of the cells whose matrices could not be factored; the corresponding entries of xTranspose are left undefined.
+   
+   \return 0 if all systems were solved successfully; otherwise, the LAPACK error code for the last failure.
+   */
+  static int solveSPDSystemsMultipleRHSTransposed(Intrepid::FieldContainer<double> &xTranspose,
+                                                  const Intrepid::FieldContainer<double> &A_SPD,
+                                                  const Intrepid::FieldContainer<double> &b,
+                                                  std::vector<int> &failedCellOrdinals) {
+    int numCells = A_SPD.dimension(0);
+    int N = A_SPD.dimension(1);
+    int nRHS = b.dimension(2);
+    
+    if ((A_SPD.rank() != 3) || (A_SPD.dimension(2) != N)) {
+      TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "A_SPD must have shape (C,N,N)");
+    }
+    if ((b.rank() != 3) || (b.dimension(0) != numCells) || (b.dimension(1) != N)) {
+      TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "b must have shape (C,N,M)");
+    }
+    if ((xTranspose.rank() != 3) || (xTranspose.dimension(0) != numCells) || (xTranspose.dimension(1) != nRHS)
+        || (xTranspose.dimension(2) != N)) {
+      TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "xTranspose must have shape (C,M,N)");
+    }
+    
+    failedCellOrdinals.clear();
+    if ((numCells == 0) || (N == 0) || (nRHS == 0)) return 0;
+    
+    // The whole batch is factored and solved at once: the matrices are interleaved so that entry (i,j) of every cell is
+    // contiguous, and each step of the (equilibrated, as in factorSPDSystem()) Cholesky factorization and of the
+    // triangular solves runs over all the cells in the innermost loop.  Only the lower triangle is stored.
+    // Cells that hit a nonpositive pivot are marked failed, and continue with a unit pivot so as not to disturb the others.
+    int C = numCells;
+    std::vector<double> scaling(N * C);
+    std::vector<int> err(C, 0);
+    for (int i=0; i<N; i++) {
+      for (int c=0; c<C; c++) {
+        double diag = A_SPD(c,i,i);
+        if ((diag <= 0.0) && (err[c] == 0)) err[c] = -1;
+        scaling[i*C + c] = (diag > 0.0) ? 1.0 / sqrt(diag) : 1.0;
+      }
+    }
+    std::vector<double> L((N * (N+1) / 2) * C); // lower triangle, row by row: entry (i,j) at ((i*(i+1))/2 + j)*C
+    for (int i=0; i<N; i++) {
+      for (int j=0; j<=i; j++) {
+        double *Lij = &L[((i*(i+1))/2 + j)*C];
+        const double *scaling_i = &scaling[i*C], *scaling_j = &scaling[j*C];
+        for (int c=0; c<C; c++) {
+          Lij[c] = scaling_i[c] * A_SPD(c,i,j) * scaling_j[c];
+        }
+      }
+    }
+    for (int j=0; j<N; j++) {
+      double *Ljj = &L[((j*(j+1))/2 + j)*C];
+      for (int k=0; k<j; k++) {
+        const double *Ljk = &L[((j*(j+1))/2 + k)*C];
+        for (int c=0; c<C; c++) {
+          Ljj[c] -= Ljk[c] * Ljk[c];
+        }
+      }
+      for (int c=0; c<C; c++) {
+        if (Ljj[c] <= 0.0) {
+          if (err[c] == 0) err[c] = j + 1; // as POTRF reports it
+          Ljj[c] = 1.0;
+        } else {
+          Ljj[c] = sqrt(Ljj[c]);
+        }
+      }
+      for (int i=j+1; i<N; i++) {
+        double *Lij = &L[((i*(i+1))/2 + j)*C];
+        for (int k=0; k<j; k++) {
+          const double *Lik = &L[((i*(i+1))/2 + k)*C];
+          const double *Ljk = &L[((j*(j+1))/2 + k)*C];
+          for (int c=0; c<C; c++) {
+            Lij[c] -= Lik[c] * Ljk[c];
+          }
+        }
+        for (int c=0; c<C; c++) {
+          Lij[c] /= Ljj[c];
+        }
+      }
+    }
+    
+    // solve L L^T y = S b for each right-hand side, then x = S y
+    std::vector<double> y(N * C);
+    for (int rhs=0; rhs<nRHS; rhs++) {
+      for (int i=0; i<N; i++) {
+        double *y_i = &y[i*C];
+        const double *scaling_i = &scaling[i*C];
+        for (int c=0; c<C; c++) {
+          y_i[c] = scaling_i[c] * b(c,i,rhs);
+        }
+        for (int k=0; k<i; k++) {
+          const double *Lik = &L[((i*(i+1))/2 + k)*C];
+          const double *y_k = &y[k*C];
+          for (int c=0; c<C; c++) {
+            y_i[c] -= Lik[c] * y_k[c];
+          }
+        }
+        const double *Lii = &L[((i*(i+1))/2 + i)*C];
+        for (int c=0; c<C; c++) {
+          y_i[c] /= Lii[c];
+        }
+      }
+      for (int i=N-1; i>=0; i--) {
+        double *y_i = &y[i*C];
+        for (int k=i+1; k<N; k++) {
+          const double *Lki = &L[((k*(k+1))/2 + i)*C];
+          const double *y_k = &y[k*C];
+          for (int c=0; c<C; c++) {
+            y_i[c] -= Lki[c] * y_k[c];
+          }
+        }
+        const double *Lii = &L[((i*(i+1))/2 + i)*C];
+        const double *scaling_i = &scaling[i*C];
+        for (int c=0; c<C; c++) {
+          y_i[c] /= Lii[c];
+          xTranspose(c,rhs,i) = scaling_i[c] * y_i[c];
+        }
+      }
+    }
+    
+    int errOut = 0;
+    for (int c=0; c<C; c++) {
+      if (err[c] != 0) {
+        errOut = err[c];
+        failedCellOrdinals.push_back(c);
+      }
+    }
+    return errOut;
+  }
+  
+  //! Computes equilibrated Cholesky factors of the C symmetric positive definite matrices A(c), for later use in solveFactoredSPDSystemsTransposed().
+  /*!
+   \param factors Out
+   A rank-3 FieldContainer with shape (C,N,N); on output, factors(c) holds (in its lower triangle, column-major) the Cholesky factor of S A(c) S.
+   \param scaling Out
+   A rank-2 FieldContainer with shape (C,N); on output, scaling(c,i) = 1/sqrt(A(c)(i,i)), the diagonal of S.
+   \param A_SPD In
+   A rank-3 FieldContainer with shape (C,N,N).  Left unmodified.
+   \param failedCellOrdinals Out
+   Ordinals of the cells whose matrices could not be factored; the corresponding entries of factors and scaling are left undefined.
+   
+   \return 0 if all matrices were factored successfully; otherwise, the LAPACK error code for the last failure.
+   */
+  static int factorSPDSystems(Intrepid::FieldContainer<double> &factors, Intrepid::FieldContainer<double> &scaling,
+                              const Intrepid::FieldContainer<double> &A_SPD, std::vector<int> &failedCellOrdinals) {
+    int numCells = A_SPD.dimension(0);
+    int N = A_SPD.dimension(1);
+    
+    if ((A_SPD.rank() != 3) || (A_SPD.dimension(2) != N)) {
+      TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "A_SPD must have shape (C,N,N)");
+    }
+    factors.resize(numCells,N,N);
+    scaling.resize(numCells,N);
+    
+    failedCellOrdinals.clear();
+    if (N == 0) return 0;
+    
+    int errOut = 0;
+    
+    for (int cellOrdinal=0; cellOrdinal < numCells; cellOrdinal++) {
+      int err = factorSPDSystem(&factors(cellOrdinal,0,0), &scaling(cellOrdinal,0), &A_SPD(cellOrdinal,0,0), N);
+      if (err != 0) {
+        errOut = err;
+        failedCellOrdinals.push_back(cellOrdinal);
+      }
+    }
+    return errOut;
+  }
+  
+  //! Solves A(c) X(c) = B(c) using the factors computed by factorSPDSystems(), writing the transpose of each solution into xTranspose.
+  /*!
+   \param xTranspose Out
+   A rank-3 FieldContainer with shape (C,M,N); on output, xTranspose(c,j,i) = X(c)(i,j).
+   \param factors In
+   A rank-3 FieldContainer with shape (C,N,N), as computed by factorSPDSystems().
+   \param scaling In
+   A rank-2 FieldContainer with shape (C,N), as computed by factorSPDSystems().
+   \param b In
+   A rank-3 FieldContainer with shape (C,N,M).
+   \param skippedCellOrdinals In
+   Sorted ordinals of cells to skip (e.g. those that factorSPDSystems() could not factor); the corresponding entries of xTranspose are left unmodified.
+   
+   \return 0 if all systems were solved successfully; otherwise, the LAPACK error code for the last failure.
+   */
+  static int solveFactoredSPDSystemsTransposed(Intrepid::FieldContainer<double> &xTranspose,
+                                               const Intrepid::FieldContainer<double> &factors,
+                                               const Intrepid::FieldContainer<double> &scaling,
+                                               const Intrepid::FieldContainer<double> &b,
+                                               const std::vector<int> &skippedCellOrdinals = std::vector<int>()) {
+    int numCells = factors.dimension(0);
+    int N = factors.dimension(1);
+    int nRHS = b.dimension(2);
+    
+    if ((b.rank() != 3) || (b.dimension(0) != numCells) || (b.dimension(1) != N)) {
+      TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "b must have shape (C,N,M)");
+    }
+    if ((xTranspose.rank() != 3) || (xTranspose.dimension(0) != numCells) || (xTranspose.dimension(1) != nRHS)
+        || (xTranspose.dimension(2) != N)) {
+      TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "xTranspose must have shape (C,M,N)");
+    }
+    if ((N == 0) || (nRHS == 0)) return 0;
+    
+    int errOut = 0;
+    
+    std::vector<int>::const_iterator skippedIt = skippedCellOrdinals.begin();
+    for (int cellOrdinal=0; cellOrdinal < numCells; cellOrdinal++) {
+      if ((skippedIt != skippedCellOrdinals.end()) && (*skippedIt == cellOrdinal)) {
+        skippedIt++;
+        continue;
+      }
+      int err = solveFactoredSPDSystemTransposed(&xTranspose(cellOrdinal,0,0), &factors(cellOrdinal,0,0), &scaling(cellOrdinal,0),
+                                                 &b(cellOrdinal,0,0), N, nRHS);
+      if (err != 0) errOut = err;
+    }
+    return errOut;
+  }
+  
   //! Returns the reciprocal of the 1-norm condition number of the matrix in A
   /*!
    \param A In
@@ -48,15 +48,18 @@
 #include "Epetra_SerialComm.h"
 #endif
 
+#include "Epetra_FECrsGraph.h"
 #include "Epetra_FECrsMatrix.h"
 #include "Epetra_FEVector.h"
 #include "Epetra_SerialDenseMatrix.h"
 #include "Epetra_SerialDenseVector.h"
 
 #include "BasisCache.h"
+#include "CellCoefficientStore.h"
 #include "DofInterpreter.h"
 #include "ElementType.h"
 #include "LocalStiffnessMatrixFilter.h"
+#include "PhaseTimers.h"
 #include "Solver.h"
 
 class BC;
@@ -86,7 +89,8 @@ typedef Teuchos::RCP<Solution> SolutionPtr;
 class Solution {
 private:
   int _cubatureEnrichmentDegree;
-  std::map< GlobalIndexType, Intrepid::FieldContainer<double> > _solutionForCellIDGlobal; // eventually, replace this with a distributed _solutionForCellID
+  int _numAssemblyThreads; // threads used for local stiffness computation in populateStiffnessAndLoad() (requires OpenMP)
+  CellCoefficientStore _solutionForCellIDGlobal; // eventually, replace this with a distributed _solutionForCellID
   std::map< GlobalIndexType, double > _energyErrorForCell; // now rank local
   std::map< GlobalIndexType, double > _energyErrorForCellGlobal;
 
@@ -106,9 +110,26 @@ private:
   Teuchos::RCP<LagrangeConstraints> _lagrangeConstraints;
 
   Teuchos::RCP<Epetra_CrsMatrix> _globalStiffMatrix;
+  Teuchos::RCP<Epetra_Operator> _matrixFreeStiffness; // used in place of _globalStiffMatrix by solveMatrixFree()
   Teuchos::RCP<Epetra_FEVector> _rhsVector;
   Teuchos::RCP<Epetra_FEVector> _lhsVector;
   
+  // the exact sparsity graph of the stiffness matrix, reused until the dof assignment changes
+  Teuchos::RCP<Epetra_FECrsGraph> _stiffnessGraph;
+  DofInterpreter* _stiffnessGraphDofInterpreter; // the dof interpreter for which _stiffnessGraph was built
+  int _stiffnessGraphDofAssignmentVersion; // and the mesh's GlobalDofAssignment::dofAssignmentVersion() at the time
+  Epetra_CrsMatrix* _stiffnessGraphMatrix; // the last matrix constructed from _stiffnessGraph, for reuse if still current
+  bool _stiffnessUsesStaticGraph; // if true, populateStiffnessAndLoad() sums into the (zeroed) entries of _stiffnessGraph
+  
+  // load-only reassembly (see setReuseStiffness())
+  bool _reuseStiffness;
+  bool _stiffnessIsReusable; // true when the last assembly stored what a load-only reassembly needs
+  Teuchos::RCP<Solver> _reusableSolver; // holds the factorization of _globalStiffMatrix
+  int _numStoredStiffnessSolves;
+  std::map< GlobalIndexType, Intrepid::FieldContainer<double> > _optimalTestWeightsForCell; // (numTrialDofs, numTestDofs)
+  Teuchos::RCP<Epetra_CrsMatrix> _dirichletLift; // the columns of the stiffness matrix for BC dofs, before BC imposition
+  Intrepid::FieldContainer<GlobalIndexTypeToCast> _dirichletLiftBCIndices; // the BC dofs for which _dirichletLift was built
+  
   bool _residualsComputed;
   bool _energyErrorComputed;
   bool _rankLocalEnergyErrorComputed;
@@ -120,10 +141,9 @@ private:
   void integrateBasisFunctions(Intrepid::FieldContainer<double> &values, ElementTypePtr elemTypePtr, int trialID);
 
   // statistics for the last solve:
-  double _totalTimeLocalStiffness, _totalTimeGlobalAssembly, _totalTimeBCImposition, _totalTimeSolve, _totalTimeDistributeSolution;
-  double _meanTimeLocalStiffness, _meanTimeGlobalAssembly, _meanTimeBCImposition, _meanTimeSolve, _meanTimeDistributeSolution;
-  double _maxTimeLocalStiffness, _maxTimeGlobalAssembly, _maxTimeBCImposition, _maxTimeSolve, _maxTimeDistributeSolution;
-  double _minTimeLocalStiffness, _minTimeGlobalAssembly, _minTimeBCImposition, _minTimeSolve, _minTimeDistributeSolution;
+  // (cross-rank, from PhaseTimers::timeStatistics())
+  TimeStatistics _timeLocalStiffness, _timeGlobalAssembly, _timeBCImposition, _timeSolve, _timeDistributeSolution;
+  std::map<GlobalIndexType, double> _localStiffnessTimeForCell; // rank-local cells, from the last populateStiffnessAndLoad()
 
   bool _reportConditionNumber, _reportTimingResults;
   bool _writeMatrixToMatlabFile;
@@ -142,6 +162,21 @@ private:
 
   void setGlobalSolutionFromCellLocalCoefficients();
   
+  bool stiffnessGraphApplies();
+  Teuchos::RCP<Epetra_FECrsGraph> buildStiffnessGraph(const Epetra_Map &partMap);
+  
+  void determineBCs(Intrepid::FieldContainer<GlobalIndexTypeToCast> &bcGlobalIndices, Intrepid::FieldContainer<double> &bcGlobalValues);
+  void applyBCValues(const Intrepid::FieldContainer<GlobalIndexTypeToCast> &bcGlobalIndices,
+                     const Intrepid::FieldContainer<double> &bcGlobalValues, const Epetra_Operator &unconstrainedStiffness);
+  Teuchos::RCP<Epetra_CrsMatrix> dirichletLift(const Intrepid::FieldContainer<GlobalIndexTypeToCast> &bcGlobalIndices);
+  void populateLoad(); // load-only reassembly; requires _stiffnessIsReusable
+  int solveWithStoredStiffness();
+  int assembleAndSolve(Teuchos::RCP<Solver> solver); // solve(), without the "solve" phase timer
+  void interpretLocalDataForBatch(const std::vector<GlobalIndexType> &cellIDs, Intrepid::FieldContainer<double> &localStiffness,
+                                  Intrepid::FieldContainer<double> &localRHS, std::vector< Intrepid::FieldContainer<double> > &interpretedStiffness,
+                                  std::vector< Intrepid::FieldContainer<double> > &interpretedRHS,
+                                  std::vector< Intrepid::FieldContainer<GlobalIndexType> > &globalDofIndices);
+  
   void gatherSolutionData(); // get all solution data onto every node (not what we should do in the end)
 protected:
   FieldContainer<double> solutionForElementTypeGlobal(ElementTypePtr elemType); // probably should be deprecated…
@@ -184,6 +219,11 @@ public:
 
   int solve( SolverPtr solver );
 
+  // solves with a MatrixFreeOperator in place of the assembled stiffness matrix; solver should be iterative.
+  // if storeLocalStiffness is false, local stiffness matrices are recomputed, a batch at a time, on each operator application;
+  // otherwise, their upper triangles are kept for the duration of the solve.
+  int solveMatrixFree( SolverPtr solver, bool storeLocalStiffness = false );
+
   void addSolution(SolutionPtr soln, double weight, bool allowEmptyCells = false, bool replaceBoundaryTerms=false); // thisSoln += weight * soln
 
   // will add terms in varsToAdd, but will replace all other variables
@@ -199,7 +239,22 @@ public:
   int cubatureEnrichmentDegree() const;
   void setCubatureEnrichmentDegree(int value);
 
+  // number of on-node worker threads used to compute local stiffness matrices during populateStiffnessAndLoad().
+  // Defaults to 1.  Values > 1 only take effect when Camellia is built with OpenMP (CAMELLIA_ENABLE_OPENMP),
+  // and require that Trilinos be built with thread-safe reference counting (Trilinos_ENABLE_THREAD_SAFE).
+  int numAssemblyThreads() const;
+  void setNumAssemblyThreads(int value);
+
   void setSolution(SolutionPtr soln); // thisSoln = soln
+  
+  // When true, solve() keeps the assembled stiffness matrix, the solver's factorization, and the optimal test weights,
+  // and subsequent solves integrate and assemble only the load vector.  This is valid as long as the BF, IP, and mesh
+  // are unchanged; only RHS and BC values may change between solves.  Call clearReusableStiffness() when anything else
+  // changes (e.g. the time step, for a BF with a 1/dt term).  Not supported for condensed solves, filters, or Lagrange
+  // or zero-mean constraints; solve() then assembles everything, as usual.
+  void setReuseStiffness(bool value);
+  void clearReusableStiffness();
+  int numStoredStiffnessSolves() const; // solves that reused the stored stiffness since construction
 
   void solutionValues(Intrepid::FieldContainer<double> &values, ElementTypePtr elemTypePtr, int trialID,
                       const Intrepid::FieldContainer<double> &physicalPoints,
@@ -214,7 +269,7 @@ public:
   void setSolnCoeffsForCellID(Intrepid::FieldContainer<double> &solnCoeffsToSet, GlobalIndexType cellID, int trialID, int sideIndex=0);
   void setSolnCoeffsForCellID(Intrepid::FieldContainer<double> &solnCoeffsToSet, GlobalIndexType cellID);
 
-  const std::map< GlobalIndexType, Intrepid::FieldContainer<double> > & solutionForCellIDGlobal() const;
+  const CellCoefficientStore & solutionForCellIDGlobal() const;
 
   double integrateSolution(int trialID);
   void integrateSolution(Intrepid::FieldContainer<double> &values, ElementTypePtr elemTypePtr, int trialID);
@@ -337,6 +392,12 @@ public:
   double minTimeSolve();
   double minTimeDistributeSolution();
 
+  // seconds spent computing each rank-local cell's local stiffness (and, for concurrent condensation, condensing it)
+  // in the last full assembly; each batch's time is divided evenly among its cells.  Load-only solves (see
+  // setReuseStiffness()) leave these unchanged.  Empty when the BF's stiffness cache is on: cells that hit the cache
+  // would appear to cost only their RHS integration.
+  const std::map<GlobalIndexType, double> &localStiffnessTimes();
+
   void reportTimings();
 
   void setUseCondensedSolve(bool value);
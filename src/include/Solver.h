@@ -41,7 +41,8 @@ public:
     SuperLUDist,
     MUMPS,
     SimpleML,
-    GMGSolver_1_Level_h
+    GMGSolver_1_Level_h,
+    GMGSolver_Multilevel // V-cycle over GMGSolver::coarseMeshHierarchy(fineSolution->mesh()); coarseMesh is ignored
   };
   
   static SolverPtr getSolver(SolverChoice choice, bool saveFactorization,
@@ -57,6 +58,7 @@ public:
     if (choiceString=="MUMPS") return MUMPS;
     if (choiceString=="SimpleML") return SimpleML;
     if (choiceString=="GMGSolver_1_Level_h") return GMGSolver_1_Level_h;
+    if (choiceString=="GMGSolver_Multilevel") return GMGSolver_Multilevel;
     TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "choiceString not recognized!");
   }
   static string solverChoiceString(SolverChoice choice) {
@@ -65,6 +67,7 @@ public:
     if (choice==MUMPS) return "MUMPS";
     if (choice==SimpleML) return "SimpleML";
     if (choice==GMGSolver_1_Level_h) return "GMGSolver_1_Level_h";
+    if (choice==GMGSolver_Multilevel) return "GMGSolver_Multilevel";
     TEUCHOS_TEST_FOR_EXCEPTION(true, std::invalid_argument, "choice not recognized!");
   }
 };
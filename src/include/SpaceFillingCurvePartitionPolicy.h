@@ -0,0 +1,55 @@
+//
+//  SpaceFillingCurvePartitionPolicy.h
+//  Camellia
+//
+//
+
+#ifndef Camellia_SpaceFillingCurvePartitionPolicy_h
+#define Camellia_SpaceFillingCurvePartitionPolicy_h
+
+#include "MeshPartitionPolicy.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+//! Partitions the active cells by ordering their centroids along a Hilbert (or Morton) curve, and cutting the curve into
+//! contiguous pieces of (approximately) equal total weight.
+/*!
+ Every rank holds the whole MeshTopology, so every rank computes the same partition without communication; the only
+ communication is the migration of Solution data for cells that change ranks.  Curve keys are computed relative to the
+ bounding box of the root cells, so they remain valid under refinement, and are cached: after a refinement, only the
+ new cells need keys, and because the curve preserves locality, most cells stay where they were.
+ */
+class SpaceFillingCurvePartitionPolicy : public MeshPartitionPolicy {
+public:
+  enum CurveType { HILBERT, MORTON };
+private:
+  CurveType _curveType;
+  std::map<GlobalIndexType, double> _cellWeights; // cells not listed have unit weight
+
+  MeshTopologyPtr _keyedTopology; // weak; the topology for which _curveKeys, _boxMin, _boxMax are valid
+  std::map<GlobalIndexType, unsigned long long> _curveKeys;
+  std::vector<double> _boxMin, _boxMax;
+
+  unsigned long long curveKey(MeshTopologyPtr meshTopology, GlobalIndexType cellID);
+  void migrateCellData(Mesh *mesh, const std::map<GlobalIndexType, PartitionIndexType> &exportedCells);
+public:
+  SpaceFillingCurvePartitionPolicy(CurveType curveType = HILBERT);
+
+  //! Weights must agree on all ranks; cells without an entry have unit weight.  Cells absent from the mesh are ignored.
+  //! If a cell cost model is set, partitionMesh() replaces these with its costs.
+  void setCellWeights(const std::map<GlobalIndexType, double> &cellWeights);
+
+  //! The partition that partitionMesh() would assign, without assigning it.
+  std::vector< std::set<GlobalIndexType> > partitionCells(MeshTopologyPtr meshTopology, PartitionIndexType numPartitions);
+
+  void partitionMesh(Mesh *mesh, PartitionIndexType numPartitions);
+
+  //! Position of the point with the given integer coordinates (each less than 2^bitsPerDimension) along the curve.
+  //! coordinates.size() * bitsPerDimension must not exceed 64.
+  static unsigned long long hilbertIndex(std::vector<unsigned> coordinates, int bitsPerDimension);
+  static unsigned long long mortonIndex(const std::vector<unsigned> &coordinates, int bitsPerDimension);
+};
+
+#endif
@@ -214,24 +214,18 @@ namespace Camellia {
     
     int numPoints = refPoints.dimension(0);
     
-    Teuchos::Array<int> spaceTimePointsDimensions;
-    refPoints.dimensions(spaceTimePointsDimensions);
-    
-    spaceTimePointsDimensions[1] -= 1; // spatial dimension is 1 less than space-time
-    if (spaceTimePointsDimensions[1]==0) spaceTimePointsDimensions[1] = 1; // degenerate case: we still want points defined in the 0-dimensional case...
-    ArrayScalar refPointsSpatial(spaceTimePointsDimensions);
+    int spaceDim = _spatialBasis->domainTopology()->getDimension();
     
-    spaceTimePointsDimensions[1] = 1; // time is 1-dimensional
-    ArrayScalar refPointsTemporal(spaceTimePointsDimensions);
+    // a tensor-product cubature of P = P_space * P_time points has only P_space distinct spatial points and P_time
+    // distinct temporal points, so we evaluate each component basis only on its distinct points, and combine via the
+    // point ordinal maps below.  (The combined values are still formed at all P points.)
+    ArrayScalar refPointsSpatial, refPointsTemporal;
+    std::vector<int> spatialPointOrdinals, temporalPointOrdinals;
+    this->getUniqueComponentPoints(refPoints, 0, spaceDim, refPointsSpatial, spatialPointOrdinals);
+    this->getUniqueComponentPoints(refPoints, spaceDim, 1, refPointsTemporal, temporalPointOrdinals);
     
-    int spaceDim = _spatialBasis->domainTopology()->getDimension();
-    // copy the points out:
-    for (int pointOrdinal=0; pointOrdinal<numPoints; pointOrdinal++) {
-      for (int d=0; d<spaceDim; d++) {
-        refPointsSpatial(pointOrdinal,d) = refPoints(pointOrdinal,d);
-      }
-      refPointsTemporal(pointOrdinal,0) = refPoints(pointOrdinal,spaceDim);
-    }
+    int numPointsSpatial = refPointsSpatial.dimension(0);
+    int numPointsTemporal = refPointsTemporal.dimension(0);
     
     Teuchos::Array<int> valuesDim; // will use to size our space and time values arrays
     values.dimensions(valuesDim); // F, P[,D,...]
@@ -242,20 +236,21 @@ namespace Camellia {
       valuesPerPointSpace *= valuesDim[d];
     }
     valuesDim[0] = _spatialBasis->getCardinality(); // field dimension
+    valuesDim[1] = numPointsSpatial;
     ArrayScalar spatialValues(valuesDim);
     _spatialBasis->getValues(spatialValues, refPointsSpatial, spatialOperatorType);
     
-    ArrayScalar temporalValues(_temporalBasis->getCardinality(), numPoints);
+    ArrayScalar temporalValues(_temporalBasis->getCardinality(), numPointsTemporal);
     if (temporalOperatorType==OPERATOR_GRAD) {
-      temporalValues.resize(_temporalBasis->getCardinality(), numPoints, _temporalBasis->rangeDimension());
+      temporalValues.resize(_temporalBasis->getCardinality(), numPointsTemporal, _temporalBasis->rangeDimension());
     }
     _temporalBasis->getValues(temporalValues, refPointsTemporal, temporalOperatorType);
     
     ArrayScalar spatialValues_opValue;
     ArrayScalar temporalValues_opValue;
     if (gradInBoth) {
-      spatialValues_opValue.resize(_spatialBasis->getCardinality(), numPoints);
-      temporalValues_opValue.resize(_temporalBasis->getCardinality(), numPoints);
+      spatialValues_opValue.resize(_spatialBasis->getCardinality(), numPointsSpatial);
+      temporalValues_opValue.resize(_temporalBasis->getCardinality(), numPointsTemporal);
       _spatialBasis->getValues(spatialValues_opValue, refPointsSpatial, OPERATOR_VALUE);
       _temporalBasis->getValues(temporalValues_opValue, refPointsTemporal, OPERATOR_VALUE);
     }
@@ -275,13 +270,15 @@ namespace Camellia {
         int spaceTimeFieldOrdinal = TENSOR_FIELD_ORDINAL(spaceFieldOrdinal, timeFieldOrdinal);
         spaceTimeValueCoordinate[0] = spaceTimeFieldOrdinal;
         for (int pointOrdinal=0; pointOrdinal<numPoints; pointOrdinal++) {
+          int spatialPointOrdinal = spatialPointOrdinals[pointOrdinal];
+          int temporalPointOrdinal = temporalPointOrdinals[pointOrdinal];
           spaceTimeValueCoordinate[1] = pointOrdinal;
-          spatialValueCoordinate[1] = pointOrdinal;
+          spatialValueCoordinate[1] = spatialPointOrdinal;
           double temporalValue;
           if (temporalOperatorType!=OPERATOR_GRAD)
-            temporalValue = temporalValues(timeFieldOrdinal,pointOrdinal);
+            temporalValue = temporalValues(timeFieldOrdinal,temporalPointOrdinal);
           else
-            temporalValue = temporalValues(timeFieldOrdinal,pointOrdinal, 0);
+            temporalValue = temporalValues(timeFieldOrdinal,temporalPointOrdinal, 0);
           int spatialValueEnumeration = spatialValues.getEnumeration(spatialValueCoordinate);
           
           if (! gradInBoth) {
@@ -291,8 +288,8 @@ namespace Camellia {
               values[spaceTimeValueEnumeration+offset] = spatialValue * temporalValue;
             }
           } else {
-            double spatialValue_opValue = spatialValues_opValue(spaceFieldOrdinal,pointOrdinal);
-            double temporalValue_opValue = temporalValues_opValue(timeFieldOrdinal,pointOrdinal);
+            double spatialValue_opValue = spatialValues_opValue(spaceFieldOrdinal,spatialPointOrdinal);
+            double temporalValue_opValue = temporalValues_opValue(timeFieldOrdinal,temporalPointOrdinal);
             
             // product rule: first components are spatial gradient times temporal value; next components are spatial value times temporal gradient
             // first, handle spatial gradients
@@ -309,7 +306,7 @@ namespace Camellia {
             spaceTimeValueCoordinate[2] = _spatialBasis->rangeDimension();
             spaceTimeValueEnumeration = values.getEnumeration(spaceTimeValueCoordinate);
             
-            double temporalGradValue = temporalValues(timeFieldOrdinal,pointOrdinal,0);
+            double temporalGradValue = temporalValues(timeFieldOrdinal,temporalPointOrdinal,0);
             double spaceTimeValue = spatialValue_opValue * temporalGradValue;
 
             values[spaceTimeValueEnumeration] = spaceTimeValue;
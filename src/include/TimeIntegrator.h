@@ -51,6 +51,8 @@ class TimeIntegrator
     double _dt;
     int _timestep;
     bool _nonlinear;
+    bool _reuseStiffness;
+    double _stiffnessDt; // the dt for which _solution's stored stiffness was assembled
     double _nlTolerance;
     double _nlL2Error;
     int _nlIteration;
@@ -58,6 +60,10 @@ class TimeIntegrator
     vector<VarPtr> testVars;
     vector<VarPtr> trialVars;
 
+    // for linear problems: records the dt in the stiffness about to be solved with, discarding any stored
+    // stiffness that was assembled with a different dt
+    void setStiffnessDt(double dt);
+
   public:
     TimeIntegrator(BFPtr steadyJacobian, SteadyResidual &steadyResidual, MeshPtr mesh,
         BCPtr bc, IPPtr ip, map<int, FunctionPtr> initialCondition, bool nonlinear);
@@ -69,6 +75,9 @@ class TimeIntegrator
     double getNLTolerance() { return _nlTolerance; }
     void setNLIterationMax(double nlIterationMax) { _nlIterationMax = nlIterationMax; }
     double getNLIterationMax() { return _nlIterationMax; }
+    // for linear problems: keep the stiffness matrix and its factorization while dt (for ESDIRK, the stage's
+    // effective dt) is unchanged, so that each solve only assembles the load (see Solution::setReuseStiffness()).  Ignored for nonlinear problems.
+    void setReuseStiffness(bool value);
     virtual void addTimeTerm(VarPtr trialVar, VarPtr testVar, FunctionPtr multiplier);
     virtual void runToTime(double T, double dt) = 0;
     virtual void calcNextTimeStep(double dt);
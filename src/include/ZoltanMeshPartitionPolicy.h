@@ -27,6 +27,12 @@ class ZoltanMeshPartitionPolicy : public MeshPartitionPolicy {
 //  vector<GlobalIndexType> getListOfActiveGlobalIDs(FieldContainer<GlobalIndexType> partitionedActiveCells);
 
   static set<GlobalIndexType> getRankLocalCellIDs(Mesh* mesh);
+
+  // data for get_object_list; the other query functions take the Mesh* directly
+  struct ObjectListData {
+    Mesh* mesh;
+    map<GlobalIndexType, double> cellWeights; // empty unless a cell cost model is set
+  };
   
   //Zoltan query functions
   static int get_number_of_objects(void *data, int *ierr);
@@ -9,6 +9,9 @@
 #include "Teuchos_UnitTestHarness.hpp"
 
 #include "BasisCache.h"
+#include "BasisEvaluation.h"
+#include "BasisFactory.h"
+#include "ReferenceValueCache.h"
 
 #include "SerialDenseWrapper.h"
 
@@ -447,4 +450,165 @@ namespace {
       TEST_ASSERT(maxDiff < tol);
     }
   }
+  
+  TEUCHOS_UNIT_TEST( BasisCache, ReferenceValuesSharedAcrossInstances )
+  {
+    CellTopoPtr quad = CellTopology::quad();
+    int H1Order = 3, cubatureDegree = 4;
+    BasisPtr basis = BasisFactory::basisFactory()->getBasis(H1Order, quad, Camellia::FUNCTION_SPACE_HGRAD);
+    
+    bool createSideCache = true;
+    BasisCachePtr basisCache1 = BasisCache::basisCacheForReferenceCell(quad, cubatureDegree, createSideCache);
+    BasisCachePtr basisCache2 = BasisCache::basisCacheForReferenceCell(quad, cubatureDegree, createSideCache);
+    
+    ReferenceValueCache* referenceValueCache = ReferenceValueCache::referenceValueCache();
+    
+    double tol = 1e-15;
+    Camellia::EOperator ops[2] = {OP_VALUE, OP_GRAD};
+    for (int opOrdinal=0; opOrdinal<2; opOrdinal++) {
+      Camellia::EOperator op = ops[opOrdinal];
+      Teuchos::RCP< const FieldContainer<double> > values1 = basisCache1->getValues(basis, op);
+      long long hitCount = referenceValueCache->hitCount();
+      Teuchos::RCP< const FieldContainer<double> > values2 = basisCache2->getValues(basis, op);
+      TEST_EQUALITY(referenceValueCache->hitCount(), hitCount + 1);
+      TEST_EQUALITY(values1.get(), values2.get());
+      
+      Teuchos::RCP< const FieldContainer<double> > expectedValues = BasisEvaluation::getValues(basis, op, basisCache1->getRefCellPoints());
+      TEST_COMPARE_FLOATING_ARRAYS(*values2, *expectedValues, tol);
+    }
+    
+    // side caches: the same side shares values; distinct sides must not
+    BasisPtr lineBasis = BasisFactory::basisFactory()->getBasis(H1Order, CellTopology::line(), Camellia::FUNCTION_SPACE_HVOL);
+    Teuchos::RCP< const FieldContainer<double> > side0Values = basisCache1->getSideBasisCache(0)->getValues(lineBasis, OP_VALUE);
+    long long hitCount = referenceValueCache->hitCount();
+    Teuchos::RCP< const FieldContainer<double> > otherSide0Values = basisCache2->getSideBasisCache(0)->getValues(lineBasis, OP_VALUE);
+    TEST_EQUALITY(referenceValueCache->hitCount(), hitCount + 1);
+    TEST_EQUALITY(side0Values.get(), otherSide0Values.get());
+    
+    bool useVolumeCoords = true;
+    Teuchos::RCP< const FieldContainer<double> > side0VolumeValues = basisCache1->getSideBasisCache(0)->getValues(basis, OP_VALUE, useVolumeCoords);
+    Teuchos::RCP< const FieldContainer<double> > side1VolumeValues = basisCache1->getSideBasisCache(1)->getValues(basis, OP_VALUE, useVolumeCoords);
+    TEST_INEQUALITY(side0VolumeValues.get(), side1VolumeValues.get());
+    Teuchos::RCP< const FieldContainer<double> > expectedSide1Values = BasisEvaluation::getValues(basis, OP_VALUE,
+                                                                                               basisCache1->getSideBasisCache(1)->getSideRefCellPointsInVolumeCoordinates());
+    TEST_COMPARE_FLOATING_ARRAYS(*side1VolumeValues, *expectedSide1Values, tol);
+    
+    // once the reference points are set explicitly, values are no longer shared
+    FieldContainer<double> refPoints(1,2);
+    refPoints(0,0) = 0.25;
+    refPoints(0,1) = -0.5;
+    basisCache2->setRefCellPoints(refPoints);
+    Teuchos::RCP< const FieldContainer<double> > pointValues = basisCache2->getValues(basis, OP_VALUE);
+    Teuchos::RCP< const FieldContainer<double> > expectedPointValues = BasisEvaluation::getValues(basis, OP_VALUE, refPoints);
+    TEST_COMPARE_FLOATING_ARRAYS(*pointValues, *expectedPointValues, tol);
+  }
+  
+  TEUCHOS_UNIT_TEST( BasisCache, ReferenceValueCacheBoundAndClear )
+  {
+    CellTopoPtr quad = CellTopology::quad();
+    int H1Order = 2, cubatureDegree = 3;
+    BasisPtr basis = BasisFactory::basisFactory()->getBasis(H1Order, quad, Camellia::FUNCTION_SPACE_HGRAD);
+    BasisCachePtr basisCache = BasisCache::basisCacheForReferenceCell(quad, cubatureDegree);
+    
+    ReferenceValueCache* referenceValueCache = ReferenceValueCache::referenceValueCache();
+    long long maxMemory = referenceValueCache->maxMemoryInBytes();
+    
+    // values returned before clear() remain valid after it
+    Teuchos::RCP< const FieldContainer<double> > values = BasisCache::basisCacheForReferenceCell(quad, cubatureDegree)->getValues(basis, OP_VALUE);
+    referenceValueCache->clear();
+    TEST_EQUALITY(referenceValueCache->memoryInBytes(), 0);
+    Teuchos::RCP< const FieldContainer<double> > expectedValues = BasisEvaluation::getValues(basis, OP_VALUE, basisCache->getRefCellPoints());
+    TEST_COMPARE_FLOATING_ARRAYS(*values, *expectedValues, 1e-15);
+    
+    // with no room, values are computed but not stored
+    referenceValueCache->setMaxMemoryInBytes(0);
+    BasisCache::basisCacheForReferenceCell(quad, cubatureDegree)->getValues(basis, OP_GRAD);
+    BasisCache::basisCacheForReferenceCell(quad, cubatureDegree)->getValues(basis, OP_GRAD);
+    TEST_EQUALITY(referenceValueCache->memoryInBytes(), 0);
+    TEST_EQUALITY(referenceValueCache->hitCount(), 0);
+    
+    // lowering the bound below current usage discards the stored values
+    referenceValueCache->setMaxMemoryInBytes(maxMemory);
+    BasisCache::basisCacheForReferenceCell(quad, cubatureDegree)->getValues(basis, OP_GRAD);
+    TEST_COMPARE(referenceValueCache->memoryInBytes(), >, 0);
+    referenceValueCache->setMaxMemoryInBytes(referenceValueCache->memoryInBytes() - 1);
+    TEST_EQUALITY(referenceValueCache->memoryInBytes(), 0);
+    referenceValueCache->setMaxMemoryInBytes(maxMemory);
+  }
+  
+  TEUCHOS_UNIT_TEST( BasisCache, AffineCellJacobian )
+  {
+    CellTopoPtr quad = CellTopology::quad();
+    int cubatureDegree = 4;
+    double tol = 1e-14;
+    
+    // a parallelogram, and a quadrilateral that isn't one
+    double parallelogramNodes[4][2] = {{0,0}, {2,0}, {3,1}, {1,1}};
+    double nonAffineNodes[4][2] = {{0,0}, {1,0}, {2,2}, {0,1}};
+    FieldContainer<double> affineCellNodes(1,4,2), mixedCellNodes(2,4,2);
+    for (int node=0; node<4; node++) {
+      for (int d=0; d<2; d++) {
+        affineCellNodes(0,node,d) = parallelogramNodes[node][d];
+        mixedCellNodes(0,node,d) = parallelogramNodes[node][d];
+        mixedCellNodes(1,node,d) = nonAffineNodes[node][d];
+      }
+    }
+    TEST_ASSERT(CamelliaCellTools::cellsAreAffine(affineCellNodes, quad));
+    TEST_ASSERT(!CamelliaCellTools::cellsAreAffine(mixedCellNodes, quad));
+    
+    bool createSideCache = true;
+    BasisCachePtr affineCache = Teuchos::rcp( new BasisCache(affineCellNodes, quad, cubatureDegree, createSideCache) );
+    BasisCachePtr mixedCache = Teuchos::rcp( new BasisCache(mixedCellNodes, quad, cubatureDegree, createSideCache) );
+    TEST_ASSERT(affineCache->cellsAreAffine());
+    TEST_ASSERT(!mixedCache->cellsAreAffine());
+    
+    // x = x0 + (xi+1)/2 * (x1-x0) + (eta+1)/2 * (x3-x0)
+    double expectedJacobian[2][2] = {{1.0, 0.5}, {0.0, 0.5}};
+    double expectedDet = 0.5;
+    const FieldContainer<double>* jacobian = &affineCache->getJacobian();
+    const FieldContainer<double>* jacobianInv = &affineCache->getJacobianInv();
+    const FieldContainer<double>* jacobianDet = &affineCache->getJacobianDet();
+    const FieldContainer<double>* mixedJacobian = &mixedCache->getJacobian();
+    const FieldContainer<double>* mixedJacobianInv = &mixedCache->getJacobianInv();
+    int numPoints = jacobian->dimension(1);
+    for (int ptOrdinal=0; ptOrdinal<numPoints; ptOrdinal++) {
+      TEST_FLOATING_EQUALITY((*jacobianDet)(0,ptOrdinal), expectedDet, tol);
+      for (int d1=0; d1<2; d1++) {
+        for (int d2=0; d2<2; d2++) {
+          TEST_ASSERT(abs((*jacobian)(0,ptOrdinal,d1,d2) - expectedJacobian[d1][d2]) < tol);
+          TEST_ASSERT(abs((*jacobian)(0,ptOrdinal,d1,d2) - (*mixedJacobian)(0,ptOrdinal,d1,d2)) < tol);
+          TEST_ASSERT(abs((*jacobianInv)(0,ptOrdinal,d1,d2) - (*mixedJacobianInv)(0,ptOrdinal,d1,d2)) < tol);
+        }
+      }
+    }
+    
+    // transformed values and weighted measures should agree with those computed by the general path
+    BasisPtr basis = BasisFactory::basisFactory()->getBasis(2, quad, Camellia::FUNCTION_SPACE_HGRAD);
+    Teuchos::RCP< const FieldContainer<double> > affineGrads = affineCache->getTransformedValues(basis, OP_GRAD);
+    Teuchos::RCP< const FieldContainer<double> > mixedGrads = mixedCache->getTransformedValues(basis, OP_GRAD);
+    for (int i=0; i<affineGrads->size(); i++) { // cell 0 comes first in mixedGrads
+      TEST_ASSERT(abs((*affineGrads)[i] - (*mixedGrads)[i]) < tol);
+    }
+    FieldContainer<double> affineMeasures = affineCache->getWeightedMeasures();
+    FieldContainer<double> mixedMeasures = mixedCache->getWeightedMeasures();
+    for (int ptOrdinal=0; ptOrdinal<numPoints; ptOrdinal++) {
+      TEST_FLOATING_EQUALITY(affineMeasures(0,ptOrdinal), mixedMeasures(0,ptOrdinal), tol);
+    }
+    
+    // side measures and normals use the broadcast Jacobian
+    for (int sideOrdinal=0; sideOrdinal<quad->getSideCount(); sideOrdinal++) {
+      BasisCachePtr affineSideCache = affineCache->getSideBasisCache(sideOrdinal);
+      BasisCachePtr mixedSideCache = mixedCache->getSideBasisCache(sideOrdinal);
+      FieldContainer<double> affineSideMeasures = affineSideCache->getWeightedMeasures();
+      FieldContainer<double> mixedSideMeasures = mixedSideCache->getWeightedMeasures();
+      const FieldContainer<double>* affineNormals = &affineSideCache->getSideNormals();
+      const FieldContainer<double>* mixedNormals = &mixedSideCache->getSideNormals();
+      for (int ptOrdinal=0; ptOrdinal<affineSideMeasures.dimension(1); ptOrdinal++) {
+        TEST_FLOATING_EQUALITY(affineSideMeasures(0,ptOrdinal), mixedSideMeasures(0,ptOrdinal), tol);
+        for (int d=0; d<2; d++) {
+          TEST_ASSERT(abs((*affineNormals)(0,ptOrdinal,d) - (*mixedNormals)(0,ptOrdinal,d)) < tol);
+        }
+      }
+    }
+  }
 } // namespace
\ No newline at end of file
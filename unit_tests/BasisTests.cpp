@@ -27,7 +27,10 @@
 
 #include "TensorBasis.h"
 
+#include "BasisCache.h"
 #include "BasisFactory.h"
+#include "LobattoHDIV_QuadBasis_separable.h"
+#include "LobattoHGRAD_QuadBasis.h"
 
 namespace {
   TEUCHOS_UNIT_TEST( Basis, LineC1_Unisolvence )
@@ -85,6 +88,55 @@ namespace {
     }
   }
   
+  TEUCHOS_UNIT_TEST( Basis, LobattoQuad_TensorCubatureValuesMatchPointwise )
+  {
+    // the Lobatto quad bases evaluate their 1D factors once per distinct x and y coordinate;
+    // check that on a tensor-product cubature this agrees with evaluating one point at a time.
+    int degree = 4;
+    bool conforming = true;
+    typedef Intrepid::FieldContainer<double> FC;
+    
+    std::vector< BasisPtr > bases;
+    bases.push_back( Teuchos::rcp( new Camellia::LobattoHGRAD_QuadBasis<double, FC>(degree, conforming) ) );
+    bases.push_back( Teuchos::rcp( new Camellia::LobattoHDIV_QuadBasis_separable<double, FC>(degree, conforming) ) );
+    
+    BasisCachePtr basisCache = BasisCache::basisCacheForReferenceCell(Camellia::CellTopology::quad(), 2 * degree);
+    FC points = basisCache->getRefCellPoints();
+    int numPoints = points.dimension(0);
+    int spaceDim = points.dimension(1);
+    
+    double tol = 1e-15;
+    for (int basisOrdinal=0; basisOrdinal < bases.size(); basisOrdinal++) {
+      BasisPtr basis = bases[basisOrdinal];
+      int cardinality = basis->getCardinality();
+      FC values, pointValues;
+      if (basis->rangeRank() == 0) {
+        values.resize(cardinality, numPoints);
+        pointValues.resize(cardinality, 1);
+      } else {
+        values.resize(cardinality, numPoints, spaceDim);
+        pointValues.resize(cardinality, 1, spaceDim);
+      }
+      basis->getValues(values, points, Intrepid::OPERATOR_VALUE);
+      
+      int valuesPerPoint = (basis->rangeRank() == 0) ? 1 : spaceDim;
+      FC point(1, spaceDim);
+      for (int pointOrdinal=0; pointOrdinal < numPoints; pointOrdinal++) {
+        for (int d=0; d<spaceDim; d++) {
+          point(0,d) = points(pointOrdinal,d);
+        }
+        basis->getValues(pointValues, point, Intrepid::OPERATOR_VALUE);
+        for (int fieldOrdinal=0; fieldOrdinal < cardinality; fieldOrdinal++) {
+          for (int comp=0; comp < valuesPerPoint; comp++) {
+            double expected = pointValues[fieldOrdinal * valuesPerPoint + comp];
+            double actual = values[(fieldOrdinal * numPoints + pointOrdinal) * valuesPerPoint + comp];
+            TEST_FLOATING_EQUALITY(actual + 1.0, expected + 1.0, tol);
+          }
+        }
+      }
+    }
+  }
+  
   //
   // Instantiate the unit test for various values of RealType.
   //
@@ -0,0 +1,137 @@
+//
+//  CellCoefficientStoreTests.cpp
+//  Camellia
+//
+//
+
+#include "CellCoefficientStore.h"
+
+#include "Teuchos_UnitTestHarness.hpp"
+
+using namespace Intrepid;
+
+namespace {
+  FieldContainer<double> coefficientsForCell(GlobalIndexType cellID, int numCoefficients) {
+    FieldContainer<double> coefficients(numCoefficients);
+    for (int i=0; i<numCoefficients; i++) {
+      coefficients[i] = cellID * 100 + i;
+    }
+    return coefficients;
+  }
+
+  TEUCHOS_UNIT_TEST( CellCoefficientStore, SetEraseCompact )
+  {
+    CellCoefficientStore store;
+    int numCells = 20;
+    for (GlobalIndexType cellID=numCells; cellID > 0; cellID--) { // insert out of order
+      store.setCoefficients(cellID, coefficientsForCell(cellID, cellID % 4 + 1));
+    }
+    TEST_EQUALITY(store.numCells(), numCells);
+    TEST_ASSERT(!store.hasCoefficients(0));
+    TEST_EQUALITY(store.coefficients(0).size(), 0);
+
+    // resize a few cells, and erase a few others
+    for (GlobalIndexType cellID=1; cellID <= numCells; cellID++) {
+      if (cellID % 3 == 0) {
+        store.setCoefficients(cellID, coefficientsForCell(cellID, 7));
+      } else if (cellID % 5 == 0) {
+        store.erase(cellID);
+      }
+    }
+
+    for (int pass=0; pass<2; pass++) {
+      for (GlobalIndexType cellID=1; cellID <= numCells; cellID++) {
+        if ((cellID % 3 != 0) && (cellID % 5 == 0)) {
+          TEST_ASSERT(!store.hasCoefficients(cellID));
+          continue;
+        }
+        int expectedSize = (cellID % 3 == 0) ? 7 : cellID % 4 + 1;
+        FieldContainer<double> expectedCoefficients = coefficientsForCell(cellID, expectedSize);
+        const FieldContainer<double>* coefficients = &store.coefficients(cellID);
+        TEST_EQUALITY(coefficients->size(), expectedSize);
+        for (int i=0; i<expectedSize; i++) {
+          TEST_EQUALITY((*coefficients)[i], expectedCoefficients[i]);
+        }
+      }
+      store.compact(); // the second pass checks that compact() preserves the values
+    }
+
+    vector<GlobalIndexType> cellIDs = store.cellIDs();
+    for (int i=1; i<cellIDs.size(); i++) {
+      TEST_COMPARE(cellIDs[i-1], <, cellIDs[i]);
+    }
+  }
+
+  TEUCHOS_UNIT_TEST( CellCoefficientStore, ReferencesSurviveReallocation )
+  {
+    CellCoefficientStore store;
+    store.setCoefficients(1, coefficientsForCell(1, 3));
+    const FieldContainer<double>* cell1Coefficients = &store.coefficients(1);
+    const FieldContainer<double>* cell2Coefficients = &store.coefficients(2); // empty: no coefficients yet
+    TEST_EQUALITY(cell2Coefficients->size(), 0);
+    store.coefficientValues(2, 4);
+    cell2Coefficients = &store.coefficients(2);
+
+    // grow the buffer well past its capacity, then erase and compact, so that it moves several times
+    for (GlobalIndexType cellID=3; cellID < 100; cellID++) {
+      store.setCoefficients(cellID, coefficientsForCell(cellID, 10));
+    }
+    for (GlobalIndexType cellID=3; cellID < 100; cellID += 2) {
+      store.erase(cellID);
+    }
+    store.compact();
+    TEST_EQUALITY(cell1Coefficients, &store.coefficients(1));
+    TEST_EQUALITY(cell1Coefficients->size(), 3);
+    for (int i=0; i<3; i++) {
+      TEST_EQUALITY((*cell1Coefficients)[i], coefficientsForCell(1, 3)[i]);
+    }
+
+    // writes through coefficientValues() land in the store, and are seen through a held view
+    TEST_EQUALITY(cell2Coefficients->size(), 4);
+    store.coefficientValues(2, 4)[3] = 42.0;
+    TEST_EQUALITY((*cell2Coefficients)[3], 42.0);
+
+    // a size change keeps the view object, which now shows the new coefficients
+    store.setCoefficients(1, coefficientsForCell(1, 6));
+    TEST_EQUALITY(cell1Coefficients->size(), 6);
+    TEST_EQUALITY((*cell1Coefficients)[5], coefficientsForCell(1, 6)[5]);
+  }
+
+  TEUCHOS_UNIT_TEST( CellCoefficientStore, AddMatchesCellwiseAdd )
+  {
+    CellCoefficientStore store1, store2;
+    set<GlobalIndexType> cellIDs;
+    for (GlobalIndexType cellID=0; cellID < 10; cellID++) {
+      store1.setCoefficients(cellID, coefficientsForCell(cellID, 5));
+      store2.setCoefficients(cellID, coefficientsForCell(cellID+1, 5));
+      cellIDs.insert(cellID);
+    }
+    TEST_ASSERT(store1.hasSameLayout(store2, cellIDs));
+
+    set<GlobalIndexType> fewerCellIDs = cellIDs;
+    fewerCellIDs.erase(0);
+    TEST_ASSERT(!store1.hasSameLayout(store2, fewerCellIDs));
+
+    double weight = -0.5;
+    store1.add(weight, store2);
+
+    vector<GlobalIndexType> cellIDVector(cellIDs.begin(), cellIDs.end());
+    vector<const double*> coefficientPointers;
+    vector<int> coefficientCounts;
+    store1.getCoefficientPointers(cellIDVector, coefficientPointers, coefficientCounts);
+    for (int cellOrdinal=0; cellOrdinal<cellIDVector.size(); cellOrdinal++) {
+      GlobalIndexType cellID = cellIDVector[cellOrdinal];
+      FieldContainer<double> expectedCoefficients = coefficientsForCell(cellID, 5);
+      FieldContainer<double> otherCoefficients = coefficientsForCell(cellID+1, 5);
+      TEST_EQUALITY(coefficientCounts[cellOrdinal], 5);
+      for (int i=0; i<5; i++) {
+        TEST_FLOATING_EQUALITY(coefficientPointers[cellOrdinal][i], expectedCoefficients[i] + weight * otherCoefficients[i], 1e-15);
+      }
+    }
+
+    // a copy should have its own buffer
+    CellCoefficientStore store3 = store1;
+    store3.coefficientValues(0, 5)[0] = 1e6;
+    TEST_INEQUALITY(store1.coefficients(0)[0], 1e6);
+  }
+} // namespace
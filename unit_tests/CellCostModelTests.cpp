@@ -0,0 +1,154 @@
+//
+//  CellCostModelTests.cpp
+//  Camellia
+//
+//
+
+#include "Teuchos_UnitTestHarness.hpp"
+#include "Teuchos_UnitTestHelpers.hpp"
+
+#include "CellCostModel.h"
+#include "MeshFactory.h"
+#include "PoissonFormulation.h"
+#include "Solution.h"
+#include "SpaceFillingCurvePartitionPolicy.h"
+
+namespace {
+  MeshPtr poissonMesh(int elementsPerSide, PoissonFormulation &form) {
+    int spaceDim = 2;
+    int H1Order = 2, delta_k = 2;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,elementsPerSide);
+    return MeshFactory::rectilinearMesh(form.bf(), dimensions, elementCounts, H1Order, delta_k);
+  }
+
+  double maxOverMean(const vector< set<GlobalIndexType> > &partitions, map<GlobalIndexType, double> &cellCosts) {
+    double maxCost = 0.0, totalCost = 0.0;
+    for (int partitionNumber=0; partitionNumber<partitions.size(); partitionNumber++) {
+      double partitionCost = 0.0;
+      for (set<GlobalIndexType>::const_iterator cellIt = partitions[partitionNumber].begin(); cellIt != partitions[partitionNumber].end(); cellIt++) {
+        partitionCost += cellCosts[*cellIt];
+      }
+      maxCost = max(maxCost, partitionCost);
+      totalCost += partitionCost;
+    }
+    return maxCost / (totalCost / partitions.size());
+  }
+
+  TEUCHOS_UNIT_TEST( CellCostModel, DofCountCostGrowsWithPolynomialOrder )
+  {
+    bool useConformingTraces = true;
+    PoissonFormulation form(2, useConformingTraces);
+    MeshPtr mesh = poissonMesh(2, form);
+
+    set<GlobalIndexType> cellsToRefine;
+    cellsToRefine.insert(0);
+    mesh->pRefine(cellsToRefine, 2);
+
+    map<GlobalIndexType, double> cellCosts = CellCostModel::dofCountCostModel()->cellCosts(mesh.get());
+    TEST_EQUALITY(cellCosts.size(), mesh->numActiveElements());
+    TEST_COMPARE(cellCosts[0], >, cellCosts[1]);
+    TEST_FLOATING_EQUALITY(cellCosts[1], cellCosts[2], 1e-15);
+
+    ElementTypePtr elemType = mesh->getElementType(1);
+    double expectedCost = CellCostModel::localSolveCost(elemType->trialOrderPtr->totalDofs(), elemType->testOrderPtr->totalDofs());
+    TEST_FLOATING_EQUALITY(cellCosts[1], expectedCost, 1e-15);
+  }
+
+  TEUCHOS_UNIT_TEST( CellCostModel, WeightedPartitionBalancesCost )
+  {
+    // p-refine one quarter of the mesh; cost-weighted partitions should be better balanced than cell-count partitions
+    bool useConformingTraces = true;
+    PoissonFormulation form(2, useConformingTraces);
+    MeshPtr mesh = poissonMesh(4, form);
+    int numPartitions = 4;
+
+    SpaceFillingCurvePartitionPolicy partitionPolicy;
+    vector< set<GlobalIndexType> > partitions = partitionPolicy.partitionCells(mesh->getTopology(), numPartitions);
+    mesh->pRefine(partitions[0], 3);
+
+    map<GlobalIndexType, double> cellCosts = CellCostModel::dofCountCostModel()->cellCosts(mesh.get());
+    double unweightedImbalance = maxOverMean(partitions, cellCosts);
+
+    partitionPolicy.setCellWeights(cellCosts);
+    vector< set<GlobalIndexType> > weightedPartitions = partitionPolicy.partitionCells(mesh->getTopology(), numPartitions);
+    double weightedImbalance = maxOverMean(weightedPartitions, cellCosts);
+
+    out << "imbalance (max/mean cost): " << unweightedImbalance << " by cell count, " << weightedImbalance << " by cost\n";
+    TEST_COMPARE(weightedImbalance, <, unweightedImbalance);
+  }
+
+  TEUCHOS_UNIT_TEST( CellCostModel, MeasuredCostsCoverRefinedCells )
+  {
+    bool useConformingTraces = true;
+    PoissonFormulation form(2, useConformingTraces);
+    MeshPtr mesh = poissonMesh(2, form);
+
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(1.0 * form.q());
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), Function::zero());
+    SolutionPtr soln = Solution::solution(mesh, bc, rhs, form.bf()->graphNorm());
+
+    CellCostModelPtr costModel = CellCostModel::measuredCostModel(soln);
+    MeshPartitionPolicyPtr partitionPolicy = MeshPartitionPolicy::spaceFillingCurvePartitionPolicy();
+    partitionPolicy->setCellCostModel(costModel);
+    mesh->setPartitionPolicy(partitionPolicy); // before any solve: the DOF-count model stands in
+
+    soln->solve();
+    TEST_EQUALITY(soln->localStiffnessTimes().size(), mesh->cellIDsInPartition().size());
+
+    // children of the refined cell have no measurements yet; they should still get costs
+    set<GlobalIndexType> cellsToRefine;
+    cellsToRefine.insert(0);
+    mesh->hRefine(cellsToRefine, RefinementPattern::regularRefinementPatternQuad());
+
+    map<GlobalIndexType, double> cellCosts = costModel->cellCosts(mesh.get());
+    set<GlobalIndexType> activeCellIDs = mesh->getActiveCellIDs();
+    TEST_EQUALITY(cellCosts.size(), activeCellIDs.size());
+    for (set<GlobalIndexType>::iterator cellIt = activeCellIDs.begin(); cellIt != activeCellIDs.end(); cellIt++) {
+      TEST_COMPARE(cellCosts[*cellIt], >, 0.0);
+    }
+
+    soln->solve();
+    TEST_EQUALITY(soln->localStiffnessTimes().size(), mesh->cellIDsInPartition().size());
+  }
+
+  TEUCHOS_UNIT_TEST( CellCostModel, MeasuredCostsFallBackToDofCount )
+  {
+    bool useConformingTraces = true;
+    PoissonFormulation form(2, useConformingTraces);
+    MeshPtr mesh = poissonMesh(2, form);
+    set<GlobalIndexType> cellsToRefine;
+    cellsToRefine.insert(0);
+    mesh->pRefine(cellsToRefine, 2); // so that the DOF-count costs differ between cells
+
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(1.0 * form.q());
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), Function::zero());
+    map<GlobalIndexType, double> dofCountCosts = CellCostModel::dofCountCostModel()->cellCosts(mesh.get());
+
+    CellCostModelPtr costModel;
+    {
+      SolutionPtr soln = Solution::solution(mesh, bc, rhs, form.bf()->graphNorm());
+      costModel = CellCostModel::measuredCostModel(soln);
+
+      // with the stiffness cache on, cache hits would misrank cells, so nothing is measured
+      form.bf()->setUseStiffnessCache(true);
+      soln->solve();
+      TEST_EQUALITY(soln->localStiffnessTimes().size(), 0);
+      form.bf()->clearStiffnessCache();
+      form.bf()->setUseStiffnessCache(false);
+
+      soln->solve();
+      TEST_EQUALITY(soln->localStiffnessTimes().size(), mesh->cellIDsInPartition().size());
+    }
+    // the model holds the solution weakly; once the solution is gone, it falls back to the DOF-count model
+    map<GlobalIndexType, double> cellCosts = costModel->cellCosts(mesh.get());
+    TEST_EQUALITY(cellCosts.size(), dofCountCosts.size());
+    for (map<GlobalIndexType, double>::iterator costIt = dofCountCosts.begin(); costIt != dofCountCosts.end(); costIt++) {
+      TEST_FLOATING_EQUALITY(cellCosts[costIt->first], costIt->second, 1e-15);
+    }
+  }
+} // namespace
@@ -8,6 +8,7 @@
 
 #include "CamelliaDebugUtility.h"
 #include "GMGOperator.h"
+#include "GMGSolver.h"
 #include "MeshFactory.h"
 #include "PoissonFormulation.h"
 #include "RHS.h"
@@ -324,4 +325,140 @@ namespace {
 //    }
     
   }
+  
+  TEUCHOS_UNIT_TEST( GMGOperator, MultilevelSolveQuad )
+  {
+    /*
+     
+     Take a 2D Poisson problem on a three-level hierarchy of uniformly refined meshes.
+     Solve on the finest mesh with a multilevel V-cycle (direct solve only on the coarsest mesh), and with
+     a W-cycle, and compare each against a direct solve on the finest mesh.
+     
+     */
+    
+    int spaceDim = 2;
+    bool useConformingTraces = false;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+    VarPtr phi = form.phi(), phi_hat = form.phi_hat(), q = form.q();
+    
+    int coarseElementCount = 2;
+    int H1Order = 2, delta_k = spaceDim;
+    vector<double> dimensions(2,1.0);
+    vector<int> elementCounts(2,coarseElementCount);
+    MeshPtr coarsestMesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+    MeshPtr middleMesh = coarsestMesh->deepCopy();
+    middleMesh->hRefine(middleMesh->getActiveCellIDs());
+    MeshPtr fineMesh = middleMesh->deepCopy();
+    fineMesh->hRefine(fineMesh->getActiveCellIDs());
+    
+    vector<MeshPtr> coarseMeshes;
+    coarseMeshes.push_back(coarsestMesh);
+    coarseMeshes.push_back(middleMesh);
+    
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(1.0 * q);
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(phi_hat, SpatialFilter::allSpace(), Function::zero());
+    IPPtr ip = bf->graphNorm();
+    
+    SolutionPtr directSoln = Solution::solution(fineMesh, bc, rhs, ip);
+    directSoln->solve(Solver::getSolver(Solver::KLU, true));
+    double phiNorm = directSoln->L2NormOfSolution(phi->ID());
+    
+    int maxIters = 200;
+    double iterativeTol = 1e-12;
+    bool useStaticCondensation = false;
+    
+    GMGOperator::MultigridStrategy strategies[2] = {GMGOperator::V_CYCLE, GMGOperator::W_CYCLE};
+    for (int i=0; i<2; i++) {
+      SolutionPtr fineSoln = Solution::solution(fineMesh, bc, rhs, ip);
+      
+      GMGSolver* gmgSolver = new GMGSolver(fineSoln, coarseMeshes, maxIters, iterativeTol,
+                                           Solver::getSolver(Solver::KLU, true), useStaticCondensation);
+      gmgSolver->setAztecOutput(0);
+      gmgSolver->setMultigridStrategy(strategies[i]);
+      SolverPtr solver = Teuchos::rcp(gmgSolver);
+      
+      // the hierarchy should have exactly two coarse levels
+      TEST_ASSERT(gmgSolver->gmgOperator().getCoarseOperator() != Teuchos::null);
+      TEST_ASSERT(gmgSolver->gmgOperator().getCoarseOperator()->getCoarseOperator() == Teuchos::null);
+      
+      fineSoln->solve(solver);
+      TEST_COMPARE(gmgSolver->iterationCount(), <, maxIters);
+      
+      fineSoln->addSolution(directSoln, -1.0);
+      double diffNorm = fineSoln->L2NormOfSolution(phi->ID());
+      double tol = 1e-8;
+      TEST_COMPARE(diffNorm, <, tol * phiNorm);
+    }
+  }
+  
+  TEUCHOS_UNIT_TEST( GMGOperator, AutomaticHierarchySolveQuad )
+  {
+    /*
+     
+     Take a 2D Poisson problem on a twice uniformly refined mesh of cubic order.  The automatic hierarchy should
+     p-coarsen the fine topology to linear order, then h-coarsen twice.  Solve with a V-cycle over that hierarchy,
+     with diagonal scaling on, and compare against a direct solve.
+     
+     */
+    
+    int spaceDim = 2;
+    bool useConformingTraces = false;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+    VarPtr phi = form.phi(), phi_hat = form.phi_hat(), q = form.q();
+    
+    int coarseElementCount = 2;
+    int H1Order = 3, delta_k = spaceDim;
+    vector<double> dimensions(2,1.0);
+    vector<int> elementCounts(2,coarseElementCount);
+    MeshPtr fineMesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+    fineMesh->hRefine(fineMesh->getActiveCellIDs());
+    fineMesh->hRefine(fineMesh->getActiveCellIDs());
+    
+    int coarsestH1Order = 1;
+    vector<MeshPtr> coarseMeshes = GMGSolver::coarseMeshHierarchy(fineMesh, coarsestH1Order);
+    TEST_EQUALITY(coarseMeshes.size(), 3);
+    if (coarseMeshes.size() != 3) return;
+    int expectedCellCounts[3] = {4, 16, 64};
+    for (int level=0; level<3; level++) {
+      TEST_EQUALITY(coarseMeshes[level]->numActiveElements(), expectedCellCounts[level]);
+      TEST_EQUALITY(coarseMeshes[level]->globalDofAssignment()->getInitialH1Order(), coarsestH1Order);
+    }
+    // the h-levels must share cell indices with the fine mesh
+    set<GlobalIndexType> middleCellIDs = coarseMeshes[1]->getActiveCellIDs();
+    for (set<GlobalIndexType>::iterator cellIDIt = middleCellIDs.begin(); cellIDIt != middleCellIDs.end(); cellIDIt++) {
+      TEST_ASSERT(fineMesh->getTopology()->getCell(*cellIDIt)->isParent());
+    }
+    
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(1.0 * q);
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(phi_hat, SpatialFilter::allSpace(), Function::zero());
+    IPPtr ip = bf->graphNorm();
+    
+    SolutionPtr directSoln = Solution::solution(fineMesh, bc, rhs, ip);
+    directSoln->solve(Solver::getSolver(Solver::KLU, true));
+    double phiNorm = directSoln->L2NormOfSolution(phi->ID());
+    
+    int maxIters = 200;
+    double iterativeTol = 1e-12;
+    SolutionPtr fineSoln = Solution::solution(fineMesh, bc, rhs, ip);
+    SolverPtr solver = Solver::getSolver(Solver::GMGSolver_Multilevel, true, iterativeTol, maxIters, fineSoln);
+    GMGSolver* gmgSolver = dynamic_cast<GMGSolver*>(solver.get());
+    TEST_ASSERT(gmgSolver != NULL);
+    if (gmgSolver == NULL) return;
+    gmgSolver->setAztecOutput(0);
+    gmgSolver->setUseDiagonalScaling(true);
+    
+    fineSoln->solve(solver);
+    TEST_COMPARE(gmgSolver->iterationCount(), <, maxIters);
+    
+    fineSoln->addSolution(directSoln, -1.0);
+    double diffNorm = fineSoln->L2NormOfSolution(phi->ID());
+    double tol = 1e-8;
+    TEST_COMPARE(diffNorm, <, tol * phiNorm);
+  }
 } // namespace
\ No newline at end of file
@@ -0,0 +1,68 @@
+//
+//  LinearTermTests.cpp
+//  Camellia
+//
+//
+
+#include "BasisCache.h"
+#include "Function.h"
+#include "LinearTerm.h"
+#include "MeshFactory.h"
+#include "PoissonFormulation.h"
+
+#include "Teuchos_UnitTestHarness.hpp"
+namespace {
+  TEUCHOS_UNIT_TEST( LinearTerm, IntegrateSymmetric )
+  {
+    // when a LinearTerm is integrated against itself, integrate() computes only the upper-triangular var blocks
+    // and mirrors them; check this against integration against a copy (which takes the non-symmetric path)
+    int spaceDim = 2;
+    bool conformingTraces = true;
+    PoissonFormulation form(spaceDim,conformingTraces);
+    BFPtr bf = form.bf();
+    
+    VarPtr tau = form.tau(), q = form.q();
+    FunctionPtr x = Function::xn(1);
+    
+    vector< LinearTermPtr > lts;
+    lts.push_back(tau->div() - x * q);
+    lts.push_back(tau + q->grad());
+    
+    int H1Order = 2;
+    vector<double> dimensions(2,1.0);
+    vector<int> elementCounts(2,1);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order);
+    
+    GlobalIndexType cellID = 0;
+    DofOrderingPtr testOrder = mesh->getElementType(cellID)->testOrderPtr;
+    bool testVsTest = true;
+    BasisCachePtr ipBasisCache = BasisCache::basisCacheForCell(mesh, cellID, testVsTest);
+    
+    int numCells = 1;
+    int numTestDofs = testOrder->totalDofs();
+    
+    double tol = 1e-14;
+    for (int i=0; i<lts.size(); i++) {
+      LinearTermPtr lt = lts[i];
+      LinearTermPtr ltCopy = Teuchos::rcp( new LinearTerm(*lt) );
+      
+      FieldContainer<double> symmetricValues(numCells,numTestDofs,numTestDofs);
+      FieldContainer<double> expectedValues(numCells,numTestDofs,numTestDofs);
+      
+      lt->integrate(symmetricValues, testOrder, lt, testOrder, ipBasisCache);
+      lt->integrate(expectedValues, testOrder, ltCopy, testOrder, ipBasisCache);
+      
+      double maxDiff = 0, maxAsymmetry = 0;
+      for (int dofOrdinal1=0; dofOrdinal1<numTestDofs; dofOrdinal1++) {
+        for (int dofOrdinal2=0; dofOrdinal2<numTestDofs; dofOrdinal2++) {
+          double diff = std::abs(symmetricValues(0,dofOrdinal1,dofOrdinal2) - expectedValues(0,dofOrdinal1,dofOrdinal2));
+          double asymmetry = std::abs(symmetricValues(0,dofOrdinal1,dofOrdinal2) - symmetricValues(0,dofOrdinal2,dofOrdinal1));
+          maxDiff = std::max(maxDiff, diff);
+          maxAsymmetry = std::max(maxAsymmetry, asymmetry);
+        }
+      }
+      TEST_COMPARE(maxDiff, <, tol);
+      TEST_COMPARE(maxAsymmetry, <, tol);
+    }
+  }
+} // namespace
@@ -0,0 +1,130 @@
+//
+//  LocalDofMapperTests.cpp
+//  Camellia
+//
+//
+
+#include "Teuchos_UnitTestHarness.hpp"
+#include "Teuchos_UnitTestHelpers.hpp"
+
+#include "GDAMinimumRule.h"
+#include "LocalDofMapper.h"
+#include "MeshFactory.h"
+#include "MPIWrapper.h"
+#include "PoissonFormulation.h"
+
+namespace {
+  // the mapping as it was computed before the sparse operator: each row, and then each column, mapped as a vector
+  FieldContainer<double> mapLocalMatrixByVectors(LocalDofMapperPtr dofMapper, const FieldContainer<double> &localData, bool fittableGlobalDofsOnly) {
+    int dataSize = localData.dimension(0);
+    int mappedDataSize = dofMapper->globalIndices().size();
+    FieldContainer<double> intermediateData(dataSize,mappedDataSize);
+    for (int i=0; i<dataSize; i++) {
+      FieldContainer<double> localRow(dataSize);
+      for (int j=0; j<dataSize; j++) {
+        localRow(j) = localData(i,j);
+      }
+      FieldContainer<double> mappedRow = dofMapper->mapLocalData(localRow, fittableGlobalDofsOnly);
+      for (int j=0; j<mappedDataSize; j++) {
+        intermediateData(i,j) = mappedRow(j);
+      }
+    }
+    FieldContainer<double> globalData(mappedDataSize,mappedDataSize);
+    for (int j=0; j<mappedDataSize; j++) {
+      FieldContainer<double> intermediateColumn(dataSize);
+      for (int i=0; i<dataSize; i++) {
+        intermediateColumn(i) = intermediateData(i,j);
+      }
+      FieldContainer<double> mappedColumn = dofMapper->mapLocalData(intermediateColumn, fittableGlobalDofsOnly);
+      for (int i=0; i<mappedDataSize; i++) {
+        globalData(i,j) = mappedColumn(i);
+      }
+    }
+    return globalData;
+  }
+
+  // true if some local dof maps to a weighted combination, rather than a (possibly negated) copy, of global dofs
+  bool isConstrained(LocalDofMapperPtr dofMapper, int localDofCount) {
+    FieldContainer<double> unitVector(localDofCount);
+    for (int j=0; j<localDofCount; j++) {
+      unitVector(j) = 1.0;
+      FieldContainer<double> mappedVector = dofMapper->mapLocalData(unitVector, false);
+      unitVector(j) = 0.0;
+      for (int i=0; i<mappedVector.size(); i++) {
+        double weight = abs(mappedVector(i));
+        if ((weight != 0.0) && (weight != 1.0)) return true;
+      }
+    }
+    return false;
+  }
+
+  void testMatrixMappingMatchesVectorMapping(int spaceDim, Teuchos::FancyOStream &out, bool &success)
+  {
+    bool useConformingTraces = true;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+
+    int H1Order = 2, delta_k = 1;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,2);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(form.bf(), dimensions, elementCounts, H1Order, delta_k);
+
+    // refining one cell leaves hanging nodes on its neighbors; p-refining another gives a second element type
+    set<GlobalIndexType> cellsToRefine;
+    cellsToRefine.insert(0);
+    mesh->hRefine(cellsToRefine);
+    cellsToRefine.clear();
+    cellsToRefine.insert(1);
+    mesh->pRefine(cellsToRefine);
+
+    GDAMinimumRule* minRule = dynamic_cast<GDAMinimumRule*>(mesh->globalDofAssignment().get());
+    TEUCHOS_TEST_FOR_EXCEPTION(minRule == NULL, std::invalid_argument, "test expects a GDAMinimumRule mesh");
+
+    int numConstrainedCells = 0;
+    double tol = 1e-13;
+    set<GlobalIndexType> cellIDs = mesh->cellIDsInPartition();
+    for (set<GlobalIndexType>::iterator cellIDIt = cellIDs.begin(); cellIDIt != cellIDs.end(); cellIDIt++) {
+      GlobalIndexType cellID = *cellIDIt;
+      CellConstraints constraints = minRule->getCellConstraints(cellID);
+      LocalDofMapperPtr dofMapper = minRule->getDofMapper(cellID, constraints);
+
+      int localDofCount = mesh->getElementType(cellID)->trialOrderPtr->totalDofs();
+      if (isConstrained(dofMapper, localDofCount)) numConstrainedCells++;
+
+      // a nonsymmetric local matrix, so that transposition errors are caught
+      FieldContainer<double> localData(localDofCount,localDofCount);
+      for (int i=0; i<localDofCount; i++) {
+        for (int j=0; j<localDofCount; j++) {
+          localData(i,j) = 1.0 / (1.0 + i + 2 * j) + ((i==j) ? 1.0 : 0.0);
+        }
+      }
+
+      for (int fittableOnly=0; fittableOnly<2; fittableOnly++) {
+        bool fittableGlobalDofsOnly = (fittableOnly == 1);
+        FieldContainer<double> expectedData = mapLocalMatrixByVectors(dofMapper, localData, fittableGlobalDofsOnly);
+        FieldContainer<double> mappedData = dofMapper->mapLocalData(localData, fittableGlobalDofsOnly);
+        TEST_EQUALITY(mappedData.size(), expectedData.size());
+        if (mappedData.size() != expectedData.size()) continue;
+        double maxDiff = 0.0, maxValue = 0.0;
+        for (int i=0; i<mappedData.size(); i++) {
+          maxDiff = max(maxDiff, abs(mappedData[i] - expectedData[i]));
+          maxValue = max(maxValue, abs(expectedData[i]));
+        }
+        if (maxDiff > tol * max(maxValue, 1.0)) {
+          out << "cell " << cellID << ": sparse and vector-by-vector mappings differ by " << maxDiff << endl;
+          success = false;
+        }
+      }
+    }
+    TEST_COMPARE(MPIWrapper::sum(numConstrainedCells), >, 0); // partitions need not all contain constrained cells
+  }
+
+  TEUCHOS_UNIT_TEST( LocalDofMapper, MatrixMappingMatchesVectorMapping_2D )
+  {
+    testMatrixMappingMatchesVectorMapping(2, out, success);
+  }
+
+  TEUCHOS_UNIT_TEST( LocalDofMapper, MatrixMappingMatchesVectorMapping_3D )
+  {
+    testMatrixMappingMatchesVectorMapping(3, out, success);
+  }
+} // namespace
@@ -0,0 +1,104 @@
+//
+//  MatrixFreeOperatorTests.cpp
+//  Camellia
+//
+//
+
+#include "CGSolver.h"
+#include "MatrixFreeOperator.h"
+#include "MeshFactory.h"
+#include "PoissonFormulation.h"
+#include "RHS.h"
+
+#include "Epetra_Vector.h"
+
+#include "Teuchos_UnitTestHarness.hpp"
+namespace {
+  SolutionPtr poissonSolution(int H1Order, int elementCount) {
+    int spaceDim = 2;
+    bool useConformingTraces = false;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+
+    int delta_k = spaceDim;
+    vector<double> dimensions(2,1.0);
+    vector<int> elementCounts(2,elementCount);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(1.0 * form.q());
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), Function::constant(1.0));
+
+    return Solution::solution(mesh, bc, rhs, bf->graphNorm());
+  }
+
+  TEUCHOS_UNIT_TEST( MatrixFreeOperator, ApplyMatchesAssembledStiffness )
+  {
+    SolutionPtr soln = poissonSolution(2, 3);
+    soln->initializeLHSVector();
+    soln->initializeStiffnessAndLoad();
+    soln->populateStiffnessAndLoad();
+
+    Teuchos::RCP<Epetra_CrsMatrix> A = soln->getStiffnessMatrix();
+    Epetra_Map partMap = soln->getPartitionMap();
+
+    Epetra_MultiVector X(partMap, 2), Y_expected(partMap, 2), Y(partMap, 2), diff(partMap, 2);
+    X.Random();
+    A->Apply(X, Y_expected);
+
+    double tol = 1e-12;
+    for (int storeIndex=0; storeIndex<2; storeIndex++) {
+      bool storeLocalStiffness = (storeIndex == 0);
+      MatrixFreeOperator matrixFreeA(soln, storeLocalStiffness);
+
+      // matvec
+      matrixFreeA.Apply(X, Y);
+      diff.Update(1.0, Y, -1.0, Y_expected, 0.0);
+      double diffNorms[2], expectedNorms[2];
+      diff.NormInf(diffNorms);
+      Y_expected.NormInf(expectedNorms);
+      for (int i=0; i<2; i++) {
+        TEST_COMPARE(diffNorms[i], <, tol * expectedNorms[i]);
+      }
+
+      // load vector, with BCs imposed
+      Epetra_MultiVector rhsDiff(*soln->getRHSVector());
+      rhsDiff.Update(1.0, *matrixFreeA.getRHSVector(), -1.0);
+      double rhsDiffNorm, rhsNorm;
+      rhsDiff.NormInf(&rhsDiffNorm);
+      soln->getRHSVector()->NormInf(&rhsNorm);
+      TEST_COMPARE(rhsDiffNorm, <, tol * rhsNorm);
+
+      // diagonal
+      Epetra_Vector expectedDiagonal(partMap);
+      A->ExtractDiagonalCopy(expectedDiagonal);
+      Epetra_MultiVector diagDiff(*matrixFreeA.getDiagonal());
+      diagDiff.Update(-1.0, expectedDiagonal, 1.0);
+      double diagDiffNorm, diagNorm;
+      diagDiff.NormInf(&diagDiffNorm);
+      expectedDiagonal.NormInf(&diagNorm);
+      TEST_COMPARE(diagDiffNorm, <, tol * diagNorm);
+    }
+  }
+
+  TEUCHOS_UNIT_TEST( MatrixFreeOperator, SolveMatchesDirectSolve )
+  {
+    SolutionPtr directSoln = poissonSolution(2, 2);
+    directSoln->solve(Solver::getSolver(Solver::KLU, false));
+
+    int phiID = PoissonFormulation(2, false).phi()->ID();
+    double phiNorm = directSoln->L2NormOfSolution(phiID);
+
+    int maxIters = 2000;
+    double iterativeTol = 1e-14;
+    SolutionPtr matrixFreeSoln = poissonSolution(2, 2);
+    SolverPtr solver = Teuchos::rcp( new CGSolver(maxIters, iterativeTol) );
+    matrixFreeSoln->solveMatrixFree(solver);
+
+    matrixFreeSoln->addSolution(directSoln, -1.0);
+    double diffNorm = matrixFreeSoln->L2NormOfSolution(phiID);
+    double tol = 1e-8;
+    TEST_COMPARE(diffNorm, <, tol * phiNorm);
+  }
+} // namespace
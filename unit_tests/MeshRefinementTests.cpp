@@ -10,6 +10,7 @@
 
 #include "BC.h"
 #include "Function.h"
+#include "GDAMinimumRule.h"
 #include "HDF5Exporter.h"
 #include "Mesh.h"
 #include "MeshFactory.h"
@@ -218,4 +219,78 @@ namespace {
 #endif
     }
   }
+
+  // after each local refinement, GDAMinimumRule's incrementally rebuilt lookups should match those of a mesh built from scratch
+  void testIncrementalLookupsMatchFullRebuild(int spaceDim, Teuchos::FancyOStream &out, bool &success)
+  {
+    bool useConformingTraces = true;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+    
+    int H1Order = 2, delta_k = 1;
+    vector<double> dimensions(spaceDim, 1.0);
+    vector<int> elementCounts(spaceDim, (spaceDim == 3) ? 2 : 3);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+    
+    int numRefinements = 4;
+    for (int refinementNumber=0; refinementNumber<=numRefinements; refinementNumber++) {
+      // refine a corner cell, and (on the last pass) p-refine another; the result has hanging nodes near both
+      set<GlobalIndexType> activeCellIDs = mesh->getActiveCellIDs();
+      set<GlobalIndexType> cellsToPRefine;
+      if (refinementNumber < numRefinements) {
+        set<GlobalIndexType> cellsToRefine;
+        cellsToRefine.insert(*activeCellIDs.rbegin());
+        mesh->hRefine(cellsToRefine);
+      } else {
+        cellsToPRefine.insert(*activeCellIDs.begin());
+        mesh->pRefine(cellsToPRefine);
+      }
+      
+      MeshPtr freshMesh = Teuchos::rcp( new Mesh(mesh->getTopology()->deepCopy(), bf, H1Order, delta_k) );
+      if (cellsToPRefine.size() > 0) freshMesh->pRefine(cellsToPRefine);
+      
+      TEST_EQUALITY(mesh->globalDofCount(), freshMesh->globalDofCount());
+      GDAMinimumRule* minRule = dynamic_cast<GDAMinimumRule*>(mesh->globalDofAssignment().get());
+      GDAMinimumRule* freshMinRule = dynamic_cast<GDAMinimumRule*>(freshMesh->globalDofAssignment().get());
+      set<GlobalIndexType> myCellIDs = mesh->cellIDsInPartition();
+      for (set<GlobalIndexType>::iterator cellIDIt = myCellIDs.begin(); cellIDIt != myCellIDs.end(); cellIDIt++) {
+        GlobalIndexType cellID = *cellIDIt;
+        set<GlobalIndexType> dofIndices = mesh->globalDofIndicesForCell(cellID);
+        set<GlobalIndexType> expectedDofIndices = freshMesh->globalDofIndicesForCell(cellID);
+        TEST_ASSERT(dofIndices == expectedDofIndices);
+        
+        // the mappers (cached on mesh since the previous pass, where they survived) must map local data the same way
+        CellConstraints constraints = minRule->getCellConstraints(cellID);
+        CellConstraints freshConstraints = freshMinRule->getCellConstraints(cellID);
+        LocalDofMapperPtr dofMapper = minRule->getDofMapper(cellID, constraints);
+        LocalDofMapperPtr freshDofMapper = freshMinRule->getDofMapper(cellID, freshConstraints);
+        TEST_ASSERT(dofMapper->globalIndices() == freshDofMapper->globalIndices());
+        
+        int localDofCount = mesh->getElementType(cellID)->trialOrderPtr->totalDofs();
+        FieldContainer<double> localData(localDofCount);
+        for (int i=0; i<localDofCount; i++) {
+          localData(i) = 1.0 / (1.0 + i);
+        }
+        bool fittableGlobalDofsOnly = false;
+        FieldContainer<double> mappedData = dofMapper->mapLocalData(localData, fittableGlobalDofsOnly);
+        FieldContainer<double> expectedMappedData = freshDofMapper->mapLocalData(localData, fittableGlobalDofsOnly);
+        TEST_EQUALITY(mappedData.size(), expectedMappedData.size());
+        if (mappedData.size() != expectedMappedData.size()) continue;
+        double tol = 1e-14;
+        for (int i=0; i<mappedData.size(); i++) {
+          TEST_FLOATING_EQUALITY(mappedData[i] + 1.0, expectedMappedData[i] + 1.0, tol); // (shifted, since entries may be zero)
+        }
+      }
+    }
+  }
+  
+  TEUCHOS_UNIT_TEST( MeshRefinement, IncrementalLookups_2D )
+  {
+    testIncrementalLookupsMatchFullRebuild(2, out, success);
+  }
+  
+  TEUCHOS_UNIT_TEST( MeshRefinement, IncrementalLookups_3D )
+  {
+    testIncrementalLookupsMatchFullRebuild(3, out, success);
+  }
 } // namespace
\ No newline at end of file
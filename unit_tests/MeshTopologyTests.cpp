@@ -78,6 +78,187 @@ namespace {
     }
   }
   
+  TEUCHOS_UNIT_TEST( MeshTopology, CellIDsForPoints)
+  {
+    int spaceDim = 2;
+    bool conformingTraces = false;
+    PoissonFormulation formulation(spaceDim, conformingTraces);
+    BFPtr bf = formulation.bf();
+    
+    int H1Order = 1, delta_k = 1;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,3);
+    vector<double> x0(spaceDim,0.0);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k, x0);
+    MeshTopologyPtr meshTopo = mesh->getTopology();
+    
+    // refine the middle cell twice, and one corner cell once
+    set<GlobalIndexType> cellsToRefine;
+    cellsToRefine.insert(4);
+    cellsToRefine.insert(8);
+    mesh->hRefine(cellsToRefine, RefinementPattern::regularRefinementPatternQuad());
+    cellsToRefine.clear();
+    CellPtr middleCell = meshTopo->getCell(4);
+    cellsToRefine.insert(middleCell->children()[0]->cellIndex());
+    mesh->hRefine(cellsToRefine, RefinementPattern::regularRefinementPatternQuad());
+    
+    // the centroid of each active cell should be located in that cell
+    set<IndexType> activeCellIndices = meshTopo->getActiveCellIndices();
+    int numPoints = activeCellIndices.size() + 1;
+    FieldContainer<double> points(numPoints,spaceDim);
+    vector<IndexType> expectedCellIDs;
+    int pointOrdinal = 0;
+    for (set<IndexType>::iterator cellIt = activeCellIndices.begin(); cellIt != activeCellIndices.end(); cellIt++, pointOrdinal++) {
+      vector<double> centroid = meshTopo->getCellCentroid(*cellIt);
+      for (int d=0; d<spaceDim; d++) {
+        points(pointOrdinal,d) = centroid[d];
+      }
+      expectedCellIDs.push_back(*cellIt);
+    }
+    // ... and a point outside the domain should not be located at all
+    points(pointOrdinal,0) = 1.5;
+    points(pointOrdinal,1) = 0.5;
+    expectedCellIDs.push_back(-1);
+    
+    vector<IndexType> cellIDs = meshTopo->cellIDsForPoints(points);
+    TEST_COMPARE_ARRAYS(cellIDs, expectedCellIDs);
+  }
+  
+  TEUCHOS_UNIT_TEST( MeshTopology, GetEntityIndexRoundTrip)
+  {
+    int spaceDim = 3;
+    bool conformingTraces = false;
+    PoissonFormulation formulation(spaceDim, conformingTraces);
+    BFPtr bf = formulation.bf();
+    
+    int H1Order = 1, delta_k = 1;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,2);
+    vector<double> x0(spaceDim,0.0);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k, x0);
+    MeshTopologyPtr meshTopo = mesh->getTopology();
+    
+    set<GlobalIndexType> cellsToRefine;
+    cellsToRefine.insert(0);
+    CellTopoPtr cellTopo = meshTopo->getCell(0)->topology();
+    mesh->hRefine(cellsToRefine, RefinementPattern::regularRefinementPattern(cellTopo));
+    
+    // looking up each entity by its vertices should give back that entity
+    for (int d=0; d<spaceDim; d++) {
+      IndexType entityCount = meshTopo->getEntityCount(d);
+      for (IndexType entityIndex=0; entityIndex<entityCount; entityIndex++) {
+        vector<IndexType> entityVertices = meshTopo->getEntityVertexIndices(d, entityIndex);
+        TEST_EQUALITY(entityVertices.size(), meshTopo->getEntityTopology(d, entityIndex)->getNodeCount());
+        set<IndexType> vertexSet(entityVertices.begin(), entityVertices.end());
+        TEST_EQUALITY(meshTopo->getEntityIndex(d, vertexSet), entityIndex);
+      }
+    }
+    
+    // a vertex set that does not form an entity should not be found: nodes 0 and 6 of a hexahedron are diagonally opposite
+    vector<IndexType> unrefinedCellVertices = meshTopo->getCell(1)->vertices();
+    set<IndexType> bogusEdgeVertices;
+    bogusEdgeVertices.insert(unrefinedCellVertices[0]);
+    bogusEdgeVertices.insert(unrefinedCellVertices[6]);
+    TEST_EQUALITY(meshTopo->getEntityIndex(1, bogusEdgeVertices), (IndexType)-1);
+  }
+  
+  TEUCHOS_UNIT_TEST( MeshTopology, GetVertexIndex)
+  {
+    int spaceDim = 2;
+    bool conformingTraces = false;
+    PoissonFormulation formulation(spaceDim, conformingTraces);
+    BFPtr bf = formulation.bf();
+    
+    int H1Order = 1, delta_k = 1;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,8);
+    vector<double> x0(spaceDim,0.0);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k, x0);
+    MeshTopologyPtr meshTopo = mesh->getTopology();
+    
+    // refinement adds vertices, including ones that coincide with the middle of existing edges
+    set<GlobalIndexType> activeCellIDs = mesh->getActiveCellIDs();
+    mesh->hRefine(activeCellIDs, RefinementPattern::regularRefinementPatternQuad());
+    
+    int vertexDim = 0;
+    IndexType numVertices = meshTopo->getEntityCount(vertexDim);
+    TEST_EQUALITY(numVertices, (2 * 8 + 1) * (2 * 8 + 1));
+    
+    double tol = 1e-14;
+    for (IndexType vertexIndex=0; vertexIndex<numVertices; vertexIndex++) {
+      vector<double> vertex = meshTopo->getVertex(vertexIndex);
+      IndexType foundVertexIndex = -1;
+      TEST_ASSERT(meshTopo->getVertexIndex(vertex, foundVertexIndex, tol));
+      TEST_EQUALITY(foundVertexIndex, vertexIndex);
+      
+      // a point within tolerance should find the same vertex
+      vector<double> nearbyPoint = vertex;
+      nearbyPoint[0] += tol / 4;
+      nearbyPoint[1] -= tol / 4;
+      TEST_ASSERT(meshTopo->getVertexIndex(nearbyPoint, foundVertexIndex, tol));
+      TEST_EQUALITY(foundVertexIndex, vertexIndex);
+      
+      // a point well outside tolerance should not find any vertex
+      vector<double> farPoint = vertex;
+      farPoint[0] += 1e-3;
+      TEST_ASSERT(!meshTopo->getVertexIndex(farPoint, foundVertexIndex, tol));
+    }
+  }
+  
+  TEUCHOS_UNIT_TEST( MeshTopology, GetVertexIndexLargeTolerance)
+  {
+    // tolerances comparable to (and larger than) the mesh size should still find the nearest vertex
+    int spaceDim = 2;
+    bool conformingTraces = false;
+    PoissonFormulation formulation(spaceDim, conformingTraces);
+    BFPtr bf = formulation.bf();
+    
+    int H1Order = 1, delta_k = 1;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,8);
+    vector<double> x0(spaceDim,0.0);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k, x0);
+    MeshTopologyPtr meshTopo = mesh->getTopology();
+    
+    double h = 1.0 / 8;
+    int vertexDim = 0;
+    IndexType numVertices = meshTopo->getEntityCount(vertexDim);
+    
+    double tol = 0.4 * h;
+    for (IndexType vertexIndex=0; vertexIndex<numVertices; vertexIndex++) {
+      vector<double> vertex = meshTopo->getVertex(vertexIndex);
+      IndexType foundVertexIndex = -1;
+      
+      // nearer to this vertex than to any other
+      vector<double> nearbyPoint = vertex;
+      nearbyPoint[0] += (vertex[0] < 0.5) ? 0.3 * h : -0.3 * h;
+      TEST_ASSERT(meshTopo->getVertexIndex(nearbyPoint, foundVertexIndex, tol));
+      TEST_EQUALITY(foundVertexIndex, vertexIndex);
+      
+      // the middle of a neighboring cell is farther than tol from every vertex
+      vector<double> cellMidpoint = vertex;
+      cellMidpoint[0] += (vertex[0] < 0.5) ? 0.5 * h : -0.5 * h;
+      cellMidpoint[1] += (vertex[1] < 0.5) ? 0.5 * h : -0.5 * h;
+      TEST_ASSERT(!meshTopo->getVertexIndex(cellMidpoint, foundVertexIndex, tol));
+      
+      // a tolerance larger than the domain finds the nearest vertex
+      TEST_ASSERT(meshTopo->getVertexIndex(nearbyPoint, foundVertexIndex, 10.0));
+      TEST_EQUALITY(foundVertexIndex, vertexIndex);
+    }
+    
+    // vertices added after the large-tolerance lookups are found with a tight tolerance
+    set<GlobalIndexType> activeCellIDs = mesh->getActiveCellIDs();
+    mesh->hRefine(activeCellIDs, RefinementPattern::regularRefinementPatternQuad());
+    numVertices = meshTopo->getEntityCount(vertexDim);
+    TEST_EQUALITY(numVertices, (2 * 8 + 1) * (2 * 8 + 1));
+    for (IndexType vertexIndex=0; vertexIndex<numVertices; vertexIndex++) {
+      vector<double> vertex = meshTopo->getVertex(vertexIndex);
+      IndexType foundVertexIndex = -1;
+      TEST_ASSERT(meshTopo->getVertexIndex(vertex, foundVertexIndex, 1e-14));
+      TEST_EQUALITY(foundVertexIndex, vertexIndex);
+    }
+  }
+  
   TEUCHOS_UNIT_TEST( MeshTopology, DeactivateCellOnRefinement)
   {
     // one easy way to create a quad mesh topology is to use MeshFactory
@@ -0,0 +1,109 @@
+//
+//  PhaseTimersTests.cpp
+//  Camellia
+//
+//
+
+#include "Teuchos_GlobalMPISession.hpp"
+#include "Teuchos_UnitTestHarness.hpp"
+
+#include "MeshFactory.h"
+#include "PhaseTimers.h"
+#include "PoissonFormulation.h"
+#include "Solution.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+  TEUCHOS_UNIT_TEST( PhaseTimers, NestedPhases )
+  {
+    PhaseTimers* timers = PhaseTimers::phaseTimers();
+    timers->clear();
+
+    for (int i=0; i<3; i++) {
+      ScopedPhaseTimer outer("outer");
+      {
+        ScopedPhaseTimer inner("inner");
+      }
+      timers->start("unstopped");
+      // stopping "outer" (when outer goes out of scope) should also stop "unstopped"
+    }
+    {
+      ScopedPhaseTimer inner("inner"); // same name, different parent
+    }
+    timers->stop("never started"); // should be ignored
+
+    TEST_EQUALITY(timers->callCount("outer"), 3);
+    TEST_EQUALITY(timers->callCount("outer/inner"), 3);
+    TEST_EQUALITY(timers->callCount("outer/unstopped"), 3);
+    TEST_EQUALITY(timers->callCount("inner"), 1);
+    TEST_EQUALITY(timers->callCount("never started"), 0);
+    TEST_COMPARE(timers->totalTime("outer"), >=, timers->totalTime("outer/inner"));
+
+    vector<PhaseTimers::PhaseStatistics> stats = timers->statistics();
+    TEST_EQUALITY(stats.size(), 4);
+    // parents precede their children
+    TEST_EQUALITY(stats[1].path.size(), 1);
+    TEST_EQUALITY(stats[1].path[0], "outer");
+    TEST_EQUALITY(stats[2].path.size(), 2);
+    TEST_EQUALITY(stats[2].path[0], "outer");
+    for (int i=0; i<stats.size(); i++) {
+      TEST_COMPARE(stats[i].time.min, <=, stats[i].time.max);
+      TEST_COMPARE(stats[i].imbalance, >=, 1.0);
+    }
+
+    timers->clear();
+    TEST_EQUALITY(timers->callCount("outer"), 0);
+  }
+
+  TEUCHOS_UNIT_TEST( PhaseTimers, ExportPerSolve )
+  {
+    int spaceDim = 2;
+    bool useConformingTraces = false;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+
+    int H1Order = 2, delta_k = 1;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,2);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(1.0 * form.q());
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), Function::zero());
+    SolutionPtr soln = Solution::solution(mesh, bc, rhs, bf->graphNorm());
+
+    PhaseTimers* timers = PhaseTimers::phaseTimers();
+    timers->clear();
+    string filePath = "PhaseTimersTests_ExportPerSolve.csv"; // relative to the working directory
+    timers->setSolveExportFile(filePath, PhaseTimers::CSV);
+    soln->solve();
+    soln->solve();
+    timers->setSolveExportFile("", PhaseTimers::CSV);
+
+    // each solve's statistics are written, and then cleared
+    TEST_EQUALITY(timers->callCount("solve"), 0);
+
+    if (Teuchos::GlobalMPISession::getRank() == 0) {
+      ifstream fin(filePath.c_str());
+      string line;
+      getline(fin, line);
+      TEST_EQUALITY(line, "solve,phase,depth,calls,min,mean,max,sum,imbalance");
+      int assemblyRowCount = 0, linearSolveRowCount = 0;
+      while (getline(fin, line)) {
+        if (line.find("\"solve/assembly\"") != string::npos) {
+          TEST_ASSERT((line.find("0,") == 0) || (line.find("1,") == 0));
+          assemblyRowCount++;
+        }
+        if (line.find("\"solve/linear solve\"") != string::npos) linearSolveRowCount++;
+      }
+      TEST_EQUALITY(assemblyRowCount, 2);
+      TEST_EQUALITY(linearSolveRowCount, 2);
+      fin.close();
+      remove(filePath.c_str());
+    }
+  }
+} // namespace
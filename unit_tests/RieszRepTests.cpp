@@ -50,4 +50,97 @@ namespace {
     
     TEST_FLOATING_EQUALITY(expectedNorm,actualNorm, tol);
   }
-} // namespace
\ No newline at end of file
+  
+  TEUCHOS_UNIT_TEST( RieszRep, CachedGramFactorizations )
+  {
+    int spaceDim = 2;
+    bool conformingTraces = true;
+    
+    PoissonFormulation form(spaceDim,conformingTraces);
+    BFPtr bf = form.bf();
+    
+    IPPtr ip = bf->graphNorm();
+    
+    int H1Order = 2;
+    vector<double> dimensions(2,1.0);
+    vector<int> elementCounts(2,2);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order);
+    
+    LinearTermPtr lt1 = Function::xn(1) * form.q();
+    LinearTermPtr lt2 = Function::yn(2) * form.q() + Function::constant(1.0) * form.tau()->x();
+    
+    RieszRepPtr cachingRieszRep = Teuchos::rcp( new RieszRep(mesh, ip, lt1) );
+    cachingRieszRep->setCacheGramFactorizations(true);
+    
+    double tol = 1e-13;
+    for (int refinement=0; refinement<2; refinement++) {
+      // the second functional reuses the Gram factorizations computed for the first
+      for (int ltOrdinal=0; ltOrdinal<2; ltOrdinal++) {
+        LinearTermPtr lt = (ltOrdinal == 0) ? lt1 : lt2;
+        cachingRieszRep->setFunctional(lt);
+        cachingRieszRep->computeRieszRep();
+        
+        RieszRepPtr freshRieszRep = Teuchos::rcp( new RieszRep(mesh, ip, lt) );
+        freshRieszRep->computeRieszRep();
+        
+        TEST_FLOATING_EQUALITY(cachingRieszRep->getNorm(), freshRieszRep->getNorm(), tol);
+      }
+      // after refinement, the cached factorizations no longer match the mesh, and should be recomputed
+      set<GlobalIndexType> cellsToRefine;
+      cellsToRefine.insert(0);
+      mesh->hRefine(cellsToRefine, RefinementPattern::regularRefinementPatternQuad());
+    }
+  }
+  
+  TEUCHOS_UNIT_TEST( RieszRep, CachedGramFactorizationsMultipleBatchesAndTypes )
+  {
+    int spaceDim = 2;
+    bool conformingTraces = true;
+    
+    PoissonFormulation form(spaceDim,conformingTraces);
+    BFPtr bf = form.bf();
+    
+    IPPtr ip = bf->graphNorm();
+    
+    int H1Order = 2;
+    vector<double> dimensions(2,1.0);
+    vector<int> elementCounts(2,3);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order);
+    
+    // p-refine some cells, so that there are two element types, each spanning several batches
+    set<GlobalIndexType> cellsToPRefine;
+    cellsToPRefine.insert(0);
+    cellsToPRefine.insert(4);
+    cellsToPRefine.insert(8);
+    mesh->pRefine(cellsToPRefine);
+    TEST_EQUALITY(mesh->elementTypes().size(), 2);
+    
+    LinearTermPtr lt1 = Function::xn(1) * form.q();
+    LinearTermPtr lt2 = Function::yn(2) * form.q() + Function::constant(1.0) * form.tau()->x();
+    
+    RieszRepPtr cachingRieszRep = Teuchos::rcp( new RieszRep(mesh, ip, lt1) );
+    cachingRieszRep->setCacheGramFactorizations(true);
+    cachingRieszRep->setMaxCellsPerBatch(2);
+    
+    double tol = 1e-13;
+    for (int ltOrdinal=0; ltOrdinal<2; ltOrdinal++) {
+      LinearTermPtr lt = (ltOrdinal == 0) ? lt1 : lt2;
+      cachingRieszRep->setFunctional(lt);
+      cachingRieszRep->computeRieszRep();
+      
+      RieszRepPtr freshRieszRep = Teuchos::rcp( new RieszRep(mesh, ip, lt) );
+      freshRieszRep->computeRieszRep();
+      
+      // compare cell by cell: a batch that used another batch's factors would show up here
+      const map<GlobalIndexType,double>* cachedNormsSquared = &cachingRieszRep->getNormsSquared();
+      const map<GlobalIndexType,double>* freshNormsSquared = &freshRieszRep->getNormsSquared();
+      TEST_EQUALITY(cachedNormsSquared->size(), freshNormsSquared->size());
+      for (map<GlobalIndexType,double>::const_iterator entryIt = freshNormsSquared->begin();
+           entryIt != freshNormsSquared->end(); entryIt++) {
+        TEST_EQUALITY(cachedNormsSquared->count(entryIt->first), 1);
+        if (cachedNormsSquared->count(entryIt->first) == 0) continue;
+        TEST_FLOATING_EQUALITY(cachedNormsSquared->find(entryIt->first)->second, entryIt->second, tol);
+      }
+    }
+  }
+} // namespace
@@ -101,4 +101,63 @@ namespace {
       TEST_COMPARE_FLOATING_ARRAYS(outInverses, expectedOutInverses, 1e-13);
     }
   }
-} // namespace
\ No newline at end of file
+  
+  TEUCHOS_UNIT_TEST( SerialDenseWrapper, SolveSPDSystemsMultipleRHSTransposed )
+  {
+    // compare the batched Cholesky solve against the per-matrix solveSPDSystemMultipleRHS()
+    int numCells = 3;
+    int N = 4;
+    int nRHS = 2;
+    
+    FieldContainer<double> A(numCells,N,N);
+    FieldContainer<double> b(numCells,N,nRHS);
+    for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+      // symmetric, strictly diagonally dominant with positive diagonal => SPD
+      for (int i=0; i<N; i++) {
+        for (int j=0; j<N; j++) {
+          A(cellOrdinal,i,j) = (i==j) ? 10.0 * (cellOrdinal + 1) + i : 1.0 / (i + j + 1);
+        }
+        for (int j=0; j<nRHS; j++) {
+          b(cellOrdinal,i,j) = i - 2.0 * j + cellOrdinal;
+        }
+      }
+    }
+    
+    FieldContainer<double> xTranspose(numCells,nRHS,N);
+    std::vector<int> failedCellOrdinals;
+    int err = SerialDenseWrapper::solveSPDSystemsMultipleRHSTransposed(xTranspose, A, b, failedCellOrdinals);
+    TEST_EQUALITY(err, 0);
+    TEST_EQUALITY(failedCellOrdinals.size(), 0);
+    
+    for (int cellOrdinal=0; cellOrdinal<numCells; cellOrdinal++) {
+      FieldContainer<double> cellA(N,N);
+      FieldContainer<double> cellB(N,nRHS);
+      for (int i=0; i<N; i++) {
+        for (int j=0; j<N; j++) {
+          cellA(i,j) = A(cellOrdinal,i,j);
+        }
+        for (int j=0; j<nRHS; j++) {
+          cellB(i,j) = b(cellOrdinal,i,j);
+        }
+      }
+      FieldContainer<double> expectedX(N,nRHS);
+      SerialDenseWrapper::solveSPDSystemMultipleRHS(expectedX, cellA, cellB);
+      
+      double tol = 1e-13;
+      for (int i=0; i<N; i++) {
+        for (int j=0; j<nRHS; j++) {
+          TEST_FLOATING_EQUALITY(xTranspose(cellOrdinal,j,i), expectedX(i,j), tol);
+        }
+      }
+    }
+    
+    // a matrix that is not SPD should be reported as a failure
+    A(1,0,0) = -1.0;
+    err = SerialDenseWrapper::solveSPDSystemsMultipleRHSTransposed(xTranspose, A, b, failedCellOrdinals);
+    TEST_INEQUALITY(err, 0);
+    TEST_EQUALITY(failedCellOrdinals.size(), 1);
+    if (failedCellOrdinals.size() == 1) {
+      TEST_EQUALITY(failedCellOrdinals[0], 1);
+    }
+  }
+} // namespace
@@ -18,7 +18,9 @@
 #include "HDF5Exporter.h"
 #include "MeshFactory.h"
 #include "MeshTools.h"
+#include "ParameterFunction.h"
 #include "PoissonFormulation.h"
+#include "RieszRep.h"
 #include "Solution.h"
 
 namespace {
@@ -53,6 +55,331 @@ namespace {
     return v;
   }
 
+  TEUCHOS_UNIT_TEST( Solution, EnergyErrorMatchesRieszRepresentation )
+  {
+    // the energy error is the norm of the Riesz representation of the residual l(v) - b(u_h, v)
+    int spaceDim = 2;
+    bool useConformingTraces = false;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+    
+    int H1Order = 2, delta_k = 2;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts;
+    elementCounts.push_back(2);
+    elementCounts.push_back(3);
+    vector<double> x0(spaceDim,0.0);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k, x0);
+    
+    // p-refine one cell so that the mesh has more than one element type
+    set<GlobalIndexType> cellsToRefine;
+    cellsToRefine.insert(0);
+    mesh->pRefine(cellsToRefine);
+    
+    SolutionPtr soln = Solution::solution(mesh);
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(Function::constant(1.0) * form.q());
+    IPPtr ip = bf->graphNorm();
+    soln->setRHS(rhs);
+    soln->setIP(ip);
+    
+    map<int, FunctionPtr> solnMap;
+    solnMap[form.phi()->ID()] = Function::xn(2) * Function::yn(1);
+    soln->projectOntoMesh(solnMap);
+    
+    double energyError = soln->energyErrorTotal();
+    
+    LinearTermPtr residual = rhs->linearTermCopy() - bf->testFunctional(soln);
+    RieszRepPtr rieszRep = Teuchos::rcp( new RieszRep(mesh, ip, residual) );
+    rieszRep->computeRieszRep();
+    
+    double tol = 1e-10;
+    TEST_FLOATING_EQUALITY(energyError, rieszRep->getNorm(), tol);
+  }
+  
+  TEUCHOS_UNIT_TEST( Solution, CondensedSolveMatchesStandardSolve )
+  {
+    // the condensed solve recovers field dofs from cached field-block factorizations; check against an uncondensed solve
+    int spaceDim = 2;
+    bool useConformingTraces = false;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+    
+    int H1Order = 3, delta_k = 2;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,2);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+    
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(Function::xn(1) * form.q());
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), Function::zero());
+    IPPtr ip = bf->graphNorm();
+    
+    SolutionPtr standardSoln = Solution::solution(mesh, bc, rhs, ip);
+    standardSoln->solve();
+    
+    // (L2NormOfSolution returns the square of the norm)
+    double phiNormSquared = standardSoln->L2NormOfSolution(form.phi()->ID());
+    
+    // condensation runs alongside the threaded local stiffness computation; try both one and two threads
+    for (int numThreads=1; numThreads<=2; numThreads++) {
+      SolutionPtr condensedSoln = Solution::solution(mesh, bc, rhs, ip);
+      condensedSoln->setUseCondensedSolve(true);
+      condensedSoln->setNumAssemblyThreads(numThreads);
+      condensedSoln->solve();
+      
+      condensedSoln->addSolution(standardSoln, -1.0);
+      
+      double tol = 1e-20;
+      TEST_COMPARE(condensedSoln->L2NormOfSolution(form.phi()->ID()), <, tol * phiNormSquared);
+    }
+  }
+  
+  TEUCHOS_UNIT_TEST( Solution, ThreadedAssemblyMatchesSerialAssembly )
+  {
+    // with several threads, local stiffness and dof interpretation run concurrently; the result should not change.
+    // A hanging node and a p-refinement give constrained cells and more than one element type.
+#ifndef _OPENMP
+    out << "Skipping: built without OpenMP, so assembly runs on a single thread and there is nothing to compare.\n";
+    return;
+#endif
+    int spaceDim = 2;
+    bool useConformingTraces = true;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+
+    int H1Order = 2, delta_k = 2;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,3);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+    set<GlobalIndexType> cellsToRefine;
+    cellsToRefine.insert(4);
+    mesh->hRefine(cellsToRefine, RefinementPattern::regularRefinementPatternQuad());
+    cellsToRefine.clear();
+    cellsToRefine.insert(0);
+    mesh->pRefine(cellsToRefine);
+
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(Function::xn(1) * form.q());
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), Function::zero());
+    IPPtr ip = bf->graphNorm();
+
+    SolutionPtr serialSoln = Solution::solution(mesh, bc, rhs, ip);
+    serialSoln->setNumAssemblyThreads(1);
+    serialSoln->solve();
+    double serialStiffnessNorm = serialSoln->getStiffnessMatrix()->NormFrobenius();
+    // (L2NormOfSolution returns the square of the norm)
+    double phiNormSquared = serialSoln->L2NormOfSolution(form.phi()->ID());
+
+    int numThreads = 4;
+    SolutionPtr threadedSoln = Solution::solution(mesh, bc, rhs, ip);
+    threadedSoln->setNumAssemblyThreads(numThreads);
+    threadedSoln->solve();
+
+    double tol = 1e-13;
+    TEST_FLOATING_EQUALITY(threadedSoln->getStiffnessMatrix()->NormFrobenius(), serialStiffnessNorm, tol);
+    threadedSoln->addSolution(serialSoln, -1.0);
+    TEST_COMPARE(threadedSoln->L2NormOfSolution(form.phi()->ID()), <, 1e-20 * phiNormSquared);
+  }
+
+  TEUCHOS_UNIT_TEST( Solution, StiffnessGraphReusedUntilRefinement )
+  {
+    // repeated solves should zero and refill the same matrix; refinement should force a new graph
+    int spaceDim = 2;
+    bool useConformingTraces = false;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+    
+    int H1Order = 2, delta_k = 2;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,2);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+    
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(Function::xn(1) * form.q());
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), Function::zero());
+    IPPtr ip = bf->graphNorm();
+    
+    SolutionPtr soln = Solution::solution(mesh, bc, rhs, ip);
+    soln->solve();
+    Epetra_CrsMatrix* firstMatrix = soln->getStiffnessMatrix().get();
+    int firstNonzeroCount = firstMatrix->NumGlobalNonzeros();
+    // (L2NormOfSolution returns the square of the norm)
+    double phiNormSquared = soln->L2NormOfSolution(form.phi()->ID());
+    
+    soln->solve();
+    TEST_EQUALITY(soln->getStiffnessMatrix().get(), firstMatrix);
+    TEST_EQUALITY(soln->getStiffnessMatrix()->NumGlobalNonzeros(), firstNonzeroCount);
+    double tol = 1e-14;
+    TEST_FLOATING_EQUALITY(soln->L2NormOfSolution(form.phi()->ID()), phiNormSquared, tol);
+    
+    mesh->hRefine(mesh->getActiveCellIDs());
+    soln->solve();
+    TEST_COMPARE(soln->getStiffnessMatrix()->NumGlobalNonzeros(), >, firstNonzeroCount);
+    
+    SolutionPtr freshSoln = Solution::solution(mesh, bc, rhs, ip);
+    freshSoln->solve();
+    phiNormSquared = freshSoln->L2NormOfSolution(form.phi()->ID());
+    soln->addSolution(freshSoln, -1.0);
+    TEST_COMPARE(soln->L2NormOfSolution(form.phi()->ID()), <, 1e-20 * phiNormSquared);
+  }
+  
+  TEUCHOS_UNIT_TEST( Solution, ReuseStiffnessMatchesStandardSolve )
+  {
+    // with reused stiffness, solves after the first assemble only the load; RHS and BC values change between solves
+    int spaceDim = 2;
+    bool useConformingTraces = false;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+    
+    int H1Order = 2, delta_k = 2;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,2);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+    
+    ParameterFunctionPtr rhsWeight = ParameterFunction::parameterFunction(1.0);
+    ParameterFunctionPtr bcValue = ParameterFunction::parameterFunction(0.0);
+    FunctionPtr f = rhsWeight;
+    FunctionPtr phi_hat_value = bcValue;
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(f * Function::xn(1) * form.q());
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), phi_hat_value);
+    IPPtr ip = bf->graphNorm();
+    
+    SolutionPtr reusedSoln = Solution::solution(mesh, bc, rhs, ip);
+    reusedSoln->setReuseStiffness(true);
+    
+    double rhsWeights[3] = {1.0, 2.0, -1.0};
+    double bcValues[3] = {0.0, 1.0, 3.0};
+    for (int solveOrdinal=0; solveOrdinal<3; solveOrdinal++) {
+      rhsWeight->setValue(rhsWeights[solveOrdinal]);
+      bcValue->setValue(bcValues[solveOrdinal]);
+      
+      reusedSoln->solve();
+      
+      SolutionPtr standardSoln = Solution::solution(mesh, bc, rhs, ip);
+      standardSoln->solve();
+      
+      // (L2NormOfSolution returns the square of the norm)
+      double phiNormSquared = standardSoln->L2NormOfSolution(form.phi()->ID());
+      
+      SolutionPtr diffSoln = Solution::solution(mesh, bc, rhs, ip);
+      diffSoln->setSolution(reusedSoln);
+      diffSoln->addSolution(standardSoln, -1.0);
+      
+      double tol = 1e-20;
+      TEST_COMPARE(diffSoln->L2NormOfSolution(form.phi()->ID()), <, tol * phiNormSquared);
+    }
+  }
+  
+  TEUCHOS_UNIT_TEST( Solution, StiffnessCacheMatchesStandardSolve )
+  {
+    // on a rectilinear mesh, cached local stiffness matrices should reproduce the standard solve
+    int spaceDim = 2;
+    bool useConformingTraces = false;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+    
+    int H1Order = 3, delta_k = 2;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,4);
+    MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+    
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(Function::xn(1) * form.q()); // varies from cell to cell
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), Function::zero());
+    IPPtr ip = bf->graphNorm();
+    
+    SolutionPtr standardSoln = Solution::solution(mesh, bc, rhs, ip);
+    standardSoln->solve();
+    
+    // (L2NormOfSolution returns the square of the norm)
+    double phiNormSquared = standardSoln->L2NormOfSolution(form.phi()->ID());
+    
+    int numMyCells = mesh->cellIDsInPartition().size();
+    double tol = 1e-20;
+    
+    bf->setUseStiffnessCache(true);
+    // the first solve fills the cache; the second uses it for every cell
+    for (int solveOrdinal=0; solveOrdinal<2; solveOrdinal++) {
+      long long hitCount = bf->stiffnessCacheHitCount();
+      SolutionPtr cachedSoln = Solution::solution(mesh, bc, rhs, ip);
+      cachedSoln->solve();
+      TEST_COMPARE(bf->stiffnessCacheSize(), >, 0);
+      long long expectedHits = (solveOrdinal == 0) ? 0 : numMyCells;
+      TEST_EQUALITY(bf->stiffnessCacheHitCount() - hitCount, expectedHits);
+      
+      cachedSoln->addSolution(standardSoln, -1.0);
+      TEST_COMPARE(cachedSoln->L2NormOfSolution(form.phi()->ID()), <, tol * phiNormSquared);
+    }
+    
+    // enriched cubature gives different matrices, so it must not hit the entries computed above
+    {
+      int cacheSize = bf->stiffnessCacheSize();
+      long long hitCount = bf->stiffnessCacheHitCount();
+      SolutionPtr enrichedSoln = Solution::solution(mesh, bc, rhs, ip);
+      enrichedSoln->setCubatureEnrichmentDegree(2);
+      enrichedSoln->solve();
+      TEST_EQUALITY(bf->stiffnessCacheHitCount(), hitCount);
+      TEST_COMPARE(bf->stiffnessCacheSize(), >, cacheSize);
+    }
+    
+    // a full cache computes new matrices without storing them
+    bf->clearStiffnessCache();
+    bf->setStiffnessCacheMaxMemoryInBytes(0);
+    {
+      SolutionPtr uncachedSoln = Solution::solution(mesh, bc, rhs, ip);
+      uncachedSoln->solve();
+      TEST_EQUALITY(bf->stiffnessCacheSize(), 0);
+      TEST_EQUALITY(bf->stiffnessCacheMemoryInBytes(), 0);
+      uncachedSoln->addSolution(standardSoln, -1.0);
+      TEST_COMPARE(uncachedSoln->L2NormOfSolution(form.phi()->ID()), <, tol * phiNormSquared);
+    }
+    
+    bf->clearStiffnessCache();
+    bf->setUseStiffnessCache(false);
+    TEST_EQUALITY(bf->stiffnessCacheSize(), 0);
+    TEST_EQUALITY(bf->stiffnessCacheHitCount(), 0);
+    
+    bf->setUseStiffnessCache(true);
+    bf->setStiffnessCacheMaxMemoryInBytes(256 * 1024 * 1024);
+    Solution::solution(mesh, bc, rhs, ip)->solve();
+    TEST_COMPARE(bf->stiffnessCacheSize(), >, 0);
+    
+    // after an h-refinement, the new cells miss the cache, while the cells in their batches that are unchanged hit it
+    {
+      set<GlobalIndexType> cellsToRefine;
+      cellsToRefine.insert(0);
+      mesh->hRefine(cellsToRefine, RefinementPattern::regularRefinementPatternQuad());
+      
+      bf->setUseStiffnessCache(false);
+      SolutionPtr refinedStandardSoln = Solution::solution(mesh, bc, rhs, ip);
+      refinedStandardSoln->solve();
+      bf->setUseStiffnessCache(true);
+      
+      int cacheSize = bf->stiffnessCacheSize();
+      long long hitCount = bf->stiffnessCacheHitCount();
+      SolutionPtr refinedSoln = Solution::solution(mesh, bc, rhs, ip);
+      refinedSoln->solve();
+      TEST_COMPARE(bf->stiffnessCacheHitCount(), >, hitCount);
+      TEST_COMPARE(bf->stiffnessCacheSize(), >=, cacheSize);
+      
+      double refinedPhiNormSquared = refinedStandardSoln->L2NormOfSolution(form.phi()->ID());
+      refinedSoln->addSolution(refinedStandardSoln, -1.0);
+      TEST_COMPARE(refinedSoln->L2NormOfSolution(form.phi()->ID()), <, tol * refinedPhiNormSquared);
+    }
+    
+    // adding a term to the BF invalidates the cache
+    bf->addTerm(form.phi(), form.q());
+    TEST_EQUALITY(bf->stiffnessCacheSize(), 0);
+    bf->setUseStiffnessCache(false);
+  }
+  
   TEUCHOS_UNIT_TEST( Solution, ImportOffRankCellData )
   {
     int numCells = 8;
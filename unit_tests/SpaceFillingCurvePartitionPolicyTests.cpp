@@ -0,0 +1,179 @@
+//
+//  SpaceFillingCurvePartitionPolicyTests.cpp
+//  Camellia
+//
+//
+
+#include "Teuchos_UnitTestHarness.hpp"
+#include "Teuchos_UnitTestHelpers.hpp"
+
+#include "MeshFactory.h"
+#include "PoissonFormulation.h"
+#include "Solution.h"
+#include "SpaceFillingCurvePartitionPolicy.h"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+  void testHilbertCurveIsContinuous(int spaceDim, Teuchos::FancyOStream &out, bool &success) {
+    // visiting the points of a 2^b x ... x 2^b grid in Hilbert order, each step should be to a neighbor
+    int bitsPerDimension = 2;
+    int pointsPerSide = 1 << bitsPerDimension;
+    int numPoints = 1;
+    for (int d=0; d<spaceDim; d++) numPoints *= pointsPerSide;
+
+    vector< vector<unsigned> > pointsInCurveOrder(numPoints);
+    for (int pointOrdinal=0; pointOrdinal<numPoints; pointOrdinal++) {
+      vector<unsigned> coordinates(spaceDim);
+      int remainder = pointOrdinal;
+      for (int d=0; d<spaceDim; d++) {
+        coordinates[d] = remainder % pointsPerSide;
+        remainder /= pointsPerSide;
+      }
+      unsigned long long index = SpaceFillingCurvePartitionPolicy::hilbertIndex(coordinates, bitsPerDimension);
+      TEST_COMPARE(index, <, (unsigned long long) numPoints);
+      if (index >= numPoints) return;
+      TEST_EQUALITY(pointsInCurveOrder[index].size(), 0); // each index used once
+      pointsInCurveOrder[index] = coordinates;
+    }
+    for (int i=1; i<numPoints; i++) {
+      int distance = 0;
+      for (int d=0; d<spaceDim; d++) {
+        distance += abs((int)pointsInCurveOrder[i][d] - (int)pointsInCurveOrder[i-1][d]);
+      }
+      TEST_EQUALITY(distance, 1);
+    }
+  }
+
+  TEUCHOS_UNIT_TEST( SpaceFillingCurvePartitionPolicy, HilbertCurveIsContinuous_2D )
+  {
+    testHilbertCurveIsContinuous(2, out, success);
+  }
+
+  TEUCHOS_UNIT_TEST( SpaceFillingCurvePartitionPolicy, HilbertCurveIsContinuous_3D )
+  {
+    testHilbertCurveIsContinuous(3, out, success);
+  }
+
+  TEUCHOS_UNIT_TEST( SpaceFillingCurvePartitionPolicy, PartitionsAreBalanced )
+  {
+    MeshTopologyPtr meshTopo = MeshFactory::quadMeshTopology(1.0, 1.0, 4, 4);
+    int numPartitions = 4;
+
+    SpaceFillingCurvePartitionPolicy partitionPolicy;
+    vector< set<GlobalIndexType> > partitions = partitionPolicy.partitionCells(meshTopo, numPartitions);
+
+    TEST_EQUALITY(partitions.size(), numPartitions);
+    set<GlobalIndexType> partitionedCells;
+    for (int partitionNumber=0; partitionNumber<numPartitions; partitionNumber++) {
+      TEST_EQUALITY(partitions[partitionNumber].size(), 4);
+      partitionedCells.insert(partitions[partitionNumber].begin(), partitions[partitionNumber].end());
+    }
+    TEST_ASSERT(partitionedCells == meshTopo->getActiveCellIndices());
+
+    // on a uniform grid, the Hilbert curve cuts the square into its four quadrants
+    for (int partitionNumber=0; partitionNumber<numPartitions; partitionNumber++) {
+      vector<double> minCentroid(2,1.0), maxCentroid(2,0.0);
+      for (set<GlobalIndexType>::iterator cellIt = partitions[partitionNumber].begin(); cellIt != partitions[partitionNumber].end(); cellIt++) {
+        vector<double> centroid = meshTopo->getCellCentroid(*cellIt);
+        for (int d=0; d<2; d++) {
+          minCentroid[d] = min(minCentroid[d], centroid[d]);
+          maxCentroid[d] = max(maxCentroid[d], centroid[d]);
+        }
+      }
+      for (int d=0; d<2; d++) {
+        TEST_COMPARE(maxCentroid[d] - minCentroid[d], <, 0.5);
+      }
+    }
+
+    // refinement keeps the cells that were not refined where they were
+    set<GlobalIndexType> cellsToRefine;
+    cellsToRefine.insert(*partitions[0].begin());
+    meshTopo->refineCell(*partitions[0].begin(), RefinementPattern::regularRefinementPatternQuad());
+    vector< set<GlobalIndexType> > refinedPartitions = partitionPolicy.partitionCells(meshTopo, numPartitions);
+    int cellsMoved = 0;
+    for (int partitionNumber=0; partitionNumber<numPartitions; partitionNumber++) {
+      for (set<GlobalIndexType>::iterator cellIt = partitions[partitionNumber].begin(); cellIt != partitions[partitionNumber].end(); cellIt++) {
+        if (cellsToRefine.find(*cellIt) != cellsToRefine.end()) continue;
+        if (refinedPartitions[partitionNumber].find(*cellIt) == refinedPartitions[partitionNumber].end()) cellsMoved++;
+      }
+    }
+    // the three cells added shift each cut by at most three cells; everything else stays put
+    TEST_COMPARE(cellsMoved, <=, 3 * (numPartitions - 1));
+  }
+
+  TEUCHOS_UNIT_TEST( SpaceFillingCurvePartitionPolicy, WeightsShiftPartitionBoundaries )
+  {
+    MeshTopologyPtr meshTopo = MeshFactory::quadMeshTopology(1.0, 1.0, 4, 4);
+    int numPartitions = 2;
+
+    SpaceFillingCurvePartitionPolicy partitionPolicy;
+    vector< set<GlobalIndexType> > partitions = partitionPolicy.partitionCells(meshTopo, numPartitions);
+
+    // make the first partition's cells three times as expensive: it should now get fewer of them
+    map<GlobalIndexType, double> cellWeights;
+    for (set<GlobalIndexType>::iterator cellIt = partitions[0].begin(); cellIt != partitions[0].end(); cellIt++) {
+      cellWeights[*cellIt] = 3.0;
+    }
+    partitionPolicy.setCellWeights(cellWeights);
+    vector< set<GlobalIndexType> > weightedPartitions = partitionPolicy.partitionCells(meshTopo, numPartitions);
+
+    TEST_EQUALITY(weightedPartitions[0].size() + weightedPartitions[1].size(), 16);
+    TEST_COMPARE(weightedPartitions[0].size(), <, partitions[0].size());
+    double weight[2] = {0.0, 0.0};
+    for (int partitionNumber=0; partitionNumber<numPartitions; partitionNumber++) {
+      for (set<GlobalIndexType>::iterator cellIt = weightedPartitions[partitionNumber].begin(); cellIt != weightedPartitions[partitionNumber].end(); cellIt++) {
+        weight[partitionNumber] += (cellWeights.find(*cellIt) != cellWeights.end()) ? cellWeights[*cellIt] : 1.0;
+      }
+    }
+    TEST_COMPARE(fabs(weight[0] - weight[1]), <=, 3.0);
+
+    cellWeights[*partitions[0].begin()] = -1.0;
+    TEST_THROW(partitionPolicy.setCellWeights(cellWeights), std::invalid_argument);
+  }
+
+  TEUCHOS_UNIT_TEST( SpaceFillingCurvePartitionPolicy, SolveMatchesStandardPartition )
+  {
+    // solve, refine (migrating the solution), and solve again; compare with the same sequence under the standard policy.
+    // Cells only change ranks with more than one rank; unit_tests/CMakeLists.txt also runs this group on two.
+    int spaceDim = 2;
+    bool useConformingTraces = true;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    BFPtr bf = form.bf();
+
+    RHSPtr rhs = RHS::rhs();
+    rhs->addTerm(Function::xn(1) * form.q());
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), Function::zero());
+    IPPtr ip = bf->graphNorm();
+
+    int H1Order = 2, delta_k = 2;
+    vector<double> dimensions(spaceDim,1.0);
+    vector<int> elementCounts(spaceDim,3);
+
+    double projectedPhiNormSquared[2], phiNormSquared[2];
+    for (int i=0; i<2; i++) {
+      bool useSpaceFillingCurve = (i == 1);
+      MeshPtr mesh = MeshFactory::rectilinearMesh(bf, dimensions, elementCounts, H1Order, delta_k);
+      if (useSpaceFillingCurve) mesh->setPartitionPolicy(MeshPartitionPolicy::spaceFillingCurvePartitionPolicy());
+
+      SolutionPtr soln = Solution::solution(mesh, bc, rhs, ip);
+      mesh->registerSolution(soln);
+      soln->solve();
+
+      set<GlobalIndexType> cellsToRefine;
+      cellsToRefine.insert(0);
+      cellsToRefine.insert(4);
+      mesh->hRefine(cellsToRefine, RefinementPattern::regularRefinementPatternQuad());
+      // before solving again: the projected solution, which for the curve policy was migrated along with its cells
+      projectedPhiNormSquared[i] = soln->L2NormOfSolution(form.phi()->ID());
+      soln->solve();
+
+      phiNormSquared[i] = soln->L2NormOfSolution(form.phi()->ID());
+    }
+    double tol = 1e-12;
+    TEST_FLOATING_EQUALITY(projectedPhiNormSquared[0], projectedPhiNormSquared[1], tol);
+    TEST_FLOATING_EQUALITY(phiNormSquared[0], phiNormSquared[1], tol);
+  }
+} // namespace
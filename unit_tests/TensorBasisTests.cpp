@@ -27,6 +27,7 @@
 
 #include "TensorBasis.h"
 
+#include "BasisCache.h"
 #include "BasisFactory.h"
 #include "CellTopology.h"
 
@@ -322,4 +323,71 @@ namespace {
     }
   }
   
+  TEUCHOS_UNIT_TEST( TensorBasis, SumFactorizedValuesMatchPointwiseValues ) {
+    // TensorBasis evaluates its component bases only on the distinct spatial and temporal points;
+    // check that on a tensor-product cubature this agrees with evaluating one point at a time.
+    int H1Order = 3;
+    
+    BasisFactoryPtr basisFactory = BasisFactory::basisFactory();
+    BasisPtr spatialBasis = basisFactory->getBasis(H1Order, CellTopology::quad(), Camellia::FUNCTION_SPACE_HGRAD);
+    BasisPtr temporalBasis = basisFactory->getBasis(H1Order, CellTopology::line(), Camellia::FUNCTION_SPACE_HGRAD);
+    
+    typedef Camellia::TensorBasis<double, FieldContainer<double> > TensorBasis;
+    Teuchos::RCP<TensorBasis> tensorBasis = Teuchos::rcp( new TensorBasis(spatialBasis, temporalBasis) );
+    
+    int tensorialDegree = 1;
+    CellTopoPtr tensorTopo = CellTopology::cellTopology(CellTopology::quad(), tensorialDegree);
+    int cubatureDegree = 2 * H1Order;
+    BasisCachePtr basisCache = BasisCache::basisCacheForReferenceCell(tensorTopo, cubatureDegree);
+    FieldContainer<double> tensorPoints = basisCache->getRefCellPoints();
+    
+    int numPoints = tensorPoints.dimension(0);
+    int spaceTimeDim = tensorPoints.dimension(1);
+    int cardinality = tensorBasis->getCardinality();
+    
+    double tol = 1e-15;
+    
+    std::vector<Intrepid::EOperator> ops;
+    ops.push_back(OPERATOR_VALUE);
+    ops.push_back(OPERATOR_GRAD);
+    for (int opOrdinal=0; opOrdinal < ops.size(); opOrdinal++) {
+      Intrepid::EOperator op = ops[opOrdinal];
+      FieldContainer<double> values, pointValues;
+      if (op == OPERATOR_VALUE) {
+        values.resize(cardinality, numPoints);
+        pointValues.resize(cardinality, 1);
+      } else {
+        values.resize(cardinality, numPoints, spaceTimeDim);
+        pointValues.resize(cardinality, 1, spaceTimeDim);
+      }
+      tensorBasis->getValues(values, tensorPoints, op);
+      
+      FieldContainer<double> point(1, spaceTimeDim);
+      for (int pointOrdinal=0; pointOrdinal < numPoints; pointOrdinal++) {
+        for (int d=0; d<spaceTimeDim; d++) {
+          point(0,d) = tensorPoints(pointOrdinal,d);
+        }
+        tensorBasis->getValues(pointValues, point, op);
+        for (int fieldOrdinal=0; fieldOrdinal < cardinality; fieldOrdinal++) {
+          if (op == OPERATOR_VALUE) {
+            TEST_FLOATING_EQUALITY(values(fieldOrdinal,pointOrdinal) + 1.0, pointValues(fieldOrdinal,0) + 1.0, tol);
+          } else {
+            for (int d=0; d<spaceTimeDim; d++) {
+              TEST_FLOATING_EQUALITY(values(fieldOrdinal,pointOrdinal,d) + 1.0, pointValues(fieldOrdinal,0,d) + 1.0, tol);
+            }
+          }
+        }
+      }
+      
+      // the basis keeps the unique component points of the last point set; a second evaluation reuses them
+      FieldContainer<double> valuesAgain(values);
+      valuesAgain.initialize(0.0);
+      tensorBasis->getValues(valuesAgain, tensorPoints, op);
+      tensorBasis->getValues(valuesAgain, tensorPoints, op);
+      for (int i=0; i<values.size(); i++) {
+        TEST_FLOATING_EQUALITY(valuesAgain[i] + 1.0, values[i] + 1.0, tol);
+      }
+    }
+  }
+  
 } // namespace
\ No newline at end of file
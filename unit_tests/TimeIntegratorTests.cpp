@@ -0,0 +1,124 @@
+//
+//  TimeIntegratorTests.cpp
+//  Camellia
+//
+//
+
+#include "Teuchos_UnitTestHarness.hpp"
+#include "Teuchos_UnitTestHelpers.hpp"
+
+#include "MeshFactory.h"
+#include "PoissonFormulation.h"
+#include "TimeIntegrator.h"
+
+namespace {
+  // the steady Poisson operator applied to solution, for a time-dependent problem phi_t - phi_xx = 0
+  class PoissonSteadyResidual : public SteadyResidual {
+    PoissonFormulation* _form;
+  public:
+    PoissonSteadyResidual(VarFactory &varFactory, PoissonFormulation* form) : SteadyResidual(varFactory), _form(form) {}
+    LinearTermPtr createResidual(SolutionPtr solution, bool includeBoundaryTerms) {
+      FunctionPtr phi_prev = Function::solution(_form->phi(), solution);
+      FunctionPtr psi_prev = Function::solution(_form->psi(), solution);
+      FunctionPtr phi_hat_prev = Function::solution(_form->phi_hat(), solution);
+      FunctionPtr psi_n_hat_prev = Function::solution(_form->psi_n_hat(), solution);
+
+      LinearTermPtr residual = Teuchos::rcp( new LinearTerm );
+      residual->addTerm( phi_prev * _form->tau()->dx() );
+      residual->addTerm( psi_prev * _form->tau() );
+      residual->addTerm( -psi_prev * _form->q()->dx() );
+      if (includeBoundaryTerms) {
+        residual->addTerm( -phi_hat_prev * _form->tau() );
+        residual->addTerm( psi_n_hat_prev * _form->q() );
+      }
+      return residual;
+    }
+  };
+
+  // runs a linear 1D heat problem for several steps, returning the rank-local solution coefficients, cell by cell
+  vector< FieldContainer<double> > heatSolution(bool useESDIRK, bool reuseStiffness, int &numStoredStiffnessSolves) {
+    int spaceDim = 1;
+    bool useConformingTraces = true;
+    PoissonFormulation form(spaceDim, useConformingTraces);
+    VarFactory varFactory = form.bf()->varFactory();
+    PoissonSteadyResidual steadyResidual(varFactory, &form);
+
+    int numCells = 4, H1Order = 2, delta_k = 1;
+    MeshPtr mesh = MeshFactory::intervalMesh(form.bf(), 0.0, 1.0, numCells, H1Order, delta_k);
+
+    BCPtr bc = BC::bc();
+    bc->addDirichlet(form.phi_hat(), SpatialFilter::allSpace(), Function::zero());
+    IPPtr ip = form.bf()->graphNorm();
+
+    FunctionPtr x = Function::xn(1);
+    map<int, FunctionPtr> initialCondition;
+    initialCondition[form.phi()->ID()] = x - x * x;
+    initialCondition[form.psi()->ID()] = Function::zero();
+    initialCondition[form.phi_hat()->ID()] = Function::zero();
+    initialCondition[form.psi_n_hat()->ID()] = Function::zero();
+
+    bool nonlinear = false;
+    Teuchos::RCP<TimeIntegrator> timeIntegrator;
+    if (useESDIRK) {
+      int numStages = 4;
+      timeIntegrator = Teuchos::rcp( new ESDIRKIntegrator(form.bf(), steadyResidual, mesh, bc, ip, initialCondition,
+                                                          numStages, nonlinear) );
+    } else {
+      timeIntegrator = Teuchos::rcp( new ImplicitEulerIntegrator(form.bf(), steadyResidual, mesh, bc, ip,
+                                                                 initialCondition, nonlinear) );
+    }
+    timeIntegrator->addTimeTerm(form.phi(), form.q(), Function::constant(1.0));
+    timeIntegrator->setReuseStiffness(reuseStiffness);
+
+    // several steps, so that solves with the stored stiffness follow setSolution() calls on the integrator's solution
+    double dt = 0.01;
+    timeIntegrator->runToTime(5 * dt, dt);
+    numStoredStiffnessSolves = timeIntegrator->solution()->numStoredStiffnessSolves();
+
+    vector< FieldContainer<double> > coefficients;
+    set<GlobalIndexType> cellIDs = mesh->cellIDsInPartition();
+    for (set<GlobalIndexType>::iterator cellIDIt = cellIDs.begin(); cellIDIt != cellIDs.end(); cellIDIt++) {
+      coefficients.push_back(timeIntegrator->solution()->allCoefficientsForCellID(*cellIDIt));
+    }
+    return coefficients;
+  }
+
+  void testReuseStiffnessMatchesFullAssembly(bool useESDIRK, Teuchos::FancyOStream &out, bool &success) {
+    int numStoredStiffnessSolves;
+    vector< FieldContainer<double> > expectedCoefficients = heatSolution(useESDIRK, false, numStoredStiffnessSolves);
+    TEST_EQUALITY(numStoredStiffnessSolves, 0);
+    vector< FieldContainer<double> > coefficients = heatSolution(useESDIRK, true, numStoredStiffnessSolves);
+    // the stored stiffness must actually be used, across steps as well as stages
+    TEST_COMPARE(numStoredStiffnessSolves, >=, 3);
+
+    TEST_EQUALITY(coefficients.size(), expectedCoefficients.size());
+    if (coefficients.size() != expectedCoefficients.size()) return;
+
+    double tol = 1e-10;
+    for (int cellOrdinal=0; cellOrdinal<coefficients.size(); cellOrdinal++) {
+      TEST_EQUALITY(coefficients[cellOrdinal].size(), expectedCoefficients[cellOrdinal].size());
+      if (coefficients[cellOrdinal].size() != expectedCoefficients[cellOrdinal].size()) continue;
+      for (int i=0; i<coefficients[cellOrdinal].size(); i++) {
+        double diff = abs(coefficients[cellOrdinal][i] - expectedCoefficients[cellOrdinal][i]);
+        if (diff > tol * max(1.0, abs(expectedCoefficients[cellOrdinal][i]))) {
+          out << "cell ordinal " << cellOrdinal << ", coefficient " << i << ": " << coefficients[cellOrdinal][i];
+          out << " with stiffness reuse, " << expectedCoefficients[cellOrdinal][i] << " without\n";
+          success = false;
+        }
+      }
+    }
+  }
+
+  TEUCHOS_UNIT_TEST( TimeIntegrator, ReuseStiffnessMatchesFullAssembly_ImplicitEuler )
+  {
+    bool useESDIRK = false;
+    testReuseStiffnessMatchesFullAssembly(useESDIRK, out, success);
+  }
+
+  TEUCHOS_UNIT_TEST( TimeIntegrator, ReuseStiffnessMatchesFullAssembly_ESDIRK )
+  {
+    // the first step is implicit Euler with a much smaller dt; the stages must not reuse its stiffness
+    bool useESDIRK = true;
+    testReuseStiffnessMatchesFullAssembly(useESDIRK, out, success);
+  }
+} // namespace